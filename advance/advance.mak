@@ -14,6 +14,7 @@ JOBJ = obj/j/$(BINARYDIR)
 KOBJ = obj/k/$(BINARYDIR)
 IOBJ = obj/i/$(BINARYDIR)
 VOBJ = obj/v/$(BINARYDIR)
+BOBJ = obj/b/$(BINARYDIR)
 SOBJ = obj/s/$(BINARYDIR)
 CFGOBJ = obj/cfg/$(BINARYDIR)
 LINEOBJ = obj/line/$(BINARYBUILDDIR)
@@ -161,6 +162,7 @@ v: $(VOBJ) $(VOBJ)/advv$(EXE)
 s: $(SOBJ) $(SOBJ)/advs$(EXE)
 k: $(KOBJ) $(KOBJ)/advk$(EXE)
 i: $(IOBJ) $(IOBJ)/advi$(EXE)
+b: $(BOBJ) $(BOBJ)/advb$(EXE)
 j: $(JOBJ) $(JOBJ)/advj$(EXE)
 m: $(MOBJ) $(MOBJ)/advm$(EXE)
 line: $(LINEOBJ) $(LINEOBJ)/advline$(EXE_FOR_BUILD)
@@ -275,6 +277,10 @@ I_SRC = \
 	$(wildcard $(srcdir)/advance/i/*.c) \
 	$(wildcard $(srcdir)/advance/i/*.h)
 
+B_SRC = \
+	$(wildcard $(srcdir)/advance/b/*.c) \
+	$(wildcard $(srcdir)/advance/b/*.h)
+
 K_SRC = \
 	$(wildcard $(srcdir)/advance/k/*.c) \
 	$(wildcard $(srcdir)/advance/k/*.h)
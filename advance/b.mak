@@ -0,0 +1,99 @@
+############################################################################
+# B
+
+BCFLAGS += \
+	-I$(srcdir)/advance/lib \
+	-I$(srcdir)/advance/blit
+BOBJDIRS += \
+	$(BOBJ)/b \
+	$(BOBJ)/lib \
+	$(BOBJ)/blit
+BOBJS += \
+	$(BOBJ)/b/b.o \
+	$(BOBJ)/lib/portable.o \
+	$(BOBJ)/lib/snstring.o \
+	$(BOBJ)/lib/log.o \
+	$(BOBJ)/lib/video.o \
+	$(BOBJ)/lib/measure.o \
+	$(BOBJ)/lib/rgb.o \
+	$(BOBJ)/lib/conf.o \
+	$(BOBJ)/lib/incstr.o \
+	$(BOBJ)/lib/videoio.o \
+	$(BOBJ)/lib/update.o \
+	$(BOBJ)/lib/generate.o \
+	$(BOBJ)/lib/crtc.o \
+	$(BOBJ)/lib/crtcbag.o \
+	$(BOBJ)/lib/monitor.o \
+	$(BOBJ)/lib/device.o \
+	$(BOBJ)/lib/gtf.o \
+	$(BOBJ)/lib/error.o \
+	$(BOBJ)/blit/blit.o \
+	$(BOBJ)/blit/hq2x.o \
+	$(BOBJ)/blit/hq2x3.o \
+	$(BOBJ)/blit/hq2x4.o \
+	$(BOBJ)/blit/hq3x.o \
+	$(BOBJ)/blit/hq4x.o \
+	$(BOBJ)/blit/xbr2x.o \
+	$(BOBJ)/blit/xbr3x.o \
+	$(BOBJ)/blit/xbr4x.o \
+	$(BOBJ)/blit/scale2x.o \
+	$(BOBJ)/blit/scale3x.o \
+	$(BOBJ)/blit/scale2k.o \
+	$(BOBJ)/blit/scale3k.o \
+	$(BOBJ)/blit/scale4k.o \
+	$(BOBJ)/blit/interp.o \
+	$(BOBJ)/blit/clear.o \
+	$(BOBJ)/blit/slice.o
+
+ifeq ($(CONF_SYSTEM),unix)
+BCFLAGS += \
+	-DADV_DATADIR=\"$(datadir)\" \
+	-DADV_SYSCONFDIR=\"$(sysconfdir)\" \
+	-I$(srcdir)/advance/linux
+BOBJDIRS += \
+	$(BOBJ)/linux
+BOBJS += \
+	$(BOBJ)/linux/file.o \
+	$(BOBJ)/linux/target.o \
+	$(BOBJ)/linux/os.o
+ifeq ($(CONF_LIB_PTHREAD),yes)
+BCFLAGS += -D_REENTRANT -DUSE_SMP \
+	-I$(srcdir)/advance/osd
+BLIBS += -lpthread
+BOBJDIRS += \
+	$(BOBJ)/osd
+BOBJS += \
+	$(BOBJ)/osd/thsteal.o
+endif
+endif
+
+ifeq ($(CONF_SYSTEM),dos)
+BCFLAGS += \
+	-I$(srcdir)/advance/dos
+BLIBS += -lalleg
+BOBJDIRS += \
+	$(BOBJ)/dos
+BOBJS += \
+	$(BOBJ)/dos/file.o \
+	$(BOBJ)/dos/target.o \
+	$(BOBJ)/dos/os.o
+endif
+
+$(BOBJ)/%.o: $(srcdir)/advance/%.c
+	$(ECHO) $@ $(MSG)
+	$(CC) $(CFLAGS) $(BCFLAGS) -c $< -o $@
+
+$(BOBJ):
+	$(ECHO) $@
+	$(MD) $@
+
+$(sort $(BOBJDIRS)):
+	$(ECHO) $@
+	$(MD) $@
+
+$(BOBJ)/advb$(EXE) : $(sort $(BOBJDIRS)) $(BOBJS)
+	$(ECHO) $@ $(MSG)
+	$(LD) $(BOBJS) $(BLIBS) $(BLDFLAGS) $(LDFLAGS) $(LIBS) -o $@
+	$(RM) advb$(EXE)
+	$(LN_S) $@ advb$(EXE)
+
@@ -0,0 +1,335 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2018 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Benchmark of the blit pipelines.
+ *
+ * Every pipeline is run on a memory target with all the SIMD instruction
+ * sets supported by the CPU, and the time is reported in milliseconds for
+ * each megapixel written.
+ */
+
+#include "portable.h"
+
+#include "advance.h"
+
+#ifdef USE_SMP
+#include "thread.h"
+#endif
+
+/***************************************************************************/
+/* bench */
+
+struct bench_struct {
+	const char* name; /**< Name of the effect. */
+	unsigned combine; /**< Combine flags. */
+	unsigned mx; /**< Horizontal scale factor. */
+	unsigned my; /**< Vertical scale factor. */
+};
+
+static struct bench_struct BENCH[] = {
+	{ "copy", VIDEO_COMBINE_Y_NONE, 1, 1 },
+	{ "double", VIDEO_COMBINE_Y_NONE, 2, 2 },
+	{ "mean", VIDEO_COMBINE_Y_MEAN | VIDEO_COMBINE_X_MEAN, 2, 2 },
+	{ "filter", VIDEO_COMBINE_Y_FILTER | VIDEO_COMBINE_X_FILTER, 2, 2 },
+	{ "maxmin", VIDEO_COMBINE_Y_MAXMIN | VIDEO_COMBINE_X_MAXMIN, 2, 2 },
+#ifndef USE_BLIT_TINY
+	{ "triad3pix", VIDEO_COMBINE_X_RGB_TRIAD3PIX, 2, 2 },
+	{ "scandouble", VIDEO_COMBINE_X_RGB_SCANDOUBLEHORZ, 2, 2 },
+	{ "scale2x", VIDEO_COMBINE_Y_SCALEX, 2, 2 },
+	{ "scale2x3", VIDEO_COMBINE_Y_SCALEX, 2, 3 },
+	{ "scale2x4", VIDEO_COMBINE_Y_SCALEX, 2, 4 },
+	{ "scale3x", VIDEO_COMBINE_Y_SCALEX, 3, 3 },
+	{ "scale4x", VIDEO_COMBINE_Y_SCALEX, 4, 4 },
+	{ "scale2k", VIDEO_COMBINE_Y_SCALEK, 2, 2 },
+	{ "scale3k", VIDEO_COMBINE_Y_SCALEK, 3, 3 },
+	{ "scale4k", VIDEO_COMBINE_Y_SCALEK, 4, 4 },
+#ifndef USE_BLIT_SMALL
+	{ "hq2x", VIDEO_COMBINE_Y_HQ, 2, 2 },
+	{ "hq2x3", VIDEO_COMBINE_Y_HQ, 2, 3 },
+	{ "hq2x4", VIDEO_COMBINE_Y_HQ, 2, 4 },
+	{ "hq3x", VIDEO_COMBINE_Y_HQ, 3, 3 },
+	{ "hq4x", VIDEO_COMBINE_Y_HQ, 4, 4 },
+	{ "xbr2x", VIDEO_COMBINE_Y_XBR, 2, 2 },
+	{ "xbr3x", VIDEO_COMBINE_Y_XBR, 3, 3 },
+	{ "xbr4x", VIDEO_COMBINE_Y_XBR, 4, 4 },
+#endif
+#endif
+	{ 0, 0, 0, 0 }
+};
+
+static unsigned opt_dx = 320;
+static unsigned opt_dy = 240;
+static double opt_time = 0.5;
+static unsigned opt_thread = 1;
+
+/**
+ * Fill the source with a pattern with large areas of the same color,
+ * like the ones generated by the emulated games.
+ */
+static void bench_fill(uint8* src, unsigned dx, unsigned dy, unsigned bytes_per_pixel)
+{
+	unsigned x, y;
+
+	for(y=0;y<dy;++y) {
+		for(x=0;x<dx;++x) {
+			unsigned v = ((x / 7) ^ (y / 5)) % 3;
+			uint8* p = src + (y * dx + x) * bytes_per_pixel;
+			switch (bytes_per_pixel) {
+			case 2 : *(uint16*)p = v * 0x4208; break;
+			case 4 : *(uint32*)p = v * 0x404040; break;
+			}
+		}
+	}
+}
+
+static void bench_name(char* buffer, unsigned size, const struct video_pipeline_struct* pipeline)
+{
+	const struct video_stage_horz_struct* stage;
+
+	*buffer = 0;
+
+	for(stage=video_pipeline_begin(pipeline);stage!=video_pipeline_end(pipeline);++stage) {
+		if (stage == video_pipeline_pivot(pipeline)) {
+			sncat(buffer, size, pipe_name(video_pipeline_vert(pipeline)->type));
+			sncat(buffer, size, ", ");
+		}
+		sncat(buffer, size, pipe_name(stage->type));
+		if (stage + 1 != video_pipeline_end(pipeline))
+			sncat(buffer, size, ", ");
+	}
+	if (video_pipeline_pivot(pipeline) == video_pipeline_end(pipeline)) {
+		if (*buffer)
+			sncat(buffer, size, ", ");
+		sncat(buffer, size, pipe_name(video_pipeline_vert(pipeline)->type));
+	}
+}
+
+static void bench_run(const struct bench_struct* bench, adv_color_def src_def, adv_color_def dst_def)
+{
+	unsigned src_bytes_per_pixel = color_def_bytes_per_pixel_get(src_def);
+	unsigned dst_bytes_per_pixel = color_def_bytes_per_pixel_get(dst_def);
+	unsigned dst_dx = opt_dx * bench->mx;
+	unsigned dst_dy = opt_dy * bench->my;
+	unsigned dst_size = dst_dx * dst_dy * dst_bytes_per_pixel;
+	uint8* src;
+	uint8* dst;
+	uint8* ref;
+	uint8* cmp;
+	unsigned simd;
+	unsigned simd_max;
+
+	src = malloc(opt_dx * opt_dy * src_bytes_per_pixel);
+	dst = malloc(dst_size);
+	ref = malloc(dst_size);
+	cmp = malloc(dst_size);
+
+	bench_fill(src, opt_dx, opt_dy, src_bytes_per_pixel);
+
+	simd_max = video_blit_simd_get();
+
+	for(simd=VIDEO_BLIT_SIMD_NONE;simd<=simd_max;++simd) {
+		struct video_pipeline_struct pipeline;
+		target_clock_t start, stop, limit;
+		unsigned count;
+		char name[256];
+		double mpix;
+
+		video_blit_simd_set(simd);
+
+		video_pipeline_init(&pipeline);
+		video_pipeline_target(&pipeline, dst, dst_dx * dst_bytes_per_pixel, dst_def);
+		video_pipeline_direct(&pipeline, dst_dx, dst_dy, opt_dx, opt_dy, opt_dx * src_bytes_per_pixel, src_bytes_per_pixel, src_def, bench->combine);
+
+		bench_name(name, sizeof(name), &pipeline);
+
+		/* warm up, and check that the result is equal at the C implementation */
+		video_pipeline_blit(&pipeline, 0, 0, src);
+		if (simd == VIDEO_BLIT_SIMD_NONE)
+			memcpy(ref, dst, dst_size);
+		else if (memcmp(ref, dst, dst_size) != 0)
+			sncat(name, sizeof(name), " [DIFFERENT FROM C]");
+
+		/* check that drawing in bands gives the same result */
+		if (video_pipeline_is_band(&pipeline)) {
+			unsigned y;
+			unsigned end;
+
+			memcpy(cmp, dst, dst_size);
+			memset(dst, 0, dst_size);
+			for(y=0;y<opt_dy;y=end) {
+				end = y + 32 <= opt_dy ? y + 16 : opt_dy;
+				video_pipeline_blit_band(&pipeline, 0, 0, src, y, end);
+			}
+			if (memcmp(cmp, dst, dst_size) != 0)
+				sncat(name, sizeof(name), " [DIFFERENT IN BANDS]");
+		}
+
+		count = 0;
+		start = target_clock();
+		limit = start + opt_time * TARGET_CLOCKS_PER_SEC;
+		do {
+			video_pipeline_blit(&pipeline, 0, 0, src);
+			++count;
+			stop = target_clock();
+		} while (stop < limit);
+
+		video_pipeline_done(&pipeline);
+
+		mpix = (double)dst_dx * dst_dy * count / 1E6;
+
+		printf("%-10s %2u>%-2u %-5s %8.3f ms/Mpix %8.1f fps %s\n", bench->name, 8 * src_bytes_per_pixel, 8 * dst_bytes_per_pixel, video_blit_simd_name(simd), (stop - start) * 1E3 / TARGET_CLOCKS_PER_SEC / mpix, count * (double)TARGET_CLOCKS_PER_SEC / (stop - start), name);
+	}
+
+	video_blit_simd_set(simd_max);
+
+	free(cmp);
+	free(ref);
+	free(dst);
+	free(src);
+}
+
+static void run(void)
+{
+	adv_color_def def16 = color_def_make_rgb_from_sizelenpos(2, 5, 11, 6, 5, 5, 0);
+	adv_color_def def32 = color_def_make_rgb_from_sizelenpos(4, 8, 16, 8, 8, 8, 0);
+	const struct bench_struct* bench;
+
+	printf("Source %ux%u, %g s for each test, %u bands\n", opt_dx, opt_dy, opt_time, video_blit_thread_get());
+
+	for(bench=BENCH;bench->name;++bench) {
+		bench_run(bench, def16, def16);
+		bench_run(bench, def32, def32);
+	}
+
+	/* color conversion */
+	bench_run(&BENCH[0], def32, def16);
+}
+
+/***************************************************************************/
+/* main */
+
+#ifdef USE_SMP
+/**
+ * The bands are drawn on the same work-stealing pool of the emulator.
+ */
+int thread_is_active(void)
+{
+	return 1;
+}
+#endif
+
+static void error_callback(void* context, enum conf_callback_error error, const char* file, const char* tag, const char* valid, const char* desc, ...)
+{
+	va_list arg;
+	va_start(arg, desc);
+	vfprintf(stderr, desc, arg);
+	fprintf(stderr, "\n");
+	if (valid)
+		fprintf(stderr, "%s\n", valid);
+	va_end(arg);
+}
+
+void os_signal(int signum, void* info, void* context)
+{
+	os_default_signal(signum, info, context);
+}
+
+int os_main(int argc, char* argv[])
+{
+	adv_conf* context;
+	const char* section_map[1];
+	int i;
+
+	context = conf_init();
+
+	if (os_init(context) != 0)
+		goto err_conf;
+
+	if (conf_input_args_load(context, 0, "", &argc, argv, error_callback, 0) != 0)
+		goto err_os;
+
+	for(i=1;i<argc;++i) {
+		if (strcmp(argv[i], "-size") == 0 && i+1 < argc) {
+			if (sscanf(argv[++i], "%ux%u", &opt_dx, &opt_dy) != 2 || opt_dx < 16 || opt_dy < 16) {
+				fprintf(stderr, "Invalid size '%s'\n", argv[i]);
+				goto err_os;
+			}
+		} else if (strcmp(argv[i], "-time") == 0 && i+1 < argc) {
+			opt_time = atof(argv[++i]);
+			if (opt_time <= 0) {
+				fprintf(stderr, "Invalid time '%s'\n", argv[i]);
+				goto err_os;
+			}
+		} else if (strcmp(argv[i], "-threads") == 0 && i+1 < argc) {
+			opt_thread = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Unknown argument '%s'\n", argv[i]);
+			goto err_os;
+		}
+	}
+
+	section_map[0] = "";
+	conf_section_set(context, section_map, 1);
+
+	if (os_inner_init("AdvanceBLIT") != 0)
+		goto err_os;
+
+	if (video_blit_init() != 0) {
+		fprintf(stderr, "%s\n", error_get());
+		goto err_os_inner;
+	}
+
+#ifdef USE_SMP
+	if (thread_init() != 0) {
+		fprintf(stderr, "Error initializing the threads\n");
+		goto err_blit;
+	}
+
+	thread_set(opt_thread, "none");
+
+	video_blit_thread_set(osd_parallel_for, opt_thread);
+#endif
+
+	run();
+
+#ifdef USE_SMP
+	thread_done();
+#endif
+	video_blit_done();
+	os_inner_done();
+	os_done();
+	conf_done(context);
+
+	return EXIT_SUCCESS;
+
+#ifdef USE_SMP
+err_blit:
+	video_blit_done();
+#endif
+err_os_inner:
+	os_inner_done();
+err_os:
+	os_done();
+err_conf:
+	conf_done(context);
+	return EXIT_FAILURE;
+}
+
@@ -35,6 +35,10 @@
 #include "error.h"
 #include "endianrw.h"
 
+#ifdef USE_SMP
+#include <unistd.h>
+#endif
+
 /***************************************************************************/
 /* mmx */
 
@@ -94,6 +98,47 @@ static inline void internal_end(void)
 	}
 }
 
+#elif defined(USE_BLIT_SSE2)
+
+/*
+ * On x86-64 SSE2 is always present, and the kernels are written with
+ * compiler intrinsics instead of inline assembler.
+ * AVX2 is instead optional, and it's detected at runtime.
+ */
+
+static void blit_has_capability(adv_bool* has_sse2, adv_bool* has_avx2)
+{
+	__builtin_cpu_init();
+
+	*has_sse2 = __builtin_cpu_supports("sse2") != 0;
+	*has_avx2 = __builtin_cpu_supports("avx2") != 0;
+}
+
+#define the_blit_asm 0
+
+adv_bool the_blit_cpu_sse2 = 0;
+adv_bool the_blit_cpu_avx2 = 0;
+adv_bool the_blit_sse2 = 0;
+adv_bool the_blit_avx2 = 0;
+
+#define BLITTER(name) (name##_def)
+#define BLITTER_SSE2(name) (the_blit_sse2 ? name##_sse2 : name##_def)
+#define BLITTER_AVX2(name) (the_blit_avx2 ? name##_avx2 : BLITTER_SSE2(name))
+
+static adv_error blit_cpu(void)
+{
+	blit_has_capability(&the_blit_cpu_sse2, &the_blit_cpu_avx2);
+
+	the_blit_sse2 = the_blit_cpu_sse2;
+	the_blit_avx2 = the_blit_cpu_sse2 && the_blit_cpu_avx2;
+
+	return 0;
+}
+
+static inline void internal_end(void)
+{
+}
+
 #else
 
 /* Assume that MMX/SSE2 is NOT present. */
@@ -113,6 +158,18 @@ static inline void internal_end(void)
 
 #endif
 
+#ifndef BLITTER_SSE2
+#define BLITTER_SSE2(name) BLITTER(name)
+#define BLITTER_AVX2(name) BLITTER(name)
+#endif
+
+/* kernels without the i386 assembler version */
+#if defined(USE_BLIT_SSE2)
+#define BLITTER_C_SSE2(name) BLITTER_SSE2(name)
+#else
+#define BLITTER_C_SSE2(name) (name##_def)
+#endif
+
 /***************************************************************************/
 /* internal */
 
@@ -225,34 +282,46 @@ static inline void internal_end(void)
 /* Align */
 #define FAST_BUFFER_ALIGN 16 /* SSE2 requirement */
 
-void* fast_buffer; /* raw pointer */
-void* fast_buffer_aligned; /* aligned pointer */
-unsigned fast_buffer_map[FAST_BUFFER_MAX]; /* stack of incremental size used */
-unsigned fast_buffer_mac; /* top of the stack */
+/* Buffers context, one for every thread running a pipeline */
+struct video_buffer_context {
+	void* raw; /**< Raw pointer. */
+	void* aligned; /**< Aligned pointer. */
+	unsigned map[FAST_BUFFER_MAX]; /**< Stack of incremental size used. */
+	unsigned mac; /**< Top of the stack. */
+};
+
+static struct video_buffer_context fast_buffer_main;
+
+#ifdef USE_SMP
+static __thread struct video_buffer_context* fast_buffer = &fast_buffer_main;
+#else
+static struct video_buffer_context* fast_buffer = &fast_buffer_main;
+#endif
 
 static void* video_buffer_alloc(unsigned size)
 {
+	struct video_buffer_context* context = fast_buffer;
 	unsigned size_aligned = ALIGN_UNSIGNED(size, FAST_BUFFER_ALIGN);
 
-	assert(fast_buffer_mac < FAST_BUFFER_MAX);
+	assert(context->mac < FAST_BUFFER_MAX);
 
-	if (fast_buffer_map[fast_buffer_mac] + size_aligned > FAST_BUFFER_SIZE - FAST_BUFFER_ALIGN) {
+	if (context->map[context->mac] + size_aligned > FAST_BUFFER_SIZE - FAST_BUFFER_ALIGN) {
 		log_std(("ERROR:blit: out of memory\n"));
 		return 0;
 	}
 
-	++fast_buffer_mac;
-	fast_buffer_map[fast_buffer_mac] = fast_buffer_map[fast_buffer_mac-1] + size_aligned;
+	++context->mac;
+	context->map[context->mac] = context->map[context->mac-1] + size_aligned;
 
-	return (uint8*)fast_buffer_aligned + fast_buffer_map[fast_buffer_mac-1];
+	return (uint8*)context->aligned + context->map[context->mac-1];
 }
 
 /* Buffers must be allocated and freed in exact reverse order */
 static void video_buffer_free(void* buffer)
 {
 	(void)buffer;
-	assert(fast_buffer_mac != 0);
-	--fast_buffer_mac;
+	assert(fast_buffer->mac != 0);
+	--fast_buffer->mac;
 }
 
 /* Debug version of the alloc functions */
@@ -283,23 +352,40 @@ static void video_buffer_free_wrap(void* buffer)
 
 #endif
 
-static void video_buffer_init(void)
+static adv_error video_buffer_context_init(struct video_buffer_context* context)
 {
-	fast_buffer = malloc(FAST_BUFFER_SIZE + FAST_BUFFER_ALIGN);
-	fast_buffer_aligned = ALIGN_PTR(fast_buffer, FAST_BUFFER_ALIGN);
-	fast_buffer_mac = 0;
-	fast_buffer_map[0] = 0;
+	context->raw = malloc(FAST_BUFFER_SIZE + FAST_BUFFER_ALIGN);
+	if (!context->raw)
+		return -1;
+	context->aligned = ALIGN_PTR(context->raw, FAST_BUFFER_ALIGN);
+	context->mac = 0;
+	context->map[0] = 0;
+	return 0;
+}
+
+static void video_buffer_context_done(struct video_buffer_context* context)
+{
+	assert(context->mac == 0);
+	free(context->raw);
+}
+
+static adv_error video_buffer_init(void)
+{
+	return video_buffer_context_init(&fast_buffer_main);
 }
 
 static void video_buffer_done(void)
 {
-	assert(fast_buffer_mac == 0);
-	free(fast_buffer);
+	video_buffer_context_done(&fast_buffer_main);
 }
 
 /***************************************************************************/
 /* init/done */
 
+#ifdef USE_SMP
+static void band_context_done(void);
+#endif
+
 adv_error video_blit_init(void)
 {
 	if (blit_cpu() != 0) {
@@ -307,16 +393,56 @@ adv_error video_blit_init(void)
 		return -1;
 	}
 
-	video_buffer_init();
+	if (video_buffer_init() != 0) {
+		error_set("Low memory.\n");
+		return -1;
+	}
 
 	return 0;
 }
 
 void video_blit_done(void)
 {
+#ifdef USE_SMP
+	band_context_done();
+#endif
 	video_buffer_done();
 }
 
+unsigned video_blit_simd_get(void)
+{
+#if defined(USE_BLIT_SSE2)
+	if (the_blit_avx2)
+		return VIDEO_BLIT_SIMD_AVX2;
+	if (the_blit_sse2)
+		return VIDEO_BLIT_SIMD_SSE2;
+#else
+	if (the_blit_asm)
+		return VIDEO_BLIT_SIMD_SSE2;
+#endif
+	return VIDEO_BLIT_SIMD_NONE;
+}
+
+void video_blit_simd_set(unsigned level)
+{
+#if defined(USE_BLIT_SSE2)
+	the_blit_sse2 = the_blit_cpu_sse2 && level >= VIDEO_BLIT_SIMD_SSE2;
+	the_blit_avx2 = the_blit_sse2 && the_blit_cpu_avx2 && level >= VIDEO_BLIT_SIMD_AVX2;
+#else
+	(void)level;
+#endif
+}
+
+const char* video_blit_simd_name(unsigned level)
+{
+	switch (level) {
+	case VIDEO_BLIT_SIMD_NONE : return "none";
+	case VIDEO_BLIT_SIMD_SSE2 : return "sse2";
+	case VIDEO_BLIT_SIMD_AVX2 : return "avx2";
+	}
+	return "unknown";
+}
+
 /***************************************************************************/
 /* stage helper */
 
@@ -405,9 +531,9 @@ static void stage_mean_vert_self(const struct video_stage_horz_struct* stage, vo
 {
 	if ((int)stage->sbpp == stage->sdp) {
 		switch (stage->sbpp) {
-		case 1 : BLITTER(internal_mean8_vert_self)(dst, src, stage->sdx); break;
-		case 2 : BLITTER(internal_mean16_vert_self)(dst, src, stage->sdx); break;
-		case 4 : BLITTER(internal_mean32_vert_self)(dst, src, stage->sdx); break;
+		case 1 : BLITTER_AVX2(internal_mean8_vert_self)(dst, src, stage->sdx); break;
+		case 2 : BLITTER_AVX2(internal_mean16_vert_self)(dst, src, stage->sdx); break;
+		case 4 : BLITTER_AVX2(internal_mean32_vert_self)(dst, src, stage->sdx); break;
 		}
 	} else {
 		switch (stage->sbpp) {
@@ -422,27 +548,27 @@ static void stage_mean_vert_self(const struct video_stage_horz_struct* stage, vo
 static inline void scale2x(void* dst0, void* dst1, void* src0, void* src1, void* src2, unsigned bytes_per_pixel, unsigned count)
 {
 	switch (bytes_per_pixel) {
-	case 1 : BLITTER(scale2x_8)(dst0, dst1, src0, src1, src2, count); break;
-	case 2 : BLITTER(scale2x_16)(dst0, dst1, src0, src1, src2, count); break;
-	case 4 : BLITTER(scale2x_32)(dst0, dst1, src0, src1, src2, count); break;
+	case 1 : BLITTER_AVX2(scale2x_8)(dst0, dst1, src0, src1, src2, count); break;
+	case 2 : BLITTER_AVX2(scale2x_16)(dst0, dst1, src0, src1, src2, count); break;
+	case 4 : BLITTER_AVX2(scale2x_32)(dst0, dst1, src0, src1, src2, count); break;
 	}
 }
 
 static inline void scale2x3(void* dst0, void* dst1, void* dst2, void* src0, void* src1, void* src2, unsigned bytes_per_pixel, unsigned count)
 {
 	switch (bytes_per_pixel) {
-	case 1 : BLITTER(scale2x3_8)(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 2 : BLITTER(scale2x3_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 4 : BLITTER(scale2x3_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 1 : BLITTER_AVX2(scale2x3_8)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 2 : BLITTER_AVX2(scale2x3_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 4 : BLITTER_AVX2(scale2x3_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
 
 static inline void scale2x4(void* dst0, void* dst1, void* dst2, void* dst3, void* src0, void* src1, void* src2, unsigned bytes_per_pixel, unsigned count)
 {
 	switch (bytes_per_pixel) {
-	case 1 : BLITTER(scale2x4_8)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case 2 : BLITTER(scale2x4_16)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case 4 : BLITTER(scale2x4_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case 1 : BLITTER_AVX2(scale2x4_8)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case 2 : BLITTER_AVX2(scale2x4_16)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case 4 : BLITTER_AVX2(scale2x4_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	}
 }
 
@@ -469,7 +595,7 @@ static inline void hq2x3(void* dst0, void* dst1, void* dst2, void* src0, void* s
 {
 	switch (interp) {
 	case INTERP_16 : hq2x3_16_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case INTERP_32 : hq2x3_32_def(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case INTERP_32 : BLITTER_C_SSE2(hq2x3_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	case INTERP_YUY2 : hq2x3_yuy2_def(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
@@ -478,7 +604,7 @@ static inline void hq2x4(void* dst0, void* dst1, void* dst2, void* dst3, void* s
 {
 	switch (interp) {
 	case INTERP_16 : hq2x4_16_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case INTERP_32 : hq2x4_32_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case INTERP_32 : BLITTER_C_SSE2(hq2x4_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	case INTERP_YUY2 : hq2x4_yuy2_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	}
 }
@@ -496,9 +622,9 @@ static inline void xbr2x(void* dst0, void* dst1, void* src0, void* src1, void* s
 static inline void scale3x(void* dst0, void* dst1, void* dst2, void* src0, void* src1, void* src2, unsigned bytes_per_pixel, unsigned count)
 {
 	switch (bytes_per_pixel) {
-	case 1 : scale3x_8_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 2 : scale3x_16_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 4 : scale3x_32_def(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 1 : BLITTER_C_SSE2(scale3x_8)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 2 : BLITTER_C_SSE2(scale3x_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 4 : BLITTER_C_SSE2(scale3x_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
 
@@ -516,7 +642,7 @@ static inline void hq3x(void* dst0, void* dst1, void* dst2, void* src0, void* sr
 {
 	switch (interp) {
 	case INTERP_16 : hq3x_16_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case INTERP_32 : hq3x_32_def(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case INTERP_32 : BLITTER_C_SSE2(hq3x_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	case INTERP_YUY2 : hq3x_yuy2_def(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
@@ -545,7 +671,7 @@ static inline void hq4x(void* dst0, void* dst1, void* dst2, void* dst3, void* sr
 {
 	switch (interp) {
 	case INTERP_16 : hq4x_16_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case INTERP_32 : hq4x_32_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case INTERP_32 : BLITTER_C_SSE2(hq4x_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	case INTERP_YUY2 : hq4x_yuy2_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	}
 }
@@ -673,9 +799,17 @@ void video_pipeline_init(struct video_pipeline_struct* pipeline)
 	pipeline->stage_mac = 0;
 	pipeline->target.line = &video_line;
 	pipeline->target.ptr = 0;
-	pipeline->target.color_def = video_color_def();
-	pipeline->target.bytes_per_pixel = color_def_bytes_per_pixel_get(video_color_def());
-	pipeline->target.bytes_per_scanline = video_bytes_per_scanline();
+
+	/* without a video mode only a memory target can be used */
+	if (video_is_active() && video_mode_is_active()) {
+		pipeline->target.color_def = video_color_def();
+		pipeline->target.bytes_per_pixel = color_def_bytes_per_pixel_get(video_color_def());
+		pipeline->target.bytes_per_scanline = video_bytes_per_scanline();
+	} else {
+		pipeline->target.color_def = 0;
+		pipeline->target.bytes_per_pixel = 0;
+		pipeline->target.bytes_per_scanline = 0;
+	}
 }
 
 void video_pipeline_target(struct video_pipeline_struct* pipeline, void* ptr, unsigned bytes_per_scanline, adv_color_def def)
@@ -771,6 +905,8 @@ static void video_pipeline_realize(struct video_pipeline_struct* pipeline, unsig
 	while (stage != stage_end) {
 		if (stage->buffer_extra_size) {
 			stage->buffer_extra = video_buffer_alloc(stage->buffer_extra_size);
+			/* the extra buffer keeps the state between rows, no bands */
+			stage_vert->band = 0;
 		} else {
 			stage->buffer_extra = 0;
 		}
@@ -1048,7 +1184,7 @@ static void video_stage_stretchy_x1(const struct video_pipeline_target_struct* t
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1082,7 +1218,7 @@ static void video_stage_stretchy_max_x1(const struct video_pipeline_target_struc
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1140,7 +1276,7 @@ static void video_stage_stretchy_mean_x1(const struct video_pipeline_target_stru
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1196,7 +1332,7 @@ static void video_stage_stretchy_filter_x1(const struct video_pipeline_target_st
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1262,7 +1398,7 @@ static void video_stage_stretchy_1x(const struct video_pipeline_target_struct* t
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	while (count) {
@@ -1312,7 +1448,7 @@ static void video_stage_stretchy_mean_1x(const struct video_pipeline_target_stru
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* src_buffer;
@@ -1380,7 +1516,7 @@ static void video_stage_stretchy_min_1x(const struct video_pipeline_target_struc
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* src_buffer;
@@ -1448,7 +1584,7 @@ static void video_stage_stretchy_filter_1x(const struct video_pipeline_target_st
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* src_buffer;
@@ -1504,7 +1640,7 @@ static void video_stage_stretchy_scale2x(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -1655,7 +1791,7 @@ static void video_stage_stretchy_scale2x3(const struct video_pipeline_target_str
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -1805,7 +1941,7 @@ static void video_stage_stretchy_scale2x4(const struct video_pipeline_target_str
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -1960,7 +2096,7 @@ static void video_stage_stretchy_scale2k(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2116,7 +2252,7 @@ static void video_stage_stretchy_hq2x(const struct video_pipeline_target_struct*
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2266,7 +2402,7 @@ static void video_stage_stretchy_hq2x3(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2416,7 +2552,7 @@ static void video_stage_stretchy_hq2x4(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2573,7 +2709,7 @@ static void video_stage_stretchy_xbr2x(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2784,7 +2920,7 @@ static void video_stage_stretchy_scale3x(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2939,7 +3075,7 @@ static void video_stage_stretchy_scale3k(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3095,7 +3231,7 @@ static void video_stage_stretchy_hq3x(const struct video_pipeline_target_struct*
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3252,7 +3388,7 @@ static void video_stage_stretchy_xbr3x(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3462,7 +3598,7 @@ static void video_stage_stretchy_scale4x(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3702,7 +3838,7 @@ static void video_stage_stretchy_scale4k(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3858,7 +3994,7 @@ static void video_stage_stretchy_hq4x(const struct video_pipeline_target_struct*
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -4015,7 +4151,7 @@ static void video_stage_stretchy_xbr4x(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -4225,7 +4361,7 @@ static void video_stage_stretchy_11(const struct video_pipeline_target_struct* t
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	while (count) {
@@ -4280,6 +4416,7 @@ static void video_stage_stretchy_set(const struct video_pipeline_target_struct*
 	stage_vert->sdy = sdy;
 	stage_vert->sdw = sdw;
 	stage_vert->ddy = ddy;
+	stage_vert->line = 0;
 
 #if !defined(USE_BLIT_SMALL) && !defined(USE_BLIT_TINY)
 	/* The pixel type is always the target pixel type because, when used, any conversion is done before */
@@ -4340,7 +4477,7 @@ static void video_stage_stretchy_set(const struct video_pipeline_target_struct*
 		video_stage_pivot_late_set(stage_vert, combine);
 		stage_vert->put = video_stage_stretchy_hq2x3;
 		stage_vert->type = pipe_y_hq2x3;
-	} else if (ddx == 2*sdx && ddy == 2*sdy && combine_y == VIDEO_COMBINE_Y_HQ) {
+	} else if (ddx == 2*sdx && ddy == 4*sdy && combine_y == VIDEO_COMBINE_Y_HQ) {
 		/* hq2x4 */
 		slice_set(&stage_vert->slice, sdy, ddy);
 
@@ -4489,6 +4626,32 @@ static void video_stage_stretchy_set(const struct video_pipeline_target_struct*
 		}
 	}
 
+	/* the integer scalers and the plain copy use only a few rows */
+	/* around the current one and can be split in horizontal bands */
+	switch (stage_vert->type) {
+	case pipe_y_scale2x :
+	case pipe_y_scale2x3 :
+	case pipe_y_scale2x4 :
+	case pipe_y_scale3x :
+	case pipe_y_scale4x :
+	case pipe_y_scale2k :
+	case pipe_y_scale3k :
+	case pipe_y_scale4k :
+	case pipe_y_hq2x :
+	case pipe_y_hq2x3 :
+	case pipe_y_hq2x4 :
+	case pipe_y_hq3x :
+	case pipe_y_hq4x :
+	case pipe_y_xbr2x :
+	case pipe_y_xbr3x :
+	case pipe_y_xbr4x :
+		stage_vert->band = ddy / sdy;
+		break;
+	default :
+		stage_vert->band = stage_vert->put == video_stage_stretchy_11;
+		break;
+	}
+
 	if (color_def_type_get(target->color_def) == adv_color_type_rgb) {
 		if (combine_y == VIDEO_COMBINE_Y_MEAN
 			|| combine_y == VIDEO_COMBINE_Y_FILTER
@@ -4521,6 +4684,8 @@ static void video_stage_stretchy_11_set(struct video_stage_vert_struct* stage_ve
 	stage_vert->sdy = sdy;
 	stage_vert->sdw = sdw;
 	stage_vert->ddy = sdy;
+	stage_vert->band = 1;
+	stage_vert->line = 0;
 
 	slice_set(&stage_vert->slice, sdy, sdy);
 
@@ -4978,8 +5143,231 @@ void video_pipeline_palette16(struct video_pipeline_struct* pipeline, unsigned d
 	video_pipeline_realize(pipeline, src_dx, dst_dx, bytes_per_pixel, combine);
 }
 
+/***************************************************************************/
+/* bands */
+
+/* Min number of rows of a band, the stages require at least four rows */
+#define VIDEO_BAND_MIN 16
+
+/* Target of a single band */
+struct video_band_target_struct {
+	struct video_pipeline_target_struct target; /**< Target seen by the stages. It must be the first field. */
+	const struct video_pipeline_target_struct* parent; /**< Real target. */
+	unsigned y_begin; /**< First row owned by the band. */
+	unsigned y_end; /**< Row after the last owned by the band. */
+	unsigned char* scratch; /**< Row used for the context rows, the result is discarded. */
+};
+
+static unsigned char* video_band_line(const struct video_pipeline_target_struct* target, unsigned y)
+{
+	const struct video_band_target_struct* band = (const struct video_band_target_struct*)target;
+
+	if (y < band->y_begin || y >= band->y_end)
+		return band->scratch;
+
+	return band->parent->line(band->parent, y);
+}
+
+/**
+ * Draw the source rows from begin to end.
+ * The vertical stage is run on the band with some additional rows of context
+ * drawn in a scratch row. All the buffers are allocated on the buffer context
+ * of the calling thread.
+ */
+static void video_pipeline_band_run(const struct video_pipeline_struct* pipeline, unsigned x, unsigned y, const void* src, unsigned begin, unsigned end)
+{
+	const struct video_stage_vert_struct* stage_vert = video_pipeline_vert(pipeline);
+	struct video_stage_horz_struct stage_map[VIDEO_STAGE_MAX];
+	struct video_stage_vert_struct band_vert;
+	struct video_band_target_struct band_target;
+	unsigned band = stage_vert->band;
+	unsigned first;
+	unsigned last;
+	int i;
+
+	first = begin < VIDEO_BAND_CONTEXT ? 0 : begin - VIDEO_BAND_CONTEXT;
+	last = end + VIDEO_BAND_CONTEXT > stage_vert->sdy ? stage_vert->sdy : end + VIDEO_BAND_CONTEXT;
+
+	/* private copy of the horizontal stages */
+	for(i=0;i<pipeline->stage_mac;++i) {
+		stage_map[i] = pipeline->stage_map[i];
+		if (stage_map[i].buffer_size)
+			stage_map[i].buffer = video_buffer_alloc(stage_map[i].buffer_size);
+	}
+
+	band_vert = *stage_vert;
+	band_vert.stage_begin = stage_map + (stage_vert->stage_begin - pipeline->stage_map);
+	band_vert.stage_end = stage_map + (stage_vert->stage_end - pipeline->stage_map);
+	band_vert.stage_pivot = stage_map + (stage_vert->stage_pivot - pipeline->stage_map);
+	band_vert.sdy = last - first;
+	band_vert.ddy = band_vert.sdy * band;
+	band_vert.line = stage_vert->line + first * band;
+	slice_set(&band_vert.slice, band_vert.sdy, band_vert.ddy);
+
+	band_target.target = pipeline->target;
+	band_target.target.line = video_band_line;
+	band_target.parent = &pipeline->target;
+	band_target.y_begin = y + begin * band;
+	band_target.y_end = y + end * band;
+	band_target.scratch = video_buffer_alloc(pipeline->target.bytes_per_scanline);
+
+	PADD(src, stage_vert->sdw * (int)first);
+
+	band_vert.put(&band_target.target, &band_vert, x, y + first * band, src);
+
+	/* restore the SSE2 micro state */
+	internal_end();
+
+	video_buffer_free(band_target.scratch);
+
+	for(i=pipeline->stage_mac-1;i>=0;--i) {
+		if (stage_map[i].buffer_size)
+			video_buffer_free(stage_map[i].buffer);
+	}
+}
+
+#ifdef USE_SMP
+
+/* Max number of bands drawn in parallel */
+#define VIDEO_BAND_MAX 16
+
+static video_blit_parallel_for* band_parallel_for; /**< Parallel execution function, 0 if disabled. */
+static struct video_buffer_context band_context[VIDEO_BAND_MAX]; /**< Buffer context of every band. */
+static unsigned band_mac; /**< Number of buffer contexts. */
+static int band_inuse; /**< Reentrant check. */
+
+/* Bands of a blit */
+struct video_band_job_struct {
+	const struct video_pipeline_struct* pipeline;
+	unsigned x;
+	unsigned y;
+	const void* src;
+	unsigned count; /**< Number of bands. */
+};
+
+/**
+ * Draw the bands from begin to end.
+ * It's called on any thread of the pool, and all these threads see the
+ * main buffer context, so every band uses its private context.
+ */
+static void band_proc(void* arg, int begin, int end)
+{
+	const struct video_band_job_struct* job = arg;
+	unsigned sdy = video_pipeline_vert(job->pipeline)->sdy;
+	struct video_buffer_context* context = fast_buffer;
+	int i;
+
+	for(i=begin;i<end;++i) {
+		fast_buffer = &band_context[i];
+		video_pipeline_band_run(job->pipeline, job->x, job->y, job->src, sdy * i / job->count, sdy * (i + 1) / job->count);
+	}
+
+	fast_buffer = context;
+}
+
+static void band_context_done(void)
+{
+	band_parallel_for = 0;
+
+	while (band_mac) {
+		--band_mac;
+		video_buffer_context_done(&band_context[band_mac]);
+	}
+}
+
+/* Draw the pipeline in parallel, return 0 if not possible */
+static adv_bool band_blit(const struct video_pipeline_struct* pipeline, unsigned x, unsigned y, const void* src)
+{
+	struct video_band_job_struct job;
+	unsigned count;
+
+	if (!band_parallel_for || !video_pipeline_vert(pipeline)->band)
+		return 0;
+
+	count = video_pipeline_vert(pipeline)->sdy / VIDEO_BAND_MIN;
+	if (count > band_mac)
+		count = band_mac;
+	if (count < 2)
+		return 0;
+
+	/* the contexts of the bands are in use, draw serially */
+	if (__atomic_exchange_n(&band_inuse, 1, __ATOMIC_ACQUIRE))
+		return 0;
+
+	job.pipeline = pipeline;
+	job.x = x;
+	job.y = y;
+	job.src = src;
+	job.count = count;
+
+	band_parallel_for(band_proc, &job, count, 1);
+
+	__atomic_store_n(&band_inuse, 0, __ATOMIC_RELEASE);
+
+	return 1;
+}
+
+#endif
+
+void video_blit_thread_set(video_blit_parallel_for* parallel_for, unsigned count)
+{
+#ifdef USE_SMP
+	if (count == 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		count = n > 0 ? n : 1;
+#else
+		count = 1;
+#endif
+	}
+	if (count > VIDEO_BAND_MAX)
+		count = VIDEO_BAND_MAX;
+
+	band_context_done();
+
+	if (!parallel_for || count < 2)
+		return;
+
+	while (band_mac < count && video_buffer_context_init(&band_context[band_mac]) == 0)
+		++band_mac;
+
+	if (band_mac < 2) {
+		band_context_done();
+		return;
+	}
+
+	band_parallel_for = parallel_for;
+
+	log_std(("blit: drawing up to %u bands in parallel\n", band_mac));
+#else
+	(void)parallel_for;
+	(void)count;
+#endif
+}
+
+unsigned video_blit_thread_get(void)
+{
+#ifdef USE_SMP
+	if (band_parallel_for)
+		return band_mac;
+#endif
+	return 1;
+}
+
 void video_pipeline_blit(const struct video_pipeline_struct* pipeline, unsigned dst_x, unsigned dst_y, const void* src)
 {
+#ifdef USE_SMP
+	if (band_blit(pipeline, dst_x, dst_y, src))
+		return;
+#endif
+
 	video_pipeline_vert_run(pipeline, dst_x, dst_y, src);
 }
 
+void video_pipeline_blit_band(const struct video_pipeline_struct* pipeline, unsigned dst_x, unsigned dst_y, const void* src, unsigned begin, unsigned end)
+{
+	assert(video_pipeline_vert(pipeline)->band != 0);
+
+	video_pipeline_band_run(pipeline, dst_x, dst_y, src, begin, end);
+}
+
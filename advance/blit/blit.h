@@ -271,6 +271,10 @@ struct __attribute__((aligned(8))) video_stage_vert_struct {
 	/* stretch slice */
 	adv_slice slice;
 
+	/* bands */
+	unsigned band; /**< Destination rows for every source row if the stage can be split in horizontal bands, 0 if not. */
+	unsigned line; /**< Number of the first line given at the line dependent stages. */
+
 	/* pipeline */
 	const struct video_stage_horz_struct* stage_begin;
 	const struct video_stage_horz_struct* stage_end;
@@ -376,6 +380,61 @@ adv_error video_blit_init(void);
  */
 void video_blit_done(void);
 
+/** \name SIMD */
+/*@{*/
+#define VIDEO_BLIT_SIMD_NONE 0 /**< Only C code. */
+#define VIDEO_BLIT_SIMD_SSE2 1 /**< SSE2 kernels. */
+#define VIDEO_BLIT_SIMD_AVX2 2 /**< AVX2 kernels, with SSE2 where no AVX2 version exists. */
+/*@}*/
+
+/**
+ * Get the SIMD instruction set used by the blitters.
+ * \return One of the VIDEO_BLIT_SIMD_* values.
+ */
+unsigned video_blit_simd_get(void);
+
+/**
+ * Limit the SIMD instruction set used by the blitters.
+ * The set is anyway limited at the one supported by the CPU.
+ * It must be called after video_blit_init() and before setting up any pipeline,
+ * because the kernels are selected when the pipeline is created.
+ * \param level One of the VIDEO_BLIT_SIMD_* values.
+ */
+void video_blit_simd_set(unsigned level);
+
+/**
+ * Get the name of a SIMD instruction set.
+ * \return Pointer at a static buffer.
+ */
+const char* video_blit_simd_name(unsigned level);
+
+/**
+ * Function used to draw the bands in parallel.
+ * It calls func() on all the items of [0, count) in ranges of chunk items,
+ * possibly on different threads, and it returns when all the calls end.
+ * It has the same definition of osd_parallel_for().
+ */
+typedef void video_blit_parallel_for(void (*func)(void* arg, int begin, int end), void* arg, int count, int chunk);
+
+/**
+ * Set the number of bands used to draw a pipeline.
+ * The pipelines that can be split are drawn in horizontal bands in parallel,
+ * every band with its private copy of the intermediate row buffers.
+ * The bands are executed by the parallel_for function, which uses the threads
+ * of the caller, the blit doesn't start any thread.
+ * Without the pthread support only one band is used.
+ * It must be called after video_blit_init(), and not while a pipeline is drawn.
+ * \param parallel_for Function used to draw the bands. 0 disables the bands.
+ * \param count Max number of bands. 1 disables the bands,
+ * 0 uses one band for every processor.
+ */
+void video_blit_thread_set(video_blit_parallel_for* parallel_for, unsigned count);
+
+/**
+ * Get the max number of bands drawn in parallel.
+ */
+unsigned video_blit_thread_get(void);
+
 /***************************************************************************/
 /* pipeline blit */
 
@@ -412,6 +471,31 @@ void video_pipeline_palette16(struct video_pipeline_struct* pipeline, unsigned d
  */
 void video_pipeline_blit(const struct video_pipeline_struct* pipeline, unsigned dst_x, unsigned dst_y, const void* src);
 
+/**
+ * Rows of context required above and below a band.
+ * A source row changes the destination rows of the source rows at this
+ * distance, xbr uses five rows.
+ */
+#define VIDEO_BAND_CONTEXT 2
+
+/**
+ * Draw only a band of a pipeline in the calling thread.
+ * The result is the same of the part drawn by video_pipeline_blit().
+ * It can be used only if the vertical stage supports the bands,
+ * and the band must have at least four rows.
+ * \param begin First source row of the band.
+ * \param end Source row after the last of the band.
+ */
+void video_pipeline_blit_band(const struct video_pipeline_struct* pipeline, unsigned dst_x, unsigned dst_y, const void* src, unsigned begin, unsigned end);
+
+/**
+ * Check if the pipeline can be drawn in bands.
+ */
+static inline adv_bool video_pipeline_is_band(const struct video_pipeline_struct* pipeline)
+{
+	return pipeline->stage_vert.band != 0;
+}
+
 /***************************************************************************/
 /* blit */
 
@@ -37,5 +37,11 @@ void hq2x3_16_def(interp_uint16* dst0, interp_uint16* dst1, interp_uint16* dst2,
 void hq2x3_32_def(interp_uint32* dst0, interp_uint32* dst1, interp_uint32* dst2, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
 void hq2x3_yuy2_def(interp_uint32* dst0, interp_uint32* dst1, interp_uint32* dst2, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
 
+#if defined(USE_BLIT_SSE2)
+
+void hq2x3_32_sse2(interp_uint32* dst0, interp_uint32* dst1, interp_uint32* dst2, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
+
+#endif
+
 #endif
 
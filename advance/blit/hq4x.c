@@ -293,3 +293,98 @@ void hq4x_yuy2_def(interp_uint32* restrict dst0, interp_uint32* restrict dst1, i
 	}
 }
 
+/***************************************************************************/
+/* HQ4x SSE2 implementation */
+
+#if defined(USE_BLIT_SSE2)
+
+/*
+ * The pattern of the pixel is computed as in the C version, and only the
+ * interpolation of the output pixels uses SSE2, with all the channels of
+ * a pixel computed at the same time.
+ */
+void hq4x_32_sse2(interp_uint32* restrict dst0, interp_uint32* restrict dst1, interp_uint32* restrict dst2, interp_uint32* restrict dst3, const interp_uint32* restrict src0, const interp_uint32* restrict src1, const interp_uint32* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	for(i=0;i<count;++i) {
+		unsigned char mask;
+
+		interp_uint32 c[9];
+
+		c[1] = src0[0];
+		c[4] = src1[0];
+		c[7] = src2[0];
+
+		if (i>0) {
+			c[0] = src0[-1];
+			c[3] = src1[-1];
+			c[6] = src2[-1];
+		} else {
+			c[0] = c[1];
+			c[3] = c[4];
+			c[6] = c[7];
+		}
+
+		if (i<count-1) {
+			c[2] = src0[1];
+			c[5] = src1[1];
+			c[8] = src2[1];
+		} else {
+			c[2] = c[1];
+			c[5] = c[4];
+			c[8] = c[7];
+		}
+
+		mask = 0;
+
+		if (interp_32_diff(c[0], c[4]))
+			mask |= 1 << 0;
+		if (interp_32_diff(c[1], c[4]))
+			mask |= 1 << 1;
+		if (interp_32_diff(c[2], c[4]))
+			mask |= 1 << 2;
+		if (interp_32_diff(c[3], c[4]))
+			mask |= 1 << 3;
+		if (interp_32_diff(c[5], c[4]))
+			mask |= 1 << 4;
+		if (interp_32_diff(c[6], c[4]))
+			mask |= 1 << 5;
+		if (interp_32_diff(c[7], c[4]))
+			mask |= 1 << 6;
+		if (interp_32_diff(c[8], c[4]))
+			mask |= 1 << 7;
+
+#define P(a, b) dst##b[a]
+#define MUR interp_32_diff(c[1], c[5])
+#define MDR interp_32_diff(c[5], c[7])
+#define MDL interp_32_diff(c[7], c[3])
+#define MUL interp_32_diff(c[3], c[1])
+#define I1(p0) c[p0]
+#define I2(i0, i1, p0, p1) interp_32_sse2_2(c[p0], c[p1], i0, i1)
+#define I3(i0, i1, i2, p0, p1, p2) interp_32_sse2_3(c[p0], c[p1], c[p2], i0, i1, i2)
+
+		switch (mask) {
+		#include "hq4x.dat"
+		}
+
+#undef P
+#undef MUR
+#undef MDR
+#undef MDL
+#undef MUL
+#undef I1
+#undef I2
+#undef I3
+
+		src0 += 1;
+		src1 += 1;
+		src2 += 1;
+		dst0 += 4;
+		dst1 += 4;
+		dst2 += 4;
+		dst3 += 4;
+	}
+}
+
+#endif
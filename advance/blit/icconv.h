@@ -250,6 +250,7 @@ static inline void internal_convbgra8888tobgr565_def(void* dst, const void* src,
 {
 	uint32* src32 = (uint32*)src;
 	uint32* dst32 = (uint32*)dst;
+	unsigned rest = count % 2;
 
 	count /= 2;
 	while (count) {
@@ -271,7 +272,59 @@ static inline void internal_convbgra8888tobgr565_def(void* dst, const void* src,
 		src32 += 2;
 		--count;
 	}
+
+	if (rest) {
+		uint16* dst16 = (uint16*)dst32;
+		*dst16 = ((src32[0] >> (8-5)) & 0x001F)
+			| ((src32[0] >> (16-5-6)) & 0x07E0)
+			| ((src32[0] >> (24-5-6-5)) & 0xF800);
+	}
+}
+
+#if defined(USE_BLIT_SSE2)
+static inline void internal_convbgra8888tobgr565_sse2(void* dst, const void* src, unsigned count)
+{
+	__m128i mask_r = _mm_set1_epi32(0xF800);
+	__m128i mask_g = _mm_set1_epi32(0x07E0);
+	__m128i mask_b = _mm_set1_epi32(0x001F);
+	const uint32* src32 = src;
+	uint16* dst16 = dst;
+	unsigned rest = count % 8;
+
+	count /= 8;
+	while (count) {
+		__m128i p0 = _mm_loadu_si128((const __m128i*)src32);
+		__m128i p1 = _mm_loadu_si128((const __m128i*)(src32 + 4));
+
+		p0 = _mm_or_si128(_mm_or_si128(
+			_mm_and_si128(_mm_srli_epi32(p0, 8), mask_r),
+			_mm_and_si128(_mm_srli_epi32(p0, 5), mask_g)),
+			_mm_and_si128(_mm_srli_epi32(p0, 3), mask_b));
+		p1 = _mm_or_si128(_mm_or_si128(
+			_mm_and_si128(_mm_srli_epi32(p1, 8), mask_r),
+			_mm_and_si128(_mm_srli_epi32(p1, 5), mask_g)),
+			_mm_and_si128(_mm_srli_epi32(p1, 3), mask_b));
+
+		/* sign extend the low word to pack it without saturation */
+		p0 = _mm_srai_epi32(_mm_slli_epi32(p0, 16), 16);
+		p1 = _mm_srai_epi32(_mm_slli_epi32(p1, 16), 16);
+
+		_mm_storeu_si128((__m128i*)dst16, _mm_packs_epi32(p0, p1));
+		src32 += 8;
+		dst16 += 8;
+		--count;
+	}
+
+	while (rest) {
+		*dst16 = ((src32[0] >> (8-5)) & 0x001F)
+			| ((src32[0] >> (16-5-6)) & 0x07E0)
+			| ((src32[0] >> (24-5-6-5)) & 0xF800);
+		++src32;
+		++dst16;
+		--rest;
+	}
 }
+#endif
 
 #if defined(USE_ASM_INLINE)
 static uint32 bgra8888tobgra5551_mask[] = {
@@ -351,6 +404,7 @@ static inline void internal_convbgra8888tobgra5551_def(void* dst, const void* sr
 {
 	uint32* src32 = (uint32*)src;
 	uint32* dst32 = (uint32*)dst;
+	unsigned rest = count % 2;
 
 	count /= 2;
 	while (count) {
@@ -372,8 +426,57 @@ static inline void internal_convbgra8888tobgra5551_def(void* dst, const void* sr
 		src32 += 2;
 		--count;
 	}
+
+	if (rest) {
+		uint16* dst16 = (uint16*)dst32;
+		*dst16 = ((src32[0] >> (8-5)) & 0x001F)
+			| ((src32[0] >> (16-5-5)) & 0x03E0)
+			| ((src32[0] >> (24-5-5-5)) & 0x7C00);
+	}
 }
 
+#if defined(USE_BLIT_SSE2)
+static inline void internal_convbgra8888tobgra5551_sse2(void* dst, const void* src, unsigned count)
+{
+	__m128i mask_r = _mm_set1_epi32(0x7C00);
+	__m128i mask_g = _mm_set1_epi32(0x03E0);
+	__m128i mask_b = _mm_set1_epi32(0x001F);
+	const uint32* src32 = src;
+	uint16* dst16 = dst;
+	unsigned rest = count % 8;
+
+	count /= 8;
+	while (count) {
+		__m128i p0 = _mm_loadu_si128((const __m128i*)src32);
+		__m128i p1 = _mm_loadu_si128((const __m128i*)(src32 + 4));
+
+		p0 = _mm_or_si128(_mm_or_si128(
+			_mm_and_si128(_mm_srli_epi32(p0, 9), mask_r),
+			_mm_and_si128(_mm_srli_epi32(p0, 6), mask_g)),
+			_mm_and_si128(_mm_srli_epi32(p0, 3), mask_b));
+		p1 = _mm_or_si128(_mm_or_si128(
+			_mm_and_si128(_mm_srli_epi32(p1, 9), mask_r),
+			_mm_and_si128(_mm_srli_epi32(p1, 6), mask_g)),
+			_mm_and_si128(_mm_srli_epi32(p1, 3), mask_b));
+
+		/* the values are less than 0x8000, the pack doesn't saturate */
+		_mm_storeu_si128((__m128i*)dst16, _mm_packs_epi32(p0, p1));
+		src32 += 8;
+		dst16 += 8;
+		--count;
+	}
+
+	while (rest) {
+		*dst16 = ((src32[0] >> (8-5)) & 0x001F)
+			| ((src32[0] >> (16-5-5)) & 0x03E0)
+			| ((src32[0] >> (24-5-5-5)) & 0x7C00);
+		++src32;
+		++dst16;
+		--rest;
+	}
+}
+#endif
+
 #if defined(USE_ASM_INLINE)
 static uint32 bgra5551tobgr332_mask[] = {
 	0x00E000E0, 0x00E000E0, 0x00E000E0, 0x00E000E0, /* r */
@@ -541,6 +644,7 @@ static inline void internal_convbgra5551tobgr565_def(void* dst, const void* src,
 {
 	uint32* src32 = (uint32*)src;
 	uint32* dst32 = (uint32*)dst;
+	unsigned rest = count % 2;
 
 	count /= 2;
 	while (count) {
@@ -549,7 +653,45 @@ static inline void internal_convbgra5551tobgr565_def(void* dst, const void* src,
 		src32 += 1;
 		--count;
 	}
+
+	if (rest) {
+		uint16* src16 = (uint16*)src32;
+		uint16* dst16 = (uint16*)dst32;
+		*dst16 = (src16[0] & 0x001F)
+			| ((src16[0] << 1) & 0xFFC0);
+	}
+}
+
+#if defined(USE_BLIT_SSE2)
+static inline void internal_convbgra5551tobgr565_sse2(void* dst, const void* src, unsigned count)
+{
+	__m128i mask_b = _mm_set1_epi16(0x001F);
+	__m128i mask_rg = _mm_set1_epi16((short)0xFFC0);
+	const uint16* src16 = src;
+	uint16* dst16 = dst;
+	unsigned rest = count % 8;
+
+	count /= 8;
+	while (count) {
+		__m128i p = _mm_loadu_si128((const __m128i*)src16);
+
+		p = _mm_or_si128(_mm_and_si128(p, mask_b), _mm_and_si128(_mm_slli_epi16(p, 1), mask_rg));
+
+		_mm_storeu_si128((__m128i*)dst16, p);
+		src16 += 8;
+		dst16 += 8;
+		--count;
+	}
+
+	while (rest) {
+		*dst16 = (src16[0] & 0x001F)
+			| ((src16[0] << 1) & 0xFFC0);
+		++src16;
+		++dst16;
+		--rest;
+	}
 }
+#endif
 
 #if defined(USE_ASM_INLINE)
 static uint32 bgra5551tobgra8888_mask[] = {
@@ -624,6 +766,50 @@ static inline void internal_convbgra5551tobgra8888_def(void* dst, const void* sr
 	}
 }
 
+#if defined(USE_BLIT_SSE2)
+static inline void internal_convbgra5551tobgra8888_sse2(void* dst, const void* src, unsigned count)
+{
+	__m128i mask_r = _mm_set1_epi32(0x00F80000);
+	__m128i mask_g = _mm_set1_epi32(0x0000F800);
+	__m128i mask_b = _mm_set1_epi32(0x000000F8);
+	__m128i zero = _mm_setzero_si128();
+	const uint16* src16 = src;
+	uint32* dst32 = dst;
+	unsigned rest = count % 8;
+
+	count /= 8;
+	while (count) {
+		__m128i p = _mm_loadu_si128((const __m128i*)src16);
+		__m128i p0 = _mm_unpacklo_epi16(p, zero);
+		__m128i p1 = _mm_unpackhi_epi16(p, zero);
+
+		p0 = _mm_or_si128(_mm_or_si128(
+			_mm_and_si128(_mm_slli_epi32(p0, 9), mask_r),
+			_mm_and_si128(_mm_slli_epi32(p0, 6), mask_g)),
+			_mm_and_si128(_mm_slli_epi32(p0, 3), mask_b));
+		p1 = _mm_or_si128(_mm_or_si128(
+			_mm_and_si128(_mm_slli_epi32(p1, 9), mask_r),
+			_mm_and_si128(_mm_slli_epi32(p1, 6), mask_g)),
+			_mm_and_si128(_mm_slli_epi32(p1, 3), mask_b));
+
+		_mm_storeu_si128((__m128i*)dst32, p0);
+		_mm_storeu_si128((__m128i*)(dst32 + 4), p1);
+		src16 += 8;
+		dst32 += 8;
+		--count;
+	}
+
+	while (rest) {
+		*dst32 = ((src16[0] << 3) & 0x000000F8)
+			| ((src16[0] << 6) & 0x0000F800)
+			| ((src16[0] << 9) & 0x00F80000);
+		++src16;
+		++dst32;
+		--rest;
+	}
+}
+#endif
+
 #if defined(USE_ASM_INLINE)
 /*
 	Y =  0.299  R + 0.587  G + 0.114  B
@@ -31,6 +31,10 @@
 #ifndef __ICOMMON_H
 #define __ICOMMON_H
 
+#if defined(USE_BLIT_SSE2)
+#include <immintrin.h>
+#endif
+
 /***************************************************************************/
 /* internal */
 
@@ -141,6 +141,82 @@ static inline void internal_mean32_vert_self_def(uint32* dst32, const uint32* sr
 	}
 }
 
+#if defined(USE_BLIT_SSE2)
+/* Process 16 bytes at time, and the remaining 32 bit words with the C version */
+static inline void internal_mean128_vert_self_sse2(void* dst, const void* src, unsigned count)
+{
+	__m128i mask = _mm_set1_epi32(mean_mask[MEAN_MASK_H_0]);
+	uint8* dst8 = dst;
+	const uint8* src8 = src;
+	unsigned rest = count % 4;
+
+	count /= 4;
+	while (count) {
+		__m128i v0 = _mm_loadu_si128((const __m128i*)dst8);
+		__m128i v1 = _mm_loadu_si128((const __m128i*)src8);
+		__m128i m = _mm_and_si128(_mm_srli_epi32(_mm_xor_si128(v0, v1), 1), mask);
+		_mm_storeu_si128((__m128i*)dst8, _mm_add_epi32(m, _mm_and_si128(v0, v1)));
+		dst8 += 16;
+		src8 += 16;
+		--count;
+	}
+
+	internal_mean32_vert_self_def((uint32*)dst8, (const uint32*)src8, rest);
+}
+
+static inline void internal_mean8_vert_self_sse2(uint8* dst, const uint8* src, unsigned count)
+{
+	internal_mean128_vert_self_sse2(dst, src, count / 4);
+}
+
+static inline void internal_mean16_vert_self_sse2(uint16* dst, const uint16* src, unsigned count)
+{
+	internal_mean128_vert_self_sse2(dst, src, count / 2);
+}
+
+static inline void internal_mean32_vert_self_sse2(uint32* dst, const uint32* src, unsigned count)
+{
+	internal_mean128_vert_self_sse2(dst, src, count);
+}
+
+/* Process 32 bytes at time, and the remaining 32 bit words with the C version */
+static __attribute__((target("avx2"))) void internal_mean256_vert_self_avx2(void* dst, const void* src, unsigned count)
+{
+	__m256i mask = _mm256_set1_epi32(mean_mask[MEAN_MASK_H_0]);
+	uint8* dst8 = dst;
+	const uint8* src8 = src;
+	unsigned rest = count % 8;
+
+	count /= 8;
+	while (count) {
+		__m256i v0 = _mm256_loadu_si256((const __m256i*)dst8);
+		__m256i v1 = _mm256_loadu_si256((const __m256i*)src8);
+		__m256i m = _mm256_and_si256(_mm256_srli_epi32(_mm256_xor_si256(v0, v1), 1), mask);
+		_mm256_storeu_si256((__m256i*)dst8, _mm256_add_epi32(m, _mm256_and_si256(v0, v1)));
+		dst8 += 32;
+		src8 += 32;
+		--count;
+	}
+
+	internal_mean32_vert_self_def((uint32*)dst8, (const uint32*)src8, rest);
+}
+
+static inline void internal_mean8_vert_self_avx2(uint8* dst, const uint8* src, unsigned count)
+{
+	internal_mean256_vert_self_avx2(dst, src, count / 4);
+}
+
+static inline void internal_mean16_vert_self_avx2(uint16* dst, const uint16* src, unsigned count)
+{
+	internal_mean256_vert_self_avx2(dst, src, count / 2);
+}
+
+static inline void internal_mean32_vert_self_avx2(uint32* dst, const uint32* src, unsigned count)
+{
+	internal_mean256_vert_self_avx2(dst, src, count);
+}
+#endif
+
 static inline void internal_mean8_vert_self_def(uint8* dst, const uint8* src, unsigned count)
 {
 	internal_mean32_vert_self_def((uint32*)dst, (uint32*)src, count / 4);
@@ -464,6 +464,44 @@ INTERP_YUY2_GEN3(14, 1, 1)
 INTERP_YUY2_GEN2(15, 1)
 INTERP_YUY2_GEN2(9, 7)
 
+#if defined(USE_BLIT_SSE2)
+
+#include <immintrin.h>
+
+/**
+ * SSE2 version of the interp_32_*() functions, with the weights as arguments.
+ * All the C versions divide by a power of 2, so the weights are scaled
+ * at a total of 16, with the same result.
+ * The C versions with a total of 2 or 4 average the fourth byte,
+ * the others clear it.
+ */
+static inline interp_uint32 interp_32_sse2_3(interp_uint32 p1, interp_uint32 p2, interp_uint32 p3, unsigned a, unsigned b, unsigned c)
+{
+	unsigned m = 16 / (a + b + c);
+	__m128i z = _mm_setzero_si128();
+	__m128i r;
+
+	/* expand every byte to a 16 bits lane */
+	r = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p1), z), _mm_set1_epi16(a * m));
+	r = _mm_add_epi16(r, _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p2), z), _mm_set1_epi16(b * m)));
+	if (c != 0)
+		r = _mm_add_epi16(r, _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p3), z), _mm_set1_epi16(c * m)));
+	r = _mm_srli_epi16(r, 4);
+	r = _mm_packus_epi16(r, r);
+
+	if (a + b + c > 4)
+		return _mm_cvtsi128_si32(r) & 0xFFFFFF;
+
+	return _mm_cvtsi128_si32(r);
+}
+
+static inline interp_uint32 interp_32_sse2_2(interp_uint32 p1, interp_uint32 p2, unsigned a, unsigned b)
+{
+	return interp_32_sse2_3(p1, p2, p2, a, b, 0);
+}
+
+#endif
+
 /**
  * Compares two pixels and return if different.
  * Used by HQ/LQ algorithm.
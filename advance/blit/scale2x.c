@@ -1497,3 +1497,172 @@ void scale2x4_32_asm(scale2x_uint32* dst0, scale2x_uint32* dst1, scale2x_uint32*
 
 #endif
 
+
+/***************************************************************************/
+/* Scale2x SSE2/AVX2 implementation */
+
+#if defined(USE_BLIT_SSE2)
+
+#include <immintrin.h>
+
+/*
+ * Scale2x of a single pixel of a border row.
+ * Used for the first and last pixels, and for the pixels not filling a
+ * whole vector register.
+ *
+ *      B
+ *     DEF
+ *      H
+ */
+#define SCALE2X_PIXEL(dst, B, D, E, F, H) \
+	do { \
+		if (B != H && D != F) { \
+			(dst)[0] = D == B ? B : E; \
+			(dst)[1] = F == B ? B : E; \
+		} else { \
+			(dst)[0] = E; \
+			(dst)[1] = E; \
+		} \
+	} while (0)
+
+/*
+ * Scale2x of many pixels in a vector register.
+ * \param p0 Output register for the left pixels.
+ * \param p1 Output register for the right pixels.
+ * The cmpeq, and, andnot and or parameters are the instructions to use
+ * for the specific register and pixel size.
+ */
+#define SCALE2X_VECTOR(p0, p1, B, D, E, F, H, cmpeq, and, andnot, or) \
+	do { \
+		__typeof__(E) skip = or(cmpeq(B, H), cmpeq(D, F)); \
+		__typeof__(E) m0 = andnot(skip, cmpeq(D, B)); \
+		__typeof__(E) m1 = andnot(skip, cmpeq(F, B)); \
+		p0 = or(and(m0, B), andnot(m0, E)); \
+		p1 = or(and(m1, B), andnot(m1, E)); \
+	} while (0)
+
+/*
+ * Process the central pixels of a row with SSE2, 16 bytes at time.
+ * It returns the index of the first pixel not processed.
+ * Unaligned loads are used to get the left and right pixels, so there
+ * is no requirement on the alignment and on the size of the row.
+ */
+#define SCALE2X_SSE2_CENTER(type, dst, src0, src1, src2, i, count, cmpeq, unpacklo, unpackhi) \
+	do { \
+		const unsigned n = 16 / sizeof(type); \
+		while (i + n < count) { \
+			__m128i B = _mm_loadu_si128((const __m128i*)(src0 + i)); \
+			__m128i D = _mm_loadu_si128((const __m128i*)(src1 + i - 1)); \
+			__m128i E = _mm_loadu_si128((const __m128i*)(src1 + i)); \
+			__m128i F = _mm_loadu_si128((const __m128i*)(src1 + i + 1)); \
+			__m128i H = _mm_loadu_si128((const __m128i*)(src2 + i)); \
+			__m128i p0, p1; \
+			SCALE2X_VECTOR(p0, p1, B, D, E, F, H, cmpeq, _mm_and_si128, _mm_andnot_si128, _mm_or_si128); \
+			_mm_storeu_si128((__m128i*)(dst + 2*i), unpacklo(p0, p1)); \
+			_mm_storeu_si128((__m128i*)(dst + 2*i + n), unpackhi(p0, p1)); \
+			i += n; \
+		} \
+	} while (0)
+
+/*
+ * Like SCALE2X_SSE2_CENTER() but with AVX2, 32 bytes at time.
+ * The unpack instructions operate on the two 128 bits lanes independently,
+ * so the lanes are reordered before the store.
+ */
+#define SCALE2X_AVX2_CENTER(type, dst, src0, src1, src2, i, count, cmpeq, unpacklo, unpackhi) \
+	do { \
+		const unsigned n = 32 / sizeof(type); \
+		while (i + n < count) { \
+			__m256i B = _mm256_loadu_si256((const __m256i*)(src0 + i)); \
+			__m256i D = _mm256_loadu_si256((const __m256i*)(src1 + i - 1)); \
+			__m256i E = _mm256_loadu_si256((const __m256i*)(src1 + i)); \
+			__m256i F = _mm256_loadu_si256((const __m256i*)(src1 + i + 1)); \
+			__m256i H = _mm256_loadu_si256((const __m256i*)(src2 + i)); \
+			__m256i p0, p1, lo, hi; \
+			SCALE2X_VECTOR(p0, p1, B, D, E, F, H, cmpeq, _mm256_and_si256, _mm256_andnot_si256, _mm256_or_si256); \
+			lo = unpacklo(p0, p1); \
+			hi = unpackhi(p0, p1); \
+			_mm256_storeu_si256((__m256i*)(dst + 2*i), _mm256_permute2x128_si256(lo, hi, 0x20)); \
+			_mm256_storeu_si256((__m256i*)(dst + 2*i + n), _mm256_permute2x128_si256(lo, hi, 0x31)); \
+			i += n; \
+		} \
+	} while (0)
+
+/*
+ * Complete a row after the vector processing, and process the first pixel.
+ */
+#define SCALE2X_FIRST(dst, src0, src1, src2) \
+	SCALE2X_PIXEL(dst, src0[0], src1[0], src1[0], src1[1], src2[0])
+
+#define SCALE2X_LAST(dst, src0, src1, src2, i, count) \
+	do { \
+		while (i + 1 < count) { \
+			SCALE2X_PIXEL(dst + 2*i, src0[i], src1[i-1], src1[i], src1[i+1], src2[i]); \
+			++i; \
+		} \
+		SCALE2X_PIXEL(dst + 2*i, src0[i], src1[i-1], src1[i], src1[i], src2[i]); \
+	} while (0)
+
+/*
+ * Define the border functions for a pixel size.
+ * The border function computes a single row of the output, the upper one
+ * if called with src0, src1, src2, and the lower one if called with
+ * src2, src1, src0.
+ */
+#define SCALE2X_BORDER(bit, cmpeq, cmpeq256, unpacklo, unpacklo256, unpackhi, unpackhi256) \
+static inline void scale2x_##bit##_sse2_border(scale2x_uint##bit* restrict dst, const scale2x_uint##bit* restrict src0, const scale2x_uint##bit* restrict src1, const scale2x_uint##bit* restrict src2, unsigned count) \
+{ \
+	unsigned i = 1; \
+	assert(count >= 2); \
+	SCALE2X_FIRST(dst, src0, src1, src2); \
+	SCALE2X_SSE2_CENTER(scale2x_uint##bit, dst, src0, src1, src2, i, count, cmpeq, unpacklo, unpackhi); \
+	SCALE2X_LAST(dst, src0, src1, src2, i, count); \
+} \
+static inline __attribute__((target("avx2"))) void scale2x_##bit##_avx2_border(scale2x_uint##bit* restrict dst, const scale2x_uint##bit* restrict src0, const scale2x_uint##bit* restrict src1, const scale2x_uint##bit* restrict src2, unsigned count) \
+{ \
+	unsigned i = 1; \
+	assert(count >= 2); \
+	SCALE2X_FIRST(dst, src0, src1, src2); \
+	SCALE2X_AVX2_CENTER(scale2x_uint##bit, dst, src0, src1, src2, i, count, cmpeq256, unpacklo256, unpackhi256); \
+	SCALE2X_SSE2_CENTER(scale2x_uint##bit, dst, src0, src1, src2, i, count, cmpeq, unpacklo, unpackhi); \
+	SCALE2X_LAST(dst, src0, src1, src2, i, count); \
+}
+
+SCALE2X_BORDER(8, _mm_cmpeq_epi8, _mm256_cmpeq_epi8, _mm_unpacklo_epi8, _mm256_unpacklo_epi8, _mm_unpackhi_epi8, _mm256_unpackhi_epi8)
+SCALE2X_BORDER(16, _mm_cmpeq_epi16, _mm256_cmpeq_epi16, _mm_unpacklo_epi16, _mm256_unpacklo_epi16, _mm_unpackhi_epi16, _mm256_unpackhi_epi16)
+SCALE2X_BORDER(32, _mm_cmpeq_epi32, _mm256_cmpeq_epi32, _mm_unpacklo_epi32, _mm256_unpacklo_epi32, _mm_unpackhi_epi32, _mm256_unpackhi_epi32)
+
+/*
+ * Define the public functions for a pixel size and an instruction set.
+ * The central rows of the 2x3 and 2x4 versions are a plain copy of the
+ * source pixels, and they are left at the C implementation.
+ */
+#define SCALE2X_FUNCTIONS(bit, set, attribute) \
+attribute void scale2x_##bit##_##set(scale2x_uint##bit* dst0, scale2x_uint##bit* dst1, const scale2x_uint##bit* src0, const scale2x_uint##bit* src1, const scale2x_uint##bit* src2, unsigned count) \
+{ \
+	scale2x_##bit##_##set##_border(dst0, src0, src1, src2, count); \
+	scale2x_##bit##_##set##_border(dst1, src2, src1, src0, count); \
+} \
+attribute void scale2x3_##bit##_##set(scale2x_uint##bit* dst0, scale2x_uint##bit* dst1, scale2x_uint##bit* dst2, const scale2x_uint##bit* src0, const scale2x_uint##bit* src1, const scale2x_uint##bit* src2, unsigned count) \
+{ \
+	scale2x_##bit##_##set##_border(dst0, src0, src1, src2, count); \
+	scale2x_##bit##_def_center(dst1, src0, src1, src2, count); \
+	scale2x_##bit##_##set##_border(dst2, src2, src1, src0, count); \
+} \
+attribute void scale2x4_##bit##_##set(scale2x_uint##bit* dst0, scale2x_uint##bit* dst1, scale2x_uint##bit* dst2, scale2x_uint##bit* dst3, const scale2x_uint##bit* src0, const scale2x_uint##bit* src1, const scale2x_uint##bit* src2, unsigned count) \
+{ \
+	scale2x_##bit##_##set##_border(dst0, src0, src1, src2, count); \
+	scale2x_##bit##_def_center(dst1, src0, src1, src2, count); \
+	scale2x_##bit##_def_center(dst2, src0, src1, src2, count); \
+	scale2x_##bit##_##set##_border(dst3, src2, src1, src0, count); \
+}
+
+SCALE2X_FUNCTIONS(8, sse2, )
+SCALE2X_FUNCTIONS(16, sse2, )
+SCALE2X_FUNCTIONS(32, sse2, )
+SCALE2X_FUNCTIONS(8, avx2, __attribute__((target("avx2"))))
+SCALE2X_FUNCTIONS(16, avx2, __attribute__((target("avx2"))))
+SCALE2X_FUNCTIONS(32, avx2, __attribute__((target("avx2"))))
+
+#endif
+
@@ -709,3 +709,221 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 #endif
 }
 
+
+/***************************************************************************/
+/* Scale3x SSE2 implementation */
+
+#if defined(USE_BLIT_SSE2)
+
+#include <immintrin.h>
+
+/*
+ * Scale3x of a single pixel of a border row.
+ * Used for the first and last pixels, and for the pixels not filling a
+ * whole vector register.
+ *
+ *     ABC
+ *     DEF
+ *     GHI
+ */
+#define SCALE3X_BORDER_PIXEL(dst, A, B, C, D, E, F, H) \
+	do { \
+		if (B != H && D != F) { \
+			(dst)[0] = D == B ? D : E; \
+			(dst)[1] = (D == B && E != C) || (F == B && E != A) ? B : E; \
+			(dst)[2] = F == B ? F : E; \
+		} else { \
+			(dst)[0] = E; \
+			(dst)[1] = E; \
+			(dst)[2] = E; \
+		} \
+	} while (0)
+
+/*
+ * Scale3x of a single pixel of the center row.
+ */
+#define SCALE3X_CENTER_PIXEL(dst, A, B, C, D, E, F, G, H, I) \
+	do { \
+		if (B != H && D != F) { \
+			(dst)[0] = (D == B && E != G) || (D == H && E != A) ? D : E; \
+			(dst)[1] = E; \
+			(dst)[2] = (F == B && E != I) || (F == H && E != C) ? F : E; \
+		} else { \
+			(dst)[0] = E; \
+			(dst)[1] = E; \
+			(dst)[2] = E; \
+		} \
+	} while (0)
+
+/*
+ * Interleave three registers of 32 bits pixels.
+ * The output is x0 y0 z0 x1, y1 z1 x2 y2, z2 x3 y3 z3.
+ */
+static inline void scale3x_interleave_32(__m128i* r0, __m128i* r1, __m128i* r2, __m128i x, __m128i y, __m128i z)
+{
+	__m128 X = _mm_castsi128_ps(x);
+	__m128 Y = _mm_castsi128_ps(y);
+	__m128 Z = _mm_castsi128_ps(z);
+	__m128 xy_lo = _mm_castsi128_ps(_mm_unpacklo_epi32(x, y));
+	__m128 xy_hi = _mm_castsi128_ps(_mm_unpackhi_epi32(x, y));
+
+	*r0 = _mm_castps_si128(_mm_shuffle_ps(xy_lo, _mm_shuffle_ps(Z, X, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+	*r1 = _mm_castps_si128(_mm_shuffle_ps(_mm_shuffle_ps(Y, Z, _MM_SHUFFLE(1, 1, 1, 1)), xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+	*r2 = _mm_castps_si128(_mm_shuffle_ps(_mm_shuffle_ps(Z, X, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(Y, Z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+/*
+ * Interleave three registers of 16 bits pixels.
+ * The pixels are sign extended at 32 bits, interleaved, and packed
+ * back, the sign extension avoids the saturation of the pack.
+ */
+static inline void scale3x_interleave_16(__m128i* r0, __m128i* r1, __m128i* r2, __m128i x, __m128i y, __m128i z)
+{
+	__m128i l0, l1, l2, h0, h1, h2;
+
+	scale3x_interleave_32(&l0, &l1, &l2,
+		_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16),
+		_mm_srai_epi32(_mm_unpacklo_epi16(y, y), 16),
+		_mm_srai_epi32(_mm_unpacklo_epi16(z, z), 16));
+	scale3x_interleave_32(&h0, &h1, &h2,
+		_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16),
+		_mm_srai_epi32(_mm_unpackhi_epi16(y, y), 16),
+		_mm_srai_epi32(_mm_unpackhi_epi16(z, z), 16));
+
+	*r0 = _mm_packs_epi32(l0, l1);
+	*r1 = _mm_packs_epi32(l2, h0);
+	*r2 = _mm_packs_epi32(h1, h2);
+}
+
+/*
+ * Interleave three registers of 8 bits pixels.
+ * Like scale3x_interleave_16() but from 8 to 16 bits.
+ */
+static inline void scale3x_interleave_8(__m128i* r0, __m128i* r1, __m128i* r2, __m128i x, __m128i y, __m128i z)
+{
+	__m128i l0, l1, l2, h0, h1, h2;
+
+	scale3x_interleave_16(&l0, &l1, &l2,
+		_mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8),
+		_mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8),
+		_mm_srai_epi16(_mm_unpacklo_epi8(z, z), 8));
+	scale3x_interleave_16(&h0, &h1, &h2,
+		_mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8),
+		_mm_srai_epi16(_mm_unpackhi_epi8(y, y), 8),
+		_mm_srai_epi16(_mm_unpackhi_epi8(z, z), 8));
+
+	*r0 = _mm_packs_epi16(l0, l1);
+	*r1 = _mm_packs_epi16(l2, h0);
+	*r2 = _mm_packs_epi16(h1, h2);
+}
+
+/*
+ * Select the pixels of a where the mask is set, and the ones of b elsewhere.
+ */
+#define SCALE3X_SELECT(mask, a, b) \
+	_mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+
+/*
+ * Process the central pixels of a row with SSE2, 16 bytes at time.
+ * It returns the index of the first pixel not processed.
+ * Unaligned loads are used to get the left and right pixels, so there
+ * is no requirement on the alignment and on the size of the row.
+ * The border rows select the B pixel, equal at the D or F pixel selected
+ * by the C implementation.
+ */
+#define SCALE3X_SSE2_BORDER(type, dst, src0, src1, src2, i, count, cmpeq, interleave) \
+	do { \
+		const unsigned n = 16 / sizeof(type); \
+		while (i + n < count) { \
+			__m128i A = _mm_loadu_si128((const __m128i*)(src0 + i - 1)); \
+			__m128i B = _mm_loadu_si128((const __m128i*)(src0 + i)); \
+			__m128i C = _mm_loadu_si128((const __m128i*)(src0 + i + 1)); \
+			__m128i D = _mm_loadu_si128((const __m128i*)(src1 + i - 1)); \
+			__m128i E = _mm_loadu_si128((const __m128i*)(src1 + i)); \
+			__m128i F = _mm_loadu_si128((const __m128i*)(src1 + i + 1)); \
+			__m128i H = _mm_loadu_si128((const __m128i*)(src2 + i)); \
+			__m128i skip = _mm_or_si128(cmpeq(B, H), cmpeq(D, F)); \
+			__m128i DB = cmpeq(D, B); \
+			__m128i FB = cmpeq(F, B); \
+			__m128i m0 = _mm_andnot_si128(skip, DB); \
+			__m128i m1 = _mm_andnot_si128(skip, _mm_or_si128(_mm_andnot_si128(cmpeq(E, C), DB), _mm_andnot_si128(cmpeq(E, A), FB))); \
+			__m128i m2 = _mm_andnot_si128(skip, FB); \
+			__m128i r0, r1, r2; \
+			interleave(&r0, &r1, &r2, SCALE3X_SELECT(m0, B, E), SCALE3X_SELECT(m1, B, E), SCALE3X_SELECT(m2, B, E)); \
+			_mm_storeu_si128((__m128i*)(dst + 3*i), r0); \
+			_mm_storeu_si128((__m128i*)(dst + 3*i + n), r1); \
+			_mm_storeu_si128((__m128i*)(dst + 3*i + 2*n), r2); \
+			i += n; \
+		} \
+	} while (0)
+
+#define SCALE3X_SSE2_CENTER(type, dst, src0, src1, src2, i, count, cmpeq, interleave) \
+	do { \
+		const unsigned n = 16 / sizeof(type); \
+		while (i + n < count) { \
+			__m128i A = _mm_loadu_si128((const __m128i*)(src0 + i - 1)); \
+			__m128i B = _mm_loadu_si128((const __m128i*)(src0 + i)); \
+			__m128i C = _mm_loadu_si128((const __m128i*)(src0 + i + 1)); \
+			__m128i D = _mm_loadu_si128((const __m128i*)(src1 + i - 1)); \
+			__m128i E = _mm_loadu_si128((const __m128i*)(src1 + i)); \
+			__m128i F = _mm_loadu_si128((const __m128i*)(src1 + i + 1)); \
+			__m128i G = _mm_loadu_si128((const __m128i*)(src2 + i - 1)); \
+			__m128i H = _mm_loadu_si128((const __m128i*)(src2 + i)); \
+			__m128i I = _mm_loadu_si128((const __m128i*)(src2 + i + 1)); \
+			__m128i skip = _mm_or_si128(cmpeq(B, H), cmpeq(D, F)); \
+			__m128i m0 = _mm_andnot_si128(skip, _mm_or_si128(_mm_andnot_si128(cmpeq(E, G), cmpeq(D, B)), _mm_andnot_si128(cmpeq(E, A), cmpeq(D, H)))); \
+			__m128i m2 = _mm_andnot_si128(skip, _mm_or_si128(_mm_andnot_si128(cmpeq(E, I), cmpeq(F, B)), _mm_andnot_si128(cmpeq(E, C), cmpeq(F, H)))); \
+			__m128i r0, r1, r2; \
+			interleave(&r0, &r1, &r2, SCALE3X_SELECT(m0, D, E), E, SCALE3X_SELECT(m2, F, E)); \
+			_mm_storeu_si128((__m128i*)(dst + 3*i), r0); \
+			_mm_storeu_si128((__m128i*)(dst + 3*i + n), r1); \
+			_mm_storeu_si128((__m128i*)(dst + 3*i + 2*n), r2); \
+			i += n; \
+		} \
+	} while (0)
+
+/*
+ * Define the row functions for a pixel size.
+ * The border function computes the upper row of the output if called with
+ * src0, src1, src2, and the lower one if called with src2, src1, src0.
+ * The pixels over the left and right borders are of the same color of the
+ * pixels on the border.
+ */
+#define SCALE3X_ROWS(bit, cmpeq) \
+static inline void scale3x_##bit##_sse2_border(scale3x_uint##bit* restrict dst, const scale3x_uint##bit* restrict src0, const scale3x_uint##bit* restrict src1, const scale3x_uint##bit* restrict src2, unsigned count) \
+{ \
+	unsigned i = 1; \
+	assert(count >= 2); \
+	SCALE3X_BORDER_PIXEL(dst, src0[0], src0[0], src0[1], src1[0], src1[0], src1[1], src2[0]); \
+	SCALE3X_SSE2_BORDER(scale3x_uint##bit, dst, src0, src1, src2, i, count, cmpeq, scale3x_interleave_##bit); \
+	while (i + 1 < count) { \
+		SCALE3X_BORDER_PIXEL(dst + 3*i, src0[i-1], src0[i], src0[i+1], src1[i-1], src1[i], src1[i+1], src2[i]); \
+		++i; \
+	} \
+	SCALE3X_BORDER_PIXEL(dst + 3*i, src0[i-1], src0[i], src0[i], src1[i-1], src1[i], src1[i], src2[i]); \
+} \
+static inline void scale3x_##bit##_sse2_center(scale3x_uint##bit* restrict dst, const scale3x_uint##bit* restrict src0, const scale3x_uint##bit* restrict src1, const scale3x_uint##bit* restrict src2, unsigned count) \
+{ \
+	unsigned i = 1; \
+	assert(count >= 2); \
+	SCALE3X_CENTER_PIXEL(dst, src0[0], src0[0], src0[1], src1[0], src1[0], src1[1], src2[0], src2[0], src2[1]); \
+	SCALE3X_SSE2_CENTER(scale3x_uint##bit, dst, src0, src1, src2, i, count, cmpeq, scale3x_interleave_##bit); \
+	while (i + 1 < count) { \
+		SCALE3X_CENTER_PIXEL(dst + 3*i, src0[i-1], src0[i], src0[i+1], src1[i-1], src1[i], src1[i+1], src2[i-1], src2[i], src2[i+1]); \
+		++i; \
+	} \
+	SCALE3X_CENTER_PIXEL(dst + 3*i, src0[i-1], src0[i], src0[i], src1[i-1], src1[i], src1[i], src2[i-1], src2[i], src2[i]); \
+} \
+void scale3x_##bit##_sse2(scale3x_uint##bit* dst0, scale3x_uint##bit* dst1, scale3x_uint##bit* dst2, const scale3x_uint##bit* src0, const scale3x_uint##bit* src1, const scale3x_uint##bit* src2, unsigned count) \
+{ \
+	scale3x_##bit##_sse2_border(dst0, src0, src1, src2, count); \
+	scale3x_##bit##_sse2_center(dst1, src0, src1, src2, count); \
+	scale3x_##bit##_sse2_border(dst2, src2, src1, src0, count); \
+}
+
+SCALE3X_ROWS(8, _mm_cmpeq_epi8)
+SCALE3X_ROWS(16, _mm_cmpeq_epi16)
+SCALE3X_ROWS(32, _mm_cmpeq_epi32)
+
+#endif
+
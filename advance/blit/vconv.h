@@ -69,10 +69,17 @@ static void video_line_bgra8888tobgr565_step4_def(const struct video_stage_horz_
 	internal_convbgra8888tobgr565_def(dst, src, count);
 }
 
+#if defined(USE_BLIT_SSE2)
+static void video_line_bgra8888tobgr565_step4_sse2(const struct video_stage_horz_struct* stage, unsigned line, void* dst, const void* src, unsigned count)
+{
+	internal_convbgra8888tobgr565_sse2(dst, src, count);
+}
+#endif
+
 static void video_stage_bgra8888tobgr565_set(struct video_stage_horz_struct* stage, unsigned sdx, int sdp)
 {
 	STAGE_SIZE(stage, pipe_bgra8888tobgr565, sdx, sdp, 4, sdx, 2);
-	STAGE_PUT(stage, BLITTER(video_line_bgra8888tobgr565_step4), 0);
+	STAGE_PUT(stage, BLITTER_SSE2(video_line_bgra8888tobgr565_step4), 0);
 }
 
 /****************************************************************************/
@@ -90,10 +97,17 @@ static void video_line_bgra8888tobgra5551_step4_def(const struct video_stage_hor
 	internal_convbgra8888tobgra5551_def(dst, src, count);
 }
 
+#if defined(USE_BLIT_SSE2)
+static void video_line_bgra8888tobgra5551_step4_sse2(const struct video_stage_horz_struct* stage, unsigned line, void* dst, const void* src, unsigned count)
+{
+	internal_convbgra8888tobgra5551_sse2(dst, src, count);
+}
+#endif
+
 static void video_stage_bgra8888tobgra5551_set(struct video_stage_horz_struct* stage, unsigned sdx, int sdp)
 {
 	STAGE_SIZE(stage, pipe_bgra8888tobgra5551, sdx, sdp, 4, sdx, 2);
-	STAGE_PUT(stage, BLITTER(video_line_bgra8888tobgra5551_step4), 0);
+	STAGE_PUT(stage, BLITTER_SSE2(video_line_bgra8888tobgra5551_step4), 0);
 }
 
 /****************************************************************************/
@@ -132,10 +146,17 @@ static void video_line_bgra5551tobgr565_step2_def(const struct video_stage_horz_
 	internal_convbgra5551tobgr565_def(dst, src, count);
 }
 
+#if defined(USE_BLIT_SSE2)
+static void video_line_bgra5551tobgr565_step2_sse2(const struct video_stage_horz_struct* stage, unsigned line, void* dst, const void* src, unsigned count)
+{
+	internal_convbgra5551tobgr565_sse2(dst, src, count);
+}
+#endif
+
 static void video_stage_bgra5551tobgr565_set(struct video_stage_horz_struct* stage, unsigned sdx, int sdp)
 {
 	STAGE_SIZE(stage, pipe_bgra5551tobgr565, sdx, sdp, 2, sdx, 2);
-	STAGE_PUT(stage, BLITTER(video_line_bgra5551tobgr565_step2), 0);
+	STAGE_PUT(stage, BLITTER_SSE2(video_line_bgra5551tobgr565_step2), 0);
 }
 
 /****************************************************************************/
@@ -153,10 +174,17 @@ static void video_line_bgra5551tobgra8888_step2_def(const struct video_stage_hor
 	internal_convbgra5551tobgra8888_def(dst, src, count);
 }
 
+#if defined(USE_BLIT_SSE2)
+static void video_line_bgra5551tobgra8888_step2_sse2(const struct video_stage_horz_struct* stage, unsigned line, void* dst, const void* src, unsigned count)
+{
+	internal_convbgra5551tobgra8888_sse2(dst, src, count);
+}
+#endif
+
 static void video_stage_bgra5551tobgra8888_set(struct video_stage_horz_struct* stage, unsigned sdx, int sdp)
 {
 	STAGE_SIZE(stage, pipe_bgra5551tobgra8888, sdx, sdp, 2, sdx, 4);
-	STAGE_PUT(stage, BLITTER(video_line_bgra5551tobgra8888_step2), 0);
+	STAGE_PUT(stage, BLITTER_SSE2(video_line_bgra5551tobgra8888_step2), 0);
 }
 
 /****************************************************************************/
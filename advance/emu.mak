@@ -46,8 +46,11 @@ ADVANCEOBJS += \
 ifeq ($(CONF_LIB_PTHREAD),yes)
 CFLAGS += -D_REENTRANT
 ADVANCECFLAGS += -DUSE_SMP
+EMUDEFS += -DMAME_THREADS
 ADVANCELIBS += -lpthread
-ADVANCEOBJS += $(OBJ)/advance/osd/thdouble.o
+ADVANCEOBJS += $(OBJ)/advance/osd/thsteal.o
+EMUCHDMANOBJS += $(OBJ)/advance/osd/thsteal.o
+EMUCHDMANLDFLAGS += -lpthread
 else
 ADVANCEOBJS += $(OBJ)/advance/osd/thmono.o
 endif
@@ -278,9 +281,12 @@ ADVANCEOBJS += \
 ifeq ($(CONF_LIB_PTHREAD),yes)
 CFLAGS += -D_REENTRANT
 ADVANCECFLAGS += -DUSE_SMP
+EMUDEFS += -DMAME_THREADS
 # pthread-win32 library without exceptions management
 ADVANCELIBS += -lpthread
-ADVANCEOBJS += $(OBJ)/advance/osd/thdouble.o
+ADVANCEOBJS += $(OBJ)/advance/osd/thsteal.o
+EMUCHDMANOBJS += $(OBJ)/advance/osd/thsteal.o
+EMUCHDMANLDFLAGS += -lpthread
 else
 ADVANCEOBJS += $(OBJ)/advance/osd/thmono.o
 endif
@@ -445,6 +451,8 @@ ADVANCEOBJS += \
 	$(OBJ)/advance/osd/script.o \
 	$(OBJ)/advance/osd/hscript.o \
 	$(OBJ)/advance/osd/safequit.o \
+	$(OBJ)/advance/osd/rewind.o \
+	$(OBJ)/advance/osd/profile.o \
 	$(OBJ)/advance/osd/fileio.o \
 	$(OBJ)/advance/osd/fuzzy.o \
 	$(OBJ)/advance/blit/blit.o \
@@ -473,6 +481,7 @@ ADVANCEOBJS += \
 	$(OBJ)/advance/lib/conf.o \
 	$(OBJ)/advance/lib/incstr.o \
 	$(OBJ)/advance/lib/fz.o \
+	$(OBJ)/advance/lib/hcache.o \
 	$(OBJ)/advance/lib/font.o \
 	$(OBJ)/advance/lib/fontdef.o \
 	$(OBJ)/advance/lib/bitmap.o \
@@ -509,6 +518,7 @@ ADVANCEOBJS += \
 	$(OBJ)/advance/lib/wave.o
 
 EMUCHDMANOBJS += \
+	$(OBJ)/advance/osd/tool.o \
 	$(OBJ)/chdman.o \
 	$(OBJ)/chd.o \
 	$(OBJ)/cdrom.o \
@@ -687,6 +697,16 @@ DBGOBJS =
 MESSDBGOBJS =
 endif
 
+# defined also for the OSD, which exports the profiler results
+ifeq ($(CONF_PROFILER),yes)
+EMUCFLAGS += -DMAME_PROFILER
+endif
+
+# the profiler is used by both the debugger and the profiler builds
+ifneq (,$(filter yes,$(CONF_DEBUGGER) $(CONF_PROFILER)))
+COREOBJS += $(OBJ)/profiler.o
+endif
+
 MAMECFLAGS += \
 	$(EMUCFLAGS) \
 	-I$(srcdir)/src \
@@ -724,6 +744,14 @@ $(OBJ)/chdman$(EXE): $(EMUCHDMANOBJS) $(EMUCHDMANLIBS)
 	$(ECHO) $@ $(MSG)
 	$(LD) $(EMUCHDMANOBJS) $(EMUCHDMANLDFLAGS) $(LDFLAGS) $(EMUCHDMANLIBS) $(LIBS) -o $@
 
+# checks the order of the timer queue against the old sorted list
+$(OBJ)/timertst$(EXE): $(OBJ)/timertst.o
+	$(ECHO) $@ $(MSG)
+	$(LD) $(OBJ)/timertst.o $(LDFLAGS) $(LIBS) -o $@
+
+check: $(OBJ)/timertst$(EXE)
+	$(OBJ)/timertst$(EXE)
+
 $(OBJ)/%.o: $(srcdir)/src/%.c
 	$(ECHO) $@ $(MSG)
 	$(CC) $(CFLAGS) $(MAMECFLAGS) $(MAMEDEFS) -c $< -o $@
@@ -832,6 +860,7 @@ EMU_ADVANCE_SRC = \
 	$(srcdir)/advance/k.mak \
 	$(srcdir)/advance/s.mak \
 	$(srcdir)/advance/i.mak \
+	$(srcdir)/advance/b.mak \
 	$(srcdir)/advance/j.mak \
 	$(srcdir)/advance/m.mak \
 	$(srcdir)/advance/line.mak \
@@ -1124,6 +1153,8 @@ dist: $(DOCOBJ)/readme.txt $(DOCOBJ)/release.txt $(DOCOBJ)/history.txt $(DOCOBJ)
 	cp $(S_SRC) $(EMU_DIST_DIR_SRC)/advance/s
 	mkdir $(EMU_DIST_DIR_SRC)/advance/i
 	cp $(I_SRC) $(EMU_DIST_DIR_SRC)/advance/i
+	mkdir $(EMU_DIST_DIR_SRC)/advance/b
+	cp $(B_SRC) $(EMU_DIST_DIR_SRC)/advance/b
 	mkdir $(EMU_DIST_DIR_SRC)/advance/cfg
 	cp $(CFG_SRC) $(EMU_DIST_DIR_SRC)/advance/cfg
 	mkdir $(EMU_DIST_DIR_SRC)/advance/menu
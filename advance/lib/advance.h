@@ -98,6 +98,7 @@
 #include "fz.h"
 #include "generate.h"
 #include "gtf.h"
+#include "hcache.h"
 #include "icon.h"
 #include "incstr.h"
 #include "inone.h"
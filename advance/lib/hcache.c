@@ -0,0 +1,380 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2005 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "portable.h"
+
+#include "hcache.h"
+#include "file.h"
+#include "log.h"
+
+/** Number of buckets allocated at the start. */
+#define HCACHE_BUCKET_MIN 1024
+
+/** Max length of a row of the cache file. */
+#define HCACHE_ROW_MAX 4096
+
+static unsigned hcache_hash(const char* path, const char* entry)
+{
+	unsigned h = 2166136261U;
+
+	while (*path)
+		h = (h ^ (unsigned char)*path++) * 16777619U;
+	h = (h ^ '\t') * 16777619U;
+	while (*entry)
+		h = (h ^ (unsigned char)*entry++) * 16777619U;
+
+	return h;
+}
+
+static struct adv_hcache_item_struct* hcache_find(adv_hcache* context, const char* path, const char* entry)
+{
+	struct adv_hcache_item_struct* i;
+
+	i = context->bucket_map[hcache_hash(path, entry) % context->bucket_max];
+	while (i) {
+		if (strcmp(i->path, path) == 0 && strcmp(i->entry, entry) == 0)
+			return i;
+		i = i->next;
+	}
+
+	return 0;
+}
+
+/**
+ * Double the number of buckets if the table is too much filled.
+ */
+static void hcache_grow(adv_hcache* context)
+{
+	struct adv_hcache_item_struct** map;
+	unsigned max;
+	unsigned j;
+
+	if (context->count < context->bucket_max)
+		return;
+
+	max = context->bucket_max * 2;
+	map = calloc(max, sizeof(struct adv_hcache_item_struct*));
+	if (!map)
+		return;
+
+	for(j=0;j<context->bucket_max;++j) {
+		struct adv_hcache_item_struct* i = context->bucket_map[j];
+		while (i) {
+			struct adv_hcache_item_struct* next = i->next;
+			unsigned pos = hcache_hash(i->path, i->entry) % max;
+			i->next = map[pos];
+			map[pos] = i;
+			i = next;
+		}
+	}
+
+	free(context->bucket_map);
+	context->bucket_map = map;
+	context->bucket_max = max;
+}
+
+static void hcache_insert(adv_hcache* context, const char* path, const char* entry, unsigned long long size, long long mtime, const char* hash)
+{
+	struct adv_hcache_item_struct* i;
+	char* dup;
+
+	i = hcache_find(context, path, entry);
+	if (i) {
+		dup = strdup(hash);
+		if (!dup)
+			return;
+		free(i->hash);
+		i->hash = dup;
+		i->size = size;
+		i->mtime = mtime;
+		return;
+	}
+
+	i = malloc(sizeof(struct adv_hcache_item_struct));
+	if (!i)
+		return;
+
+	i->path = strdup(path);
+	i->entry = strdup(entry);
+	i->hash = strdup(hash);
+	if (!i->path || !i->entry || !i->hash) {
+		free(i->path);
+		free(i->entry);
+		free(i->hash);
+		free(i);
+		return;
+	}
+	i->size = size;
+	i->mtime = mtime;
+
+	hcache_grow(context);
+
+	i->next = context->bucket_map[hcache_hash(path, entry) % context->bucket_max];
+	context->bucket_map[hcache_hash(path, entry) % context->bucket_max] = i;
+	++context->count;
+}
+
+/**
+ * Split the next tab separated field of a row.
+ */
+static char* hcache_field(char** s)
+{
+	char* field = *s;
+	char* end;
+
+	if (!field)
+		return 0;
+
+	end = strchr(field, '\t');
+	if (end) {
+		*end = 0;
+		*s = end + 1;
+	} else {
+		*s = 0;
+	}
+
+	return field;
+}
+
+static void hcache_load(adv_hcache* context)
+{
+	char row[HCACHE_ROW_MAX];
+	FILE* f;
+
+	f = fopen(context->file, "rt");
+	if (!f) {
+		log_std(("hcache: no cache file %s\n", context->file));
+		return;
+	}
+
+	while (fgets(row, sizeof(row), f)) {
+		char* s = row;
+		char* hash;
+		char* size;
+		char* mtime;
+		char* path;
+		char* entry;
+		char* end;
+
+		if (row[0] == '#')
+			continue;
+
+		end = strpbrk(row, "\r\n");
+		if (!end)
+			continue; /* row too long */
+		*end = 0;
+
+		hash = hcache_field(&s);
+		size = hcache_field(&s);
+		mtime = hcache_field(&s);
+		path = hcache_field(&s);
+		entry = hcache_field(&s);
+		if (!entry || s)
+			continue; /* invalid row */
+
+		hcache_insert(context, path, entry, strtoull(size, 0, 10), strtoll(mtime, 0, 10), hash);
+	}
+
+	fclose(f);
+
+	log_std(("hcache: loaded %u checksums from %s\n", context->count, context->file));
+}
+
+/**
+ * Get the size and the modification time of a file.
+ */
+static adv_error hcache_stat(const char* path, unsigned long long* size, long long* mtime)
+{
+	struct stat st;
+
+	if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+		return -1;
+
+	*size = st.st_size;
+	*mtime = st.st_mtime;
+
+	return 0;
+}
+
+/**
+ * Allocate a checksum cache and load it from a file.
+ * If the file doesn't exist the cache is empty.
+ * \param file File used to load and save the cache.
+ * \return The cache or 0 on error.
+ */
+adv_hcache* hcache_alloc(const char* file)
+{
+	adv_hcache* context;
+
+	context = malloc(sizeof(adv_hcache));
+	if (!context)
+		return 0;
+
+	context->file = strdup(file);
+	context->bucket_max = HCACHE_BUCKET_MIN;
+	context->bucket_map = calloc(context->bucket_max, sizeof(struct adv_hcache_item_struct*));
+	context->count = 0;
+	context->modified_flag = 0;
+
+	if (!context->file || !context->bucket_map) {
+		free(context->file);
+		free(context->bucket_map);
+		free(context);
+		return 0;
+	}
+
+	hcache_load(context);
+
+	return context;
+}
+
+/**
+ * Free the checksum cache.
+ * The cache isn't saved, use hcache_save() before.
+ */
+void hcache_free(adv_hcache* context)
+{
+	unsigned j;
+
+	for(j=0;j<context->bucket_max;++j) {
+		struct adv_hcache_item_struct* i = context->bucket_map[j];
+		while (i) {
+			struct adv_hcache_item_struct* next = i->next;
+			free(i->path);
+			free(i->entry);
+			free(i->hash);
+			free(i);
+			i = next;
+		}
+	}
+
+	free(context->bucket_map);
+	free(context->file);
+	free(context);
+}
+
+/**
+ * Save the checksum cache if modified.
+ * The file is written with a different name and then renamed, so a
+ * concurrent reader always sees a complete file.
+ */
+adv_error hcache_save(adv_hcache* context)
+{
+	char tmp[FILE_MAXPATH];
+	unsigned j;
+	FILE* f;
+
+	if (!context->modified_flag)
+		return 0;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", context->file);
+
+	f = fopen(tmp, "wt");
+	if (!f) {
+		log_std(("ERROR:hcache: error creating %s\n", tmp));
+		return -1;
+	}
+
+	fprintf(f, "# Checksum cache. Fields: checksum, size, mtime, path, entry\n");
+
+	for(j=0;j<context->bucket_max;++j) {
+		struct adv_hcache_item_struct* i;
+		for(i=context->bucket_map[j];i;i=i->next)
+			fprintf(f, "%s\t%llu\t%lld\t%s\t%s\n", i->hash, i->size, i->mtime, i->path, i->entry);
+	}
+
+	if (fclose(f) != 0) {
+		log_std(("ERROR:hcache: error writing %s\n", tmp));
+		remove(tmp);
+		return -1;
+	}
+
+	/* on some systems the rename doesn't overwrite an existing file */
+	if (rename(tmp, context->file) != 0) {
+		remove(context->file);
+		if (rename(tmp, context->file) != 0) {
+			log_std(("ERROR:hcache: error renaming %s\n", tmp));
+			remove(tmp);
+			return -1;
+		}
+	}
+
+	context->modified_flag = 0;
+
+	log_std(("hcache: saved %u checksums in %s\n", context->count, context->file));
+
+	return 0;
+}
+
+/**
+ * Get the checksums of a file.
+ * \param path Path of the file.
+ * \param entry Entry in the archive, or 0 for a plain file.
+ * \return The checksums or 0 if missing or if the file was changed.
+ */
+const char* hcache_get(adv_hcache* context, const char* path, const char* entry)
+{
+	struct adv_hcache_item_struct* i;
+	unsigned long long size;
+	long long mtime;
+
+	if (!entry)
+		entry = "";
+
+	i = hcache_find(context, path, entry);
+	if (!i)
+		return 0;
+
+	if (hcache_stat(path, &size, &mtime) != 0)
+		return 0;
+
+	if (i->size != size || i->mtime != mtime)
+		return 0;
+
+	return i->hash;
+}
+
+/**
+ * Set the checksums of a file.
+ * \param path Path of the file.
+ * \param entry Entry in the archive, or 0 for a plain file.
+ * \param hash Checksums.
+ */
+adv_error hcache_set(adv_hcache* context, const char* path, const char* entry, const char* hash)
+{
+	unsigned long long size;
+	long long mtime;
+
+	if (!entry)
+		entry = "";
+
+	/* the names are stored in a tab separated row */
+	if (strpbrk(path, "\t\r\n") || strpbrk(entry, "\t\r\n") || strpbrk(hash, "\t\r\n"))
+		return -1;
+
+	if (hcache_stat(path, &size, &mtime) != 0)
+		return -1;
+
+	hcache_insert(context, path, entry, size, mtime, hash);
+	context->modified_flag = 1;
+
+	return 0;
+}
+
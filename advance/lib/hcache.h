@@ -0,0 +1,87 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2005 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/** \file
+ * Checksum cache.
+ *
+ * Persistent cache of the checksums of the files and of the entries of the
+ * archives. An item is identified by the path of the file and by the name of
+ * the entry in the archive, and it's valid until the size and the
+ * modification time of the file don't change.
+ *
+ * The cache is saved as a text file, one item for row, with the fields
+ * separated by a tab:
+ *
+ * "checksum size mtime path entry"
+ *
+ * The checksum is the string used by MAME to store the hash data, like
+ * "c:1234abcd#s:...#". The entry is empty for plain files. The rows
+ * starting with '#' are comments.
+ */
+
+#ifndef __HCACHE_H
+#define __HCACHE_H
+
+#include "extra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup Hash */
+/*@{*/
+
+/**
+ * Item of the checksum cache.
+ */
+struct adv_hcache_item_struct {
+	char* path; /**< Path of the file. */
+	char* entry; /**< Entry in the archive, empty for plain files. */
+	unsigned long long size; /**< Size of the file. */
+	long long mtime; /**< Modification time of the file. */
+	char* hash; /**< Checksums. */
+	struct adv_hcache_item_struct* next; /**< Next item in the same bucket. */
+};
+
+/**
+ * Checksum cache.
+ */
+typedef struct adv_hcache_struct {
+	char* file; /**< File used to store the cache. */
+	struct adv_hcache_item_struct** bucket_map; /**< Hash table of the items. */
+	unsigned bucket_max; /**< Number of buckets. */
+	unsigned count; /**< Number of items. */
+	adv_bool modified_flag; /**< If the cache needs to be saved. */
+} adv_hcache;
+
+adv_hcache* hcache_alloc(const char* file);
+void hcache_free(adv_hcache* context);
+adv_error hcache_save(adv_hcache* context);
+const char* hcache_get(adv_hcache* context, const char* path, const char* entry);
+adv_error hcache_set(adv_hcache* context, const char* path, const char* entry, const char* hash);
+
+/*@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -36,6 +36,8 @@
 #include "endianrw.h"
 #include "error.h"
 
+#include <zlib.h>
+
 /**************************************************************************************/
 /* MNG */
 
@@ -899,6 +901,8 @@ adv_error adv_mng_write_mhdr(
 		| (1 << 6); /* Enable flags */
 	if (is_lc)
 		simplicity |= (1 << 1); /* Basic features */
+	else
+		simplicity |= (1 << 5); /* Delta-PNG */
 
 	memset(mhdr, 0, 28);
 	be_uint32_write(mhdr, pix_width);
@@ -943,3 +947,263 @@ adv_error adv_mng_write_fram(unsigned tick, adv_fz* f, unsigned* count)
 	return 0;
 }
 
+/**
+ * Initialize a MNG writing context.
+ * The context converts the images in delta frames, it must be used
+ * for all the frames of the MNG stream.
+ * \param pix_width Frame width.
+ * \param pix_height Frame height.
+ * \param delta If write the frames as differences from the previous one. If not set the MHDR must be written with is_lc set.
+ * \param fast Use the fast compression for the differences.
+ * \return Return the MNG context. It must be destroied calling adv_mng_write_done(). On error return 0.
+ */
+adv_mng_write* adv_mng_write_init(unsigned pix_width, unsigned pix_height, adv_bool delta, adv_bool fast)
+{
+	adv_mng_write* mng;
+
+	mng = malloc(sizeof(adv_mng_write));
+	if (!mng)
+		return 0;
+
+	mng->delta_flag = delta;
+	mng->fast_flag = fast;
+	mng->pixel = 0;
+	mng->width = pix_width;
+	mng->height = pix_height;
+	mng->line = 0;
+	mng->cur_ptr = 0;
+	mng->prev_ptr = 0;
+	mng->dlt_ptr = 0;
+	mng->z_ptr = 0;
+	mng->z_size = 0;
+	mng->pal_size = 0;
+
+	return mng;
+}
+
+/**
+ * Destroy a MNG writing context.
+ * \param mng MNG context previously returned by adv_mng_write_init().
+ */
+void adv_mng_write_done(adv_mng_write* mng)
+{
+	free(mng->cur_ptr);
+	free(mng->prev_ptr);
+	free(mng->dlt_ptr);
+	free(mng->z_ptr);
+	free(mng);
+}
+
+static adv_error mng_write_alloc(adv_mng_write* mng, unsigned pix_pixel)
+{
+	unsigned size;
+
+	mng->pixel = pix_pixel;
+	mng->line = mng->width * pix_pixel;
+
+	size = mng->height * mng->line;
+	mng->cur_ptr = malloc(size);
+	mng->prev_ptr = malloc(size);
+
+	/* +1 for the filter byte */
+	size = mng->height * (mng->line + 1);
+	mng->dlt_ptr = malloc(size);
+
+	mng->z_size = size * 103 / 100 + 12;
+	mng->z_ptr = malloc(mng->z_size);
+
+	if (!mng->cur_ptr || !mng->prev_ptr || !mng->dlt_ptr || !mng->z_ptr) {
+		error_set("Low memory");
+		return -1;
+	}
+
+	return 0;
+}
+
+static void mng_write_copy(adv_mng_write* mng, const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch)
+{
+	unsigned char* p = mng->cur_ptr;
+	unsigned i, j, k;
+
+	for(i=0;i<mng->height;++i) {
+		if (pix_pixel_pitch == mng->pixel) {
+			memcpy(p, pix_ptr, mng->line);
+			p += mng->line;
+		} else {
+			const unsigned char* s = pix_ptr;
+			for(j=0;j<mng->width;++j) {
+				for(k=0;k<mng->pixel;++k)
+					*p++ = s[k];
+				s += pix_pixel_pitch;
+			}
+		}
+		pix_ptr += pix_scanline_pitch;
+	}
+}
+
+/**
+ * Write the difference from the previous frame.
+ * Only the rectangle containing the changed pixels is written, as
+ * a delta image with addition. If nothing is changed, only the
+ * palette is written, if changed.
+ */
+static adv_error mng_write_delta(adv_mng_write* mng, const unsigned char* pal_ptr, unsigned pal_size, adv_fz* f, unsigned* count)
+{
+	uint8 dhdr[20];
+	unsigned dhdr_size;
+	unsigned x0, x1, y0, y1;
+	unsigned i, j;
+
+	/* changed scanlines */
+	y0 = 0;
+	while (y0 < mng->height && memcmp(mng->cur_ptr + y0 * mng->line, mng->prev_ptr + y0 * mng->line, mng->line) == 0)
+		++y0;
+
+	y1 = mng->height;
+	while (y1 > y0 && memcmp(mng->cur_ptr + (y1 - 1) * mng->line, mng->prev_ptr + (y1 - 1) * mng->line, mng->line) == 0)
+		--y1;
+
+	/* changed columns */
+	x0 = mng->line;
+	x1 = 0;
+	for(i=y0;i<y1;++i) {
+		const unsigned char* c = mng->cur_ptr + i * mng->line;
+		const unsigned char* p = mng->prev_ptr + i * mng->line;
+
+		j = 0;
+		while (j < x0 && c[j] == p[j])
+			++j;
+		x0 = j;
+
+		j = mng->line;
+		while (j > x1 && c[j-1] == p[j-1])
+			--j;
+		x1 = j;
+	}
+
+	be_uint16_write(dhdr + 0, 1); /* object id */
+	dhdr[2] = 1; /* PNG stream without IHDR */
+
+	if (y0 == y1) {
+		dhdr[3] = 7; /* no change */
+		dhdr_size = 4;
+	} else {
+		/* align to pixels */
+		x0 = x0 / mng->pixel;
+		x1 = (x1 + mng->pixel - 1) / mng->pixel;
+
+		dhdr[3] = 1; /* block pixel addition */
+		be_uint32_write(dhdr + 4, x1 - x0);
+		be_uint32_write(dhdr + 8, y1 - y0);
+		be_uint32_write(dhdr + 12, x0);
+		be_uint32_write(dhdr + 16, y0);
+		dhdr_size = 20;
+	}
+
+	if (adv_png_write_chunk(f, ADV_MNG_CN_DHDR, dhdr, dhdr_size, count) != 0)
+		return -1;
+
+	if (pal_size != mng->pal_size || (pal_size != 0 && memcmp(pal_ptr, mng->pal_ptr, pal_size) != 0)) {
+		if (adv_png_write_chunk(f, ADV_PNG_CN_PLTE, pal_ptr, pal_size, count) != 0)
+			return -1;
+	}
+
+	if (y0 != y1) {
+		unsigned run = (x1 - x0) * mng->pixel;
+		unsigned char* d = mng->dlt_ptr;
+		unsigned long z_size;
+
+		for(i=y0;i<y1;++i) {
+			const unsigned char* c = mng->cur_ptr + i * mng->line + x0 * mng->pixel;
+			const unsigned char* p = mng->prev_ptr + i * mng->line + x0 * mng->pixel;
+
+			*d++ = 0; /* filter byte */
+			for(j=0;j<run;++j)
+				*d++ = c[j] - p[j];
+		}
+
+		z_size = mng->z_size;
+		if (compress2(mng->z_ptr, &z_size, mng->dlt_ptr, d - mng->dlt_ptr, mng->fast_flag ? Z_BEST_SPEED : Z_DEFAULT_COMPRESSION) != Z_OK) {
+			error_set("Error compressing data");
+			return -1;
+		}
+
+		if (adv_png_write_chunk(f, ADV_PNG_CN_IDAT, mng->z_ptr, z_size, count) != 0)
+			return -1;
+	}
+
+	if (adv_png_write_iend(f, count) != 0)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Write a MNG image.
+ * The first image is written complete, the others as differences from
+ * the previous one if the context was created with delta enabled.
+ * \param mng MNG context previously returned by adv_mng_write_init().
+ * \param pix_width Image width. It must match the context width.
+ * \param pix_height Image height. It must match the context height.
+ * \param pix_pixel Image bytes per pixel. It must not change between images.
+ * \param pix_ptr Pointer at the start of the image data.
+ * \param pix_pixel_pitch Pitch for the next pixel. It may differ from pix_pixel.
+ * \param pix_scanline_pitch Pitch for the next scanline.
+ * \param pal_ptr Palette data pointer. Use 0 for RGB image.
+ * \param pal_size Palette size in bytes. Use 0 for RGB image.
+ * \param f File to write.
+ * \param count Pointer at the incremental counter of bytes written. Use 0 for disabling it.
+ */
+adv_error adv_mng_write_image(
+	adv_mng_write* mng,
+	unsigned pix_width, unsigned pix_height, unsigned pix_pixel,
+	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	const unsigned char* pal_ptr, unsigned pal_size,
+	adv_fz* f, unsigned* count)
+{
+	unsigned char* t;
+
+	if (pix_width != mng->width || pix_height != mng->height) {
+		error_set("Invalid image size");
+		return -1;
+	}
+
+	if (pal_size > 256*3) {
+		error_set("Invalid palette size");
+		return -1;
+	}
+
+	if (!mng->delta_flag)
+		return adv_png_write_raw(pix_width, pix_height, pix_pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, pal_ptr, pal_size, 0, 0, mng->fast_flag, f, count);
+
+	if (mng->pixel == 0) {
+		if (mng_write_alloc(mng, pix_pixel) != 0)
+			return -1;
+
+		mng_write_copy(mng, pix_ptr, pix_pixel_pitch, pix_scanline_pitch);
+
+		/* the first image is complete */
+		if (adv_png_write_raw(mng->width, mng->height, mng->pixel, mng->cur_ptr, mng->pixel, mng->line, pal_ptr, pal_size, 0, 0, mng->fast_flag, f, count) != 0)
+			return -1;
+	} else {
+		if (pix_pixel != mng->pixel) {
+			error_unsupported_set("Unsupported pixel size change");
+			return -1;
+		}
+
+		mng_write_copy(mng, pix_ptr, pix_pixel_pitch, pix_scanline_pitch);
+
+		if (mng_write_delta(mng, pal_ptr, pal_size, f, count) != 0)
+			return -1;
+	}
+
+	if (pal_size != 0)
+		memcpy(mng->pal_ptr, pal_ptr, pal_size);
+	mng->pal_size = pal_size;
+
+	t = mng->prev_ptr;
+	mng->prev_ptr = mng->cur_ptr;
+	mng->cur_ptr = t;
+
+	return 0;
+}
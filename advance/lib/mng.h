@@ -86,6 +86,27 @@ typedef struct adv_mng_struct {
 	unsigned frame_height; /**< Frame height. */
 } adv_mng;
 
+/**
+ * MNG writing context.
+ */
+typedef struct adv_mng_write_struct {
+	adv_bool delta_flag; /**< Write the frames as differences from the previous one. */
+	adv_bool fast_flag; /**< Use the fast compression for the differences. */
+	unsigned pixel; /**< Bytes per pixel. 0 before the first frame. */
+	unsigned width; /**< Frame width. */
+	unsigned height; /**< Frame height. */
+	unsigned line; /**< Bytes per scanline of the frame buffers. */
+
+	unsigned char* cur_ptr; /**< Current frame. */
+	unsigned char* prev_ptr; /**< Previous frame. */
+	unsigned char* dlt_ptr; /**< Delta buffer. */
+	unsigned char* z_ptr; /**< Compressed delta buffer. */
+	unsigned z_size; /**< Compressed delta buffer size. */
+
+	unsigned char pal_ptr[256*3]; /**< Palette of the previous frame. */
+	unsigned pal_size; /**< Palette size in bytes. */
+} adv_mng_write;
+
 adv_error adv_mng_read_signature(adv_fz* f);
 adv_error adv_mng_write_signature(adv_fz* f, unsigned* count);
 adv_error adv_mng_write_mhdr(
@@ -95,6 +116,15 @@ adv_error adv_mng_write_mhdr(
 );
 adv_error adv_mng_write_mend(adv_fz* f, unsigned* count);
 adv_error adv_mng_write_fram(unsigned tick, adv_fz* f, unsigned* count);
+adv_mng_write* adv_mng_write_init(unsigned pix_width, unsigned pix_height, adv_bool delta, adv_bool fast);
+void adv_mng_write_done(adv_mng_write* mng);
+adv_error adv_mng_write_image(
+	adv_mng_write* mng,
+	unsigned pix_width, unsigned pix_height, unsigned pix_pixel,
+	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	const unsigned char* pal_ptr, unsigned pal_size,
+	adv_fz* f, unsigned* count
+);
 
 /** \addtogroup VideoFile */
 /*@{*/
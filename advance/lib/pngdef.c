@@ -33,6 +33,7 @@
 #include "pngdef.h"
 #include "rgb.h"
 #include "png.h"
+#include "mng.h"
 #include "mode.h"
 #include "endianrw.h"
 
@@ -68,7 +69,26 @@ adv_bool adv_png_color_def_is_valid(adv_color_def def)
 	return def == adv_png_color_def(pixel);
 }
 
+/**
+ * Write an image already in a PNG format, as a PNG or as a MNG frame.
+ * \param mng MNG context. Use 0 to write a PNG.
+ */
+static adv_error png_write_raw_image(
+	adv_mng_write* mng,
+	unsigned pix_width, unsigned pix_height, unsigned pix_pixel,
+	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	const unsigned char* pal_ptr, unsigned pal_size,
+	adv_bool fast,
+	adv_fz* f, unsigned* count)
+{
+	if (mng)
+		return adv_mng_write_image(mng, pix_width, pix_height, pix_pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, pal_ptr, pal_size, f, count);
+	else
+		return adv_png_write_raw(pix_width, pix_height, pix_pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, pal_ptr, pal_size, 0, 0, fast, f, count);
+}
+
 static adv_error png_write_raw_pal(
+	adv_mng_write* mng,
 	unsigned pix_width, unsigned pix_height, unsigned pix_pixel,
 	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
 	adv_color_rgb* rgb_ptr, unsigned rgb_max,
@@ -111,7 +131,7 @@ static adv_error png_write_raw_pal(
 		pix_ptr += pix_scanline_pitch - pix_pixel_pitch * pix_width;
 	}
 
-	if (adv_png_write_raw(pix_width, pix_height, 1, i_ptr, 1, 1 * pix_width, palette, rgb_max * 3, 0, 0, fast, f, count) != 0) {
+	if (png_write_raw_image(mng, pix_width, pix_height, 1, i_ptr, 1, 1 * pix_width, palette, rgb_max * 3, fast, f, count) != 0) {
 		goto err_free;
 	}
 
@@ -125,6 +145,7 @@ err:
 }
 
 static adv_error png_write_raw_paltorgb(
+	adv_mng_write* mng,
 	unsigned pix_width, unsigned pix_height, unsigned pix_pixel,
 	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
 	adv_color_rgb* rgb_ptr, unsigned rgb_max,
@@ -158,7 +179,7 @@ static adv_error png_write_raw_paltorgb(
 		pix_ptr += pix_scanline_pitch - pix_pixel_pitch * pix_width;
 	}
 
-	if (adv_png_write_raw(pix_width, pix_height, 3, i_ptr, 3, 3 * pix_width, 0, 0, 0, 0, fast, f, count) != 0) {
+	if (png_write_raw_image(mng, pix_width, pix_height, 3, i_ptr, 3, 3 * pix_width, 0, 0, fast, f, count) != 0) {
 		goto err_free;
 	}
 
@@ -172,6 +193,7 @@ err:
 }
 
 static adv_error png_write_raw_rgb(
+	adv_mng_write* mng,
 	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
 	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
 	adv_bool fast,
@@ -214,7 +236,7 @@ static adv_error png_write_raw_rgb(
 		pix_ptr += pix_scanline_pitch - pix_pixel_pitch * pix_width;
 	}
 
-	if (adv_png_write_raw(pix_width, pix_height, 3, i_ptr, 3, 3 * pix_width, 0, 0, 0, 0, fast, f, count) != 0) {
+	if (png_write_raw_image(mng, pix_width, pix_height, 3, i_ptr, 3, 3 * pix_width, 0, 0, fast, f, count) != 0) {
 		goto err_free;
 	}
 
@@ -227,7 +249,8 @@ err:
 	return -1;
 }
 
-adv_error adv_png_write_raw_def(
+static adv_error png_write_raw_def(
+	adv_mng_write* mng,
 	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
 	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
 	adv_color_rgb* rgb_ptr, unsigned rgb_max,
@@ -243,24 +266,58 @@ adv_error adv_png_write_raw_def(
 	if (type == adv_color_type_palette) {
 		if (rgb_max <= 256) {
 			/* write palette image */
-			return png_write_raw_pal(pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, fast, f, count);
+			return png_write_raw_pal(mng, pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, fast, f, count);
 		} else {
 			/* convert from palette to 24 bit rgb */
-			return png_write_raw_paltorgb(pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, fast, f, count);
+			return png_write_raw_paltorgb(mng, pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, fast, f, count);
 		}
 	} else if (type == adv_color_type_rgb) {
 		if (adv_png_color_def_is_valid(pix_def)) {
 			/* write rgb image */
-			return adv_png_write_raw(pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, 0, 0, 0, 0, fast, f, count);
+			return png_write_raw_image(mng, pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, 0, 0, fast, f, count);
 		} else {
 			/* convert from generic rgb to 24 bit rgb */
-			return png_write_raw_rgb(pix_width, pix_height, pix_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, fast, f, count);
+			return png_write_raw_rgb(mng, pix_width, pix_height, pix_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, fast, f, count);
 		}
 	} else {
 		return -1;
 	}
 }
 
+adv_error adv_png_write_raw_def(
+	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
+	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	adv_color_rgb* rgb_ptr, unsigned rgb_max,
+	adv_bool fast,
+	adv_fz* f, unsigned* count)
+{
+	return png_write_raw_def(0, pix_width, pix_height, pix_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, fast, f, count);
+}
+
+/**
+ * Write a MNG image, eventually converting it.
+ * \param mng MNG context previously returned by adv_mng_write_init().
+ * \param pix_width Image width.
+ * \param pix_height Image height.
+ * \param pix_def Image color definition.
+ * \param pix_ptr Pointer at the start of the image data.
+ * \param pix_pixel_pitch Pitch for the next pixel.
+ * \param pix_scanline_pitch Pitch for the next scanline.
+ * \param rgb_ptr Palette data pointer. Use 0 for RGB image.
+ * \param rgb_max Palette size in number of colors. Use 0 for RGB image.
+ * \param f File to write.
+ * \param count Pointer at the incremental counter of bytes written. Use 0 for disabling it.
+ */
+adv_error adv_mng_write_image_def(
+	adv_mng_write* mng,
+	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
+	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	adv_color_rgb* rgb_ptr, unsigned rgb_max,
+	adv_fz* f, unsigned* count)
+{
+	return png_write_raw_def(mng, pix_width, pix_height, pix_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, mng->fast_flag, f, count);
+}
+
 /**
  * Save a complete PNG image, eventually converting it.
  * \param pix_width Image width.
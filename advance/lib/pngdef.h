@@ -38,6 +38,7 @@
 #include "extra.h"
 #include "fz.h"
 #include "rgb.h"
+#include "mng.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +52,14 @@ adv_error adv_png_write_raw_def(
 	adv_fz* f, unsigned* count
 );
 
+adv_error adv_mng_write_image_def(
+	adv_mng_write* mng,
+	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
+	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	adv_color_rgb* rgb_ptr, unsigned rgb_max,
+	adv_fz* f, unsigned* count
+);
+
 /** \addtogroup VideoFile */
 /*@{*/
 adv_color_def adv_png_color_def(unsigned bytes_per_pixel);
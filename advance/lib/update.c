@@ -183,3 +183,17 @@ void update_stop(unsigned x, unsigned y, unsigned size_x, unsigned size_y, adv_b
 	is_update_draw_allowed = 0;
 }
 
+/**
+ * End drawing a page without displaying it.
+ * The displayed page isn't changed, and the next update_start() draws again
+ * on the same page. The video drivers without pages may anyway update the
+ * screen.
+ */
+void update_cancel(void)
+{
+	assert(is_update_draw_allowed != 0);
+
+	video_write_unlock(0, 0, 0, 0, 0);
+
+	is_update_draw_allowed = 0;
+}
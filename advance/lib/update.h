@@ -54,6 +54,7 @@ void update_done(void);
 
 void update_start(void);
 void update_stop(unsigned x, unsigned y, unsigned size_x, unsigned size_y, adv_bool wait_retrace);
+void update_cancel(void);
 
 #ifdef __cplusplus
 }
@@ -74,6 +74,7 @@ MENUOBJS += \
 	$(MENUOBJ)/lib/joyall.o \
 	$(MENUOBJ)/lib/jnone.o \
 	$(MENUOBJ)/lib/readinfo.o \
+	$(MENUOBJ)/lib/hcache.o \
 	$(MENUOBJ)/lib/soundall.o \
 	$(MENUOBJ)/lib/videoall.o \
 	$(MENUOBJ)/lib/vnone.o \
@@ -227,6 +227,30 @@ bool file_findinzip_byfile(const string& zip_file, const string& name, string& f
 	return false;
 }
 
+bool file_findinzip_bycrc(const string& zip_file, unsigned crc, string& file)
+{
+	adv_zip* zip;
+	adv_zipent* ent;
+
+	if (access(cpath_export(zip_file), F_OK)!=0)
+		return false;
+
+	zip = zip_open(cpath_export(zip_file));
+	if (!zip)
+		return false;
+
+	while ((ent = zip_read(zip))!=0) {
+		if (ent->crc32 == crc) {
+			file = ent->name;
+			zip_close(zip);
+			return true;
+		}
+	}
+
+	zip_close(zip);
+	return false;
+}
+
 string file_select_random(const path_container& c)
 {
 	int n = rand() % c.size();
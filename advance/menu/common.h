@@ -95,6 +95,7 @@ std::string list_abs(const std::string& rel, const std::string& cwd);
 
 bool file_findinzip_byfile(const std::string& zip_file, const std::string& name, std::string& file, unsigned& crc);
 bool file_findinzip_byname(const std::string& zip_file, const std::string& name, std::string& file, unsigned& crc);
+bool file_findinzip_bycrc(const std::string& zip_file, unsigned crc, std::string& file);
 
 std::string token_get(const std::string& s, int& ptr, const char* sep);
 void token_skip(const std::string& s, int& ptr, const char* sep);
@@ -74,6 +74,8 @@ struct state_t {
 	machinedevice* m; /**< Machine device. */
 	unsigned rom_size; /**< Size of the current rom. */
 	bool rom_merge; /**< Merge of the current rom. */
+	bool rom_crc; /**< If the current rom has the CRC. */
+	gamerom* r; /**< Current rom. */
 
 };
 
@@ -227,13 +229,21 @@ static void process_rom(struct state_t* state, enum token_t t, const char* s, un
 	if (t == token_open) {
 		state->rom_merge = false;
 		state->rom_size = 0;
+		state->rom_crc = false;
+		state->r = new gamerom;
 	} else if (t == token_close) {
-		if (!state->g) {
+		if (!state->g || !state->r) {
 			process_error(state, 0, "invalid state");
 			return;
 		}
-		if (!state->rom_merge)
+		if (!state->rom_merge) {
 			state->g->size_set(state->g->size_get() + state->rom_size);
+			// the roms not dumped have no CRC
+			if (state->rom_crc)
+				state->g->rom_bag_get().insert(state->g->rom_bag_get().end(), *state->r);
+		}
+		delete state->r;
+		state->r = 0;
 	}
 }
 
@@ -245,6 +255,30 @@ static void process_romsize(struct state_t* state, enum token_t t, const char* s
 	}
 }
 
+static void process_romname(struct state_t* state, enum token_t t, const char* s, unsigned len, const char** attributes)
+{
+	if (t == token_data) {
+		if (!state->r) {
+			process_error(state, 0, "invalid state");
+			return;
+		}
+		state->r->name = string(s, len);
+	}
+}
+
+static void process_romcrc(struct state_t* state, enum token_t t, const char* s, unsigned len, const char** attributes)
+{
+	if (t == token_data) {
+		if (!state->r) {
+			process_error(state, 0, "invalid state");
+			return;
+		}
+		string v = string(s, len);
+		state->r->crc = strtoul(v.c_str(), 0, 16);
+		state->rom_crc = true;
+	}
+}
+
 static void process_rommerge(struct state_t* state, enum token_t t, const char* s, unsigned len, const char** attributes)
 {
 	if (t == token_data) {
@@ -399,6 +433,8 @@ static struct conversion_t CONV2[] = {
 static struct conversion_t CONV3[] = {
 	{ 3, { match_mamemessraine, match_gamemachine, "rom", "merge", 0 }, process_rommerge },
 	{ 3, { match_mamemessraine, match_gamemachine, "rom", "size", 0 }, process_romsize },
+	{ 3, { match_mamemessraine, match_gamemachine, "rom", "name", 0 }, process_romname },
+	{ 3, { match_mamemessraine, match_gamemachine, "rom", "crc", 0 }, process_romcrc },
 	{ 3, { match_mamemessraine, match_gamemachine, "device", "name", 0 }, process_devicename },
 	{ 3, { match_mamemessraine, match_gamemachine, "device", "type", 0 }, process_devicename }, /* from MESS 0.106, instead of "name" */
 	{ 3, { match_mamemessraine, match_gamemachine, "driver", "status", 0 }, process_driverstatus },
@@ -556,6 +592,7 @@ bool mame_info::load_xml(istream& is, game_set& gar)
 	state.g = 0;
 	state.a = &gar;
 	state.m = 0;
+	state.r = 0;
 
 	XML_SetUserData(state.parser, &state);
 	XML_SetElementHandler(state.parser, start_handler, end_handler);
@@ -86,6 +86,7 @@ game::game(const game& A) :
 	clone_bag(A.clone_bag),
 	parent(A.parent),
 	machinedevice_bag(A.machinedevice_bag),
+	rom_bag(A.rom_bag),
 	snap_path(A.snap_path), clip_path(A.clip_path), flyer_path(A.flyer_path), cabinet_path(A.cabinet_path),
 	sound_path(A.sound_path), icon_path(A.icon_path), marquee_path(A.marquee_path),
 	emu(A.emu)
@@ -485,6 +486,118 @@ void game_set::cache(merge_t merge)
 	}
 }
 
+/**
+ * Get the CRC from the checksums string of the emulator, like "c:1234abcd#s:...#".
+ */
+static bool rom_hash_crc_get(const char* hash, unsigned& crc)
+{
+	while (*hash) {
+		if (hash[0] == 'c' && hash[1] == ':') {
+			char* end;
+			crc = strtoul(hash + 2, &end, 16);
+			return end == hash + 10;
+		}
+		hash = strchr(hash, '#');
+		if (!hash)
+			break;
+		++hash;
+	}
+
+	return false;
+}
+
+/**
+ * Get the checksums of a rom from the checksum cache of the emulator.
+ * The emulator stores the rom with its name, or with its CRC if loaded by CRC.
+ */
+static const char* rom_hash_get(adv_hcache* cache, const path_container& zip_bag, const gamerom& rom)
+{
+	char crc_name[16];
+
+	snprintf(crc_name, sizeof(crc_name), "%08x", rom.crc);
+
+	for(path_container::const_iterator j=zip_bag.begin();j!=zip_bag.end();++j) {
+		const char* hash;
+
+		hash = hcache_get(cache, cpath_export(*j), rom.name.c_str());
+		if (hash)
+			return hash;
+
+		hash = hcache_get(cache, cpath_export(*j), crc_name);
+		if (hash)
+			return hash;
+	}
+
+	return 0;
+}
+
+/**
+ * Check the roms of the games with the checksum cache of the emulator.
+ * Only the games already loaded at least one time by the emulator are
+ * checked, because only for them the cache has the checksums.
+ * A game is flagged as missing if a rom isn't in the zip files, and as
+ * bad if a rom has a wrong CRC.
+ * The zip files are read only to confirm the missing roms.
+ * \param cache_file File of the checksum cache.
+ */
+void game_set::rom_check(const string& cache_file)
+{
+	adv_hcache* cache;
+
+	cache = hcache_alloc(cpath_export(cache_file));
+
+	for(iterator i=begin();i!=end();++i) {
+		const path_container& zip_bag = i->rom_zip_set_get();
+		gamerom_container unknown_bag;
+		bool checked = false;
+		bool missing = false;
+		bool bad = false;
+
+		if (cache && zip_bag.size() > 0) {
+			for(gamerom_container::const_iterator j=i->rom_bag_get().begin();j!=i->rom_bag_get().end();++j) {
+				const char* hash = rom_hash_get(cache, zip_bag, *j);
+				unsigned crc;
+
+				if (!hash) {
+					unknown_bag.insert(unknown_bag.end(), *j);
+				} else {
+					checked = true;
+					if (rom_hash_crc_get(hash, crc) && crc != j->crc) {
+						log_std(("menu:game: %s has the bad rom %s\n", i->name_get().c_str(), j->name.c_str()));
+						bad = true;
+					}
+				}
+			}
+
+			// if the emulator loaded the game, the roms not in the cache are likely missing
+			if (checked) {
+				for(gamerom_container::const_iterator j=unknown_bag.begin();j!=unknown_bag.end();++j) {
+					path_container::const_iterator k;
+					for(k=zip_bag.begin();k!=zip_bag.end();++k) {
+						string file;
+						unsigned crc;
+						if (file_findinzip_byname(*k, j->name, file, crc) || file_findinzip_bycrc(*k, j->crc, file))
+							break;
+					}
+					if (k == zip_bag.end()) {
+						log_std(("menu:game: %s has the missing rom %s\n", i->name_get().c_str(), j->name.c_str()));
+						missing = true;
+					}
+				}
+			}
+		}
+
+		i->flag_set(missing, game::flag_rom_missing);
+		i->flag_set(bad, game::flag_rom_bad);
+
+		// the roms are not used anymore
+		i->rom_bag_get().clear();
+	}
+
+	if (cache)
+		hcache_free(cache);
+}
+
 bool game_set::is_tree_rom_of_present(const string& name, merge_t type) const
 {
 	switch (type) {
@@ -63,6 +63,16 @@ struct machinedevice {
 
 typedef std::list<machinedevice> machinedevice_container;
 
+// ------------------------------------------------------------------------
+// Rom
+
+struct gamerom {
+	std::string name; ///< Name of the rom.
+	unsigned crc; ///< CRC of the rom.
+};
+
+typedef std::list<gamerom> gamerom_container;
+
 // ------------------------------------------------------------------------
 // Game
 
@@ -88,6 +98,8 @@ class game {
 	static const unsigned flag_tree_present = 0x40;
 	static const unsigned flag_duplicate = 0x80;
 	static const unsigned flag_filled = 0x100;
+	static const unsigned flag_rom_missing = 0x200;
+	static const unsigned flag_rom_bad = 0x400;
 
 	friend class game_set;
 
@@ -126,6 +138,8 @@ class game {
 
 	mutable machinedevice_container machinedevice_bag; //< Set of devices supported (MESS)
 
+	mutable gamerom_container rom_bag; //< Roms of the game to check, cleared after the check
+
 	// path of available images, =="" if none
 	mutable resource snap_path;
 	mutable resource clip_path;
@@ -272,9 +286,13 @@ public:
 	const game& clone_best_get() const;
 
 	machinedevice_container& machinedevice_bag_get() const { return machinedevice_bag; }
+	gamerom_container& rom_bag_get() const { return rom_bag; }
 
 	bool present_get() const {
-		return size_get() == 0 || rom_zip_set_get().size() > 0;
+		return (size_get() == 0 || rom_zip_set_get().size() > 0) && !flag_get(flag_rom_missing);
+	}
+	bool rom_bad_get() const {
+		return flag_get(flag_rom_bad);
 	}
 	bool present_tree_get() const {
 		return flag_get(flag_tree_present);
@@ -306,6 +324,7 @@ public:
 	typedef game_by_name_set::iterator iterator;
 
 	void cache(merge_t merge);
+	void rom_check(const std::string& cache_file);
 
 	bool is_tree_rom_of_present(const std::string& name, merge_t type) const;
 	bool is_game_tag(const std::string& name, const std::string& tag) const;
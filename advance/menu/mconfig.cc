@@ -982,6 +982,11 @@ bool config_state::load(adv_conf* config_context, bool opt_verbose)
 		}
 	}
 
+	// check the roms with the checksums computed by the emulator
+	if (opt_verbose)
+		target_nfo("log: check roms\n");
+	gar.rom_check(path_abs(path_import(file_config_file_home("hash.dat")), dir_cwd()));
+
 	// load the software definitions
 	for(pemulator_container::iterator i=emu_active.begin();i!=emu_active.end();) {
 		if (opt_verbose)
@@ -352,6 +352,8 @@ void draw_menu_info(const game_set& gar, const game* g, int x, int y, int dx, me
 
 		if (!gb->present_tree_get())
 			draw_tag_right("MISSING", xl, xr, y, in_separator, COLOR_MENU_BAR_TAG);
+		else if (gb->rom_bad_get())
+			draw_tag_right("    BAD", xl, xr, y, in_separator, COLOR_MENU_BAR_TAG);
 		else if (gb->play_get() == play_preliminary)
 			draw_tag_right("  ALPHA", xl, xr, y, in_separator, COLOR_MENU_BAR_TAG);
 		else
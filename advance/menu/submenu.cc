@@ -628,6 +628,9 @@ void run_clone(config_state& rs)
 			default: break;
 			}
 
+			if ((*j)->rom_bad_get())
+				s << " [BAD ROMS]";
+
 			emulator* emu = base->emulator_get();
 			if (!emu || emu->filter_working(**j))
 				ch.insert(ch.end(), choice(s.str(), (void*)&**j));
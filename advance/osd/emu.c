@@ -231,6 +231,9 @@ static void help(void)
 	target_out("%slistxml        output the rom XML file\n", slash);
 	target_out("%srecord FILE    record an .inp file\n", slash);
 	target_out("%splayback FILE  play an .inp file\n", slash);
+	target_out("%sbench SECONDS  run a benchmark without video, sound and input\n", slash);
+	target_out("%sprofile FILE   save the profiler call trees in CSV format\n", slash);
+	target_out("%strace FILE     save the profiler trace in Chrome format\n", slash);
 	target_out("%sversion        print the version\n", slash);
 	target_out("\n");
 #ifdef MESS
@@ -600,6 +603,29 @@ adv_error include_load(adv_conf* context, int priority, const char* include_spec
 	return 0;
 }
 
+/**
+ * Load the options of the benchmark, as if they are in the command line.
+ * The benchmark runs without any device and without throttling.
+ */
+static adv_error bench_load(adv_conf* cfg_context, int seconds)
+{
+	char time_buffer[16];
+	char* arg_map[] = {
+		"-device_video", "none",
+		"-device_sound", "none",
+		"-device_keyboard", "none",
+		"-device_joystick", "none",
+		"-device_mouse", "none",
+		"-misc_quiet",
+		"-misc_timetorun", time_buffer
+	};
+	int arg_mac = sizeof(arg_map) / sizeof(arg_map[0]);
+
+	snprintf(time_buffer, sizeof(time_buffer), "%d", seconds);
+
+	return conf_input_args_load(cfg_context, 3, "", &arg_mac, arg_map, error_callback, 0);
+}
+
 /***************************************************************************/
 /* Main */
 
@@ -617,6 +643,7 @@ int os_main(int argc, char* argv[])
 	const char* opt_cfg;
 	char* opt_gamename;
 	int opt_version;
+	int opt_bench;
 	struct advance_context* context = &CONTEXT;
 	const char* section_map[32];
 	unsigned section_mac;
@@ -634,6 +661,7 @@ int os_main(int argc, char* argv[])
 	opt_version = 0;
 	opt_help = 0;
 	opt_cfg = 0;
+	opt_bench = 0;
 
 	memset(&option, 0, sizeof(option));
 	memset(&CONTEXT, 0, sizeof(CONTEXT));
@@ -675,6 +703,8 @@ int os_main(int argc, char* argv[])
 		goto err_os;
 	if (advance_safequit_init(&context->safequit, context->cfg)!=0)
 		goto err_os;
+	if (advance_rewind_init(&context->rewind, context->cfg)!=0)
+		goto err_os;
 	if (hardware_script_init(context->cfg)!=0)
 		goto err_os;
 
@@ -714,6 +744,19 @@ int os_main(int argc, char* argv[])
 			else
 				snprintf(option.playback_file_buffer, sizeof(option.playback_file_buffer), "%s", argv[i+1]);
 			++i;
+		} else if (target_option_compare(argv[i], "bench") && i+1<argc && argv[i+1][0] != '-') {
+			opt_bench = atoi(argv[i+1]);
+			if (opt_bench < 1 || opt_bench > 3600) {
+				target_err("Invalid argument '%s' for option 'bench'.\n", argv[i+1]);
+				goto err_os;
+			}
+			++i;
+		} else if (target_option_compare(argv[i], "profile") && i+1<argc && argv[i+1][0] != '-') {
+			sncpy(context->profile.config.csv_buffer, sizeof(context->profile.config.csv_buffer), argv[i+1]);
+			++i;
+		} else if (target_option_compare(argv[i], "trace") && i+1<argc && argv[i+1][0] != '-') {
+			sncpy(context->profile.config.trace_buffer, sizeof(context->profile.config.trace_buffer), argv[i+1]);
+			++i;
 		} else if (target_option_extract(argv[i]) == 0) {
 			unsigned j;
 			if (opt_gamename) {
@@ -730,6 +773,11 @@ int os_main(int argc, char* argv[])
 		}
 	}
 
+	if (opt_bench) {
+		if (bench_load(context->cfg, opt_bench) != 0)
+			goto err_os;
+	}
+
 	if (opt_cfg) {
 		sncpy(cfg_buffer, sizeof(cfg_buffer), file_config_file_home(opt_cfg));
 	} else {
@@ -918,6 +966,7 @@ int os_main(int argc, char* argv[])
 		goto err_os;
 	if (advance_video_config_load(&context->video, context->cfg, &option) != 0)
 		goto err_os;
+	context->video.config.bench_flag = opt_bench != 0;
 	if (advance_sound_config_load(&context->sound, context->cfg, &option) != 0)
 		goto err_os;
 	if (advance_input_config_load(&context->input, context->cfg) != 0)
@@ -930,6 +979,8 @@ int os_main(int argc, char* argv[])
 		goto err_os;
 	if (advance_safequit_config_load(&context->safequit, context->cfg) != 0)
 		goto err_os;
+	if (advance_rewind_config_load(&context->rewind, context->cfg) != 0)
+		goto err_os;
 	if (hardware_script_config_load(context->cfg) != 0)
 		goto err_os;
 
@@ -955,8 +1006,10 @@ int os_main(int argc, char* argv[])
 		goto err_inner_input;
 	if (advance_safequit_inner_init(&context->safequit, &option) != 0)
 		goto err_inner_ui;
-	if (hardware_script_inner_init() != 0)
+	if (advance_rewind_inner_init(&context->rewind, &option) != 0)
 		goto err_inner_safequit;
+	if (hardware_script_inner_init() != 0)
+		goto err_inner_rewind;
 
 	log_std(("emu: mame_game_run()\n"));
 
@@ -964,9 +1017,13 @@ int os_main(int argc, char* argv[])
 	if (r < 0)
 		goto err_inner_script;
 
+	if (advance_profile_save(&context->profile) != 0)
+		r = -1;
+
 	log_std(("emu: *_inner_done()\n"));
 
 	hardware_script_inner_done();
+	advance_rewind_inner_done(&context->rewind);
 	advance_safequit_inner_done(&context->safequit);
 	advance_ui_inner_done(&context->ui);
 	advance_input_inner_done(&context->input);
@@ -980,6 +1037,7 @@ int os_main(int argc, char* argv[])
 	log_std(("emu: *_done()\n"));
 
 	hardware_script_done();
+	advance_rewind_done(&context->rewind);
 	advance_safequit_done(&context->safequit);
 	advance_fileio_done(&context->fileio);
 	advance_record_done(&context->record);
@@ -1022,6 +1080,8 @@ done_os:
 
 err_inner_script:
 	hardware_script_inner_done();
+err_inner_rewind:
+	advance_rewind_inner_done(&context->rewind);
 err_inner_safequit:
 	advance_safequit_inner_done(&context->safequit);
 err_inner_ui:
@@ -1035,6 +1095,7 @@ err_inner_global:
 err_os_inner:
 	os_inner_done();
 	hardware_script_done();
+	advance_rewind_done(&context->rewind);
 	advance_safequit_done(&context->safequit);
 	advance_fileio_done(&context->fileio);
 	advance_record_done(&context->record);
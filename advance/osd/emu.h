@@ -37,6 +37,7 @@
 #include "target.h"
 #include "file.h"
 #include "fz.h"
+#include "hcache.h"
 #include "key.h"
 #include "conf.h"
 #include "generate.h"
@@ -45,6 +46,7 @@
 #include "filter.h"
 #include "dft.h"
 #include "font.h"
+#include "mng.h"
 
 #ifdef USE_LCD
 #include "lcd.h"
@@ -150,6 +152,68 @@ adv_bool advance_safequit_can_exit(struct advance_safequit_context* context);
 unsigned advance_safequit_event_mask(struct advance_safequit_context* context);
 void advance_safequit_update(struct advance_safequit_context* context);
 
+/***************************************************************************/
+/* Rewind */
+
+#define REWIND_KEY_INTERVAL 32 /**< Max number of deltas following a full state. */
+
+/**
+ * State saved in the rewind buffer.
+ */
+struct advance_rewind_entry {
+	unsigned char* data; /**< Encoded state. */
+	unsigned size; /**< Size of the encoded state. */
+	unsigned id; /**< Unique identifier. */
+	unsigned key; /**< Identifier of the full state of reference, equal to id for a full state. */
+};
+
+struct advance_rewind_config_context {
+	unsigned buffer_size; /**< Max memory used by the states, 0 to disable. */
+	unsigned frame_interval; /**< Frames between two states. */
+};
+
+struct advance_rewind_state_context {
+	adv_bool active_flag; /**< If the rewind is active for the game. */
+	struct advance_rewind_entry* entry_map; /**< Ring of states, the last one is the most recent. */
+	unsigned entry_pos; /**< Position of the oldest state. */
+	unsigned entry_mac; /**< Number of states. */
+	unsigned entry_max; /**< Allocated number of states. */
+	unsigned entry_size; /**< Total size of the states. */
+	unsigned entry_id; /**< Identifier of the next state. */
+	unsigned reference; /**< Identifier of the full state used as reference by the core, 0 if none. */
+	unsigned frame_counter; /**< Frames since the last state. */
+	adv_bool rewind_flag; /**< If the last state is the one already loaded. */
+};
+
+struct advance_rewind_context {
+	struct advance_rewind_config_context config;
+	struct advance_rewind_state_context state;
+};
+
+adv_error advance_rewind_init(struct advance_rewind_context* context, adv_conf* cfg_context);
+void advance_rewind_done(struct advance_rewind_context* context);
+adv_error advance_rewind_inner_init(struct advance_rewind_context* context, struct mame_option* option);
+void advance_rewind_inner_done(struct advance_rewind_context* context);
+adv_error advance_rewind_config_load(struct advance_rewind_context* context, adv_conf* cfg_context);
+void advance_rewind_update(struct advance_rewind_context* context, adv_bool rewind_flag, adv_bool is_pause);
+
+/***************************************************************************/
+/* Profile */
+
+#define PROFILE_TRACE_MAX (1 << 21) /**< Max number of events traced for each thread. */
+
+struct advance_profile_config_context {
+	char csv_buffer[FILE_MAXPATH]; /**< File of the call trees in CSV format, empty if disabled. */
+	char trace_buffer[FILE_MAXPATH]; /**< File of the trace in the Chrome format, empty if disabled. */
+};
+
+struct advance_profile_context {
+	struct advance_profile_config_context config;
+};
+
+void advance_profile_start(struct advance_profile_context* context, adv_bool bench_flag);
+adv_error advance_profile_save(struct advance_profile_context* context);
+
 /***************************************************************************/
 /* Input */
 
@@ -227,7 +291,7 @@ adv_error advance_input_init(struct advance_input_context* context, adv_conf* cf
 void advance_input_done(struct advance_input_context* context);
 adv_error advance_input_inner_init(struct advance_input_context* context, adv_conf* cfg_context);
 void advance_input_inner_done(struct advance_input_context* context);
-void advance_input_update(struct advance_input_context* context, struct advance_safequit_context* safequit_context, adv_bool is_pause);
+void advance_input_update(struct advance_input_context* context, struct advance_safequit_context* safequit_context, struct advance_rewind_context* rewind_context, adv_bool is_pause, adv_bool rewind_flag);
 adv_error advance_input_config_load(struct advance_input_context* context, adv_conf* cfg_context);
 int advance_input_exit_filter(struct advance_input_context* context, struct advance_safequit_context* safequit_context, adv_bool result_memory);
 void advance_input_force_exit(struct advance_input_context* context);
@@ -399,9 +463,50 @@ struct advance_record_config_context {
 	unsigned video_interlace; /**< Interlace factor for the video recording. */
 };
 
+#ifdef USE_SMP
+#define RECORD_QUEUE_MAX 32 /**< Number of frames and sound blocks waiting to be written. */
+
+#define RECORD_SLOT_SOUND 0 /**< Slot with sound samples. */
+#define RECORD_SLOT_VIDEO 1 /**< Slot with a video frame. */
+
+/**
+ * Copy of the data to record, written by the record thread.
+ */
+struct advance_record_slot {
+	unsigned type; /**< RECORD_SLOT_* */
+	unsigned char* data_ptr; /**< Samples, or packed pixels. */
+	unsigned data_size; /**< Allocated size of the data. */
+	unsigned sample_count; /**< Number of samples. */
+	unsigned width; /**< Frame width. */
+	unsigned height; /**< Frame height. */
+	unsigned bytes_per_pixel; /**< Frame bytes per pixel. */
+	unsigned orientation; /**< Frame orientation. */
+	adv_color_def color_def; /**< Frame color definition. */
+	adv_color_rgb* palette_map; /**< Copy of the frame palette. */
+	unsigned palette_max; /**< Number of palette entries. */
+	unsigned palette_size; /**< Allocated number of palette entries. */
+};
+#endif
+
 struct advance_record_state_context {
 #ifdef USE_SMP
 	pthread_mutex_t access_mutex;
+
+	pthread_t queue_thread; /**< Thread writing the recording. */
+	pthread_mutex_t queue_mutex; /**< Access control for the queue. */
+	pthread_cond_t queue_cond; /**< Signal of a queue change. */
+	adv_bool queue_active_flag; /**< If the thread is running. */
+	adv_bool queue_exit_flag; /**< Request to the thread to exit when the queue is empty. */
+	struct advance_record_slot queue_map[RECORD_QUEUE_MAX]; /**< Ring of slots to write. */
+	unsigned queue_pos; /**< First slot to write. */
+	unsigned queue_count; /**< Number of slots to write. */
+	unsigned queue_max; /**< Max number of slots waiting. */
+	unsigned queue_wait_counter; /**< Number of times the queue was full. */
+	target_clock_t queue_wait_time; /**< Time spent waiting for a free slot. */
+	target_clock_t queue_report_time; /**< Time of the last queue report in the OSD. */
+	unsigned queue_report_wait_counter; /**< Number of times the queue was full at the last report. */
+	adv_bool queue_sound_error_flag; /**< Error writing the sound. */
+	adv_bool queue_video_error_flag; /**< Error writing the video. */
 #endif
 
 	adv_bool sound_active_flag; /**< Main activation flag for sound recording. */
@@ -425,6 +530,7 @@ struct advance_record_state_context {
 
 	char video_file_buffer[FILE_MAXPATH]; /**< Video file */
 	adv_fz* video_f; /**< Video handle */
+	adv_mng_write* video_mng; /**< Video MNG writer */
 
 	char snapshot_file_buffer[FILE_MAXPATH]; /**< Shapshot file */
 };
@@ -467,9 +573,16 @@ struct advance_estimate_context {
 	double estimate_osd_last; /**< Last time at point 2 */
 	double estimate_frame_last; /**< Last time at point 3 */
 	double estimate_common_last;
+	double total_mame; /**< Total time of the MAME full frames */
+	double total_osd; /**< Total time of the OSD full frames */
+	double total_common; /**< Total time of the common part of the full frames */
+	unsigned total_mame_count; /**< Number of MAME full frames measured */
+	unsigned total_osd_count; /**< Number of OSD full frames measured */
+	unsigned total_common_count; /**< Number of common parts measured */
 };
 
 void advance_estimate_init(struct advance_estimate_context* context, double step);
+void advance_estimate_total_reset(struct advance_estimate_context* context);
 
 void advance_estimate_mame_begin(struct advance_estimate_context* context);
 void advance_estimate_mame_end(struct advance_estimate_context* context, adv_bool skip_flag);
@@ -661,6 +774,7 @@ struct advance_video_config_context {
 	adv_bool vsync_flag; /**< If vsync is active. */
 	adv_bool wait_vsync_flag; /**< If wait vsync is active. */
 	adv_bool triplebuf_flag; /**< If triple buffering is active. */
+	adv_bool partial_flag; /**< If only the changed part of the game image is drawn. */
 	int skiplines; /**< Centering value for screen, -1 for auto centering. */
 	int skipcolumns; /**< Centering value for screen, -1 for auto centering. */
 	char resolution_buffer[MODE_NAME_MAX]; /**< Name of the resolution. "auto" for automatic. */
@@ -679,6 +793,7 @@ struct advance_video_config_context {
 	double fps_fixed; /**< Fixed fps. If ==0 use the original fps. */
 	int fastest_time; /**< Time for turbo at the startup [seconds]. */
 	int measure_time; /**< Time for the speed measure [seconds]. */
+	adv_bool bench_flag; /**< Print the speed measure as a benchmark report [boolean]. */
 	adv_bool restore_flag; /**< Reset the video mode at the exit [boolean]. */
 	unsigned magnify_factor; /**< Magnify factor requested [0=auto,1,2,3,4]. */
 	unsigned magnify_size; /**< Magnify target size. */
@@ -694,6 +809,9 @@ struct advance_video_config_context {
 	char section_resolutionclock_buffer[256]; /**< Section used to store the option for the resolution/freq. */
 	char section_orientation_buffer[256]; /**< Section used to store the option for the orientation. */
 	adv_bool smp_flag; /**< Use threads */
+	unsigned smp_blit; /**< Max number of blit bands drawn in parallel, 0 for automatic. */
+	unsigned smp_thread; /**< Threads used for the parallel execution, 0 for automatic. */
+	char smp_affinity_buffer[256]; /**< Processor affinity of the parallel execution threads. */
 	adv_bool crash_flag; /**< If enable the crash menu entry. */
 	adv_bool rawsound_flag; /**< Force the generation of all the sound samples. */
 	unsigned monitor_aspect_x; /**< Horizontal aspect of the monitor (4 for a standard monitor) */
@@ -714,6 +832,7 @@ struct advance_video_config_context {
 
 #define PIPELINE_MEASURE_MAX 13
 #define PIPELINE_BLIT_MAX 2 /**< Number of pipelines to create. 0 for buffered, 1 for direct write. */
+#define PARTIAL_PAGE_MAX 3 /**< Max number of video pages to track for the partial update. */
 
 /** State for the video part. */
 struct advance_video_state_context {
@@ -800,11 +919,15 @@ struct advance_video_state_context {
 	pthread_mutex_t thread_video_mutex; /**< Thread access control. */
 	adv_bool thread_exit_flag; /**< If the thread must exit. */
 	adv_bool thread_state_ready_flag; /**< If the thread data is ready. */
-	struct osd_bitmap* thread_state_game; /**< Thread game bitmap to draw. */
-	short* thread_state_sample_buffer; /**< Thread game sound to play. */
+	struct osd_bitmap* thread_state_game; /**< Thread game bitmap to draw. It points to thread_state_game_buffer or it's 0. */
+	struct osd_bitmap thread_state_game_buffer; /**< Storage for the thread game bitmap. */
+	void* thread_state_game_copy; /**< Copy of the game bitmap data, used if the core cannot swap it. */
+	unsigned thread_state_game_copy_size; /**< Size of the copy of the game bitmap data. */
+	adv_bool thread_state_game_fill_flag; /**< If the thread must fill the swapped bitmap of the core with the game bitmap. */
+	adv_bool thread_game_wait_flag; /**< If the core must wait the fill before drawing. Used only by the main thread. */
+	const short* thread_state_sample_buffer; /**< Thread game sound to play. The core doesn't reuse it until the next frame. */
 	unsigned thread_state_sample_count;
 	unsigned thread_state_sample_recount;
-	unsigned thread_state_sample_max;
 	unsigned thread_state_led; /**< Thread game led to set. */
 	unsigned thread_state_input; /**< Thread input to process. */
 	adv_bool thread_state_skip_flag; /**< Thread frame skip_flag to use. */
@@ -818,6 +941,7 @@ struct advance_video_state_context {
 
 	/* Measure */
 	unsigned measure_counter; /**< Measure frame counter. */
+	unsigned measure_limit; /**< Measure frame counter limit. */
 	adv_bool measure_flag; /**< Measure active flag. */
 	target_clock_t measure_start; /**< Start of the measure. */
 	target_clock_t measure_stop; /**< End of the measure. */
@@ -840,6 +964,15 @@ struct advance_video_state_context {
 	struct video_pipeline_struct blit_pipeline[PIPELINE_BLIT_MAX]; /**< Put pipeline to video. */
 	unsigned blit_pipeline_index; /**< Pipeline to use. */
 
+	/* Partial update info */
+	unsigned char* partial_ptr; /**< Copy of the last game image with the blit orientation. 0 if missing. */
+	unsigned partial_size_x; /**< Width of the copy. */
+	unsigned partial_size_y; /**< Height of the copy. */
+	unsigned partial_begin_map[PARTIAL_PAGE_MAX]; /**< First row to redraw on every video page. */
+	unsigned partial_end_map[PARTIAL_PAGE_MAX]; /**< Row after the last to redraw on every video page. */
+	unsigned partial_display_page; /**< Video page currently displayed. */
+	adv_bool partial_skip_flag; /**< The displayed page is already updated and it isn't required to display it again. */
+
 	/* Buffer info */
 	int buffer_src_dp; /**< Source pixel step of the game bitmap. */
 	int buffer_src_dw; /**< Source row step of the game bitmap. */
@@ -1004,12 +1137,19 @@ void advance_global_done(struct advance_global_context* context);
 /***************************************************************************/
 /* Fileio */
 
+struct advance_fileio_config_context {
+	adv_bool hash_cache_flag; /**< Use the checksum cache. */
+};
+
 struct advance_fileio_state_context {
 	adv_fz* diff_handle; /**< Diff file handle. */
 	char diff_file_buffer[FILE_MAXPATH]; /**< Diff file path. */
+	adv_hcache* hash_cache; /**< Checksum cache, loaded at the first use. */
+	adv_bool hash_cache_failed_flag; /**< If the checksum cache cannot be allocated. */
 };
 
 struct advance_fileio_context {
+	struct advance_fileio_config_context config;
 	struct advance_fileio_state_context state;
 };
 
@@ -1031,6 +1171,8 @@ struct advance_context {
 	struct advance_sound_context sound;
 	struct advance_record_context record;
 	struct advance_safequit_context safequit;
+	struct advance_rewind_context rewind;
+	struct advance_profile_context profile;
 	struct advance_fileio_context fileio;
 	struct advance_ui_context ui;
 };
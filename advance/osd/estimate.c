@@ -53,6 +53,20 @@ void advance_estimate_init(struct advance_estimate_context* context, double step
 	context->estimate_common_full = 0.001 * step;
 }
 
+/**
+ * Reset the total times.
+ * Differently than the estimates, they are not reset by advance_estimate_init().
+ */
+void advance_estimate_total_reset(struct advance_estimate_context* context)
+{
+	context->total_mame = 0;
+	context->total_osd = 0;
+	context->total_common = 0;
+	context->total_mame_count = 0;
+	context->total_osd_count = 0;
+	context->total_common_count = 0;
+}
+
 void advance_estimate_mame_end(struct advance_estimate_context* context, adv_bool skip_flag)
 {
 	double current = advance_timer();
@@ -60,10 +74,13 @@ void advance_estimate_mame_end(struct advance_estimate_context* context, adv_boo
 	if (context->estimate_mame_flag) {
 		double previous;
 		previous = current - context->estimate_mame_last;
-		if (skip_flag)
+		if (skip_flag) {
 			context->estimate_mame_skip = estimate_merge(context->estimate_mame_skip, previous);
-		else
+		} else {
 			context->estimate_mame_full = estimate_merge(context->estimate_mame_full, previous);
+			context->total_mame += previous;
+			++context->total_mame_count;
+		}
 	}
 }
 
@@ -82,10 +99,13 @@ void advance_estimate_osd_end(struct advance_estimate_context* context, adv_bool
 	if (context->estimate_osd_flag) {
 		double previous;
 		previous = current - context->estimate_osd_last;
-		if (skip_flag)
+		if (skip_flag) {
 			context->estimate_osd_skip = estimate_merge(context->estimate_osd_skip, previous);
-		else
+		} else {
 			context->estimate_osd_full = estimate_merge(context->estimate_osd_full, previous);
+			context->total_osd += previous;
+			++context->total_osd_count;
+		}
 	}
 }
 
@@ -104,10 +124,13 @@ void advance_estimate_common_end(struct advance_estimate_context* context, adv_b
 	if (context->estimate_common_flag) {
 		double previous;
 		previous = current - context->estimate_common_last;
-		if (skip_flag)
+		if (skip_flag) {
 			context->estimate_common_skip = estimate_merge(context->estimate_common_skip, previous);
-		else
+		} else {
 			context->estimate_common_full = estimate_merge(context->estimate_common_full, previous);
+			context->total_common += previous;
+			++context->total_common_count;
+		}
 	}
 }
 
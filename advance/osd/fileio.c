@@ -38,6 +38,10 @@
 
 #include <zlib.h>
 
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 /***************************************************************************/
 /* Declaration */
 
@@ -320,6 +324,145 @@ osd_file* osd_fopen(int pathtype, int pathindex, const char* filename, const cha
 	return (osd_file*)h;
 }
 
+#ifndef MESS
+
+/**
+ * Get the checksum cache, loading it at the first use.
+ */
+static adv_hcache* hash_cache_get(void)
+{
+	struct advance_fileio_context* context = &CONTEXT.fileio;
+
+	if (!context->config.hash_cache_flag || context->state.hash_cache_failed_flag)
+		return 0;
+
+	if (!context->state.hash_cache) {
+		context->state.hash_cache = hcache_alloc(file_config_file_home("hash.dat"));
+		if (!context->state.hash_cache) {
+			log_std(("ERROR:fileio: unable to allocate the checksum cache\n"));
+			context->state.hash_cache_failed_flag = 1;
+		}
+	}
+
+	return context->state.hash_cache;
+}
+
+int osd_hash_cache_get(int pathtype, int pathindex, const char* filename, const char* entry, char* hash)
+{
+	struct fileio_item* i;
+	adv_hcache* cache;
+	const char* cached;
+	char path_buffer[FILE_MAXPATH];
+
+	cache = hash_cache_get();
+	if (!cache)
+		return -1;
+
+	i = fileio_find(pathtype);
+	if (!i || pathindex >= i->dir_mac)
+		return -1;
+
+	sncpy(path_buffer, sizeof(path_buffer), file_abs(i->dir_map[pathindex], filename));
+
+	cached = hcache_get(cache, path_buffer, entry);
+
+	log_std(("osd: osd_hash_cache_get(%s,%s) -> %s\n", path_buffer, entry ? entry : "", cached ? cached : "miss"));
+
+	if (!cached || strlen(cached) >= HASH_BUF_SIZE)
+		return -1;
+
+	strcpy(hash, cached);
+	return 0;
+}
+
+void osd_hash_cache_set(int pathtype, int pathindex, const char* filename, const char* entry, const char* hash)
+{
+	struct fileio_item* i;
+	adv_hcache* cache;
+	char path_buffer[FILE_MAXPATH];
+
+	cache = hash_cache_get();
+	if (!cache)
+		return;
+
+	i = fileio_find(pathtype);
+	if (!i || pathindex >= i->dir_mac)
+		return;
+
+	sncpy(path_buffer, sizeof(path_buffer), file_abs(i->dir_map[pathindex], filename));
+
+	log_std(("osd: osd_hash_cache_set(%s,%s,%s)\n", path_buffer, entry ? entry : "", hash));
+
+	hcache_set(cache, path_buffer, entry, hash);
+}
+
+#if HAVE_MMAP && HAVE_SYS_MMAN_H
+
+void* osd_fmap(int pathtype, int pathindex, const char* filename, UINT64* length)
+{
+	struct fileio_item* i;
+	char path_buffer[FILE_MAXPATH];
+	struct stat st;
+	void* data;
+	int f;
+
+	i = fileio_find(pathtype);
+	if (!i || pathindex >= i->dir_mac)
+		return 0;
+
+	sncpy(path_buffer, sizeof(path_buffer), file_abs(i->dir_map[pathindex], filename));
+
+	/* files in a zip are not mapped */
+	if (strchr(path_buffer, '=') != 0)
+		return 0;
+
+	f = open(path_buffer, O_RDONLY);
+	if (f == -1)
+		return 0;
+
+	if (fstat(f, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		close(f);
+		return 0;
+	}
+
+	data = mmap(0, st.st_size, PROT_READ, MAP_SHARED, f, 0);
+
+	/* the mapping remains valid after the close */
+	close(f);
+
+	if (data == MAP_FAILED) {
+		log_std(("WARNING:fileio: mmap(%s) failed, %s\n", path_buffer, strerror(errno)));
+		return 0;
+	}
+
+	log_std(("osd: osd_fmap(%s) -> %p, %lld bytes\n", path_buffer, data, (long long)st.st_size));
+
+	*length = st.st_size;
+	return data;
+}
+
+void osd_funmap(void* data, UINT64 length)
+{
+	log_std(("osd: osd_funmap(%p)\n", data));
+
+	munmap(data, length);
+}
+
+#else
+
+void* osd_fmap(int pathtype, int pathindex, const char* filename, UINT64* length)
+{
+	return 0;
+}
+
+void osd_funmap(void* data, UINT64 length)
+{
+}
+
+#endif
+
+#endif
+
 void osd_fclose(osd_file* file)
 {
 	adv_fz* h = (adv_fz*)file;
@@ -734,9 +877,17 @@ adv_error advance_fileio_init(struct advance_fileio_context* context, adv_conf*
 	}
 
 	context->state.diff_handle = 0;
+	context->state.hash_cache = 0;
+	context->state.hash_cache_failed_flag = 0;
+
+	conf_bool_register_default(cfg_context, "misc_hashcache", 1);
 
 #ifdef MESS
 	conf_string_register_default(cfg_context, "dir_crc", file_config_dir_singledir("crc"));
+#else
+	conf_int_register_limit_default(cfg_context, "misc_chdcache", 1, 4096, CHD_CACHE_HUNKS_DEFAULT);
+	conf_int_register_limit_default(cfg_context, "misc_chdreadahead", 0, 256, CHD_CACHE_READAHEAD_DEFAULT);
+	conf_int_register_limit_default(cfg_context, "misc_zipcache", 1, 256, ZIP_CACHE_DEFAULT);
 #endif
 
 	return 0;
@@ -751,6 +902,11 @@ void advance_fileio_done(struct advance_fileio_context* context)
 	if (context->state.diff_handle) {
 		fzclose(context->state.diff_handle);
 	}
+	if (context->state.hash_cache) {
+		hcache_save(context->state.hash_cache);
+		hcache_free(context->state.hash_cache);
+		context->state.hash_cache = 0;
+	}
 }
 
 static void dir_create(const char* dir)
@@ -822,6 +978,8 @@ adv_error advance_fileio_config_load(struct advance_fileio_context* context, adv
 		}
 	}
 
+	context->config.hash_cache_flag = conf_bool_get_default(cfg_context, "misc_hashcache");
+
 #ifdef MESS
 	{
 		const char* s = conf_string_get_default(cfg_context, "dir_crc");
@@ -829,6 +987,10 @@ adv_error advance_fileio_config_load(struct advance_fileio_context* context, adv
 		log_std(("advance:fileio: %s %s\n", "dir_crc", a));
 		sncpy(option->crc_dir_buffer, sizeof(option->crc_dir_buffer), a);
 	}
+#else
+	option->chd_cache = conf_int_get_default(cfg_context, "misc_chdcache");
+	option->chd_readahead = conf_int_get_default(cfg_context, "misc_chdreadahead");
+	option->zip_cache = conf_int_get_default(cfg_context, "misc_zipcache");
 #endif
 
 	return 0;
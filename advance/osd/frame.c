@@ -36,6 +36,7 @@
 #include "advance.h"
 
 #include <math.h>
+#include <limits.h>
 
 /***************************************************************************/
 /*
@@ -431,6 +432,20 @@ adv_error advance_video_update_index(struct advance_video_context* context)
 	return 0;
 }
 
+/**
+ * Invalidate the contents of all the video pages for the partial update.
+ * At the next frames all the pages are completely redrawn.
+ */
+static void video_partial_invalidate(struct advance_video_context* context)
+{
+	unsigned i;
+
+	for(i=0;i<PARTIAL_PAGE_MAX;++i) {
+		context->state.partial_begin_map[i] = 0;
+		context->state.partial_end_map[i] = UINT_MAX;
+	}
+}
+
 /**
  * Invalidates and clears the contents of the screen.
  */
@@ -461,6 +476,8 @@ void advance_video_invalidate_screen(struct advance_video_context* context)
 		video_clear(update_x_get(), update_y_get(), video_size_x(), video_size_y(), color);
 		update_stop(update_x_get(), update_y_get(), video_size_x(), video_size_y(), 0);
 	}
+
+	video_partial_invalidate(context);
 }
 
 /**
@@ -493,6 +510,12 @@ static void video_done_pipeline(struct advance_video_context* context)
 		free(context->state.buffer_ptr_alloc);
 		context->state.buffer_ptr_alloc = 0;
 	}
+
+	/* the copy of the game image is recreated with the new orientation and size */
+	if (context->state.partial_ptr) {
+		free(context->state.partial_ptr);
+		context->state.partial_ptr = 0;
+	}
 }
 
 /**
@@ -533,6 +556,11 @@ static adv_error vidmode_init(struct advance_video_context* context, adv_mode* m
 	context->state.blit_pipeline_flag = 0;
 	context->state.buffer_ptr_alloc = 0;
 
+	/* initialize the partial update */
+	context->state.partial_ptr = 0;
+	context->state.partial_display_page = 0;
+	context->state.partial_skip_flag = 0;
+
 	/* initialize the update system */
 	update_init(context->config.triplebuf_flag != 0 ? 3 : 1);
 	log_std(("emu:video: using %d hardware video buffers\n", update_page_max_get()));
@@ -1674,6 +1702,222 @@ static void video_buffer_clear(struct advance_video_context* context)
 	}
 }
 
+/**
+ * Compare a row of the game image with its copy, and update the copy.
+ * \param dst Copy of the row.
+ * \param src Row of the game image.
+ * \param size_x Number of pixels of the row.
+ * \param dp Pixel step of the game image in bytes.
+ * \param bytes_per_pixel Bytes per pixel of the game image.
+ * \return !=0 if the row is changed.
+ */
+static adv_bool video_partial_row(unsigned char* dst, const unsigned char* src, unsigned size_x, int dp, unsigned bytes_per_pixel)
+{
+	adv_bool changed;
+	unsigned i;
+
+	if (dp == (int)bytes_per_pixel) {
+		unsigned size = size_x * bytes_per_pixel;
+
+		if (memcmp(dst, src, size) == 0)
+			return 0;
+
+		memcpy(dst, src, size);
+		return 1;
+	}
+
+	/* the rows of the rotated or flipped games aren't contiguous */
+	changed = 0;
+	switch (bytes_per_pixel) {
+	case 2 : {
+		uint16* dst16 = (uint16*)dst;
+		for(i=0;i<size_x;++i) {
+			uint16 v = *(const uint16*)src;
+			if (dst16[i] != v) {
+				dst16[i] = v;
+				changed = 1;
+			}
+			src += dp;
+		}
+		} break;
+	case 4 : {
+		uint32* dst32 = (uint32*)dst;
+		for(i=0;i<size_x;++i) {
+			uint32 v = *(const uint32*)src;
+			if (dst32[i] != v) {
+				dst32[i] = v;
+				changed = 1;
+			}
+			src += dp;
+		}
+		} break;
+	default :
+		for(i=0;i<size_x;++i) {
+			if (memcmp(dst, src, bytes_per_pixel) != 0) {
+				memcpy(dst, src, bytes_per_pixel);
+				changed = 1;
+			}
+			dst += bytes_per_pixel;
+			src += dp;
+		}
+		break;
+	}
+
+	return changed;
+}
+
+/**
+ * Get the rows of the game image changed from the previous frame.
+ * The image is read with the blit orientation and compared with a copy
+ * of the previous one, updated at the same time.
+ * \param src First pixel of the game image.
+ * \param size_x, size_y Size of the game image.
+ * \param dw, dp Row and pixel step of the game image in bytes.
+ * \param begin First changed row.
+ * \param end Row after the last changed row. Equal at begin if nothing is changed.
+ * \return 0 on success, !=0 if the copy cannot be allocated.
+ */
+static adv_error video_partial_compare(struct advance_video_context* context, const unsigned char* src, unsigned size_x, unsigned size_y, int dw, int dp, unsigned* begin, unsigned* end)
+{
+	unsigned bytes_per_pixel = context->state.game_bytes_per_pixel;
+	unsigned bytes_per_row = size_x * bytes_per_pixel;
+	unsigned char* ptr;
+	adv_bool all;
+	unsigned y;
+
+	all = 0;
+	if (!context->state.partial_ptr
+		|| context->state.partial_size_x != size_x
+		|| context->state.partial_size_y != size_y
+	) {
+		free(context->state.partial_ptr);
+		context->state.partial_ptr = 0;
+
+		ptr = malloc(size_y * bytes_per_row);
+		if (!ptr) {
+			log_std(("ERROR:emu:video: low memory for the partial update\n"));
+			return -1;
+		}
+
+		context->state.partial_ptr = ptr;
+		context->state.partial_size_x = size_x;
+		context->state.partial_size_y = size_y;
+		all = 1;
+	}
+
+	*begin = 0;
+	*end = 0;
+	for(y=0;y<size_y;++y) {
+		if (video_partial_row(context->state.partial_ptr + y * bytes_per_row, src + (int)y * dw, size_x, dp, bytes_per_pixel)) {
+			if (*begin == *end)
+				*begin = y;
+			*end = y + 1;
+		}
+	}
+
+	/* without a previous copy everything is changed */
+	if (all) {
+		*begin = 0;
+		*end = size_y;
+	}
+
+	return 0;
+}
+
+/**
+ * Add a range of changed rows at all the video pages.
+ */
+static void video_partial_add(struct advance_video_context* context, unsigned begin, unsigned end)
+{
+	unsigned i;
+
+	if (begin >= end)
+		return;
+
+	for(i=0;i<PARTIAL_PAGE_MAX;++i) {
+		if (context->state.partial_begin_map[i] >= context->state.partial_end_map[i]) {
+			context->state.partial_begin_map[i] = begin;
+			context->state.partial_end_map[i] = end;
+		} else {
+			if (context->state.partial_begin_map[i] > begin)
+				context->state.partial_begin_map[i] = begin;
+			if (context->state.partial_end_map[i] < end)
+				context->state.partial_end_map[i] = end;
+		}
+	}
+}
+
+/**
+ * Draw on the video page only the rows changed from the image it contains.
+ * The pages are reused after update_page_max_get() frames, and every page
+ * keeps the range of the rows changed after it was drawn the last time.
+ * If nothing is changed on the displayed page, the page flip can be skipped.
+ */
+static void video_frame_put_partial(struct advance_video_context* context, const struct video_pipeline_struct* pipeline, unsigned x, unsigned y, const unsigned char* src)
+{
+	unsigned size_y = context->state.game_visible_size_y;
+	unsigned page = update_page_get();
+	unsigned display = context->state.partial_display_page;
+	unsigned begin;
+	unsigned end;
+
+	assert(update_page_max_get() <= PARTIAL_PAGE_MAX);
+
+	if (video_partial_compare(context, src, context->state.game_visible_size_x, size_y, context->state.blit_src_dw, context->state.blit_src_dp, &begin, &end) != 0) {
+		/* without the copy draw everything, and redraw the other pages later */
+		video_partial_invalidate(context);
+		context->state.partial_begin_map[page] = 0;
+		context->state.partial_end_map[page] = 0;
+		video_pipeline_blit(pipeline, x, y, src);
+		return;
+	}
+
+	/* the effects change also the rows near the changed ones */
+	if (begin < end) {
+		begin = begin < VIDEO_BAND_CONTEXT ? 0 : begin - VIDEO_BAND_CONTEXT;
+		end = end + VIDEO_BAND_CONTEXT > size_y ? size_y : end + VIDEO_BAND_CONTEXT;
+	}
+
+	video_partial_add(context, begin, end);
+
+	/* rows to redraw on this page */
+	begin = context->state.partial_begin_map[page];
+	end = context->state.partial_end_map[page];
+	if (end > size_y)
+		end = size_y;
+	context->state.partial_begin_map[page] = 0;
+	context->state.partial_end_map[page] = 0;
+
+	/* the pipeline measure requires the complete blit */
+	if (context->state.pipeline_measure_flag) {
+		video_pipeline_blit(pipeline, x, y, src);
+		return;
+	}
+
+	if (begin >= end) {
+		/* if also the displayed page is updated, it isn't required to display it again */
+		context->state.partial_skip_flag = context->state.partial_begin_map[display] >= context->state.partial_end_map[display];
+		return;
+	}
+
+	/* draw everything if the pipeline cannot be split or if the band is big, */
+	/* the complete blit may use more threads */
+	if (!video_pipeline_is_band(pipeline) || size_y < 4 || (end - begin) * 2 > size_y) {
+		video_pipeline_blit(pipeline, x, y, src);
+		return;
+	}
+
+	/* the band must have at least four rows */
+	while (end - begin < 4) {
+		if (end < size_y)
+			++end;
+		else
+			--begin;
+	}
+
+	video_pipeline_blit_band(pipeline, x, y, src, begin, end);
+}
+
 static unsigned pipeline_combine(unsigned p)
 {
 	if (p == 0)
@@ -2102,14 +2346,22 @@ static void video_frame_put(struct advance_video_context* context, struct advanc
 			/* because the ui may write over the game area */
 			video_buffer_clear(context);
 		}
+
+		/* the whole screen is overwritten, all the pages must be redrawn */
+		video_partial_invalidate(context);
 	} else {
 		/* direct write on screen */
 
 		/* compute the source pointer */
 		src_offset = context->state.blit_src_offset + context->state.game_visible_pos_y * context->state.blit_src_dw + context->state.game_visible_pos_x * context->state.blit_src_dp;
 
-		/* blit directly on the video */
-		video_pipeline_blit(&context->state.blit_pipeline[context->state.blit_pipeline_index], dst_x + x, dst_y + y, (unsigned char*)bitmap->ptr + src_offset);
+		if (context->config.partial_flag) {
+			/* blit only the changed rows */
+			video_frame_put_partial(context, &context->state.blit_pipeline[context->state.blit_pipeline_index], dst_x + x, dst_y + y, (unsigned char*)bitmap->ptr + src_offset);
+		} else {
+			/* blit directly on the video */
+			video_pipeline_blit(&context->state.blit_pipeline[context->state.blit_pipeline_index], dst_x + x, dst_y + y, (unsigned char*)bitmap->ptr + src_offset);
+		}
 	}
 
 	/* no buffering is used */
@@ -2257,6 +2509,10 @@ static void video_frame_game(struct advance_video_context* context, struct advan
 {
 	/* bitmap */
 	if (!skip_flag) {
+		/* with a software palette a color change affects the whole image */
+		if (context->state.palette_dirty_flag && context->state.mode_index != MODE_FLAGS_INDEX_PALETTE8)
+			video_partial_invalidate(context);
+
 		video_frame_palette(context);
 		video_frame_screen(context, ui_context, bitmap);
 
@@ -712,6 +712,10 @@ void osd_customize_inputport_list(input_port_default_entry* defaults)
 	seq_set_1(&i->defaultseq, KEYCODE_ASTERISK);
 	i->name = "Turbo";
 
+	i = config_portdef_find(defaults, IPT_UI_REWIND);
+	seq_set_1(&i->defaultseq, KEYCODE_BACKSLASH);
+	i->name = "Rewind";
+
 	i = config_portdef_find(defaults, IPT_UI_COCKTAIL);
 	seq_set_1(&i->defaultseq, KEYCODE_SLASH_PAD);
 	i->name = "Cocktail";
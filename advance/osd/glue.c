@@ -68,7 +68,8 @@ static const char* DEVICES[] = {
 
 struct advance_glue_context {
 	mame_bitmap* bitmap;
-	mame_bitmap* bitmap_alt;
+	mame_bitmap* bitmap_alt; /**< Second screen bitmap used by mame_video_swap(). */
+	mame_bitmap* bitmap_screen; /**< Screen bitmap allocated by the core. */
 	struct osd_video_option option;
 
 	int video_flag; /** If the video initialization completed with success. */
@@ -100,6 +101,8 @@ struct advance_glue_context {
 
 static struct advance_glue_context GLUE;
 
+extern mame_bitmap *scrbitmap[];
+
 /***************************************************************************/
 /* MAME */
 
@@ -651,6 +654,12 @@ int mame_game_run(struct advance_context* context, const struct mame_option* adv
 	options.debug_depth = 8;
 	options.controller = 0; /* no controller file to load */
 
+#ifndef MESS
+	chd_set_cache_size(advance->chd_cache, advance->chd_readahead);
+	unzip_cache_set_size(advance->zip_cache);
+	options.runahead = advance->runahead;
+#endif
+
 	if (advance->bios_buffer[0] == 0 || strcmp(advance->bios_buffer, "default")==0)
 		options.bios = 0;
 	else
@@ -1175,6 +1184,7 @@ static struct mame_port GLUE_PORT_STD[] = {
 	S("ui_record_start", "Record Start", UI_RECORD_START)
 	S("ui_record_stop", "Record Stop", UI_RECORD_STOP)
 	S("ui_turbo", "Turbo", UI_TURBO)
+	S("ui_rewind", "Rewind", UI_REWIND)
 	S("ui_cocktail", "Cocktail", UI_COCKTAIL)
 	S("ui_help", "Help", UI_HELP)
 	S("ui_startup", "Startup", UI_STARTUP_END)
@@ -1744,6 +1754,7 @@ static unsigned PORT_TYPE_REPORT_DEFAULT[] = {
 	IPT_UI_RECORD_START,
 	IPT_UI_RECORD_STOP,
 	IPT_UI_TURBO,
+	IPT_UI_REWIND,
 	IPT_UI_COCKTAIL,
 	IPT_UI_HELP,
 	IPT_UI_STARTUP_END,
@@ -2028,6 +2039,231 @@ unsigned mame_ui_frames_per_second(void)
 	return Machine->drv->frames_per_second;
 }
 
+/**
+ * Get the run-ahead performance.
+ * \param frame_time Where to put the time used to emulate a displayed frame, in seconds.
+ * \param state_time Where to put the part of the frame time used to save and load the state.
+ * \return The number of frames emulated ahead, 0 if the run-ahead isn't active.
+ */
+unsigned mame_ui_runahead_info(double* frame_time, double* state_time)
+{
+#ifdef MESS
+	return 0;
+#else
+	const performance_info* performance = mame_get_performance_info();
+
+	*frame_time = performance->runahead_frame_time;
+	*state_time = performance->runahead_state_time;
+
+	return performance->runahead_frames;
+#endif
+}
+
+/**
+ * Start the profiler.
+ * The profiler is present only in the debug and profiler builds.
+ * \param trace_max Number of events to trace for each thread, 0 to disable the trace.
+ */
+void mame_ui_profiler_start(unsigned trace_max)
+{
+#if (defined(MAME_DEBUG) || defined(MAME_PROFILER)) && !defined(MESS)
+	profiler_set_trace(trace_max);
+	profiler_start();
+#endif
+}
+
+/**
+ * Get the time spent in a profiled section.
+ * \param index Index of the section, starting from 0.
+ * \param tag Where to put the name of the section.
+ * \param time Where to put the time, in seconds.
+ * \return 0 on success, -1 if the section doesn't exist or the profiler isn't present.
+ */
+adv_error mame_ui_profiler_get(unsigned index, const char** tag, double* time)
+{
+#if (defined(MAME_DEBUG) || defined(MAME_PROFILER)) && !defined(MESS)
+	*tag = profiler_get_tag(index);
+	if (!*tag)
+		return -1;
+
+	*time = (double)profiler_get_ticks(index) / (double)osd_profiling_ticks_per_second();
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * Get the number of threads profiled.
+ * \return The number of threads, 0 if the profiler isn't present.
+ */
+unsigned mame_ui_profiler_thread_count(void)
+{
+#if (defined(MAME_DEBUG) || defined(MAME_PROFILER)) && !defined(MESS)
+	return profiler_get_thread_count();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Get a node of the call tree of a profiled thread.
+ * The parents always come before their children.
+ * \param thread Index of the thread.
+ * \param index Index of the node, starting from 0.
+ * \param name Where to put the name of the scope.
+ * \param parent Where to put the index of the parent node, -1 for the top level scopes.
+ * \param calls Where to put the number of times the scope was entered.
+ * \param total Where to put the time spent in the scope, in seconds.
+ * \param self Where to put the time spent in the scope without the nested scopes, in seconds.
+ * \return 0 on success, -1 if the node doesn't exist.
+ */
+adv_error mame_ui_profiler_node_get(unsigned thread, unsigned index, const char** name, int* parent, unsigned* calls, double* total, double* self)
+{
+#if (defined(MAME_DEBUG) || defined(MAME_PROFILER)) && !defined(MESS)
+	const profiler_node* node;
+	double scale = 1.0 / (double)osd_profiling_ticks_per_second();
+	int count;
+
+	node = profiler_get_nodes(thread, &count);
+
+	/* skip the root */
+	if ((int)index + 1 >= count)
+		return -1;
+	node += index + 1;
+
+	*name = profiler_get_scope_name(node->scope);
+	*parent = node->parent - 1;
+	*calls = node->calls;
+	*total = node->total * scale;
+	*self = node->self * scale;
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * Get an event of the trace of a profiled thread.
+ * \param thread Index of the thread.
+ * \param index Index of the event, starting from 0.
+ * \param name Where to put the name of the scope entered, 0 if the event exits the last scope.
+ * \param time Where to put the time of the event from the start of the profiler, in seconds.
+ * \return 0 on success, -1 if the event doesn't exist.
+ */
+adv_error mame_ui_profiler_event_get(unsigned thread, unsigned index, const char** name, double* time)
+{
+#if (defined(MAME_DEBUG) || defined(MAME_PROFILER)) && !defined(MESS)
+	const profiler_event* event;
+	int count;
+
+	event = profiler_get_events(thread, &count);
+	if ((int)index >= count)
+		return -1;
+	event += index;
+
+	*name = event->scope != PROFILER_END ? profiler_get_scope_name(event->scope) : 0;
+	*time = event->ticks / (double)osd_profiling_ticks_per_second();
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * Check if the game state can be saved.
+ */
+adv_bool mame_ui_state_supported(void)
+{
+#ifdef MESS
+	/* the MESS core doesn't save the state in memory */
+	return 0;
+#else
+	return (Machine->gamedrv->flags & GAME_SUPPORTS_SAVE) != 0;
+#endif
+}
+
+#ifndef MESS
+/**
+ * Schedule a call at the end of the current timeslice.
+ * Only in the callback the state can be saved and loaded.
+ */
+void mame_ui_state_schedule(void (*callback)(void))
+{
+	mame_schedule_state_callback(callback);
+}
+
+/**
+ * Save the game state in memory.
+ * The saved data remains valid up to the next save.
+ * If a reference is set, only the differences with it are saved.
+ */
+adv_error mame_ui_state_save(const unsigned char** data, unsigned* size)
+{
+	UINT32 data_size;
+
+	if (mame_save_state_memory() != 0)
+		return -1;
+
+	*data = state_save_get_memory(&data_size);
+	*size = data_size;
+	if (!*data)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Load a game state saved in memory.
+ */
+adv_error mame_ui_state_load(const unsigned char* data, unsigned size)
+{
+	if (mame_load_state_memory(data, size) != 0)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Set the reference of the next saves.
+ * \param data State to use as reference, or 0 to save full states.
+ */
+adv_error mame_ui_state_reference(const unsigned char* data, unsigned size)
+{
+	if (!data) {
+		state_save_clear_reference();
+		return 0;
+	}
+
+	if (state_save_set_reference(data, size) != 0)
+		return -1;
+
+	return 0;
+}
+#else
+void mame_ui_state_schedule(void (*callback)(void))
+{
+}
+
+adv_error mame_ui_state_save(const unsigned char** data, unsigned* size)
+{
+	return -1;
+}
+
+adv_error mame_ui_state_load(const unsigned char* data, unsigned size)
+{
+	return -1;
+}
+
+adv_error mame_ui_state_reference(const unsigned char* data, unsigned size)
+{
+	return -1;
+}
+#endif
+
 /**
  * Check if a MAME port is active.
  * A port is active if the associated key sequence is pressed.
@@ -2099,6 +2335,74 @@ void mame_ui_gamma_factor_set(double gamma)
 	palette_set_global_gamma(palette_get_global_gamma() * gamma);
 }
 
+/**
+ * Exchange the screen bitmap of the core with a second one.
+ * After the call the core draws the next frames in the other bitmap,
+ * and the bitmap of the current frame remains unchanged until the next call.
+ * It's used to pass the frame at the video thread without copying it.
+ * Before the core draws again, the other bitmap must be filled with the
+ * current frame calling mame_video_swap_copy(), because many drivers
+ * redraw only the changed parts, or nothing, keeping the previous contents.
+ * \return
+ * - ==0 Exchange not possible, the bitmap must be copied.
+ * - ==1 Exchange done.
+ */
+int mame_video_swap(void)
+{
+
+	/* the vector games erase only the pixels drawn in the previous frame */
+	if (GLUE.option.vector_flag)
+		return 0;
+
+	/* the artwork draws in a different bitmap */
+	if (!GLUE.bitmap || GLUE.bitmap != scrbitmap[0])
+		return 0;
+
+	if (!GLUE.bitmap_alt) {
+		GLUE.bitmap_alt = bitmap_alloc_depth(GLUE.bitmap->width, GLUE.bitmap->height, GLUE.bitmap->depth);
+		if (!GLUE.bitmap_alt)
+			return 0;
+		GLUE.bitmap_screen = scrbitmap[0];
+		log_std(("glue: allocated the second screen bitmap %dx%dx%d\n", GLUE.bitmap->width, GLUE.bitmap->height, GLUE.bitmap->depth));
+	}
+
+	if (scrbitmap[0] == GLUE.bitmap_screen)
+		scrbitmap[0] = GLUE.bitmap_alt;
+	else
+		scrbitmap[0] = GLUE.bitmap_screen;
+
+	return 1;
+}
+
+/**
+ * Fill the screen bitmap of the core with the frame passed by mame_video_swap().
+ * The screen bitmap of the core already contains an older frame, usually the
+ * previous one, so only the changed rows are copied, and nothing if the
+ * frame is unchanged.
+ * It can be called from a different thread, but the core must not draw
+ * before the end of the copy.
+ */
+void mame_video_swap_copy(void)
+{
+	mame_bitmap* front;
+	mame_bitmap* back = scrbitmap[0];
+	unsigned size;
+	int y;
+
+	if (back == GLUE.bitmap_screen)
+		front = GLUE.bitmap_alt;
+	else
+		front = GLUE.bitmap_screen;
+
+	size = back->width * ((back->depth + 7) / 8);
+
+	/* the core draws the next frame over the current one */
+	for(y=0;y<back->height;++y) {
+		if (memcmp(back->line[y], front->line[y], size) != 0)
+			memcpy(back->line[y], front->line[y], size);
+	}
+}
+
 /***************************************************************************/
 /* OSD */
 
@@ -2237,6 +2541,14 @@ void osd_close_display(void)
 
 	if (GLUE.video_flag)
 		osd2_video_done();
+
+	/* restore the bitmap of the core, it's freed by the core itself */
+	if (GLUE.bitmap_alt) {
+		scrbitmap[0] = GLUE.bitmap_screen;
+		bitmap_free(GLUE.bitmap_alt);
+		GLUE.bitmap_alt = 0;
+		GLUE.bitmap_screen = 0;
+	}
 }
 
 /**
@@ -2534,11 +2846,31 @@ cycles_t osd_cycles_per_second(void)
 /**
  * Time measure for profiling.
  * It must return the maximum precise timer available.
- * The time base isn't required.
+ * The monotonic clock is read without a system call on Linux.
  */
 cycles_t osd_profiling_ticks(void)
 {
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * (cycles_t)1000000000 + ts.tv_nsec;
+#else
 	return target_clock();
+#endif
+}
+
+/**
+ * Time base for profiling.
+ */
+cycles_t osd_profiling_ticks_per_second(void)
+{
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+	return 1000000000;
+#else
+	return TARGET_CLOCKS_PER_SEC;
+#endif
 }
 
 /**
@@ -2680,6 +3012,8 @@ int osd_handle_user_interface(mame_bitmap *bitmap, int is_menu_active)
 	/* continous input, a direct MAME function doesn't exist */
 	if (seq_pressed(input_port_default_seq(IPT_UI_TURBO, 0, SEQ_TYPE_STANDARD)))
 		input |= OSD_INPUT_TURBO;
+	if (seq_pressed(input_port_default_seq(IPT_UI_REWIND, 0, SEQ_TYPE_STANDARD)))
+		input |= OSD_INPUT_REWIND;
 	if (seq_pressed(input_port_default_seq(IPT_UI_PAN_RIGHT, 0, SEQ_TYPE_STANDARD)))
 		input |= OSD_INPUT_PAN_RIGHT;
 	if (seq_pressed(input_port_default_seq(IPT_UI_PAN_LEFT, 0, SEQ_TYPE_STANDARD)))
@@ -2890,6 +3224,7 @@ adv_error mame_init(struct advance_context* context)
 	conf_float_register_limit_default(context->cfg, "display_brightness", 0.1, 10.0, 1.0);
 
 	conf_bool_register_default(context->cfg, "misc_cheat", 0);
+	conf_int_register_limit_default(context->cfg, "misc_runahead", 0, 8, 0);
 	conf_string_register_default(context->cfg, "misc_languagefile", "english.lng");
 	conf_string_register_default(context->cfg, "misc_cheatfile", "cheat.dat");
 
@@ -2940,6 +3275,7 @@ adv_error mame_config_load(adv_conf* cfg_context, struct mame_option* option)
 	option->brightness = conf_float_get_default(cfg_context, "display_brightness");
 
 	option->cheat_flag = conf_bool_get_default(cfg_context, "misc_cheat");
+	option->runahead = conf_int_get_default(cfg_context, "misc_runahead");
 
 	sncpy(option->language_file_buffer, sizeof(option->language_file_buffer), conf_string_get_default(cfg_context, "misc_languagefile"));
 
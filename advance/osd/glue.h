@@ -99,6 +99,12 @@ struct mame_option {
 	char hiscore_file_buffer[MAME_MAXPATH];
 	char bios_buffer[MAME_MAXBIOS];
 
+	unsigned chd_cache;
+	unsigned chd_readahead;
+	unsigned zip_cache;
+
+	unsigned runahead;
+
 #ifdef MESS
 	char crc_dir_buffer[MAME_MAXPATH];
 	struct mame_image* image_map[MAME_MAXIMAGE];
@@ -249,7 +255,20 @@ void mame_ui_refresh(void);
 void mame_ui_gamma_factor_set(double gamma);
 unsigned char mame_ui_cpu_read(unsigned cpu, unsigned addr);
 unsigned mame_ui_frames_per_second(void);
+unsigned mame_ui_runahead_info(double* frame_time, double* state_time);
+void mame_ui_profiler_start(unsigned trace_max);
+adv_error mame_ui_profiler_get(unsigned index, const char** tag, double* time);
+unsigned mame_ui_profiler_thread_count(void);
+adv_error mame_ui_profiler_node_get(unsigned thread, unsigned index, const char** name, int* parent, unsigned* calls, double* total, double* self);
+adv_error mame_ui_profiler_event_get(unsigned thread, unsigned index, const char** name, double* time);
 void mame_ui_input_map(unsigned* pdigital_mac, struct mame_digital_map_entry* digital_map, unsigned digital_max);
+adv_bool mame_ui_state_supported(void);
+void mame_ui_state_schedule(void (*callback)(void));
+adv_error mame_ui_state_save(const unsigned char** data, unsigned* size);
+adv_error mame_ui_state_load(const unsigned char* data, unsigned size);
+adv_error mame_ui_state_reference(const unsigned char* data, unsigned size);
+int mame_video_swap(void);
+void mame_video_swap_copy(void);
 
 /***************************************************************************/
 /* OSD interface */
@@ -347,6 +366,7 @@ typedef unsigned osd_input;
 #define OSD_INPUT_SELECT 0x00010000
 #define OSD_INPUT_CANCEL 0x00020000
 #define OSD_INPUT_CONFIGURE 0x00040000
+#define OSD_INPUT_REWIND 0x00080000
 #define OSD_INPUT_COIN1 0x00100000
 #define OSD_INPUT_COIN2 0x00200000
 #define OSD_INPUT_COIN3 0x00400000
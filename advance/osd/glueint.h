@@ -52,6 +52,9 @@
 #include "../../src/osdepend.h"
 #include "../../src/ui_text.h"
 #include "../../src/profiler.h"
+#include "../../src/chd.h"
+#include "../../src/hash.h"
+#include "../../src/unzip.h"
 
 #endif
 
@@ -63,6 +66,7 @@
 #define IPT_UI_MODE_PRED IPT_OSD_6
 #define IPT_UI_RECORD_START IPT_OSD_7
 #define IPT_UI_RECORD_STOP IPT_OSD_8
+#define IPT_UI_REWIND IPT_OSD_9
 
 input_seq* glue_portdef_seq_get(input_port_default_entry* port, int seqtype);
 input_seq* glue_port_seq_get(input_port_entry* port, int seqtype);
@@ -2507,7 +2507,7 @@ void advance_input_force_exit(struct advance_input_context* context)
 	context->state.input_forced_exit_flag = 1;
 }
 
-void advance_input_update(struct advance_input_context* context, struct advance_safequit_context* safequit_context, adv_bool is_pause)
+void advance_input_update(struct advance_input_context* context, struct advance_safequit_context* safequit_context, struct advance_rewind_context* rewind_context, adv_bool is_pause, adv_bool rewind_flag)
 {
 	assert(context->state.active_flag != 0);
 
@@ -2522,6 +2522,9 @@ void advance_input_update(struct advance_input_context* context, struct advance_
 
 	advance_safequit_update(safequit_context);
 
+	/* the rewind goes back while the input is held */
+	advance_rewind_update(rewind_context, rewind_flag, is_pause);
+
 	/* forced exit due idle timeout */
 	if (context->config.input_idle_limit && (context->state.input_current_clock - context->state.input_idle_clock) > context->config.input_idle_limit * TARGET_CLOCKS_PER_SEC) {
 		context->state.input_forced_exit_flag = 1;
@@ -0,0 +1,253 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2002, 2003, 2004, 2005 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+
+#include "portable.h"
+
+#include "emu.h"
+
+#include "advance.h"
+
+/**
+ * Node of the call tree of a thread.
+ */
+struct profile_node {
+	const char* name;
+	int parent;
+	unsigned calls;
+	double total;
+	double self;
+};
+
+/**
+ * Write a name as a JSON string.
+ */
+static void profile_json_name(FILE* f, const char* name)
+{
+	fputc('"', f);
+	for(;*name;++name) {
+		if (*name == '"' || *name == '\\')
+			fputc('\\', f);
+		fputc(*name, f);
+	}
+	fputc('"', f);
+}
+
+/**
+ * Write a name inside a quoted CSV field.
+ */
+static void profile_csv_name(FILE* f, const char* name)
+{
+	for(;*name;++name) {
+		if (*name == '"')
+			fputc('"', f);
+		fputc(*name, f);
+	}
+}
+
+/**
+ * Write the path of a node, with the scopes separated by ';'.
+ */
+static void profile_csv_path(FILE* f, struct profile_node* map, int i)
+{
+	if (map[i].parent >= 0) {
+		profile_csv_path(f, map, map[i].parent);
+		fputc(';', f);
+	}
+	profile_csv_name(f, map[i].name);
+}
+
+/**
+ * Save the call trees of all the threads in CSV format.
+ * A line for every node, with the times in seconds.
+ */
+static adv_error profile_save_csv(const char* file)
+{
+	struct profile_node* map;
+	unsigned thread;
+	unsigned mac;
+	unsigned max;
+	FILE* f;
+
+	f = fopen(file, "w");
+	if (!f) {
+		target_err("Error opening the profile file '%s'.\n", file);
+		return -1;
+	}
+
+	fprintf(f, "thread,scope,calls,total,self\n");
+
+	for(thread=0;thread<mame_ui_profiler_thread_count();++thread) {
+		struct profile_node node;
+
+		/* the parents come before their children, so the paths can be built while reading */
+		max = 0;
+		mac = 0;
+		map = 0;
+		while (mame_ui_profiler_node_get(thread, mac, &node.name, &node.parent, &node.calls, &node.total, &node.self) == 0) {
+			if (mac == max) {
+				struct profile_node* map_new;
+				max = max ? 2 * max : 256;
+				map_new = realloc(map, max * sizeof(struct profile_node));
+				if (!map_new) {
+					target_err("Low memory saving the profile file '%s'.\n", file);
+					free(map);
+					fclose(f);
+					return -1;
+				}
+				map = map_new;
+			}
+			map[mac] = node;
+
+			fprintf(f, "%u,\"", thread);
+			profile_csv_path(f, map, mac);
+			fprintf(f, "\",%u,%.9f,%.9f\n", node.calls, node.total, node.self);
+
+			++mac;
+		}
+
+		free(map);
+	}
+
+	if (fclose(f) != 0) {
+		target_err("Error writing the profile file '%s'.\n", file);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Save the traces of all the threads in the Chrome trace event format.
+ * The file can be opened with chrome://tracing or Perfetto.
+ */
+static adv_error profile_save_trace(const char* file)
+{
+	unsigned thread;
+	const char* sep;
+	FILE* f;
+
+	f = fopen(file, "w");
+	if (!f) {
+		target_err("Error opening the trace file '%s'.\n", file);
+		return -1;
+	}
+
+	fprintf(f, "{\"traceEvents\":[\n");
+	sep = "";
+
+	for(thread=0;thread<mame_ui_profiler_thread_count();++thread) {
+		const char* name;
+		double time;
+		double last;
+		unsigned depth;
+		unsigned i;
+
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}", sep, thread, thread == 0 ? "main" : "thread", thread);
+		sep = ",\n";
+
+		depth = 0;
+		last = 0;
+		for(i=0;mame_ui_profiler_event_get(thread, i, &name, &time) == 0;++i) {
+			/* the events of the scopes opened before the start are missing */
+			if (!name && depth == 0)
+				continue;
+
+			fprintf(f, "%s{", sep);
+			if (name) {
+				fprintf(f, "\"name\":");
+				profile_json_name(f, name);
+				fprintf(f, ",\"ph\":\"B\"");
+				++depth;
+			} else {
+				fprintf(f, "\"ph\":\"E\"");
+				--depth;
+			}
+			fprintf(f, ",\"pid\":0,\"tid\":%u,\"ts\":%.3f}", thread, time * 1E6);
+			last = time;
+		}
+
+		/* close the scopes still open when the trace buffer was full */
+		while (depth > 0) {
+			fprintf(f, "%s{\"ph\":\"E\",\"pid\":0,\"tid\":%u,\"ts\":%.3f}", sep, thread, last * 1E6);
+			--depth;
+		}
+	}
+
+	fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	if (fclose(f) != 0) {
+		target_err("Error writing the trace file '%s'.\n", file);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Start the profiler at the begin of the emulation.
+ * The profiler is started only if requested, it has a cost.
+ * \param bench_flag If the benchmark is running, it reports the profiler times.
+ */
+void advance_profile_start(struct advance_profile_context* context, adv_bool bench_flag)
+{
+	if (!bench_flag && !context->config.csv_buffer[0] && !context->config.trace_buffer[0])
+		return;
+
+	mame_ui_profiler_start(context->config.trace_buffer[0] ? PROFILE_TRACE_MAX : 0);
+}
+
+/**
+ * Save the profiler results at the end of the emulation.
+ */
+adv_error advance_profile_save(struct advance_profile_context* context)
+{
+	if (!context->config.csv_buffer[0] && !context->config.trace_buffer[0])
+		return 0;
+
+	if (mame_ui_profiler_thread_count() == 0) {
+		target_err("The profiler isn't available, run ./configure with --enable-profiler.\n");
+		return -1;
+	}
+
+	if (context->config.csv_buffer[0]) {
+		if (profile_save_csv(context->config.csv_buffer) != 0)
+			return -1;
+		log_std(("emu:profile: saved %s\n", context->config.csv_buffer));
+	}
+
+	if (context->config.trace_buffer[0]) {
+		if (profile_save_trace(context->config.trace_buffer) != 0)
+			return -1;
+		log_std(("emu:profile: saved %s\n", context->config.trace_buffer));
+	}
+
+	return 0;
+}
@@ -116,6 +116,45 @@ static adv_error sound_start(struct advance_record_context* context, const char*
 	return 0;
 }
 
+/**
+ * Write some samples in the sound file.
+ * \param map samples buffer
+ * \param mac number of 16 bit samples mono or stereo
+ */
+static adv_error sound_write(struct advance_record_context* context, const short* map, unsigned mac)
+{
+	unsigned char buffer[2048];
+	unsigned count;
+	unsigned i;
+
+	count = mac * context->state.sound_sample_size / 2;
+
+	while (count) {
+		unsigned run = count;
+		if (run > sizeof(buffer) / 2)
+			run = sizeof(buffer) / 2;
+
+		for(i=0;i<run;++i)
+			le_uint16_write(buffer + i * 2, map[i]);
+
+		if (fwrite(buffer, 2, run, context->state.sound_f) != run) {
+			log_std(("ERROR: writing file %s\n", context->state.sound_file_buffer));
+			return -1;
+		}
+
+		map += run;
+		count -= run;
+	}
+
+	return 0;
+}
+
+#ifdef USE_SMP
+static struct advance_record_slot* queue_get(struct advance_record_context* context, unsigned type);
+static void queue_put(struct advance_record_context* context);
+static adv_error queue_alloc(struct advance_record_slot* slot, unsigned size);
+#endif
+
 /**
  * Insert some data in the sound recording. Automatically save if full.
  * \param map samples buffer
@@ -123,8 +162,6 @@ static adv_error sound_start(struct advance_record_context* context, const char*
  */
 static adv_error sound_update(struct advance_record_context* context, const short* map, unsigned mac)
 {
-	unsigned i;
-
 	if (!context->state.sound_active_flag)
 		return -1;
 
@@ -139,20 +176,39 @@ static adv_error sound_update(struct advance_record_context* context, const shor
 		return 0;
 	}
 
-	for(i=0;i<mac * context->state.sound_sample_size / 2;++i) {
-		unsigned char p[2];
-		le_uint16_write(p, map[i]);
-		if (fwrite(p, 2, 1, context->state.sound_f) != 1)
-			goto err;
+#ifdef USE_SMP
+	if (context->state.queue_active_flag) {
+		struct advance_record_slot* slot;
+		unsigned size = mac * context->state.sound_sample_size;
+
+		/* the error is reported when the recording is stopped */
+		slot = queue_get(context, RECORD_SLOT_SOUND);
+		if (!slot)
+			return -1;
+
+		if (queue_alloc(slot, size) != 0)
+			return -1;
+
+		memcpy(slot->data_ptr, map, size);
+		slot->type = RECORD_SLOT_SOUND;
+		slot->sample_count = mac;
+
+		queue_put(context);
+
+		context->state.sound_sample_counter += mac;
+
+		return 0;
+	}
+#endif
+
+	if (sound_write(context, map, mac) != 0) {
+		sound_cancel(context);
+		return -1;
 	}
 
 	context->state.sound_sample_counter += mac;
 
 	return 0;
-err:
-	log_std(("ERROR: writing file %s\n", context->state.sound_file_buffer));
-	sound_cancel(context);
-	return -1;
 }
 
 /* Save and stop the current file recording */
@@ -216,6 +272,7 @@ static void video_cancel(struct advance_record_context* context)
 
 	context->state.video_active_flag = 0;
 
+	adv_mng_write_done(context->state.video_mng);
 	fzclose(context->state.video_f);
 	remove(context->state.video_file_buffer);
 }
@@ -287,24 +344,31 @@ static adv_error video_start(struct advance_record_context* context, const char*
 
 	png_orientation_size(&pix_width, &pix_height, orientation);
 
-	if (adv_mng_write_mhdr(pix_width, pix_height, context->state.video_freq_base, 1, context->state.video_f, 0) != 0) {
+	/* not LC, the frames are written as differences from the previous one */
+	if (adv_mng_write_mhdr(pix_width, pix_height, context->state.video_freq_base, 0, context->state.video_f, 0) != 0) {
 		log_std(("ERROR: writing header in file %s\n", context->state.video_file_buffer));
 		fzclose(context->state.video_f);
 		remove(context->state.video_file_buffer);
 		return -1;
 	}
 
+	context->state.video_mng = adv_mng_write_init(pix_width, pix_height, 1, 1);
+	if (!context->state.video_mng) {
+		log_std(("ERROR: low memory for file %s\n", context->state.video_file_buffer));
+		fzclose(context->state.video_f);
+		remove(context->state.video_file_buffer);
+		return -1;
+	}
+
 	context->state.video_active_flag = 1;
 
 	return 0;
 }
 
 /**
- * Insert some data in the video recording. Automatically save if full.
- * \param map samples buffer
- * \param mac number of 16 bit samples mono or stereo in little endian format
+ * Write a frame in the video file.
  */
-static adv_error video_update(struct advance_record_context* context, const void* video_buffer, unsigned video_width, unsigned video_height, unsigned video_bytes_per_pixel, unsigned video_bytes_per_scanline, adv_color_def color_def, adv_color_rgb* palette_map, unsigned palette_max, unsigned orientation)
+static adv_error video_write(struct advance_record_context* context, const void* video_buffer, unsigned video_width, unsigned video_height, unsigned video_bytes_per_pixel, unsigned video_bytes_per_scanline, adv_color_def color_def, adv_color_rgb* palette_map, unsigned palette_max, unsigned orientation)
 {
 	const uint8* pix_ptr;
 	unsigned pix_width;
@@ -312,6 +376,32 @@ static adv_error video_update(struct advance_record_context* context, const void
 	int pix_pixel_pitch;
 	int pix_scanline_pitch;
 
+	pix_ptr = video_buffer;
+	pix_width = video_width;
+	pix_height = video_height;
+	pix_pixel_pitch = video_bytes_per_pixel;
+	pix_scanline_pitch = video_bytes_per_scanline;
+
+	png_orientation(&pix_ptr, &pix_width, &pix_height, &pix_pixel_pitch, &pix_scanline_pitch, orientation);
+
+	if (adv_mng_write_fram(context->state.video_freq_step, context->state.video_f, 0) != 0) {
+		log_std(("ERROR: writing image frame in file %s\n", context->state.video_file_buffer));
+		return -1;
+	}
+
+	if (adv_mng_write_image_def(context->state.video_mng, pix_width, pix_height, color_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, palette_map, palette_max, context->state.video_f, 0)!=0) {
+		log_std(("ERROR: writing image data in file %s\n", context->state.video_file_buffer));
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Insert some data in the video recording. Automatically save if full.
+ */
+static adv_error video_update(struct advance_record_context* context, const void* video_buffer, unsigned video_width, unsigned video_height, unsigned video_bytes_per_pixel, unsigned video_bytes_per_scanline, adv_color_def color_def, adv_color_rgb* palette_map, unsigned palette_max, unsigned orientation)
+{
 	if (!context->state.video_active_flag)
 		return -1;
 
@@ -331,29 +421,57 @@ static adv_error video_update(struct advance_record_context* context, const void
 		return 0;
 	}
 
-	pix_ptr = video_buffer;
-	pix_width = video_width;
-	pix_height = video_height;
-	pix_pixel_pitch = video_bytes_per_pixel;
-	pix_scanline_pitch = video_bytes_per_scanline;
+#ifdef USE_SMP
+	if (context->state.queue_active_flag) {
+		struct advance_record_slot* slot;
+		unsigned row = video_width * video_bytes_per_pixel;
+		unsigned y;
+
+		/* the error is reported when the recording is stopped */
+		slot = queue_get(context, RECORD_SLOT_VIDEO);
+		if (!slot)
+			return -1;
+
+		if (queue_alloc(slot, row * video_height) != 0)
+			return -1;
+
+		/* copy the frame packed, the game continues to draw on the original */
+		for(y=0;y<video_height;++y)
+			memcpy(slot->data_ptr + y * row, (const uint8*)video_buffer + y * video_bytes_per_scanline, row);
+
+		slot->palette_max = 0;
+		if (palette_map && palette_max) {
+			if (slot->palette_size < palette_max) {
+				free(slot->palette_map);
+				slot->palette_size = 0;
+				slot->palette_map = malloc(palette_max * sizeof(adv_color_rgb));
+				if (!slot->palette_map)
+					return -1;
+				slot->palette_size = palette_max;
+			}
+			memcpy(slot->palette_map, palette_map, palette_max * sizeof(adv_color_rgb));
+			slot->palette_max = palette_max;
+		}
 
-	png_orientation(&pix_ptr, &pix_width, &pix_height, &pix_pixel_pitch, &pix_scanline_pitch, orientation);
+		slot->type = RECORD_SLOT_VIDEO;
+		slot->width = video_width;
+		slot->height = video_height;
+		slot->bytes_per_pixel = video_bytes_per_pixel;
+		slot->color_def = color_def;
+		slot->orientation = orientation;
 
-	if (adv_mng_write_fram(context->state.video_freq_step, context->state.video_f, 0) != 0) {
-		log_std(("ERROR: writing image frame in file %s\n", context->state.video_file_buffer));
-		goto err;
+		queue_put(context);
+
+		return 0;
 	}
+#endif
 
-	if (adv_png_write_raw_def(pix_width, pix_height, color_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, palette_map, palette_max, 1, context->state.video_f, 0)!=0) {
-		log_std(("ERROR: writing image data in file %s\n", context->state.video_file_buffer));
-		goto err;
+	if (video_write(context, video_buffer, video_width, video_height, video_bytes_per_pixel, video_bytes_per_scanline, color_def, palette_map, palette_max, orientation) != 0) {
+		video_cancel(context);
+		return -1;
 	}
 
 	return 0;
-
-err:
-	video_cancel(context);
-	return -1;
 }
 
 /* Save and stop the current file recording */
@@ -364,6 +482,8 @@ static adv_error video_stop(struct advance_record_context* context, unsigned* ti
 
 	context->state.video_active_flag = 0;
 
+	adv_mng_write_done(context->state.video_mng);
+
 	if (adv_mng_write_mend(context->state.video_f, 0)!=0) {
 		goto err;
 	}
@@ -381,6 +501,215 @@ err:
 	return -1;
 }
 
+/*************************************************************************************/
+/* Queue */
+
+#ifdef USE_SMP
+
+/*
+ * The sound and the video recording are written by a separated thread.
+ * The emulation copies the data in a ring of slots, and waits only
+ * if the ring is full. The sound and the video share the same ring
+ * to keep the order of the writes.
+ */
+
+static adv_error queue_alloc(struct advance_record_slot* slot, unsigned size)
+{
+	if (slot->data_size >= size)
+		return 0;
+
+	free(slot->data_ptr);
+	slot->data_size = 0;
+
+	slot->data_ptr = malloc(size);
+	if (!slot->data_ptr) {
+		log_std(("ERROR: low memory for the recording queue\n"));
+		return -1;
+	}
+
+	slot->data_size = size;
+
+	return 0;
+}
+
+/**
+ * Get the next free slot, waiting for it if the queue is full.
+ * The slot is sent to the writer with queue_put().
+ * \return 0 if the recording of this type had an error.
+ */
+static struct advance_record_slot* queue_get(struct advance_record_context* context, unsigned type)
+{
+	struct advance_record_slot* slot;
+
+	pthread_mutex_lock(&context->state.queue_mutex);
+
+	if ((type == RECORD_SLOT_SOUND && context->state.queue_sound_error_flag)
+		|| (type == RECORD_SLOT_VIDEO && context->state.queue_video_error_flag)) {
+		pthread_mutex_unlock(&context->state.queue_mutex);
+		return 0;
+	}
+
+	if (context->state.queue_count == RECORD_QUEUE_MAX) {
+		target_clock_t start = target_clock();
+
+		while (context->state.queue_count == RECORD_QUEUE_MAX)
+			pthread_cond_wait(&context->state.queue_cond, &context->state.queue_mutex);
+
+		context->state.queue_wait_time += target_clock() - start;
+		++context->state.queue_wait_counter;
+	}
+
+	slot = &context->state.queue_map[(context->state.queue_pos + context->state.queue_count) % RECORD_QUEUE_MAX];
+
+	pthread_mutex_unlock(&context->state.queue_mutex);
+
+	return slot;
+}
+
+/**
+ * Show the state of the queue in the OSD, at most one time every second.
+ * It's shown only if the writer is late, i.e. if the queue isn't
+ * empty or if it was full from the last report.
+ * The queue mutex must be locked.
+ */
+static void queue_report(struct advance_record_context* context)
+{
+	target_clock_t now = target_clock();
+
+	if (now - context->state.queue_report_time < TARGET_CLOCKS_PER_SEC)
+		return;
+
+	context->state.queue_report_time = now;
+
+	/* the slot just queued is always present */
+	if (context->state.queue_count <= 1 && context->state.queue_wait_counter == context->state.queue_report_wait_counter)
+		return;
+
+	context->state.queue_report_wait_counter = context->state.queue_wait_counter;
+
+	advance_global_message(&CONTEXT.global, "Recording queue %u/%u, %u slow downs", context->state.queue_count, RECORD_QUEUE_MAX, context->state.queue_wait_counter);
+}
+
+static void queue_put(struct advance_record_context* context)
+{
+	pthread_mutex_lock(&context->state.queue_mutex);
+
+	++context->state.queue_count;
+	if (context->state.queue_count > context->state.queue_max)
+		context->state.queue_max = context->state.queue_count;
+
+	queue_report(context);
+
+	pthread_cond_broadcast(&context->state.queue_cond);
+
+	pthread_mutex_unlock(&context->state.queue_mutex);
+}
+
+static void* queue_thread(void* void_context)
+{
+	struct advance_record_context* context = void_context;
+
+	pthread_mutex_lock(&context->state.queue_mutex);
+
+	while (1) {
+		struct advance_record_slot* slot;
+		adv_bool sound_error;
+		adv_bool video_error;
+
+		while (!context->state.queue_count && !context->state.queue_exit_flag)
+			pthread_cond_wait(&context->state.queue_cond, &context->state.queue_mutex);
+
+		/* exit only when all the data is written */
+		if (!context->state.queue_count)
+			break;
+
+		slot = &context->state.queue_map[context->state.queue_pos];
+		sound_error = context->state.queue_sound_error_flag;
+		video_error = context->state.queue_video_error_flag;
+
+		/* the compression and the file write are done without locks */
+		pthread_mutex_unlock(&context->state.queue_mutex);
+
+		if (slot->type == RECORD_SLOT_SOUND) {
+			if (!sound_error && sound_write(context, (const short*)slot->data_ptr, slot->sample_count) != 0)
+				sound_error = 1;
+		} else {
+			if (!video_error && video_write(context, slot->data_ptr, slot->width, slot->height, slot->bytes_per_pixel, slot->width * slot->bytes_per_pixel, slot->color_def, slot->palette_max ? slot->palette_map : 0, slot->palette_max, slot->orientation) != 0)
+				video_error = 1;
+		}
+
+		pthread_mutex_lock(&context->state.queue_mutex);
+
+		context->state.queue_sound_error_flag = sound_error;
+		context->state.queue_video_error_flag = video_error;
+		context->state.queue_pos = (context->state.queue_pos + 1) % RECORD_QUEUE_MAX;
+		--context->state.queue_count;
+
+		pthread_cond_broadcast(&context->state.queue_cond);
+	}
+
+	pthread_mutex_unlock(&context->state.queue_mutex);
+
+	return 0;
+}
+
+/* Start the writer thread, if it fails the recording is written directly */
+static void queue_start(struct advance_record_context* context)
+{
+	context->state.queue_pos = 0;
+	context->state.queue_count = 0;
+	context->state.queue_max = 0;
+	context->state.queue_wait_counter = 0;
+	context->state.queue_wait_time = 0;
+	context->state.queue_report_time = target_clock();
+	context->state.queue_report_wait_counter = 0;
+	context->state.queue_sound_error_flag = 0;
+	context->state.queue_video_error_flag = 0;
+	context->state.queue_exit_flag = 0;
+
+	if (pthread_create(&context->state.queue_thread, NULL, queue_thread, context) != 0) {
+		log_std(("ERROR: creating the recording thread, recording without it\n"));
+		return;
+	}
+
+	context->state.queue_active_flag = 1;
+}
+
+/* Write all the queued data and stop the writer thread */
+static void queue_stop(struct advance_record_context* context)
+{
+	if (!context->state.queue_active_flag)
+		return;
+
+	pthread_mutex_lock(&context->state.queue_mutex);
+	context->state.queue_exit_flag = 1;
+	pthread_cond_broadcast(&context->state.queue_cond);
+	pthread_mutex_unlock(&context->state.queue_mutex);
+
+	pthread_join(context->state.queue_thread, NULL);
+
+	context->state.queue_active_flag = 0;
+
+	log_std(("advance:record: queue max %u/%u, full %u times, waited %g [s]\n", context->state.queue_max, RECORD_QUEUE_MAX, context->state.queue_wait_counter, context->state.queue_wait_time / (double)TARGET_CLOCKS_PER_SEC));
+
+	if (context->state.queue_sound_error_flag)
+		sound_cancel(context);
+	if (context->state.queue_video_error_flag)
+		video_cancel(context);
+}
+
+static void queue_free(struct advance_record_context* context)
+{
+	unsigned i;
+
+	for(i=0;i<RECORD_QUEUE_MAX;++i) {
+		free(context->state.queue_map[i].data_ptr);
+		free(context->state.queue_map[i].palette_map);
+	}
+}
+
+#endif
+
 /*************************************************************************************/
 /* Snapshot */
 
@@ -508,6 +837,12 @@ void osd_record_start(void)
 	char path_wav[FILE_MAXPATH];
 	char path_mng[FILE_MAXPATH];
 
+#ifdef USE_SMP
+	pthread_mutex_lock(&context->state.access_mutex);
+
+	queue_stop(context);
+#endif
+
 	if (context->config.sound_flag && sound_context->state.rate) {
 		sound_cancel(context); /* ignore error */
 	}
@@ -520,10 +855,6 @@ void osd_record_start(void)
 
 	advance_global_message(&CONTEXT.global, "Start recording");
 
-#ifdef USE_SMP
-	pthread_mutex_lock(&context->state.access_mutex);
-#endif
-
 	log_std(("osd: osd_record_start()\n"));
 
 	if (context->config.sound_flag && sound_context->state.rate) {
@@ -543,6 +874,9 @@ void osd_record_start(void)
 	}
 
 #ifdef USE_SMP
+	if (context->state.sound_active_flag || context->state.video_active_flag)
+		queue_start(context);
+
 	pthread_mutex_unlock(&context->state.access_mutex);
 #endif
 }
@@ -553,9 +887,15 @@ void osd_record_stop(void)
 
 	unsigned sound_time;
 	unsigned video_time;
+	unsigned wait_counter = 0;
 
 #ifdef USE_SMP
 	pthread_mutex_lock(&context->state.access_mutex);
+
+	/* flush the queue before writing the trailers */
+	queue_stop(context);
+
+	wait_counter = context->state.queue_wait_counter;
 #endif
 
 	log_std(("osd: osd_record_stop()\n"));
@@ -566,8 +906,12 @@ void osd_record_stop(void)
 	pthread_mutex_unlock(&context->state.access_mutex);
 #endif
 
-	if (sound_time != 0 || video_time != 0)
-		advance_global_message(&CONTEXT.global, "Stop recording %d/%d [s]", sound_time, video_time);
+	if (sound_time != 0 || video_time != 0) {
+		if (wait_counter != 0)
+			advance_global_message(&CONTEXT.global, "Stop recording %d/%d [s], %d slow downs", sound_time, video_time, wait_counter);
+		else
+			advance_global_message(&CONTEXT.global, "Stop recording %d/%d [s]", sound_time, video_time);
+	}
 }
 
 static void advance_snapshot_next(struct advance_record_context* context, const mame_game* game, char* path_png, unsigned size)
@@ -695,8 +1039,15 @@ adv_error advance_record_init(struct advance_record_context* context, adv_conf*
 	conf_int_register_limit_default(cfg_context, "record_video_interleave", 1, 30, 2);
 
 #ifdef USE_SMP
+	memset(context->state.queue_map, 0, sizeof(context->state.queue_map));
+	context->state.queue_active_flag = 0;
+
 	if (pthread_mutex_init(&context->state.access_mutex, NULL) != 0)
 		return -1;
+	if (pthread_mutex_init(&context->state.queue_mutex, NULL) != 0)
+		return -1;
+	if (pthread_cond_init(&context->state.queue_cond, NULL) != 0)
+		return -1;
 #endif
 
 	return 0;
@@ -704,10 +1055,17 @@ adv_error advance_record_init(struct advance_record_context* context, adv_conf*
 
 void advance_record_done(struct advance_record_context* context)
 {
+#ifdef USE_SMP
+	queue_stop(context);
+#endif
+
 	sound_cancel(context);
 	video_cancel(context);
 
 #ifdef USE_SMP
+	queue_free(context);
+	pthread_cond_destroy(&context->state.queue_cond);
+	pthread_mutex_destroy(&context->state.queue_mutex);
 	pthread_mutex_destroy(&context->state.access_mutex);
 #endif
 }
@@ -0,0 +1,318 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2002, 2003, 2004, 2005 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+#include "portable.h"
+
+#include "emu.h"
+
+#include "advance.h"
+
+/**
+ * Get the state at the specified position, 0 is the oldest.
+ */
+static struct advance_rewind_entry* rewind_entry(struct advance_rewind_context* context, unsigned i)
+{
+	return &context->state.entry_map[(context->state.entry_pos + i) % context->state.entry_max];
+}
+
+/**
+ * Get the most recent state.
+ */
+static struct advance_rewind_entry* rewind_last(struct advance_rewind_context* context)
+{
+	return rewind_entry(context, context->state.entry_mac - 1);
+}
+
+/**
+ * Remove the oldest state.
+ */
+static void rewind_remove_first(struct advance_rewind_context* context)
+{
+	struct advance_rewind_entry* entry = rewind_entry(context, 0);
+
+	context->state.entry_size -= entry->size;
+	free(entry->data);
+
+	context->state.entry_pos = (context->state.entry_pos + 1) % context->state.entry_max;
+	--context->state.entry_mac;
+}
+
+/**
+ * Remove the most recent state.
+ */
+static void rewind_remove_last(struct advance_rewind_context* context)
+{
+	struct advance_rewind_entry* entry = rewind_last(context);
+
+	if (entry->id == context->state.reference)
+		context->state.reference = 0;
+
+	context->state.entry_size -= entry->size;
+	free(entry->data);
+
+	--context->state.entry_mac;
+}
+
+/**
+ * Search a state by identifier, starting from the most recent.
+ */
+static struct advance_rewind_entry* rewind_search(struct advance_rewind_context* context, unsigned id)
+{
+	unsigned i;
+
+	for(i=context->state.entry_mac;i>0;--i) {
+		struct advance_rewind_entry* entry = rewind_entry(context, i - 1);
+		if (entry->id == id)
+			return entry;
+		if (entry->id < id)
+			break;
+	}
+
+	return 0;
+}
+
+/**
+ * Insert a new state as the most recent.
+ */
+static adv_error rewind_insert(struct advance_rewind_context* context, const unsigned char* data, unsigned size, unsigned key)
+{
+	struct advance_rewind_entry* entry;
+	unsigned char* copy;
+
+	if (context->state.entry_mac == context->state.entry_max) {
+		unsigned max = context->state.entry_max ? 2 * context->state.entry_max : 64;
+		struct advance_rewind_entry* map;
+		unsigned i;
+
+		map = malloc(max * sizeof(struct advance_rewind_entry));
+		if (!map)
+			return -1;
+
+		for(i=0;i<context->state.entry_mac;++i)
+			map[i] = *rewind_entry(context, i);
+
+		free(context->state.entry_map);
+		context->state.entry_map = map;
+		context->state.entry_max = max;
+		context->state.entry_pos = 0;
+	}
+
+	copy = malloc(size);
+	if (!copy)
+		return -1;
+	memcpy(copy, data, size);
+
+	entry = rewind_entry(context, context->state.entry_mac);
+	entry->data = copy;
+	entry->size = size;
+	entry->id = context->state.entry_id++;
+	entry->key = key ? key : entry->id;
+
+	++context->state.entry_mac;
+	context->state.entry_size += size;
+
+	return 0;
+}
+
+/**
+ * Keep the states in the memory limit.
+ * A full state is removed with all the deltas referring it.
+ */
+static void rewind_shrink(struct advance_rewind_context* context)
+{
+	while (context->state.entry_size > context->config.buffer_size && context->state.entry_mac > 1) {
+		unsigned key = rewind_entry(context, 0)->key;
+
+		rewind_remove_first(context);
+		while (context->state.entry_mac != 0 && rewind_entry(context, 0)->key == key)
+			rewind_remove_first(context);
+	}
+}
+
+/**
+ * Save a new state, called by the core between two timeslices.
+ */
+static void rewind_save_callback(void)
+{
+	struct advance_rewind_context* context = &CONTEXT.rewind;
+	const unsigned char* data;
+	unsigned size;
+	unsigned key;
+	target_clock_t start;
+
+	start = target_clock();
+
+	/* save a full state if the reference isn't anymore in the buffer */
+	/* or if the deltas are getting too many */
+	key = context->state.reference;
+	if (key != 0 && (!rewind_search(context, key) || context->state.entry_id - key > REWIND_KEY_INTERVAL))
+		key = 0;
+
+	if (key == 0) {
+		mame_ui_state_reference(0, 0);
+		context->state.reference = 0;
+	}
+
+	if (mame_ui_state_save(&data, &size) != 0) {
+		/* try again at the next frame */
+		return;
+	}
+
+	context->state.frame_counter = 0;
+	context->state.rewind_flag = 0;
+
+	if (rewind_insert(context, data, size, key) != 0) {
+		log_std(("ERROR:emu:rewind: low memory\n"));
+		return;
+	}
+
+	/* a full state becomes the reference of the next ones */
+	if (key == 0) {
+		if (mame_ui_state_reference(data, size) == 0)
+			context->state.reference = rewind_last(context)->id;
+	}
+
+	rewind_shrink(context);
+
+	log_debug(("emu:rewind: save %s state of %u bytes in %g ms, %u states of %u bytes\n", key ? "delta" : "full", size, (target_clock() - start) * 1000.0 / TARGET_CLOCKS_PER_SEC, context->state.entry_mac, context->state.entry_size));
+}
+
+/**
+ * Load the previous state, called by the core between two timeslices.
+ */
+static void rewind_load_callback(void)
+{
+	struct advance_rewind_context* context = &CONTEXT.rewind;
+	struct advance_rewind_entry* entry;
+
+	/* the last state was already loaded, go back to the previous one */
+	if (context->state.rewind_flag && context->state.entry_mac > 1)
+		rewind_remove_last(context);
+
+	if (context->state.entry_mac == 0)
+		return;
+
+	entry = rewind_last(context);
+
+	/* a delta needs its full state as reference */
+	if (entry->key != entry->id && entry->key != context->state.reference) {
+		struct advance_rewind_entry* key = rewind_search(context, entry->key);
+
+		if (!key || mame_ui_state_reference(key->data, key->size) != 0) {
+			log_std(("ERROR:emu:rewind: invalid reference state\n"));
+			context->state.reference = 0;
+			return;
+		}
+
+		context->state.reference = key->id;
+	}
+
+	if (mame_ui_state_load(entry->data, entry->size) != 0) {
+		log_std(("ERROR:emu:rewind: invalid state\n"));
+		return;
+	}
+
+	context->state.frame_counter = 0;
+	context->state.rewind_flag = 1;
+}
+
+adv_error advance_rewind_init(struct advance_rewind_context* context, adv_conf* cfg_context)
+{
+	conf_int_register_limit_default(cfg_context, "misc_rewindbuffer", 0, 1024, 16);
+	conf_int_register_limit_default(cfg_context, "misc_rewindinterval", 1, 60, 4);
+	return 0;
+}
+
+void advance_rewind_done(struct advance_rewind_context* context)
+{
+}
+
+adv_error advance_rewind_inner_init(struct advance_rewind_context* context, struct mame_option* option)
+{
+	context->state.active_flag = 0;
+	context->state.entry_map = 0;
+	context->state.entry_pos = 0;
+	context->state.entry_mac = 0;
+	context->state.entry_max = 0;
+	context->state.entry_size = 0;
+	context->state.entry_id = 1;
+	context->state.reference = 0;
+	context->state.frame_counter = 0;
+	context->state.rewind_flag = 0;
+
+	return 0;
+}
+
+void advance_rewind_inner_done(struct advance_rewind_context* context)
+{
+	while (context->state.entry_mac != 0)
+		rewind_remove_first(context);
+
+	free(context->state.entry_map);
+	context->state.entry_map = 0;
+	context->state.entry_max = 0;
+}
+
+adv_error advance_rewind_config_load(struct advance_rewind_context* context, adv_conf* cfg_context)
+{
+	context->config.buffer_size = conf_int_get_default(cfg_context, "misc_rewindbuffer") * 1024 * 1024;
+	context->config.frame_interval = conf_int_get_default(cfg_context, "misc_rewindinterval");
+
+	return 0;
+}
+
+/**
+ * Update the rewind buffer at every frame.
+ * \param rewind_flag If the rewind input is pressed.
+ * \param is_pause If the game is paused.
+ */
+void advance_rewind_update(struct advance_rewind_context* context, adv_bool rewind_flag, adv_bool is_pause)
+{
+	if (context->config.buffer_size == 0)
+		return;
+
+	/* enable it at the first frame, when the game is running */
+	if (!context->state.active_flag) {
+		if (!mame_ui_state_supported())
+			return;
+		context->state.active_flag = 1;
+		log_std(("emu:rewind: active with %u bytes every %u frames\n", context->config.buffer_size, context->config.frame_interval));
+	}
+
+	if (rewind_flag) {
+		/* go back of one state at every frame */
+		mame_ui_state_schedule(rewind_load_callback);
+		advance_ui_message(&CONTEXT.ui, "Rewind");
+	} else if (!is_pause) {
+		++context->state.frame_counter;
+		if (context->state.frame_counter >= context->config.frame_interval)
+			mame_ui_state_schedule(rewind_save_callback);
+	}
+}
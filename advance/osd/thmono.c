@@ -37,6 +37,62 @@ void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int m
 	func(arg, 0, 1);
 }
 
+void osd_parallel_for(void (*func)(void* arg, int begin, int end), void* arg, int count, int chunk)
+{
+	int begin;
+
+	if (chunk < 1)
+		chunk = 1;
+
+	for (begin = 0; begin < count; begin += chunk)
+		func(arg, begin, begin + chunk < count ? begin + chunk : count);
+}
+
+struct _osd_task_group {
+	int dummy;
+};
+
+struct _osd_task_group* osd_task_group_alloc(void)
+{
+	return malloc(sizeof(struct _osd_task_group));
+}
+
+void osd_task_group_free(struct _osd_task_group* group)
+{
+	free(group);
+}
+
+void osd_task_group_run(struct _osd_task_group* group, void (*func)(void* arg), void* arg)
+{
+	func(arg);
+}
+
+void osd_task_group_wait(struct _osd_task_group* group)
+{
+}
+
+struct _osd_lock {
+	int dummy;
+};
+
+struct _osd_lock* osd_lock_alloc(void)
+{
+	return malloc(sizeof(struct _osd_lock));
+}
+
+void osd_lock_free(struct _osd_lock* lock)
+{
+	free(lock);
+}
+
+void osd_lock_acquire(struct _osd_lock* lock)
+{
+}
+
+void osd_lock_release(struct _osd_lock* lock)
+{
+}
+
 int thread_init(void)
 {
 	return 0;
@@ -46,3 +102,8 @@ void thread_done(void)
 {
 }
 
+int thread_set(unsigned count, const char* affinity)
+{
+	return 0;
+}
+
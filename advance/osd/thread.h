@@ -41,6 +41,16 @@ int thread_init(void);
  */
 void thread_done(void);
 
+/**
+ * Set the number of threads used for the parallel execution.
+ * It must not be called when some parallel work is running.
+ * \param count Number of threads including the calling one. 0 for one for every processor.
+ * \param affinity Processor affinity of the threads. "none" to not bind them, "auto"
+ * to bind them to processors different than the first, or a list of processor numbers.
+ * \return 0 on success, ==-1 if the affinity is invalid.
+ */
+int thread_set(unsigned count, const char* affinity);
+
 /**
  * Callback used to enable and disable the thread support at runtime.
  * This function is called every time a thread need to be started.
@@ -51,5 +61,20 @@ void thread_done(void);
  */
 int thread_is_active(void);
 
+/**
+ * Parallel execution on the threads started by thread_set().
+ * They are the same functions declared in osdepend.h, for the programs
+ * not including it, like the tools.
+ */
+void osd_parallel_for(void (*func)(void* arg, int begin, int end), void* arg, int count, int chunk);
+struct _osd_task_group* osd_task_group_alloc(void);
+void osd_task_group_free(struct _osd_task_group* group);
+void osd_task_group_run(struct _osd_task_group* group, void (*func)(void* arg), void* arg);
+void osd_task_group_wait(struct _osd_task_group* group);
+struct _osd_lock* osd_lock_alloc(void);
+void osd_lock_free(struct _osd_lock* lock);
+void osd_lock_acquire(struct _osd_lock* lock);
+void osd_lock_release(struct _osd_lock* lock);
+
 #endif
 
@@ -0,0 +1,883 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2001, 2002, 2003 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. 
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+/* for pthread_setaffinity_np() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "portable.h"
+
+#include "thread.h"
+#include "log.h"
+
+/** \file
+ * A pthread implementation of the parallel execution functions.
+ *
+ * A pool of worker threads is started by thread_set(). Every worker, and
+ * every other thread that queues some work, owns a Chase-Lev deque of jobs.
+ * The owner pushes and pops jobs at the bottom of its deque without locks,
+ * the other threads steal jobs from the top with a single compare and swap.
+ *
+ * A thread waiting the completion of its jobs executes its own jobs and
+ * steals the jobs of the other threads. This allows nested calls at any
+ * depth without deadlocks. When no job is found, it sleeps like an idle
+ * worker until a new job is queued or its jobs are completed.
+ *
+ * The only lock is used to put to sleep the idle workers and the waiting
+ * threads.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#define THREAD_MAX 64 /**< Max number of worker threads. */
+#define THREAD_EXTERNAL_MAX 32 /**< Max number of not worker threads able to queue jobs. */
+#define THREAD_SPIN 64 /**< Number of steal attempts before sleeping. */
+#define DEQUE_MAX 256 /**< Size of a deque. It must be a power of 2. */
+#define GROUP_BLOCK 64 /**< Jobs allocated at once in a task group. */
+
+/**
+ * Job.
+ */
+struct job_struct {
+	void (*func)(void* arg); /**< Function to call. */
+	void* arg; /**< Argument of the function. */
+	int* pending; /**< Counter decremented at the end of the job. */
+};
+
+/**
+ * Work-stealing deque.
+ */
+struct deque_struct {
+	long top; /**< Next job to steal. Changed by the thieves. */
+	char pad0[64 - sizeof(long)];
+	long bottom; /**< Next free position. Changed only by the owner. */
+	char pad1[64 - sizeof(long)];
+	struct job_struct* map[DEQUE_MAX]; /**< Circular buffer of jobs. */
+};
+
+/**
+ * Deques. The first THREAD_MAX are owned by the workers, the others by the external threads.
+ */
+static struct deque_struct thread_deque[THREAD_MAX + THREAD_EXTERNAL_MAX];
+static __thread struct deque_struct* thread_self; /**< Deque of the current thread. */
+static __thread unsigned thread_seed; /**< Random seed used to select the victim. */
+static int thread_external_used[THREAD_EXTERNAL_MAX]; /**< If the external deque is assigned at a thread. */
+static int thread_external_mac; /**< Number of external deques ever assigned, the thieves check only them. */
+
+static pthread_t thread_id[THREAD_MAX]; /**< ID of the workers. */
+static unsigned thread_mac; /**< Number of workers. */
+static int thread_cpu[THREAD_MAX]; /**< Processor of every worker, or -1. */
+static int thread_exit; /**< Exit request for the workers. */
+static unsigned thread_epoch; /**< Incremented every time a job is queued. */
+static unsigned thread_sleeping; /**< Number of sleeping workers and waiting threads. */
+static pthread_cond_t thread_cond; /**< Wakeup condition. */
+static pthread_mutex_t thread_mutex; /**< Mutex used only for sleeping. */
+
+/****************************************************************************/
+/* deque */
+
+/**
+ * Push a job at the bottom of the deque.
+ * Called only by the owner.
+ * \return 0 on success, -1 if the deque is full.
+ */
+static int deque_push(struct deque_struct* deque, struct job_struct* job)
+{
+	long b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+	long t = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+
+	if (b - t >= DEQUE_MAX)
+		return -1;
+
+	__atomic_store_n(&deque->map[b & (DEQUE_MAX - 1)], job, __ATOMIC_RELAXED);
+
+	/* publish the job, and its content, to the thieves */
+	__atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+/**
+ * Pop a job from the bottom of the deque.
+ * Called only by the owner.
+ * \return The job or 0 if the deque is empty.
+ */
+static struct job_struct* deque_pop(struct deque_struct* deque)
+{
+	long b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+	long t;
+	struct job_struct* job;
+
+	__atomic_store_n(&deque->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+	if (t > b) {
+		/* empty */
+		__atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+
+	job = __atomic_load_n(&deque->map[b & (DEQUE_MAX - 1)], __ATOMIC_RELAXED);
+
+	if (t == b) {
+		/* last job, race with the thieves */
+		if (!__atomic_compare_exchange_n(&deque->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			job = 0;
+		__atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+	}
+
+	return job;
+}
+
+/**
+ * Steal a job from the top of the deque.
+ * Called by any thread.
+ * \return The job or 0 if the deque is empty or if the race with another thread is lost.
+ */
+static struct job_struct* deque_steal(struct deque_struct* deque)
+{
+	long t = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+	long b;
+	struct job_struct* job;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+	if (t >= b)
+		return 0;
+
+	job = __atomic_load_n(&deque->map[t & (DEQUE_MAX - 1)], __ATOMIC_RELAXED);
+
+	if (!__atomic_compare_exchange_n(&deque->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return 0;
+
+	return job;
+}
+
+/****************************************************************************/
+/* job */
+
+/**
+ * Get the deque of the current thread.
+ * A deque is assigned at the first call of a not worker thread,
+ * and it's kept until job_release().
+ * \return The deque or 0 if no more deques are available.
+ */
+static struct deque_struct* job_self(void)
+{
+	if (!thread_self) {
+		int mac;
+		int i;
+
+		for (i = 0; i < THREAD_EXTERNAL_MAX; ++i) {
+			int unused = 0;
+			if (__atomic_compare_exchange_n(&thread_external_used[i], &unused, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				break;
+		}
+		if (i == THREAD_EXTERNAL_MAX)
+			return 0;
+
+		/* make the deque visible to the thieves */
+		mac = __atomic_load_n(&thread_external_mac, __ATOMIC_RELAXED);
+		while (mac < i + 1 && !__atomic_compare_exchange_n(&thread_external_mac, &mac, i + 1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+
+		thread_self = &thread_deque[THREAD_MAX + i];
+		thread_seed = i + 1;
+	}
+
+	return thread_self;
+}
+
+/**
+ * Release the deque of a not worker thread if it's empty.
+ * The top and bottom positions are kept, so a thief still working on the
+ * old owner sees a consistent deque. The deque is assigned again at the
+ * next queued job, and the transient threads don't exhaust the deques.
+ */
+static void job_release(void)
+{
+	struct deque_struct* deque = thread_self;
+	unsigned i;
+
+	if (!deque || deque < &thread_deque[THREAD_MAX])
+		return;
+
+	/* only the owner pushes, if it's empty it remains empty */
+	if (__atomic_load_n(&deque->top, __ATOMIC_ACQUIRE) < __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED))
+		return;
+
+	i = deque - &thread_deque[THREAD_MAX];
+	thread_self = 0;
+	__atomic_store_n(&thread_external_used[i], 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Execute a job and signal its end.
+ * The last job of a group wakes up the sleeping threads, because one of
+ * them may wait for the group.
+ */
+static void job_exec(struct job_struct* job)
+{
+	int* pending = job->pending;
+
+	job->func(job->arg);
+
+	/* the job may be freed after this point */
+	if (__atomic_sub_fetch(pending, 1, __ATOMIC_SEQ_CST) != 0)
+		return;
+
+	if (__atomic_load_n(&thread_sleeping, __ATOMIC_SEQ_CST) != 0) {
+		pthread_mutex_lock(&thread_mutex);
+		pthread_cond_broadcast(&thread_cond);
+		pthread_mutex_unlock(&thread_mutex);
+	}
+}
+
+/**
+ * Get a job from the own deque or steal it from another thread.
+ * \return The job or 0 if no job is found.
+ */
+static struct job_struct* job_get(void)
+{
+	struct job_struct* job;
+	unsigned worker_mac;
+	unsigned external_mac;
+	unsigned mac;
+	unsigned start;
+	unsigned i;
+
+	if (thread_self) {
+		job = deque_pop(thread_self);
+		if (job)
+			return job;
+	}
+
+	/* the deques of the workers are initialized before their count is increased */
+	worker_mac = __atomic_load_n(&thread_mac, __ATOMIC_ACQUIRE);
+	external_mac = __atomic_load_n(&thread_external_mac, __ATOMIC_RELAXED);
+	if (external_mac > THREAD_EXTERNAL_MAX)
+		external_mac = THREAD_EXTERNAL_MAX;
+	mac = worker_mac + external_mac;
+	if (!mac)
+		return 0;
+
+	/* start from a random victim to spread the contention */
+	thread_seed = thread_seed * 1103515245 + 12345;
+	start = (thread_seed >> 16) % mac;
+
+	for (i = 0; i < mac; ++i) {
+		struct deque_struct* deque;
+		unsigned j = (start + i) % mac;
+
+		if (j < worker_mac)
+			deque = &thread_deque[j];
+		else
+			deque = &thread_deque[THREAD_MAX + j - worker_mac];
+
+		if (deque == thread_self)
+			continue;
+
+		job = deque_steal(deque);
+		if (job)
+			return job;
+	}
+
+	return 0;
+}
+
+/**
+ * Wake up the sleeping workers.
+ */
+static void job_signal(void)
+{
+	__atomic_add_fetch(&thread_epoch, 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&thread_sleeping, __ATOMIC_SEQ_CST) != 0) {
+		pthread_mutex_lock(&thread_mutex);
+		pthread_cond_broadcast(&thread_cond);
+		pthread_mutex_unlock(&thread_mutex);
+	}
+}
+
+/**
+ * Queue a job.
+ * If the job cannot be queued, it's executed immediately.
+ */
+static void job_push(struct job_struct* job)
+{
+	struct deque_struct* deque = job_self();
+
+	if (!deque || deque_push(deque, job) != 0) {
+		job_exec(job);
+		return;
+	}
+
+	job_signal();
+}
+
+/**
+ * Wait until the counter reaches 0.
+ * Meanwhile, execute the queued jobs of any thread.
+ * If no job is found, sleep until a new job is queued or the counter
+ * reaches 0. The own deque is empty at this point, so all the remaining
+ * jobs are in the deques of running threads.
+ * At the end the deque of a not worker thread is released if empty.
+ */
+static void job_wait(int* pending)
+{
+	unsigned spin = 0;
+
+	while (1) {
+		unsigned epoch = __atomic_load_n(&thread_epoch, __ATOMIC_SEQ_CST);
+		struct job_struct* job;
+
+		if (__atomic_load_n(pending, __ATOMIC_ACQUIRE) == 0)
+			break;
+
+		job = job_get();
+		if (job) {
+			job_exec(job);
+			spin = 0;
+			continue;
+		}
+
+		if (++spin < THREAD_SPIN) {
+			sched_yield();
+			continue;
+		}
+
+		spin = 0;
+
+		/* sleep until a new job is queued or the last job ends */
+		pthread_mutex_lock(&thread_mutex);
+		__atomic_add_fetch(&thread_sleeping, 1, __ATOMIC_SEQ_CST);
+		while (__atomic_load_n(&thread_epoch, __ATOMIC_SEQ_CST) == epoch && __atomic_load_n(pending, __ATOMIC_SEQ_CST) != 0)
+			pthread_cond_wait(&thread_cond, &thread_mutex);
+		__atomic_sub_fetch(&thread_sleeping, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&thread_mutex);
+	}
+
+	job_release();
+}
+
+/****************************************************************************/
+/* thread */
+
+static void* thread_proc(void* arg)
+{
+	unsigned spin = 0;
+
+	thread_self = arg;
+	thread_seed = thread_self - thread_deque + 1;
+
+	while (1) {
+		unsigned epoch = __atomic_load_n(&thread_epoch, __ATOMIC_SEQ_CST);
+		struct job_struct* job;
+
+		if (__atomic_load_n(&thread_exit, __ATOMIC_ACQUIRE))
+			break;
+
+		job = job_get();
+		if (job) {
+			job_exec(job);
+			spin = 0;
+			continue;
+		}
+
+		if (++spin < THREAD_SPIN) {
+			sched_yield();
+			continue;
+		}
+
+		spin = 0;
+
+		/* sleep until a new job is queued */
+		pthread_mutex_lock(&thread_mutex);
+		__atomic_add_fetch(&thread_sleeping, 1, __ATOMIC_SEQ_CST);
+		while (__atomic_load_n(&thread_epoch, __ATOMIC_SEQ_CST) == epoch && !__atomic_load_n(&thread_exit, __ATOMIC_ACQUIRE))
+			pthread_cond_wait(&thread_cond, &thread_mutex);
+		__atomic_sub_fetch(&thread_sleeping, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&thread_mutex);
+	}
+
+	pthread_exit(0);
+	return 0;
+}
+
+/**
+ * Stop all the workers.
+ */
+static void thread_stop(void)
+{
+	unsigned i;
+
+	if (!thread_mac)
+		return;
+
+	__atomic_store_n(&thread_exit, 1, __ATOMIC_RELEASE);
+
+	pthread_mutex_lock(&thread_mutex);
+	pthread_cond_broadcast(&thread_cond);
+	pthread_mutex_unlock(&thread_mutex);
+
+	for (i = 0; i < thread_mac; ++i)
+		pthread_join(thread_id[i], NULL);
+
+	__atomic_store_n(&thread_mac, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Bind a worker to a processor.
+ */
+static void thread_affinity(unsigned i)
+{
+	if (thread_cpu[i] < 0)
+		return;
+
+#if defined(__linux__) && defined(CPU_SET)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(thread_cpu[i], &set);
+		if (pthread_setaffinity_np(thread_id[i], sizeof(set), &set) != 0) {
+			log_std(("thread: pthread_setaffinity_np(%d) failed\n", thread_cpu[i]));
+		}
+	}
+#else
+	log_std(("thread: processor affinity not supported\n"));
+#endif
+}
+
+/**
+ * Parse the processor affinity.
+ * \param affinity "none", "auto", or a list of processor numbers.
+ * \param cpu_mac Number of processors.
+ * \param worker_mac Number of workers.
+ */
+static int thread_affinity_parse(const char* affinity, unsigned cpu_mac, unsigned worker_mac)
+{
+	int list[THREAD_MAX];
+	unsigned list_mac;
+	const char* s;
+	unsigned i;
+
+	if (!affinity || !*affinity || strcmp(affinity, "none") == 0) {
+		for (i = 0; i < worker_mac; ++i)
+			thread_cpu[i] = -1;
+		return 0;
+	}
+
+	if (strcmp(affinity, "auto") == 0) {
+		/* the processor 0 is left to the main thread */
+		for (i = 0; i < worker_mac; ++i)
+			thread_cpu[i] = (i + 1) % cpu_mac;
+		return 0;
+	}
+
+	list_mac = 0;
+	s = affinity;
+	while (*s) {
+		char* e;
+		long v;
+
+		while (*s == ' ' || *s == ',')
+			++s;
+		if (!*s)
+			break;
+
+		v = strtol(s, &e, 10);
+		if (e == s || v < 0 || v > 1023 || list_mac >= THREAD_MAX)
+			return -1;
+
+		list[list_mac++] = v;
+		s = e;
+	}
+
+	if (!list_mac)
+		return -1;
+
+	for (i = 0; i < worker_mac; ++i)
+		thread_cpu[i] = list[i % list_mac];
+
+	return 0;
+}
+
+/**
+ * Initialize the thread support.
+ * The workers are started later by thread_set().
+ */
+int thread_init(void)
+{
+	thread_exit = 0;
+	thread_mac = 0;
+
+	if (pthread_mutex_init(&thread_mutex, NULL) != 0)
+		return -1;
+	if (pthread_cond_init(&thread_cond, NULL) != 0)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Deinitialize the thread system.
+ */
+void thread_done(void)
+{
+	thread_stop();
+
+	pthread_mutex_destroy(&thread_mutex);
+	pthread_cond_destroy(&thread_cond);
+}
+
+/**
+ * Set the number of threads and their processor affinity.
+ */
+int thread_set(unsigned count, const char* affinity)
+{
+	unsigned cpu_mac;
+	unsigned worker_mac;
+	unsigned i;
+
+#ifdef _SC_NPROCESSORS_ONLN
+	{
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		cpu_mac = n > 0 ? n : 1;
+	}
+#else
+	cpu_mac = 1;
+#endif
+
+	if (count == 0)
+		count = cpu_mac;
+
+	/* the calling thread works as well */
+	worker_mac = count - 1;
+	if (worker_mac > THREAD_MAX)
+		worker_mac = THREAD_MAX;
+
+	thread_stop();
+
+	if (thread_affinity_parse(affinity, cpu_mac, worker_mac) != 0) {
+		log_std(("ERROR:thread: invalid affinity '%s'\n", affinity));
+		return -1;
+	}
+
+	thread_exit = 0;
+
+	log_std(("thread: starting %u workers on %u processors\n", worker_mac, cpu_mac));
+
+	for (i = 0; i < worker_mac; ++i) {
+		struct deque_struct* deque = &thread_deque[i];
+
+		deque->top = 0;
+		deque->bottom = 0;
+
+		if (pthread_create(&thread_id[i], NULL, thread_proc, deque) != 0) {
+			log_std(("ERROR:thread: pthread_create() failed\n"));
+			break;
+		}
+
+		/* make the worker visible to the thieves */
+		__atomic_store_n(&thread_mac, i + 1, __ATOMIC_RELEASE);
+
+		thread_affinity(i);
+	}
+
+	return 0;
+}
+
+/****************************************************************************/
+/* parallel */
+
+/**
+ * State of a parallel for.
+ */
+struct parallel_for_struct {
+	void (*func)(void* arg, int begin, int end); /**< Function to call. */
+	void* arg; /**< Argument of the function. */
+	int count; /**< Number of items. */
+	int chunk; /**< Number of items for call. */
+	int next; /**< Next item to process. Atomic. */
+};
+
+/**
+ * Process chunks until the range is exhausted.
+ */
+static void parallel_for_proc(void* void_arg)
+{
+	struct parallel_for_struct* pf = void_arg;
+
+	while (1) {
+		int begin = __atomic_fetch_add(&pf->next, pf->chunk, __ATOMIC_RELAXED);
+		int end;
+
+		if (begin >= pf->count)
+			break;
+
+		end = begin + pf->chunk;
+		if (end > pf->count)
+			end = pf->count;
+
+		pf->func(pf->arg, begin, end);
+	}
+}
+
+void osd_parallel_for(void (*func)(void* arg, int begin, int end), void* arg, int count, int chunk)
+{
+	struct parallel_for_struct pf;
+	struct job_struct job[THREAD_MAX];
+	unsigned job_mac;
+	int pending;
+	int chunk_mac;
+	unsigned i;
+
+	if (count <= 0)
+		return;
+	if (chunk < 1)
+		chunk = 1;
+
+	chunk_mac = (count + chunk - 1) / chunk;
+
+	job_mac = __atomic_load_n(&thread_mac, __ATOMIC_ACQUIRE);
+	if (job_mac > (unsigned)(chunk_mac - 1))
+		job_mac = chunk_mac - 1;
+
+	if (!thread_is_active() || job_mac == 0) {
+		int begin;
+		for (begin = 0; begin < count; begin += chunk)
+			func(arg, begin, begin + chunk < count ? begin + chunk : count);
+		return;
+	}
+
+	pf.func = func;
+	pf.arg = arg;
+	pf.count = count;
+	pf.chunk = chunk;
+	pf.next = 0;
+
+	/* queue some helpers, every one processes chunks until the end */
+	pending = job_mac;
+	for (i = 0; i < job_mac; ++i) {
+		job[i].func = parallel_for_proc;
+		job[i].arg = &pf;
+		job[i].pending = &pending;
+		job_push(&job[i]);
+	}
+
+	parallel_for_proc(&pf);
+
+	/* the helpers not yet started find nothing to do */
+	job_wait(&pending);
+}
+
+/**
+ * State of a osd_parallelize() call.
+ */
+struct parallelize_struct {
+	void (*func)(void* arg, int num, int max); /**< Function to call. */
+	void* arg; /**< Argument of the function. */
+	int max; /**< Number of calls. */
+};
+
+static void parallelize_proc(void* void_arg, int begin, int end)
+{
+	struct parallelize_struct* pz = void_arg;
+	int i;
+
+	for (i = begin; i < end; ++i)
+		pz->func(pz->arg, i, pz->max);
+}
+
+void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int max)
+{
+	struct parallelize_struct pz;
+	int limit;
+
+	limit = __atomic_load_n(&thread_mac, __ATOMIC_ACQUIRE) + 1;
+	if (max > limit)
+		max = limit;
+
+	if (!thread_is_active() || max <= 1) {
+		func(arg, 0, 1);
+		return;
+	}
+
+	pz.func = func;
+	pz.arg = arg;
+	pz.max = max;
+
+	osd_parallel_for(parallelize_proc, &pz, max, 1);
+}
+
+/****************************************************************************/
+/* task group */
+
+/**
+ * Block of jobs of a task group.
+ */
+struct group_block_struct {
+	struct job_struct map[GROUP_BLOCK]; /**< Jobs. */
+	struct group_block_struct* next; /**< Next block. */
+};
+
+/**
+ * Task group.
+ */
+struct _osd_task_group {
+	int pending; /**< Number of queued jobs not yet completed. */
+	struct group_block_struct* block_list; /**< List of blocks. */
+	struct group_block_struct* block; /**< Current block. */
+	unsigned block_pos; /**< First free job in the current block. */
+};
+
+struct _osd_task_group* osd_task_group_alloc(void)
+{
+	struct _osd_task_group* group = malloc(sizeof(struct _osd_task_group));
+	if (!group)
+		return 0;
+
+	group->pending = 0;
+	group->block_list = 0;
+	group->block = 0;
+	group->block_pos = GROUP_BLOCK;
+
+	return group;
+}
+
+void osd_task_group_run(struct _osd_task_group* group, void (*func)(void* arg), void* arg)
+{
+	struct job_struct* job;
+
+	if (!thread_is_active() || __atomic_load_n(&thread_mac, __ATOMIC_ACQUIRE) == 0) {
+		func(arg);
+		return;
+	}
+
+	if (group->block_pos == GROUP_BLOCK) {
+		/* the blocks are never moved, the queued jobs point to them */
+		struct group_block_struct* next = group->block ? group->block->next : group->block_list;
+		if (!next) {
+			next = malloc(sizeof(struct group_block_struct));
+			if (!next) {
+				func(arg);
+				return;
+			}
+			next->next = 0;
+			if (group->block)
+				group->block->next = next;
+			else
+				group->block_list = next;
+		}
+		group->block = next;
+		group->block_pos = 0;
+	}
+
+	job = &group->block->map[group->block_pos++];
+	job->func = func;
+	job->arg = arg;
+	job->pending = &group->pending;
+
+	__atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+
+	job_push(job);
+}
+
+void osd_task_group_wait(struct _osd_task_group* group)
+{
+	job_wait(&group->pending);
+
+	/* reuse the blocks */
+	group->block = 0;
+	group->block_pos = GROUP_BLOCK;
+}
+
+void osd_task_group_free(struct _osd_task_group* group)
+{
+	if (!group)
+		return;
+
+	osd_task_group_wait(group);
+
+	while (group->block_list) {
+		struct group_block_struct* next = group->block_list->next;
+		free(group->block_list);
+		group->block_list = next;
+	}
+
+	free(group);
+}
+
+/****************************************************************************/
+/* lock */
+
+/**
+ * Lock.
+ */
+struct _osd_lock {
+	pthread_mutex_t mutex; /**< Mutex. */
+};
+
+struct _osd_lock* osd_lock_alloc(void)
+{
+	struct _osd_lock* lock = malloc(sizeof(struct _osd_lock));
+	if (!lock)
+		return 0;
+
+	if (pthread_mutex_init(&lock->mutex, 0) != 0) {
+		free(lock);
+		return 0;
+	}
+
+	return lock;
+}
+
+void osd_lock_free(struct _osd_lock* lock)
+{
+	if (!lock)
+		return;
+
+	pthread_mutex_destroy(&lock->mutex);
+	free(lock);
+}
+
+void osd_lock_acquire(struct _osd_lock* lock)
+{
+	pthread_mutex_lock(&lock->mutex);
+}
+
+void osd_lock_release(struct _osd_lock* lock)
+{
+	pthread_mutex_unlock(&lock->mutex);
+}
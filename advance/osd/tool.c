@@ -0,0 +1,282 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2001, 2002, 2003 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+/** \file
+ * Portable implementation of the OSD interface of the tools, like chdman.
+ */
+
+#include "portable.h"
+
+#include "osd_tool.h"
+
+#ifdef USE_SMP
+#include "thread.h"
+#include "log.h"
+#endif
+
+/****************************************************************************/
+/* Physical drive */
+
+/**
+ * Physical drives aren't supported.
+ */
+int osd_is_physical_drive(const char *filename)
+{
+	return 0;
+}
+
+/**
+ * Physical drives aren't supported.
+ */
+int osd_get_physical_drive_geometry(const char *filename, UINT32 *cylinders, UINT32 *heads, UINT32 *sectors, UINT32 *bps)
+{
+	return 0;
+}
+
+/****************************************************************************/
+/* File */
+
+UINT64 osd_get_file_size(const char *filename)
+{
+	struct stat st;
+
+	if (stat(filename, &st) != 0)
+		return 0;
+
+	return st.st_size;
+}
+
+osd_tool_file *osd_tool_fopen(const char *filename, const char *mode)
+{
+	return (osd_tool_file*)fopen(filename, mode);
+}
+
+void osd_tool_fclose(osd_tool_file *file)
+{
+	fclose((FILE*)file);
+}
+
+UINT32 osd_tool_fread(osd_tool_file *file, UINT64 offset, UINT32 count, void *buffer)
+{
+	if (fseeko((FILE*)file, offset, SEEK_SET) != 0)
+		return 0;
+
+	return fread(buffer, 1, count, (FILE*)file);
+}
+
+UINT32 osd_tool_fwrite(osd_tool_file *file, UINT64 offset, UINT32 count, const void *buffer)
+{
+	if (fseeko((FILE*)file, offset, SEEK_SET) != 0)
+		return 0;
+
+	return fwrite(buffer, 1, count, (FILE*)file);
+}
+
+UINT64 osd_tool_flength(osd_tool_file *file)
+{
+	off_t length;
+
+	if (fseeko((FILE*)file, 0, SEEK_END) != 0)
+		return 0;
+
+	length = ftello((FILE*)file);
+	if (length < 0)
+		return 0;
+
+	return length;
+}
+
+/****************************************************************************/
+/* Group */
+
+#ifdef USE_SMP
+
+/**
+ * The groups run on the same work-stealing pool of the emulator.
+ * The tools don't disable the threads at runtime.
+ */
+int thread_is_active(void)
+{
+	return 1;
+}
+
+/**
+ * The tools have no log file.
+ */
+void log_f(const char* text, ...)
+{
+}
+
+static int tool_thread_state; /**< 0 not started, 1 started, -1 not available. */
+
+static void tool_thread_done(void)
+{
+	thread_done();
+}
+
+/**
+ * Start the pool at the first use, with one thread for each processor.
+ * \return 0 if the pool is running.
+ */
+static int tool_thread_start(void)
+{
+	long cpu_mac;
+
+	if (tool_thread_state != 0)
+		return tool_thread_state > 0 ? 0 : -1;
+
+	tool_thread_state = -1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+	cpu_mac = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	cpu_mac = 1;
+#endif
+	/* with a single processor the parallel execution only adds overhead */
+	if (cpu_mac < 2)
+		return -1;
+
+	if (thread_init() != 0)
+		return -1;
+
+	/* the thread waiting a group also executes the tasks */
+	if (thread_set(0, "none") != 0) {
+		thread_done();
+		return -1;
+	}
+
+	atexit(tool_thread_done);
+
+	tool_thread_state = 1;
+
+	return 0;
+}
+
+/**
+ * Allocate a group.
+ * \return The group or 0 if the threads aren't available or useful.
+ */
+osd_tool_group *osd_tool_group_alloc(void)
+{
+	if (tool_thread_start() != 0)
+		return 0;
+
+	return (osd_tool_group*)osd_task_group_alloc();
+}
+
+/**
+ * Wait the queued tasks and free the group.
+ */
+void osd_tool_group_free(osd_tool_group *group)
+{
+	osd_task_group_free((struct _osd_task_group*)group);
+}
+
+/**
+ * Queue a task in the group.
+ */
+void osd_tool_group_run(osd_tool_group *group, void (*func)(void *param), void *param)
+{
+	osd_task_group_run((struct _osd_task_group*)group, func, param);
+}
+
+/**
+ * Wait the end of all the tasks of the group.
+ * Meanwhile, execute the queued tasks.
+ */
+void osd_tool_group_wait(osd_tool_group *group)
+{
+	osd_task_group_wait((struct _osd_task_group*)group);
+}
+
+/****************************************************************************/
+/* Lock */
+
+osd_tool_lock *osd_tool_lock_alloc(void)
+{
+	return (osd_tool_lock*)osd_lock_alloc();
+}
+
+void osd_tool_lock_free(osd_tool_lock *lock)
+{
+	osd_lock_free((struct _osd_lock*)lock);
+}
+
+void osd_tool_lock_acquire(osd_tool_lock *lock)
+{
+	osd_lock_acquire((struct _osd_lock*)lock);
+}
+
+void osd_tool_lock_release(osd_tool_lock *lock)
+{
+	osd_lock_release((struct _osd_lock*)lock);
+}
+
+#else
+
+/**
+ * Threads aren't available, the tools run serially.
+ */
+osd_tool_group *osd_tool_group_alloc(void)
+{
+	return 0;
+}
+
+void osd_tool_group_free(osd_tool_group *group)
+{
+}
+
+void osd_tool_group_run(osd_tool_group *group, void (*func)(void *param), void *param)
+{
+	func(param);
+}
+
+void osd_tool_group_wait(osd_tool_group *group)
+{
+}
+
+osd_tool_lock *osd_tool_lock_alloc(void)
+{
+	return 0;
+}
+
+void osd_tool_lock_free(osd_tool_lock *lock)
+{
+}
+
+void osd_tool_lock_acquire(osd_tool_lock *lock)
+{
+}
+
+void osd_tool_lock_release(osd_tool_lock *lock)
+{
+}
+
+#endif
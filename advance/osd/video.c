@@ -450,6 +450,8 @@ static void video_command(struct advance_video_context* context, struct advance_
 		unsigned skip;
 		unsigned rate;
 		unsigned l;
+		double runahead_frame_time;
+		double runahead_state_time;
 
 		if (context->state.info_counter) {
 			--context->state.info_counter;
@@ -485,6 +487,14 @@ static void video_command(struct advance_video_context* context, struct advance_
 		if (l>=11 && isspace(buffer[l-11]))
 			buffer[l-11] = ADV_FONT_FIXSPACE;
 
+		/* the run-ahead time of a displayed frame, and the part used by the state */
+		if (mame_ui_runahead_info(&runahead_frame_time, &runahead_state_time) != 0) {
+			char runahead[256];
+			snprintf(runahead, sizeof(runahead), " ahead %.1f/%.1f ms -", runahead_frame_time * 1000.0, runahead_state_time * 1000.0);
+			sncat(runahead, sizeof(runahead), buffer);
+			sncpy(buffer, sizeof(buffer), runahead);
+		}
+
 		advance_ui_direct_text(ui_context, buffer);
 
 		hardware_script_info(0, 0, 0, buffer);
@@ -526,7 +536,15 @@ static void video_frame_stop(struct advance_video_context* context)
 	if (vsync && (video_flags() & MODE_FLAGS_RETRACE_WAIT_SYNC) != 0)
 		vsync = 0;
 
-	update_stop(update_x_get(), update_y_get(), video_size_x(), video_size_y(), vsync);
+	if (context->state.partial_skip_flag && !vsync) {
+		/* the screen already shows the frame, don't display it again */
+		update_cancel();
+	} else {
+		context->state.partial_display_page = update_page_get();
+		update_stop(update_x_get(), update_y_get(), video_size_x(), video_size_y(), vsync);
+	}
+
+	context->state.partial_skip_flag = 0;
 
 	stop = target_clock() - start;
 
@@ -592,59 +610,65 @@ void advance_video_thread_wait(struct advance_video_context* context)
 
 #ifdef USE_SMP
 /**
- * Duplicate a bitmap.
- * The old buffer is reused if possible.
+ * Fill the swapped bitmap of the core with the game bitmap.
+ * It's called by the video thread outside the lock, and the core waits for
+ * it only when it starts to draw the next frame.
  */
-static struct osd_bitmap* video_thread_bitmap_duplicate(struct osd_bitmap* old, const struct osd_bitmap* current)
+static void video_thread_bitmap_fill(struct advance_video_context* context)
 {
-	if (current) {
-		if (old) {
-			if (old->size_y != current->size_y
-				|| old->bytes_per_scanline != current->bytes_per_scanline) {
-				free(old->ptr);
-				old->ptr = 0;
-			}
-		}
+	mame_video_swap_copy();
 
-		if (!old) {
-			old = malloc(sizeof(struct osd_bitmap));
-			old->ptr = 0;
-		}
+	pthread_mutex_lock(&context->state.thread_video_mutex);
 
-		if (!old->ptr)
-			old->ptr = malloc(current->size_y * current->bytes_per_scanline);
+	context->state.thread_state_game_fill_flag = 0;
 
-		memcpy(old->ptr, current->ptr, current->size_y * current->bytes_per_scanline);
-		old->size_x = current->size_x;
-		old->size_y = current->size_y;
-		old->bytes_per_scanline = current->bytes_per_scanline;
-	} else {
-		if (old) {
-			free(old->ptr);
-			free(old);
-			old = 0;
-		}
-	}
+	/* wakeup the main thread, if waiting in osd_wait_for_screen() */
+	pthread_cond_broadcast(&context->state.thread_video_cond);
 
-	return old;
+	pthread_mutex_unlock(&context->state.thread_video_mutex);
 }
 
 /**
- * Free a bitmap.
+ * Set the game bitmap for the video thread.
+ * If possible the thread gets the bitmap of the core, and the core is
+ * instructed to draw the next frame in a different bitmap, filled with the
+ * current frame by the video thread.
  */
-static void video_thread_bitmap_free(struct osd_bitmap* bitmap)
+static void video_thread_bitmap_set(struct advance_video_context* context, const struct osd_bitmap* current)
 {
-	if (bitmap) {
-		free(bitmap->ptr);
-		free(bitmap);
+	struct osd_bitmap* bitmap = &context->state.thread_state_game_buffer;
+	unsigned size;
+
+	if (!current) {
+		context->state.thread_state_game = 0;
+		return;
+	}
+
+	*bitmap = *current;
+	context->state.thread_state_game = bitmap;
+
+	/* pass the bitmap of the core */
+	if (mame_video_swap() != 0) {
+		context->state.thread_state_game_fill_flag = 1;
+		context->state.thread_game_wait_flag = 1;
+		return;
+	}
+
+	size = current->size_y * current->bytes_per_scanline;
+	if (size > context->state.thread_state_game_copy_size) {
+		free(context->state.thread_state_game_copy);
+		context->state.thread_state_game_copy = malloc(size);
+		context->state.thread_state_game_copy_size = size;
 	}
-}
 
+	memcpy(context->state.thread_state_game_copy, current->ptr, size);
+	bitmap->ptr = context->state.thread_state_game_copy;
+}
 #endif
 
 /**
  * Precomputation of the frame before updating.
- * Mainly used to duplicate the data for the video thread.
+ * Mainly used to pass the data at the video thread.
  */
 static void video_frame_prepare(struct advance_video_context* context, struct advance_sound_context* sound_context, struct advance_estimate_context* estimate_context, const struct osd_bitmap* game, const struct osd_bitmap* debug, const osd_rgb_t* debug_palette, unsigned debug_palette_size, unsigned led, unsigned input, const short* sample_buffer, unsigned sample_count, unsigned sample_recount, adv_bool skip_flag)
 {
@@ -663,21 +687,15 @@ static void video_frame_prepare(struct advance_video_context* context, struct ad
 		advance_estimate_common_begin(estimate_context);
 
 		if (!skip_flag) {
-			context->state.thread_state_game = video_thread_bitmap_duplicate(context->state.thread_state_game, game);
+			video_thread_bitmap_set(context, game);
 		}
 
 		context->state.thread_state_led = led;
 		context->state.thread_state_input = input;
 		context->state.thread_state_skip_flag = skip_flag;
 
-		if (sample_count > context->state.thread_state_sample_max) {
-			log_std(("advance:thread: realloc sample buffer %d samples -> %d samples, %d bytes\n", context->state.thread_state_sample_max, 2*sample_count, sound_context->state.input_bytes_per_sample * 2 * sample_count));
-			context->state.thread_state_sample_max = 2 * sample_count;
-			context->state.thread_state_sample_buffer = realloc(context->state.thread_state_sample_buffer, sound_context->state.input_bytes_per_sample * context->state.thread_state_sample_max);
-			assert(context->state.thread_state_sample_buffer);
-		}
-
-		memcpy(context->state.thread_state_sample_buffer, sample_buffer, sample_count * sound_context->state.input_bytes_per_sample);
+		/* the core mixes the next frame in a different buffer, no need to copy it */
+		context->state.thread_state_sample_buffer = sample_buffer;
 		context->state.thread_state_sample_count = sample_count;
 		context->state.thread_state_sample_recount = sample_recount;
 
@@ -713,6 +731,10 @@ static void video_frame_update(struct advance_video_context* context, struct adv
 
 		pthread_mutex_unlock(&context->state.thread_video_mutex);
 	} else {
+		/* the bitmap of the core was already swapped */
+		if (context->state.thread_state_game_fill_flag)
+			video_thread_bitmap_fill(context);
+
 		video_frame_update_now(context, sound_context, estimate_context, record_context, ui_context, safequit_context, game, debug, debug_palette, debug_palette_size, led, input, sample_buffer, sample_count, sample_recount, skip_flag);
 	}
 #else
@@ -759,6 +781,10 @@ static void* video_thread(void* void_context)
 			break;
 		}
 
+		/* first release the bitmap of the core */
+		if (context->state.thread_state_game_fill_flag)
+			video_thread_bitmap_fill(context);
+
 		log_debug(("advance:thread: draw start\n"));
 
 		/* update the frame */
@@ -865,10 +891,13 @@ int osd2_thread_init(void)
 	context->state.thread_exit_flag = 0;
 	context->state.thread_state_ready_flag = 0;
 	context->state.thread_state_game = 0;
+	context->state.thread_state_game_copy = 0;
+	context->state.thread_state_game_copy_size = 0;
+	context->state.thread_state_game_fill_flag = 0;
+	context->state.thread_game_wait_flag = 0;
 	context->state.thread_state_led = 0;
 	context->state.thread_state_input = 0;
 	context->state.thread_state_sample_count = 0;
-	context->state.thread_state_sample_max = 0;
 	context->state.thread_state_sample_buffer = 0;
 	context->state.thread_state_skip_flag = 0;
 	if (pthread_mutex_init(&context->state.thread_video_mutex, NULL) != 0) {
@@ -913,8 +942,7 @@ void osd2_thread_done(void)
 	pthread_join(context->state.thread_id, NULL);
 
 	log_std(("advance:thread: exit\n"));
-	video_thread_bitmap_free(context->state.thread_state_game);
-	free(context->state.thread_state_sample_buffer);
+	free(context->state.thread_state_game_copy);
 	pthread_cond_destroy(&context->state.thread_video_cond);
 	pthread_mutex_destroy(&context->state.thread_video_mutex);
 
@@ -969,6 +997,38 @@ err:
 	return -1;
 }
 
+/**
+ * Print the benchmark report.
+ * Each line is a "name value" pair, with the times in seconds.
+ */
+static void video_bench_report(struct advance_video_context* context, struct advance_estimate_context* estimate_context)
+{
+	double real_time = (double)(context->state.measure_stop - context->state.measure_start) / TARGET_CLOCKS_PER_SEC;
+	double game_time = context->state.measure_limit / context->state.game_fps;
+	const char* tag;
+	double time;
+	unsigned i;
+
+	target_out("game %s\n", mame_game_name(CONTEXT.game));
+	target_out("frames %u\n", context->state.measure_limit);
+	target_out("game_time %.6f\n", game_time);
+	target_out("real_time %.6f\n", real_time);
+	target_out("speed %.4f\n", game_time / real_time);
+	target_out("fps %.2f\n", context->state.measure_limit / real_time);
+
+	/* average time of a frame, in the core and in the OSD */
+	if (estimate_context->total_mame_count != 0)
+		target_out("frame_mame_time %.6f\n", estimate_context->total_mame / estimate_context->total_mame_count);
+	if (estimate_context->total_osd_count != 0)
+		target_out("frame_osd_time %.6f\n", estimate_context->total_osd / estimate_context->total_osd_count);
+	if (estimate_context->total_common_count != 0)
+		target_out("frame_common_time %.6f\n", estimate_context->total_common / estimate_context->total_common_count);
+
+	/* total time of each profiled section, only in the debug build */
+	for(i=0;mame_ui_profiler_get(i, &tag, &time) == 0;++i)
+		target_out("profiler_%s %.6f\n", tag, time);
+}
+
 void osd2_video_done(void)
 {
 	struct advance_video_context* context = &CONTEXT.video;
@@ -992,7 +1052,10 @@ void osd2_video_done(void)
         /* print the speed measure */
 	if (context->state.measure_flag
 		&& context->state.measure_stop > context->state.measure_start) {
-		target_out("%g\n", (double)(context->state.measure_stop - context->state.measure_start) / TARGET_CLOCKS_PER_SEC);
+		if (context->config.bench_flag)
+			video_bench_report(context, &CONTEXT.estimate);
+		else
+			target_out("%g\n", (double)(context->state.measure_stop - context->state.measure_start) / TARGET_CLOCKS_PER_SEC);
 	}
 }
 
@@ -1115,8 +1178,12 @@ void osd_reset(void)
 
 	/* initialize the measure state */
 	context->state.measure_counter = context->config.measure_time * context->state.game_fps;
+	context->state.measure_limit = context->state.measure_counter;
 	context->state.measure_flag = context->state.measure_counter != 0;
 	context->state.measure_start = target_clock();
+	advance_estimate_total_reset(&CONTEXT.estimate);
+
+	advance_profile_start(&CONTEXT.profile, context->state.measure_flag && context->config.bench_flag);
 
 	advance_video_update_skip(context);
 	advance_video_update_sync(context);
@@ -1148,6 +1215,27 @@ int osd_skip_this_frame(void)
 		return context->state.skip_flag;
 }
 
+void osd_wait_for_screen(void)
+{
+#ifdef USE_SMP
+	struct advance_video_context* context = &CONTEXT.video;
+
+	if (!context->state.thread_game_wait_flag)
+		return;
+
+	pthread_mutex_lock(&context->state.thread_video_mutex);
+
+	/* wait for the video thread to fill the bitmap */
+	while (context->state.thread_state_game_fill_flag) {
+		pthread_cond_wait(&context->state.thread_video_cond, &context->state.thread_video_mutex);
+	}
+
+	pthread_mutex_unlock(&context->state.thread_video_mutex);
+
+	context->state.thread_game_wait_flag = 0;
+#endif
+}
+
 static int int_compare(const void* void_a, const void* void_b)
 {
 	int* a = (int*)void_a;
@@ -1271,7 +1359,7 @@ int osd2_frame(const struct osd_bitmap* game, const struct osd_bitmap* debug, co
 	/* update the global info */
 	video_command(&CONTEXT.video, &CONTEXT.estimate, &CONTEXT.safequit, &CONTEXT.ui, CONTEXT.cfg, led, input, skip_flag, knocker);
 	advance_video_skip(&CONTEXT.video, &CONTEXT.estimate, &CONTEXT.record);
-	advance_input_update(&CONTEXT.input, &CONTEXT.safequit, CONTEXT.video.state.pause_flag);
+	advance_input_update(&CONTEXT.input, &CONTEXT.safequit, &CONTEXT.rewind, CONTEXT.video.state.pause_flag, (input & OSD_INPUT_REWIND) != 0);
 
 	/* estimate the time */
 	advance_estimate_frame(&CONTEXT.estimate);
@@ -1412,6 +1500,7 @@ adv_error advance_video_init(struct advance_video_context* context, adv_conf* cf
 	conf_bool_register_default(cfg_context, "display_scanlines", 0);
 	conf_bool_register_default(cfg_context, "display_vsync", 1);
 	conf_bool_register_default(cfg_context, "display_buffer", 0);
+	conf_bool_register_default(cfg_context, "display_partial", 0);
 	conf_int_register_enum_default(cfg_context, "display_resize", conf_enum(OPTION_RESIZE), STRETCH_FRACTIONAL_XY);
 	conf_int_register_enum_default(cfg_context, "display_magnify", conf_enum(OPTION_MAGNIFY), 0);
 	conf_int_register_default(cfg_context, "display_magnifysize", 640);
@@ -1442,6 +1531,9 @@ adv_error advance_video_init(struct advance_video_context* context, adv_conf* cf
 #ifdef USE_SMP
 	/* SMP always enabled by default */
 	conf_bool_register_default(cfg_context, "misc_smp", 1);
+	conf_int_register_limit_default(cfg_context, "misc_smpblit", 0, 16, 0);
+	conf_int_register_limit_default(cfg_context, "misc_smpthreads", 0, 65, 0);
+	conf_string_register_default(cfg_context, "misc_smpaffinity", "none");
 #endif
 
 	conf_int_register_enum_default(cfg_context, "sync_resample", conf_enum(OPTION_RESAMPLE), -1);
@@ -1535,6 +1627,7 @@ adv_error advance_video_config_load(struct advance_video_context* context, adv_c
 	context->config.scanlines_flag = conf_bool_get_default(cfg_context, "display_scanlines");
 	context->config.vsync_flag = conf_bool_get_default(cfg_context, "display_vsync");
 	context->config.triplebuf_flag = conf_bool_get_default(cfg_context, "display_buffer");
+	context->config.partial_flag = conf_bool_get_default(cfg_context, "display_partial");
 	context->config.stretch = conf_int_get_default(cfg_context, "display_resize");
 	context->config.magnify_factor = conf_int_get_default(cfg_context, "display_magnify");
 	context->config.magnify_size = conf_int_get_default(cfg_context, "display_magnifysize");
@@ -1670,8 +1763,14 @@ adv_error advance_video_config_load(struct advance_video_context* context, adv_c
 
 #ifdef USE_SMP
 	context->config.smp_flag = conf_bool_get_default(cfg_context, "misc_smp");
+	context->config.smp_blit = conf_int_get_default(cfg_context, "misc_smpblit");
+	context->config.smp_thread = conf_int_get_default(cfg_context, "misc_smpthreads");
+	sncpy(context->config.smp_affinity_buffer, sizeof(context->config.smp_affinity_buffer), conf_string_get_default(cfg_context, "misc_smpaffinity"));
 #else
 	context->config.smp_flag = 0;
+	context->config.smp_blit = 1;
+	context->config.smp_thread = 1;
+	sncpy(context->config.smp_affinity_buffer, sizeof(context->config.smp_affinity_buffer), "none");
 #endif
 
 	i = conf_int_get_default(cfg_context, "sync_resample");
@@ -1747,6 +1846,13 @@ void advance_video_done(struct advance_video_context* context)
 
 adv_error advance_video_inner_init(struct advance_video_context* context, struct mame_option* option)
 {
+	if (context->config.smp_flag) {
+		if (thread_set(context->config.smp_thread, context->config.smp_affinity_buffer) != 0) {
+			target_err("Invalid argument '%s' for option 'misc_smpaffinity'.\n", context->config.smp_affinity_buffer);
+			return -1;
+		}
+	}
+
 	if (adv_video_init() != 0) {
 		target_err("%s\n", error_get());
 		return -1;
@@ -1758,6 +1864,9 @@ adv_error advance_video_inner_init(struct advance_video_context* context, struct
 		return -1;
 	}
 
+	if (context->config.smp_flag)
+		video_blit_thread_set(osd_parallel_for, context->config.smp_blit);
+
 	advance_video_mode_preinit(context, option);
 
 	return 0;
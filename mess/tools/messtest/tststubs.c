@@ -31,6 +31,10 @@ int osd_skip_this_frame(void)
 	return 0;
 }
 
+void osd_wait_for_screen(void)
+{
+}
+
 mame_bitmap *osd_override_snapshot(mame_bitmap *bitmap, rectangle *bounds)
 {
 	return NULL;
@@ -78,6 +78,9 @@ endif
 ifneq ($(wildcard $(srcdir)/advance/i.mak),)
 include $(srcdir)/advance/i.mak
 endif
+ifneq ($(wildcard $(srcdir)/advance/b.mak),)
+include $(srcdir)/advance/b.mak
+endif
 ifneq ($(wildcard $(srcdir)/advance/j.mak),)
 include $(srcdir)/advance/j.mak
 endif
@@ -56,6 +56,13 @@
 
 #define NO_MATCH					(~0)
 
+#define MAX_READAHEAD_DEPTH			8			/* max self/parent references followed by the read-ahead */
+#define READAHEAD_IDLE				0			/* job free */
+#define READAHEAD_QUEUED			1			/* job waiting for its task */
+#define READAHEAD_DONE				2			/* hunk read and decompressed, not yet collected */
+#define READAHEAD_CANCELLED			3			/* hunk read by the caller, the task only frees the job */
+#define COMPRESS_WINDOW_HUNKS		64			/* hunks read while the previous ones are compressed */
+
 
 
 /*************************************
@@ -103,6 +110,81 @@ struct _metadata_entry
 typedef struct _metadata_entry metadata_entry;
 
 
+struct _cache_entry
+{
+	UINT8 *					data;			/* decompressed data */
+	UINT32					hunknum;		/* index of the cached hunk, or ~0 if empty */
+	UINT32					lastused;		/* time of the last access, for LRU */
+	struct _readahead_job *	job;			/* read-ahead job filling the data, or NULL */
+};
+typedef struct _cache_entry cache_entry;
+
+
+struct _readahead_job
+{
+	struct _chd_file *		chd;			/* file owning the job */
+	cache_entry *			entry;			/* target cache entry */
+	chd_interface_file *	file;			/* file containing the compressed data */
+	UINT64					offset;			/* offset of the compressed data */
+	UINT8 *					compressed;		/* compressed data, read by the task */
+	UINT32					length;			/* length of the compressed data */
+	UINT32					hunkbytes;		/* length of the decompressed data */
+	UINT32					crc[MAX_READAHEAD_DEPTH];	/* CRCs to validate */
+	int						crccount;		/* number of CRCs to validate */
+	void *					codecdata;		/* private decompressor */
+	void *					lock;			/* lock held by the task while it runs */
+	int						err;			/* result of the read and decompression */
+	int						state;			/* READAHEAD_* state, changed with the lock */
+};
+typedef struct _readahead_job readahead_job;
+
+
+struct _compress_job
+{
+	struct _compress_window *	window;		/* window owning the job */
+	UINT8 *					data;			/* raw data */
+	UINT8 *					compressed;		/* compressed data */
+	UINT32					hunknum;		/* index of the hunk */
+	UINT32					crc;			/* CRC of the raw data */
+	UINT32					length;			/* length of the compressed data, or 0 if not compressible */
+	UINT32					checksumbytes;	/* bytes to add to the MD5/SHA1 */
+	int						err;			/* result of the compression */
+	int						done;			/* set when compressed, changed with the lock */
+};
+typedef struct _compress_job compress_job;
+
+
+struct _compress_window
+{
+	struct _compress_state *	state;		/* pipeline owning the window */
+	compress_job			job[COMPRESS_WINDOW_HUNKS];	/* consecutive hunks */
+	UINT32					count;			/* number of hunks read, changed with the lock */
+	UINT32					hunknum;		/* index of the first hunk */
+	void *					group;			/* tasks using the hunks of the window */
+};
+typedef struct _compress_window compress_window;
+
+
+struct _compress_state
+{
+	chd_file *				chd;			/* file being written */
+	compress_window			window[2];		/* one is read, the other compressed and written */
+	compress_window *		fill;			/* window being read */
+	UINT32					capacity;		/* hunks in a full window */
+	struct MD5Context *		md5;			/* MD5 being computed */
+	struct sha1_ctx *		sha;			/* SHA1 being computed */
+	chd_interface			groupif;		/* interface used to run the tasks */
+	void *					lock;			/* lock of the shared state, or NULL to work serially */
+	UINT32					nextwrite;		/* next hunk to write, in order */
+	int						writing;		/* set while a task writes the hunks */
+	int						err;			/* first error of the tasks */
+	UINT64					length;			/* length of the file written by the tasks */
+	void *					codec[2 * COMPRESS_WINDOW_HUNKS];	/* idle compressors */
+	UINT32					codeccount;		/* number of idle compressors */
+};
+typedef struct _compress_state compress_state;
+
+
 struct _chd_file
 {
 	UINT32					cookie;			/* cookie, should equal COOKIE_VALUE */
@@ -115,8 +197,17 @@ struct _chd_file
 
 	map_entry *				map;			/* array of map entries */
 
-	UINT8 *					cache;			/* hunk cache pointer */
-	UINT32					cachehunk;		/* index of currently cached hunk */
+	UINT8 *					cache;			/* hunk buffer used for compression */
+
+	cache_entry *			cachemap;		/* LRU cache of decompressed hunks */
+	UINT32					cachecount;		/* number of cache entries */
+	UINT32					cacheclock;		/* LRU clock */
+
+	readahead_job *			readahead;		/* read-ahead jobs, or NULL if disabled */
+	UINT32					readaheadcount;	/* number of read-ahead jobs */
+	UINT32					lasthunk;		/* last hunk read, to detect sequential access */
+	chd_interface			groupif;		/* interface used to run the read-ahead */
+	void *					group;			/* task group of the read-ahead jobs */
 
 	UINT8 *					compare;		/* hunk compare pointer */
 	UINT32					comparehunk;	/* index of current compare data */
@@ -162,6 +253,13 @@ static chd_interface cur_interface;
 static chd_file *first_file;
 static int last_error;
 
+static UINT32 cache_hunks = CHD_CACHE_HUNKS_DEFAULT;
+static UINT32 cache_readahead = CHD_CACHE_READAHEAD_DEFAULT;
+
+static void *file_lock;						/* file access lock, while any read-ahead is active */
+static chd_interface file_lock_interface;	/* interface of the file access lock */
+static UINT32 file_lock_users;				/* number of files with the read-ahead */
+
 static const UINT8 nullmd5[CHD_MD5_BYTES] = { 0 };
 static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 
@@ -175,8 +273,24 @@ static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 
 static int validate_header(const chd_header *header);
 static int read_hunk_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest);
-static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum);
-static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src);
+static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum, UINT8 **data);
+static int init_cache(chd_file *chd);
+static void free_cache(chd_file *chd);
+static void free_readahead(chd_file *chd);
+static cache_entry *cache_find(chd_file *chd, UINT32 hunknum);
+static cache_entry *cache_victim(chd_file *chd);
+static void cache_wait(chd_file *chd);
+static void cache_collect(chd_file *chd, cache_entry *entry);
+static void cache_invalidate(chd_file *chd, UINT32 hunknum);
+static void readahead_start(chd_file *chd, UINT32 hunknum);
+static int compress_hunk(void *codecdata, UINT32 compression, UINT32 hunkbytes, const UINT8 *src, UINT8 *dest);
+static void compress_init(compress_state *state, chd_file *chd, UINT32 hunknum, struct MD5Context *md5, struct sha1_ctx *sha);
+static void compress_free(compress_state *state);
+static UINT8 *compress_buffer(compress_state *state);
+static UINT64 compress_length(compress_state *state);
+static int compress_push(compress_state *state, UINT32 hunknum, UINT32 checksumbytes);
+static int compress_flush(compress_state *state);
+static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src, const compress_job *job);
 static int read_header(chd_interface_file *file, chd_header *header);
 static int write_header(chd_interface_file *file, const chd_header *header);
 static int read_hunk_map(chd_file *chd);
@@ -187,6 +301,8 @@ static int find_metadata_entry(chd_file *chd, UINT32 metatag, UINT32 metaindex,
 
 static int init_codec(chd_file *chd);
 static void free_codec(chd_file *chd);
+static void *init_stream(int compress);
+static void free_stream(void *codecdata);
 
 static chd_interface_file *multi_open(const char *filename, const char *mode);
 static void multi_close(chd_interface_file *file);
@@ -310,6 +426,25 @@ void chd_save_interface(chd_interface *interface_save)
 
 
 
+/*************************************
+ *
+ *  Cache setup
+ *
+ *************************************/
+
+void chd_set_cache_size(UINT32 hunks, UINT32 readahead)
+{
+	/* applies to the files opened later */
+	cache_hunks = hunks ? hunks : 1;
+
+	/* leave room for the hunks in use */
+	cache_readahead = readahead;
+	if (cache_readahead > cache_hunks / 2)
+		cache_readahead = cache_hunks / 2;
+}
+
+
+
 /*************************************
  *
  *  Create a new data file
@@ -501,6 +636,7 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 {
 	chd_file *finalchd;
 	chd_file chd = { 0 };
+	UINT32 i;
 	int err;
 
 	last_error = CHDERR_NONE;
@@ -566,14 +702,18 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 	if (err != CHDERR_NONE)
 		SET_ERROR_AND_CLEANUP(err);
 
-	/* allocate and init the hunk cache */
+	/* allocate the hunk buffers */
 	chd.cache = malloc(chd.header.hunkbytes);
 	chd.compare = malloc(chd.header.hunkbytes);
 	if (!chd.cache || !chd.compare)
 		SET_ERROR_AND_CLEANUP(CHDERR_OUT_OF_MEMORY);
-	chd.cachehunk = ~0;
 	chd.comparehunk = ~0;
 
+	/* allocate and init the hunk cache */
+	err = init_cache(&chd);
+	if (err != CHDERR_NONE)
+		SET_ERROR_AND_CLEANUP(err);
+
 	/* allocate the temporary compressed buffer */
 	chd.compressed = malloc(chd.header.hunkbytes);
 	if (!chd.compressed)
@@ -590,6 +730,10 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 		SET_ERROR_AND_CLEANUP(CHDERR_OUT_OF_MEMORY);
 	*finalchd = chd;
 
+	/* the read-ahead jobs refer to the final copy */
+	for (i = 0; i < finalchd->readaheadcount; i++)
+		finalchd->readahead[i].chd = finalchd;
+
 	/* hook us into the global list */
 	finalchd->cookie = COOKIE_VALUE;
 	finalchd->next = first_file;
@@ -599,6 +743,7 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 	return finalchd;
 
 cleanup:
+	free_cache(&chd);
 	if (chd.codecdata)
 		free_codec(&chd);
 	if (chd.compressed)
@@ -630,6 +775,9 @@ void chd_close(chd_file *chd)
 	if (!chd || chd->cookie != COOKIE_VALUE)
 		return;
 
+	/* stop the read-ahead and free the hunk cache */
+	free_cache(chd);
+
 	/* deinit the codec */
 	if (chd->codecdata)
 		free_codec(chd);
@@ -638,7 +786,7 @@ void chd_close(chd_file *chd)
 	if (chd->compressed)
 		free(chd->compressed);
 
-	/* free the hunk cache and compare data */
+	/* free the hunk buffers */
 	if (chd->compare)
 		free(chd->compare);
 	if (chd->cache)
@@ -854,6 +1002,7 @@ int chd_set_metadata(chd_file *chd, UINT32 metatag, UINT32 metaindex, const void
 
 UINT32 chd_read(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, void *buffer)
 {
+	UINT8 *data;
 	int err;
 
 	last_error = CHDERR_NONE;
@@ -880,15 +1029,12 @@ UINT32 chd_read(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, void *buffer)
 		chd->maxhunk = hunknum;
 
 	/* if the hunk is not cached, load and decompress it */
-	if (chd->cachehunk != hunknum)
-	{
-		err = read_hunk_into_cache(chd, hunknum);
-		if (err != CHDERR_NONE)
-			SET_ERROR_AND_CLEANUP(err);
-	}
+	err = read_hunk_into_cache(chd, hunknum, &data);
+	if (err != CHDERR_NONE)
+		SET_ERROR_AND_CLEANUP(err);
 
 	/* now copy the data from the cache */
-	memcpy(buffer, chd->cache, chd->header.hunkbytes);
+	memcpy(buffer, data, chd->header.hunkbytes);
 	return 1;
 
 cleanup:
@@ -931,7 +1077,7 @@ UINT32 chd_write(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, const void *bu
 		chd->maxhunk = hunknum;
 
 	/* then write out the hunk */
-	err = write_hunk_from_memory(chd, hunknum, buffer);
+	err = write_hunk_from_memory(chd, hunknum, buffer, NULL);
 	if (err != CHDERR_NONE)
 		SET_ERROR_AND_CLEANUP(err);
 	return 1;
@@ -1055,9 +1201,12 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 	UINT64 sourceoffset = 0;
 	struct MD5Context md5;
 	struct sha1_ctx sha;
+	compress_state state;
 	clock_t lastupdate;
 	int err, hunknum;
 
+	state.chd = NULL;
+
 	/* punt if no interface */
 	if (!cur_interface.open)
 		SET_ERROR_AND_CLEANUP(CHDERR_NO_INTERFACE);
@@ -1086,6 +1235,9 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 	MD5Init(&md5);
 	sha1_init(&sha);
 
+	/* the hunks are compressed, hashed and written by the tasks while the next are read */
+	compress_init(&state, chd, 0, &md5, &sha);
+
 	/* loop over source hunks until we run out */
 	lastupdate = 0;
 	for (hunknum = 0; hunknum < chd->header.totalhunks; hunknum++)
@@ -1093,18 +1245,20 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 		clock_t curtime = clock();
 		UINT32 bytestochecksum;
 		UINT32 bytesread;
+		UINT8 *data = compress_buffer(&state);
 
-		/* read the data */
-		bytesread = multi_read(sourcefile, sourceoffset + offset, chd->header.hunkbytes, chd->cache);
+		/* read the data; the source isn't shared with the read-ahead tasks, and a */
+		/* CHD source, as in chdman -diff, takes the file lock in its own reads */
+		bytesread = (*cur_interface.read)(sourcefile, sourceoffset + offset, chd->header.hunkbytes, data);
 		if (bytesread < chd->header.hunkbytes)
-			memset(&chd->cache[bytesread], 0, chd->header.hunkbytes - bytesread);
+			memset(&data[bytesread], 0, chd->header.hunkbytes - bytesread);
 
 		/* progress */
 		if (curtime - lastupdate > CLOCKS_PER_SEC / 2)
 		{
 			UINT64 sourcepos = (UINT64)hunknum * chd->header.hunkbytes;
 			if (progress && sourcepos)
-				(*progress)("Compressing hunk %d/%d... (ratio=%d%%)  \r", hunknum, chd->header.totalhunks, 100 - multi_length(chd->file) * 100 / sourcepos);
+				(*progress)("Compressing hunk %d/%d... (ratio=%d%%)  \r", hunknum, chd->header.totalhunks, 100 - compress_length(&state) * 100 / sourcepos);
 			lastupdate = curtime;
 		}
 
@@ -1117,26 +1271,22 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 			else
 				bytestochecksum = chd->header.logicalbytes - sourceoffset;
 		}
-		if (bytestochecksum)
-		{
-			MD5Update(&md5, chd->cache, bytestochecksum);
-			sha1_update(&sha, bytestochecksum, chd->cache);
-		}
 
-		/* write out the hunk */
-		err = write_hunk_from_memory(chd, hunknum, chd->cache);
+		/* hash and write out the hunk */
+		err = compress_push(&state, hunknum, bytestochecksum);
 		if (err != CHDERR_NONE)
 			SET_ERROR_AND_CLEANUP(err);
 
-		/* update our CRC map */
-		if ((chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
-			(chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
-			add_to_crcmap(chd, hunknum);
-
 		/* prepare for the next hunk */
 		sourceoffset += chd->header.hunkbytes;
 	}
 
+	/* write out the remaining hunks */
+	err = compress_flush(&state);
+	compress_free(&state);
+	if (err != CHDERR_NONE)
+		SET_ERROR_AND_CLEANUP(err);
+
 	/* compute the final MD5/SHA1 values */
 	MD5Final(chd->header.md5, &md5);
 	sha1_final(&sha);
@@ -1161,6 +1311,7 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 	return CHDERR_NONE;
 
 cleanup:
+	compress_free(&state);
 	if (sourcefile)
 		multi_close(sourcefile);
 	return last_error;
@@ -1177,6 +1328,7 @@ int chd_verify(chd_file *chd, void (*progress)(const char *, ...), UINT8 actualm
 	struct MD5Context md5;
 	struct sha1_ctx sha;
 	UINT64 sourceoffset = 0;
+	UINT8 *data;
 	int err, prev_err = CHDERR_NONE, hunknum = 0;
 	clock_t lastupdate;
 
@@ -1212,7 +1364,7 @@ int chd_verify(chd_file *chd, void (*progress)(const char *, ...), UINT8 actualm
 		}
 
 		/* read the hunk into the cache */
-		err = read_hunk_into_cache(chd, hunknum);
+		err = read_hunk_into_cache(chd, hunknum, &data);
 		if (err == CHDERR_DECOMPRESSION_ERROR)
 		{
 			prev_err = CHDERR_DECOMPRESSION_ERROR;
@@ -1233,8 +1385,8 @@ int chd_verify(chd_file *chd, void (*progress)(const char *, ...), UINT8 actualm
 		}
 		if (bytestochecksum)
 		{
-			MD5Update(&md5, chd->cache, bytestochecksum);
-			sha1_update(&sha, bytestochecksum, chd->cache);
+			MD5Update(&md5, data, bytestochecksum);
+			sha1_update(&sha, bytestochecksum, data);
 		}
 
 		/* prepare for the next hunk */
@@ -1324,6 +1476,7 @@ static int validate_header(const chd_header *header)
 static int read_hunk_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest)
 {
 	map_entry *entry = &chd->map[hunknum];
+	cache_entry *cached;
 	UINT32 bytes;
 	int err;
 
@@ -1382,12 +1535,22 @@ static int read_hunk_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest)
 
 		/* self-referenced data */
 		case MAP_ENTRY_TYPE_SELF_HUNK:
-			if (chd->cachehunk == entry->offset && dest == chd->cache)
+			cached = cache_find(chd, entry->offset);
+			if (cached && !cached->job)
+			{
+				memcpy(dest, cached->data, chd->header.hunkbytes);
 				break;
+			}
 			return read_hunk_into_memory(chd, entry->offset, dest);
 
 		/* parent-referenced data */
 		case MAP_ENTRY_TYPE_PARENT_HUNK:
+			cached = cache_find(chd->parent, entry->offset);
+			if (cached && !cached->job)
+			{
+				memcpy(dest, cached->data, chd->header.hunkbytes);
+				break;
+			}
 			err = read_hunk_into_memory(chd->parent, entry->offset, dest);
 			if (err != CHDERR_NONE)
 				return err;
@@ -1401,26 +1564,441 @@ static int read_hunk_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest)
 }
 
 
-static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum)
+static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum, UINT8 **data)
 {
+	cache_entry *entry;
 	int err;
 
 	/* if we're already in the cache, we're done */
-	if (chd->cachehunk == hunknum)
+	entry = cache_find(chd, hunknum);
+	if (entry && entry->job)
+	{
+		/* collect the read-ahead of this hunk only; on failure the entry is released */
+		cache_collect(chd, entry);
+		if (entry->hunknum != hunknum)
+			entry = NULL;
+	}
+	if (entry)
+	{
+		entry->lastused = ++chd->cacheclock;
+		*data = entry->data;
+		readahead_start(chd, hunknum);
 		return CHDERR_NONE;
-	chd->cachehunk = ~0;
+	}
 
-	/* otherwise, read the data */
-	err = read_hunk_into_memory(chd, hunknum, chd->cache);
+	/* otherwise, replace the least recently used entry */
+	entry = cache_victim(chd);
+	if (!entry)
+	{
+		cache_wait(chd);
+		entry = cache_victim(chd);
+	}
+	entry->hunknum = ~0;
+	*data = entry->data;
+
+	/* read the data */
+	err = read_hunk_into_memory(chd, hunknum, entry->data);
 	if (err != CHDERR_NONE)
 		return err;
 
 	/* mark the hunk successfully cached in */
-	chd->cachehunk = hunknum;
+	entry->hunknum = hunknum;
+	entry->lastused = ++chd->cacheclock;
+
+	/* start decompressing the next hunks while the caller uses this one */
+	readahead_start(chd, hunknum);
+	return CHDERR_NONE;
+}
+
+
+
+/*************************************
+ *
+ *  Hunk cache
+ *
+ *************************************/
+
+static int init_cache(chd_file *chd)
+{
+	UINT8 *data;
+	UINT32 i;
+
+	/* allocate the entries and their data in a single block */
+	chd->cachecount = cache_hunks;
+	chd->cachemap = malloc(chd->cachecount * sizeof(cache_entry));
+	if (!chd->cachemap)
+		return CHDERR_OUT_OF_MEMORY;
+	data = malloc(chd->cachecount * chd->header.hunkbytes);
+	if (!data)
+	{
+		free(chd->cachemap);
+		chd->cachemap = NULL;
+		return CHDERR_OUT_OF_MEMORY;
+	}
+	for (i = 0; i < chd->cachecount; i++)
+	{
+		chd->cachemap[i].data = data + i * chd->header.hunkbytes;
+		chd->cachemap[i].hunknum = ~0;
+		chd->cachemap[i].lastused = 0;
+		chd->cachemap[i].job = NULL;
+	}
+	chd->cacheclock = 0;
+	chd->lasthunk = ~0;
+
+	/* the read-ahead needs a way to run the jobs; without it, just cache */
+	chd->groupif = cur_interface;
+	if (!cache_readahead || !chd->groupif.group_alloc || !chd->groupif.lock_alloc)
+		return CHDERR_NONE;
+
+	chd->readahead = malloc(cache_readahead * sizeof(readahead_job));
+	if (!chd->readahead)
+		return CHDERR_NONE;
+	memset(chd->readahead, 0, cache_readahead * sizeof(readahead_job));
+	chd->readaheadcount = cache_readahead;
+
+	/* each job has its own decompressor, so they can run in parallel */
+	for (i = 0; i < chd->readaheadcount; i++)
+	{
+		readahead_job *job = &chd->readahead[i];
+
+		job->chd = chd;
+		job->hunkbytes = chd->header.hunkbytes;
+		job->compressed = malloc(chd->header.hunkbytes);
+		job->codecdata = init_stream(0);
+		job->lock = (*chd->groupif.lock_alloc)();
+		if (!job->compressed || !job->codecdata || !job->lock)
+			break;
+	}
+
+	/* the tasks read the files, so all the accesses are serialized by a single lock */
+	if (i == chd->readaheadcount && !file_lock)
+	{
+		file_lock_interface = chd->groupif;
+		file_lock = (*file_lock_interface.lock_alloc)();
+	}
+	if (i == chd->readaheadcount && file_lock)
+		chd->group = (*chd->groupif.group_alloc)();
+
+	/* if something failed, go on without read-ahead */
+	if (!chd->group)
+	{
+		free_readahead(chd);
+		if (!file_lock_users && file_lock)
+		{
+			(*file_lock_interface.lock_free)(file_lock);
+			file_lock = NULL;
+		}
+		return CHDERR_NONE;
+	}
+
+	file_lock_users++;
+	return CHDERR_NONE;
+}
+
+
+static void free_readahead(chd_file *chd)
+{
+	UINT32 i;
+
+	for (i = 0; i < chd->readaheadcount; i++)
+	{
+		readahead_job *job = &chd->readahead[i];
+
+		if (job->compressed)
+			free(job->compressed);
+		if (job->codecdata)
+			free_stream(job->codecdata);
+		if (job->lock)
+			(*chd->groupif.lock_free)(job->lock);
+	}
+	free(chd->readahead);
+	chd->readahead = NULL;
+	chd->readaheadcount = 0;
+}
+
+
+static void free_cache(chd_file *chd)
+{
+	/* stop the read-ahead before freeing what it uses */
+	if (chd->group)
+	{
+		(*chd->groupif.group_wait)(chd->group);
+		(*chd->groupif.group_free)(chd->group);
+		chd->group = NULL;
+
+		/* the last file with the read-ahead frees the file lock */
+		if (--file_lock_users == 0)
+		{
+			(*file_lock_interface.lock_free)(file_lock);
+			file_lock = NULL;
+		}
+	}
+
+	if (chd->readahead)
+		free_readahead(chd);
+
+	if (chd->cachemap)
+	{
+		free(chd->cachemap[0].data);
+		free(chd->cachemap);
+		chd->cachemap = NULL;
+	}
+}
+
+
+static cache_entry *cache_find(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 i;
+
+	for (i = 0; i < chd->cachecount; i++)
+		if (chd->cachemap[i].hunknum == hunknum)
+			return &chd->cachemap[i];
+	return NULL;
+}
+
+
+static cache_entry *cache_victim(chd_file *chd)
+{
+	cache_entry *victim = NULL;
+	UINT32 i;
+
+	/* pick the least recently used entry not being filled by the read-ahead */
+	for (i = 0; i < chd->cachecount; i++)
+	{
+		cache_entry *entry = &chd->cachemap[i];
+		if (entry->job)
+			continue;
+		if (entry->hunknum == ~0)
+			return entry;
+		if (!victim || entry->lastused < victim->lastused)
+			victim = entry;
+	}
+	return victim;
+}
+
+
+static void cache_wait(chd_file *chd)
+{
+	UINT32 i;
+
+	if (!chd->group)
+		return;
+
+	/* the group can only wait for all the queued jobs */
+	(*chd->groupif.group_wait)(chd->group);
+
+	for (i = 0; i < chd->readaheadcount; i++)
+		if (chd->readahead[i].entry)
+			cache_collect(chd, chd->readahead[i].entry);
+}
+
+
+static void cache_collect(chd_file *chd, cache_entry *entry)
+{
+	readahead_job *job = entry->job;
+	int err = CHDERR_READ_ERROR;
+
+	/* wait only if the task is running, a queued one is cancelled */
+	(*chd->groupif.lock_acquire)(job->lock);
+	if (job->state == READAHEAD_DONE)
+	{
+		err = job->err;
+		job->state = READAHEAD_IDLE;
+	}
+	else
+		job->state = READAHEAD_CANCELLED;
+	(*chd->groupif.lock_release)(job->lock);
+
+	/* a failed or cancelled hunk is read again by the caller, which reports the error */
+	if (err != CHDERR_NONE)
+		entry->hunknum = ~0;
+	entry->job = NULL;
+	job->entry = NULL;
+}
+
+
+static void cache_invalidate(chd_file *chd, UINT32 hunknum)
+{
+	cache_entry *entry = cache_find(chd, hunknum);
+
+	if (!entry)
+		return;
+	if (entry->job)
+		cache_collect(chd, entry);
+	entry->hunknum = ~0;
+}
+
+
+
+/*************************************
+ *
+ *  Hunk read-ahead
+ *
+ *************************************/
+
+static int readahead_load(readahead_job *job)
+{
+	zlib_codec_data *codec = job->codecdata;
+	UINT8 *dest = job->entry->data;
+	int i;
+
+	/* read */
+	if (multi_read(job->file, job->offset, job->length, job->compressed) != job->length)
+		return CHDERR_READ_ERROR;
+
+	/* decompress */
+	codec->inflater.next_in = job->compressed;
+	codec->inflater.avail_in = job->length;
+	codec->inflater.total_in = 0;
+	codec->inflater.next_out = dest;
+	codec->inflater.avail_out = job->hunkbytes;
+	codec->inflater.total_out = 0;
+	if (inflateReset(&codec->inflater) != Z_OK)
+		return CHDERR_DECOMPRESSION_ERROR;
+	inflate(&codec->inflater, Z_FINISH);
+	if (codec->inflater.total_out != job->hunkbytes)
+		return CHDERR_DECOMPRESSION_ERROR;
+
+	/* validate all the CRCs found following the references */
+	for (i = 0; i < job->crccount; i++)
+		if (job->crc[i] != crc32(0, &dest[0], job->hunkbytes))
+			return CHDERR_DECOMPRESSION_ERROR;
+
 	return CHDERR_NONE;
 }
 
 
+static void readahead_task(void *param)
+{
+	readahead_job *job = param;
+	chd_interface *groupif = &job->chd->groupif;
+
+	/* the caller holds the lock only to collect or cancel the job */
+	(*groupif->lock_acquire)(job->lock);
+	if (job->state == READAHEAD_QUEUED)
+	{
+		job->err = readahead_load(job);
+		job->state = READAHEAD_DONE;
+	}
+	else
+		job->state = READAHEAD_IDLE;
+	(*groupif->lock_release)(job->lock);
+}
+
+
+static int readahead_prepare(chd_file *chd, UINT32 hunknum, readahead_job *job)
+{
+	int depth;
+
+	job->crccount = 0;
+
+	/* follow the references up to the compressed data */
+	for (depth = 0; depth < MAX_READAHEAD_DEPTH; depth++)
+	{
+		map_entry *entry = &chd->map[hunknum];
+
+		if (!(entry->flags & MAP_ENTRY_FLAG_NO_CRC))
+			job->crc[job->crccount++] = entry->crc;
+
+		switch (entry->flags & MAP_ENTRY_FLAG_TYPE_MASK)
+		{
+			case MAP_ENTRY_TYPE_COMPRESSED:
+				if (chd->header.compression != CHDCOMPRESSION_ZLIB && chd->header.compression != CHDCOMPRESSION_ZLIB_PLUS)
+					return 0;
+
+				/* the task reads and decompresses the data */
+				job->file = chd->file;
+				job->offset = entry->offset;
+				job->length = entry->length;
+				return 1;
+
+			case MAP_ENTRY_TYPE_SELF_HUNK:
+				hunknum = entry->offset;
+				break;
+
+			case MAP_ENTRY_TYPE_PARENT_HUNK:
+				chd = chd->parent;
+				hunknum = entry->offset;
+				break;
+
+			/* uncompressed and mini hunks are cheap to read when needed */
+			default:
+				return 0;
+		}
+	}
+	return 0;
+}
+
+
+static void readahead_start(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 next, last, i;
+
+	if (!chd->readahead)
+		return;
+
+	/* only sequential access triggers the read-ahead */
+	if (hunknum != chd->lasthunk + 1)
+	{
+		chd->lasthunk = hunknum;
+		return;
+	}
+	chd->lasthunk = hunknum;
+
+	last = hunknum + chd->readaheadcount;
+	if (last >= chd->header.totalhunks)
+		last = chd->header.totalhunks - 1;
+
+	i = 0;
+	for (next = hunknum + 1; next <= last; next++)
+	{
+		readahead_job *job;
+		cache_entry *entry;
+
+		if (cache_find(chd, next))
+			continue;
+
+		/* get a free job, collecting the completed ones */
+		for (; i < chd->readaheadcount; i++)
+		{
+			int state;
+
+			job = &chd->readahead[i];
+			(*chd->groupif.lock_acquire)(job->lock);
+			state = job->state;
+			(*chd->groupif.lock_release)(job->lock);
+
+			if (state == READAHEAD_DONE)
+			{
+				cache_collect(chd, job->entry);
+				state = READAHEAD_IDLE;
+			}
+			if (state == READAHEAD_IDLE)
+				break;
+		}
+		if (i == chd->readaheadcount)
+			break;
+		job = &chd->readahead[i];
+
+		/* don't queue anything the synchronous path reads as fast */
+		if (!readahead_prepare(chd, next, job))
+			continue;
+
+		entry = cache_victim(chd);
+		if (!entry)
+			break;
+
+		entry->hunknum = next;
+		entry->lastused = ++chd->cacheclock;
+		entry->job = job;
+		job->entry = entry;
+		job->state = READAHEAD_QUEUED;
+
+		(*chd->groupif.group_run)(chd->group, readahead_task, job);
+	}
+}
+
+
 
 /*************************************
  *
@@ -1428,16 +2006,21 @@ static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum)
  *
  *************************************/
 
-static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src)
+static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src, const compress_job *job)
 {
 	map_entry *entry = &chd->map[hunknum];
 	map_entry newentry;
 	UINT8 fileentry[MAP_ENTRY_SIZE];
 	const void *data = src;
+	UINT8 *compressed;
 	UINT32 bytes, match;
+	int length;
+
+	/* the cached copy becomes stale */
+	cache_invalidate(chd, hunknum);
 
-	/* first compute the CRC */
-	newentry.crc = crc32(0, &src[0], chd->header.hunkbytes);
+	/* first compute the CRC, unless the job already did it */
+	newentry.crc = job ? job->crc : crc32(0, &src[0], chd->header.hunkbytes);
 
 	/* some extra stuff for zlib+ compression */
 	if (chd->header.compression == CHDCOMPRESSION_ZLIB_PLUS)
@@ -1485,38 +2068,26 @@ static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *sr
 	newentry.length = chd->header.hunkbytes;
 	newentry.flags = MAP_ENTRY_TYPE_UNCOMPRESSED;
 
-	/* now try compressing the data */
-	switch (chd->header.compression)
+	/* now try compressing the data, unless the job already did it */
+	if (job)
 	{
-		case CHDCOMPRESSION_ZLIB:
-		case CHDCOMPRESSION_ZLIB_PLUS:
-		{
-			zlib_codec_data *codec = chd->codecdata;
-			int err;
-
-			/* reset the decompressor */
-			codec->deflater.next_in = (void *)src;
-			codec->deflater.avail_in = chd->header.hunkbytes;
-			codec->deflater.total_in = 0;
-			codec->deflater.next_out = chd->compressed;
-			codec->deflater.avail_out = chd->header.hunkbytes;
-			codec->deflater.total_out = 0;
-			err = deflateReset(&codec->deflater);
-			if (err != Z_OK)
-				return CHDERR_COMPRESSION_ERROR;
-
-			/* do it */
-			err = deflate(&codec->deflater, Z_FINISH);
+		compressed = job->compressed;
+		length = job->length;
+	}
+	else
+	{
+		compressed = chd->compressed;
+		length = compress_hunk(chd->codecdata, chd->header.compression, chd->header.hunkbytes, src, compressed);
+		if (length < 0)
+			return CHDERR_COMPRESSION_ERROR;
+	}
 
-			/* if we didn't run out of space, override the raw data with compressed */
-			if (err == Z_STREAM_END && codec->deflater.total_out < newentry.length)
-			{
-				data = chd->compressed;
-				newentry.length = codec->deflater.total_out;
-				newentry.flags = MAP_ENTRY_TYPE_COMPRESSED;
-			}
-			break;
-		}
+	/* if we didn't run out of space, override the raw data with compressed */
+	if (length != 0)
+	{
+		data = compressed;
+		newentry.length = length;
+		newentry.flags = MAP_ENTRY_TYPE_COMPRESSED;
 	}
 
 	/* if the data doesn't fit into the previous entry, make a new one at the eof */
@@ -1544,6 +2115,413 @@ write_entry:
 
 
 
+/*************************************
+ *
+ *  Parallel compression
+ *
+ *************************************/
+
+static int compress_hunk(void *codecdata, UINT32 compression, UINT32 hunkbytes, const UINT8 *src, UINT8 *dest)
+{
+	switch (compression)
+	{
+		case CHDCOMPRESSION_ZLIB:
+		case CHDCOMPRESSION_ZLIB_PLUS:
+		{
+			zlib_codec_data *codec = codecdata;
+			int err;
+
+			/* reset the compressor */
+			codec->deflater.next_in = (void *)src;
+			codec->deflater.avail_in = hunkbytes;
+			codec->deflater.total_in = 0;
+			codec->deflater.next_out = dest;
+			codec->deflater.avail_out = hunkbytes;
+			codec->deflater.total_out = 0;
+			err = deflateReset(&codec->deflater);
+			if (err != Z_OK)
+				return -1;
+
+			/* do it */
+			err = deflate(&codec->deflater, Z_FINISH);
+
+			/* use the compressed data only if we didn't run out of space */
+			if (err == Z_STREAM_END && codec->deflater.total_out < hunkbytes)
+				return codec->deflater.total_out;
+			break;
+		}
+	}
+
+	/* not compressible */
+	return 0;
+}
+
+
+/* write the compressed hunks of the window in order, starting from the next */
+/* to write; called with the lock held, which is released during the writes */
+static void compress_write(compress_window *window)
+{
+	compress_state *state = window->state;
+	chd_file *chd = state->chd;
+
+	/* a single task writes at a time, and only the hunks of its own window */
+	if (state->writing || state->err != CHDERR_NONE)
+		return;
+	state->writing = 1;
+
+	while (state->nextwrite - window->hunknum < window->count)
+	{
+		compress_job *job = &window->job[state->nextwrite - window->hunknum];
+		map_entry *entry = &chd->map[job->hunknum];
+		UINT64 end = 0;
+		int err;
+
+		if (!job->done)
+			break;
+
+		/* the other hunks are compressed meanwhile */
+		(*state->groupif.lock_release)(state->lock);
+
+		err = job->err;
+		if (err == CHDERR_NONE)
+			err = write_hunk_from_memory(chd, job->hunknum, job->data, job);
+
+		/* update our CRC map */
+		if (err == CHDERR_NONE &&
+			(entry->flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
+			(entry->flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
+			add_to_crcmap(chd, job->hunknum);
+
+		/* note the end of the data, for the progress */
+		if (err == CHDERR_NONE && entry->length != 0)
+			end = entry->offset + entry->length;
+
+		(*state->groupif.lock_acquire)(state->lock);
+
+		if (err != CHDERR_NONE)
+		{
+			state->err = err;
+			break;
+		}
+		if (end > state->length)
+			state->length = end;
+		state->nextwrite++;
+	}
+
+	state->writing = 0;
+}
+
+
+static void compress_task(void *param)
+{
+	compress_job *job = param;
+	compress_window *window = job->window;
+	compress_state *state = window->state;
+	chd_file *chd = state->chd;
+	void *codecdata = NULL;
+	int length;
+
+	job->crc = crc32(0, &job->data[0], chd->header.hunkbytes);
+	job->length = 0;
+	job->err = CHDERR_NONE;
+
+	/* skip the hunks stored as mini, they don't need the compressed data */
+	if (chd->header.compression == CHDCOMPRESSION_ZLIB_PLUS)
+	{
+		UINT32 bytes;
+		for (bytes = 8; bytes < chd->header.hunkbytes; bytes++)
+			if (job->data[bytes] != job->data[bytes - 8])
+				break;
+		if (bytes == chd->header.hunkbytes)
+			goto done;
+	}
+
+	/* take an idle compressor, or make a new one */
+	if (chd->header.compression != CHDCOMPRESSION_NONE)
+	{
+		(*state->groupif.lock_acquire)(state->lock);
+		if (state->codeccount)
+			codecdata = state->codec[--state->codeccount];
+		(*state->groupif.lock_release)(state->lock);
+		if (!codecdata)
+			codecdata = init_stream(1);
+		if (!codecdata)
+		{
+			job->err = CHDERR_OUT_OF_MEMORY;
+			goto done;
+		}
+	}
+
+	length = compress_hunk(codecdata, chd->header.compression, chd->header.hunkbytes, job->data, job->compressed);
+	if (length < 0)
+		job->err = CHDERR_COMPRESSION_ERROR;
+	else
+		job->length = length;
+
+done:
+	(*state->groupif.lock_acquire)(state->lock);
+	if (codecdata)
+		state->codec[state->codeccount++] = codecdata;
+
+	/* write the hunk, and the following ones, if it's the next in order */
+	job->done = 1;
+	compress_write(window);
+	(*state->groupif.lock_release)(state->lock);
+}
+
+
+static void compress_write_task(void *param)
+{
+	compress_window *window = param;
+	compress_state *state = window->state;
+
+	(*state->groupif.lock_acquire)(state->lock);
+	compress_write(window);
+	(*state->groupif.lock_release)(state->lock);
+}
+
+
+static void compress_md5_task(void *param)
+{
+	compress_window *window = param;
+	UINT32 i;
+
+	for (i = 0; i < window->count; i++)
+		if (window->job[i].checksumbytes)
+			MD5Update(window->state->md5, window->job[i].data, window->job[i].checksumbytes);
+}
+
+
+static void compress_sha1_task(void *param)
+{
+	compress_window *window = param;
+	UINT32 i;
+
+	for (i = 0; i < window->count; i++)
+		if (window->job[i].checksumbytes)
+			sha1_update(window->state->sha, window->job[i].checksumbytes, window->job[i].data);
+}
+
+
+static void compress_init(compress_state *state, chd_file *chd, UINT32 hunknum, struct MD5Context *md5, struct sha1_ctx *sha)
+{
+	UINT32 w, i;
+
+	memset(state, 0, sizeof(*state));
+	state->chd = chd;
+	state->md5 = md5;
+	state->sha = sha;
+	state->nextwrite = hunknum;
+	state->fill = &state->window[0];
+	for (w = 0; w < 2; w++)
+	{
+		state->window[w].state = state;
+		for (i = 0; i < COMPRESS_WINDOW_HUNKS; i++)
+			state->window[w].job[i].window = &state->window[w];
+	}
+
+	/* by default read, hash and write one hunk at a time in the hunk buffer */
+	state->capacity = 1;
+	state->window[0].job[0].data = chd->cache;
+
+	/* the pipeline needs a way to run the tasks, and a lock */
+	state->groupif = cur_interface;
+	if (!state->groupif.group_alloc || !state->groupif.lock_alloc)
+		return;
+
+	for (w = 0; w < 2; w++)
+	{
+		for (i = 0; i < COMPRESS_WINDOW_HUNKS; i++)
+		{
+			compress_job *job = &state->window[w].job[i];
+
+			job->data = malloc(chd->header.hunkbytes);
+			job->compressed = malloc(chd->header.hunkbytes);
+			if (!job->data || !job->compressed)
+				goto fallback;
+		}
+
+		/* no group is returned if the tasks can't run in parallel */
+		state->window[w].group = (*state->groupif.group_alloc)();
+		if (!state->window[w].group)
+			goto fallback;
+	}
+
+	state->lock = (*state->groupif.lock_alloc)();
+	if (!state->lock)
+		goto fallback;
+
+	state->length = multi_length(chd->file);
+	state->capacity = COMPRESS_WINDOW_HUNKS;
+	return;
+
+fallback:
+	/* go on serially */
+	compress_free(state);
+	state->window[0].job[0].data = chd->cache;
+}
+
+
+static void compress_free(compress_state *state)
+{
+	UINT32 w, i;
+
+	/* punt if never initialized */
+	if (!state->chd)
+		return;
+
+	for (w = 0; w < 2; w++)
+		if (state->window[w].group)
+		{
+			(*state->groupif.group_wait)(state->window[w].group);
+			(*state->groupif.group_free)(state->window[w].group);
+			state->window[w].group = NULL;
+		}
+
+	for (w = 0; w < 2; w++)
+		for (i = 0; i < COMPRESS_WINDOW_HUNKS; i++)
+		{
+			compress_job *job = &state->window[w].job[i];
+
+			if (job->data && job->data != state->chd->cache)
+				free(job->data);
+			if (job->compressed)
+				free(job->compressed);
+			job->data = NULL;
+			job->compressed = NULL;
+		}
+
+	while (state->codeccount)
+		free_stream(state->codec[--state->codeccount]);
+
+	if (state->lock)
+	{
+		(*state->groupif.lock_free)(state->lock);
+		state->lock = NULL;
+	}
+
+	state->capacity = 1;
+	state->fill = &state->window[0];
+	state->window[0].count = 0;
+	state->window[1].count = 0;
+}
+
+
+static UINT8 *compress_buffer(compress_state *state)
+{
+	return state->fill->job[state->fill->count].data;
+}
+
+
+static UINT64 compress_length(compress_state *state)
+{
+	UINT64 length;
+
+	/* the tasks write the file, so ask them */
+	if (!state->lock)
+		return multi_length(state->chd->file);
+
+	(*state->groupif.lock_acquire)(state->lock);
+	length = state->length;
+	(*state->groupif.lock_release)(state->lock);
+	return length;
+}
+
+
+static int compress_dispatch(compress_state *state)
+{
+	compress_window *window = state->fill;
+	compress_window *other = (window == &state->window[0]) ? &state->window[1] : &state->window[0];
+	int err;
+
+	/* the other window is hashed and written before this one, then its buffers are free */
+	(*state->groupif.group_wait)(other->group);
+	(*state->groupif.lock_acquire)(state->lock);
+	err = state->err;
+	other->count = 0;
+	(*state->groupif.lock_release)(state->lock);
+	if (err != CHDERR_NONE)
+		return err;
+
+	/* hash this window, and write the hunks compressed before the other window was written */
+	(*state->groupif.group_run)(window->group, compress_md5_task, window);
+	(*state->groupif.group_run)(window->group, compress_sha1_task, window);
+	(*state->groupif.group_run)(window->group, compress_write_task, window);
+
+	/* read the next hunks in the other window */
+	state->fill = other;
+	return CHDERR_NONE;
+}
+
+
+static int compress_push(compress_state *state, UINT32 hunknum, UINT32 checksumbytes)
+{
+	compress_window *window = state->fill;
+	compress_job *job = &window->job[window->count];
+
+	/* without the pipeline, hash and write the hunk at once */
+	if (!state->lock)
+	{
+		chd_file *chd = state->chd;
+		int err;
+
+		if (checksumbytes)
+		{
+			MD5Update(state->md5, job->data, checksumbytes);
+			sha1_update(state->sha, checksumbytes, job->data);
+		}
+
+		err = write_hunk_from_memory(chd, hunknum, job->data, NULL);
+		if (err != CHDERR_NONE)
+			return err;
+
+		/* update our CRC map */
+		if ((chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
+			(chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
+			add_to_crcmap(chd, hunknum);
+		return CHDERR_NONE;
+	}
+
+	job->hunknum = hunknum;
+	job->checksumbytes = checksumbytes;
+	job->done = 0;
+
+	/* the tasks look only at the hunks already counted */
+	(*state->groupif.lock_acquire)(state->lock);
+	if (window->count == 0)
+		window->hunknum = hunknum;
+	window->count++;
+	(*state->groupif.lock_release)(state->lock);
+
+	(*state->groupif.group_run)(window->group, compress_task, job);
+
+	/* switch the windows when full */
+	if (window->count < state->capacity)
+		return CHDERR_NONE;
+	return compress_dispatch(state);
+}
+
+
+static int compress_flush(compress_state *state)
+{
+	int err = CHDERR_NONE;
+
+	if (!state->lock)
+		return CHDERR_NONE;
+
+	if (state->fill->count)
+		err = compress_dispatch(state);
+
+	/* wait the last hunks */
+	(*state->groupif.group_wait)(state->window[0].group);
+	(*state->groupif.group_wait)(state->window[1].group);
+	if (err == CHDERR_NONE)
+		err = state->err;
+	return err;
+}
+
+
+
 /*************************************
  *
  *  Header read
@@ -1983,11 +2961,14 @@ int chd_compress_ex(chd_exfile *chdex, const char *rawfile, UINT64 offset,
 {
 	chd_interface_file *sourcefile = NULL;
 	chd_file *chd;
+	compress_state state;
 	clock_t lastupdate;
 	int err;
 	UINT64 sourcefileoffset = 0;
 	int hunk, blksread = 0;
 
+	state.chd = NULL;
+
 	/* punt if no interface */
 	if (!cur_interface.open)
 		SET_ERROR_AND_CLEANUP(CHDERR_NO_INTERFACE);
@@ -2003,6 +2984,9 @@ int chd_compress_ex(chd_exfile *chdex, const char *rawfile, UINT64 offset,
 	if (!sourcefile)
 		SET_ERROR_AND_CLEANUP(CHDERR_FILE_NOT_FOUND);
 
+	/* the hunks are compressed, hashed and written by the tasks while the next are read */
+	compress_init(&state, chd, chdex->hunknum, &chdex->md5, &chdex->sha);
+
 	/* loop over source hunks until we run out */
 	lastupdate = 0;
 	for (hunk = 0; hunk < hunks_to_read; hunk++)
@@ -2010,15 +2994,16 @@ int chd_compress_ex(chd_exfile *chdex, const char *rawfile, UINT64 offset,
 		clock_t curtime = clock();
 		UINT32 bytestochecksum;
 		UINT32 bytesread;
+		UINT8 *data = compress_buffer(&state);
 		int i;
 
 		/* read the data.  first, zero the whole hunk */
-		memset(chd->cache, 0, chd->header.hunkbytes);
+		memset(data, 0, chd->header.hunkbytes);
 
 		/* read each frame to a maximum framesize boundry, automatically padding them out */
 		for (i = 0; i < srcperhunk; i++)
 		{
-			bytesread = multi_read(sourcefile, sourcefileoffset + offset, inpsecsize, &chd->cache[i*hunksecsize]);
+			bytesread = (*cur_interface.read)(sourcefile, sourcefileoffset + offset, inpsecsize, &data[i*hunksecsize]);
 			/*
                NOTE: because we pad CD tracks to a hunk boundry, there is a possibility
                that we will run off the end of the sourcefile and bytesread will be zero.
@@ -2035,7 +3020,7 @@ int chd_compress_ex(chd_exfile *chdex, const char *rawfile, UINT64 offset,
 		{
 			UINT64 sourcepos = (UINT64)hunk+chdex->hunknum * chd->header.hunkbytes;
 			if (progress && sourcepos)
-				(*progress)("Compressing hunk %d/%d... (ratio=%d%%)  \r", hunk+chdex->hunknum, chd->header.totalhunks, 100 - multi_length(chd->file) * 100 / sourcepos);
+				(*progress)("Compressing hunk %d/%d... (ratio=%d%%)  \r", hunk+chdex->hunknum, chd->header.totalhunks, 100 - compress_length(&state) * 100 / sourcepos);
 			lastupdate = curtime;
 		}
 
@@ -2048,31 +3033,28 @@ int chd_compress_ex(chd_exfile *chdex, const char *rawfile, UINT64 offset,
 			else
 				bytestochecksum = chd->header.logicalbytes - chdex->sourceoffset;
 		}
-		if (bytestochecksum)
-		{
-			MD5Update(&chdex->md5, chd->cache, bytestochecksum);
-			sha1_update(&chdex->sha, bytestochecksum, chd->cache);
-		}
 
-		/* write out the hunk */
-		err = write_hunk_from_memory(chd, hunk + chdex->hunknum, chd->cache);
+		/* hash and write out the hunk */
+		err = compress_push(&state, hunk + chdex->hunknum, bytestochecksum);
 		if (err != CHDERR_NONE)
 			SET_ERROR_AND_CLEANUP(err);
 
-		/* update our CRC map */
-		if ((chd->map[hunk + chdex->hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
-			(chd->map[hunk + chdex->hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
-			add_to_crcmap(chd, hunk + chdex->hunknum);
-
 		/* prepare for the next hunk */
 		chdex->sourceoffset += chd->header.hunkbytes;
 	}
 
+	/* write out the remaining hunks */
+	err = compress_flush(&state);
+	compress_free(&state);
+	if (err != CHDERR_NONE)
+		SET_ERROR_AND_CLEANUP(err);
+
 	chdex->hunknum += hunks_to_read;
 
 	return CHDERR_NONE;
 
 cleanup:
+	compress_free(&state);
 	if (sourcefile)
 		multi_close(sourcefile);
 	return last_error;
@@ -2288,6 +3270,67 @@ static void free_codec(chd_file *chd)
 
 
 
+/*************************************
+ *
+ *  Private codec streams
+ *
+ *************************************/
+
+static void *init_stream(int compress)
+{
+	zlib_codec_data *data;
+	int err;
+
+	data = malloc(sizeof(zlib_codec_data));
+	if (!data)
+		return NULL;
+	memset(data, 0, sizeof(zlib_codec_data));
+
+	/* init only the stream needed, with the same settings of init_codec() */
+	if (compress)
+	{
+		data->deflater.zalloc = fast_alloc;
+		data->deflater.zfree = fast_free;
+		data->deflater.opaque = data;
+		err = deflateInit2(&data->deflater, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+	}
+	else
+	{
+		data->inflater.zalloc = fast_alloc;
+		data->inflater.zfree = fast_free;
+		data->inflater.opaque = data;
+		err = inflateInit2(&data->inflater, -MAX_WBITS);
+	}
+	if (err != Z_OK)
+	{
+		free_stream(data);
+		return NULL;
+	}
+	return data;
+}
+
+
+static void free_stream(void *codecdata)
+{
+	zlib_codec_data *data = codecdata;
+	int i;
+
+	if (!data)
+		return;
+
+	/* ending the stream never initialized is harmless */
+	inflateEnd(&data->inflater);
+	deflateEnd(&data->deflater);
+
+	/* free our fast memory */
+	for (i = 0; i < MAX_ZLIB_ALLOCS; i++)
+		if (data->allocptr[i])
+			free(data->allocptr[i]);
+	free(data);
+}
+
+
+
 /*************************************
  *
  *  Multifile routines
@@ -2306,12 +3349,27 @@ static void multi_close(chd_interface_file *file)
 
 static UINT32 multi_read(chd_interface_file *file, UINT64 offset, UINT32 count, void *buffer)
 {
-	return (*cur_interface.read)(file, offset, count, buffer);
+	UINT32 result;
+
+	/* the read-ahead tasks access the files at the same time */
+	if (file_lock)
+		(*file_lock_interface.lock_acquire)(file_lock);
+	result = (*cur_interface.read)(file, offset, count, buffer);
+	if (file_lock)
+		(*file_lock_interface.lock_release)(file_lock);
+	return result;
 }
 
 static UINT32 multi_write(chd_interface_file *file, UINT64 offset, UINT32 count, const void *buffer)
 {
-	return (*cur_interface.write)(file, offset, count, buffer);
+	UINT32 result;
+
+	if (file_lock)
+		(*file_lock_interface.lock_acquire)(file_lock);
+	result = (*cur_interface.write)(file, offset, count, buffer);
+	if (file_lock)
+		(*file_lock_interface.lock_release)(file_lock);
+	return result;
 }
 
 static UINT64 multi_length(chd_interface_file *file)
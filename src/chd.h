@@ -103,6 +103,9 @@
 #define CHDMETATAG_WILDCARD			0
 #define CHD_METAINDEX_APPEND		((UINT32)-1)
 
+#define CHD_CACHE_HUNKS_DEFAULT		64			/* default number of cached hunks */
+#define CHD_CACHE_READAHEAD_DEFAULT	8			/* default number of hunks read ahead */
+
 #define HARD_DISK_STANDARD_METADATA	0x47444444
 #define HARD_DISK_METADATA_FORMAT	"CYLS:%d,HEADS:%d,SECS:%d,BPS:%d"
 
@@ -176,6 +179,20 @@ struct _chd_interface
 	UINT32 (*read)(chd_interface_file *file, UINT64 offset, UINT32 count, void *buffer);
 	UINT32 (*write)(chd_interface_file *file, UINT64 offset, UINT32 count, const void *buffer);
 	UINT64 (*length)(chd_interface_file *file);
+
+	/* optional task group used to decompress the read-ahead hunks and to */
+	/* compress the hunks in parallel; if NULL, all is done serially */
+	void *(*group_alloc)(void);
+	void (*group_free)(void *group);
+	void (*group_run)(void *group, void (*task)(void *param), void *param);
+	void (*group_wait)(void *group);
+
+	/* optional locks used by the read-ahead and the compression tasks, which */
+	/* also access the files; if NULL, all is done serially */
+	void *(*lock_alloc)(void);
+	void (*lock_free)(void *lock);
+	void (*lock_acquire)(void *lock);
+	void (*lock_release)(void *lock);
 };
 typedef struct _chd_interface chd_interface;
 
@@ -189,6 +206,7 @@ typedef struct _chd_interface chd_interface;
 
 void chd_set_interface(chd_interface *new_interface);
 void chd_save_interface(chd_interface *interface_save);
+void chd_set_cache_size(UINT32 hunks, UINT32 readahead);
 
 int chd_create(const char *filename, UINT64 logicalbytes, UINT32 hunkbytes, UINT32 compression, chd_file *parent);
 chd_file *chd_open(const char *filename, int writeable, chd_file *parent);
@@ -36,6 +36,14 @@ static void chdman_close(chd_interface_file *file);
 static UINT32 chdman_read(chd_interface_file *file, UINT64 offset, UINT32 count, void *buffer);
 static UINT32 chdman_write(chd_interface_file *file, UINT64 offset, UINT32 count, const void *buffer);
 static UINT64 chdman_length(chd_interface_file *file);
+static void *chdman_group_alloc(void);
+static void chdman_group_free(void *group);
+static void chdman_group_run(void *group, void (*task)(void *param), void *param);
+static void chdman_group_wait(void *group);
+static void *chdman_lock_alloc(void);
+static void chdman_lock_free(void *lock);
+static void chdman_lock_acquire(void *lock);
+static void chdman_lock_release(void *lock);
 
 
 
@@ -49,7 +57,15 @@ static chd_interface chdman_interface =
 	chdman_close,
 	chdman_read,
 	chdman_write,
-	chdman_length
+	chdman_length,
+	chdman_group_alloc,
+	chdman_group_free,
+	chdman_group_run,
+	chdman_group_wait,
+	chdman_lock_alloc,
+	chdman_lock_free,
+	chdman_lock_acquire,
+	chdman_lock_release
 };
 
 static chd_file *special_chd;
@@ -1947,6 +1963,96 @@ static UINT64 chdman_length(chd_interface_file *file)
 
 
 
+/*-------------------------------------------------
+    chdman_group_alloc - interface for allocating
+    the task group used to compress and decompress
+    the hunks in parallel
+-------------------------------------------------*/
+
+static void *chdman_group_alloc(void)
+{
+	return osd_tool_group_alloc();
+}
+
+
+/*-------------------------------------------------
+    chdman_group_free - interface for freeing
+    a task group
+-------------------------------------------------*/
+
+static void chdman_group_free(void *group)
+{
+	osd_tool_group_free((osd_tool_group *) group);
+}
+
+
+/*-------------------------------------------------
+    chdman_group_run - interface for queueing a
+    task in a group
+-------------------------------------------------*/
+
+static void chdman_group_run(void *group, void (*task)(void *param), void *param)
+{
+	osd_tool_group_run((osd_tool_group *) group, task, param);
+}
+
+
+/*-------------------------------------------------
+    chdman_group_wait - interface for waiting
+    all the tasks of a group
+-------------------------------------------------*/
+
+static void chdman_group_wait(void *group)
+{
+	osd_tool_group_wait((osd_tool_group *) group);
+}
+
+
+/*-------------------------------------------------
+    chdman_lock_alloc - interface for allocating
+    a lock used by the read-ahead tasks
+-------------------------------------------------*/
+
+static void *chdman_lock_alloc(void)
+{
+	return osd_tool_lock_alloc();
+}
+
+
+/*-------------------------------------------------
+    chdman_lock_free - interface for freeing
+    a lock
+-------------------------------------------------*/
+
+static void chdman_lock_free(void *lock)
+{
+	osd_tool_lock_free((osd_tool_lock *) lock);
+}
+
+
+/*-------------------------------------------------
+    chdman_lock_acquire - interface for
+    acquiring a lock
+-------------------------------------------------*/
+
+static void chdman_lock_acquire(void *lock)
+{
+	osd_tool_lock_acquire((osd_tool_lock *) lock);
+}
+
+
+/*-------------------------------------------------
+    chdman_lock_release - interface for
+    releasing a lock
+-------------------------------------------------*/
+
+static void chdman_lock_release(void *lock)
+{
+	osd_tool_lock_release((osd_tool_lock *) lock);
+}
+
+
+
 /*-------------------------------------------------
     main - entry point
 -------------------------------------------------*/
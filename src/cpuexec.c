@@ -103,6 +103,8 @@ struct _cpuexec_data
 
 	void *	timedint_timer;			/* reference to this CPU's timer */
 	mame_time timedint_period; 		/* timing period of the timed interrupt */
+
+	int		profiler_scope;			/* profiler scope of the execution */
 };
 
 
@@ -207,6 +209,7 @@ int cpuexec_init(void)
 	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
 	{
 		int cputype = Machine->drv->cpu[cpunum].cpu_type;
+		char scope[32];
 		int num_regs;
 
 		/* if this is a dummy, stop looking */
@@ -220,6 +223,10 @@ int cpuexec_init(void)
 		cpu[cpunum].clockscale = 1.0;
 		cpu[cpunum].localtime = time_zero;
 
+		/* the profiler reports the CPUs with their names */
+		sprintf(scope, "cpu%d:%s", cpunum + 1, cputype_name(cputype));
+		cpu[cpunum].profiler_scope = profiler_scope_register(scope, PROFILER_CPU1 + cpunum);
+
 		/* compute the cycle times */
 		sec_to_cycles[cpunum] = cpu[cpunum].clockscale * cpu[cpunum].clock;
 		cycles_to_sec[cpunum] = 1.0 / sec_to_cycles[cpunum];
@@ -499,7 +506,7 @@ void cpuexec_timeslice(void)
 			/* run for the requested number of cycles */
 			if (cycles_running > 0)
 			{
-				profiler_mark(PROFILER_CPU1 + cpunum);
+				profiler_scope_begin(cpu[cpunum].profiler_scope);
 				cycles_stolen = 0;
 				ran = cpunum_execute(cpunum, cycles_running);
 
@@ -509,7 +516,7 @@ void cpuexec_timeslice(void)
 #endif /* MAME_DEBUG */
 
 				ran -= cycles_stolen;
-				profiler_mark(PROFILER_END);
+				profiler_scope_end();
 
 				/* account for these cycles */
 				cpu[cpunum].totalcycles += ran;
@@ -88,6 +88,21 @@ INLINE int readbit(const UINT8 *src, int bitnum)
 }
 
 
+/*-------------------------------------------------
+    gfx_row_usage - return the pen usage of the
+    lines of a character, or NULL if not available
+-------------------------------------------------*/
+
+INLINE const UINT16 *gfx_row_usage(const gfx_element *gfx, unsigned int code)
+{
+	/* the drivers may draw with a modified copy of the element */
+	if (!gfx->pen_usage || !gfx->row_usage || gfx->row_gfxdata != gfx->gfxdata || gfx->row_height != gfx->height)
+		return NULL;
+
+	return gfx->row_usage + code * gfx->height;
+}
+
+
 
 /***************************************************************************
 
@@ -129,6 +144,7 @@ void drawgfx_init(void)
 static void calc_penusage(gfx_element *gfx, int num)
 {
 	const UINT8 *dp = gfx->gfxdata + num * gfx->char_modulo;
+	UINT16 *rp = gfx->row_usage ? gfx->row_usage + num * gfx->height : NULL;
 	UINT32 usage = 0;
 	int x, y;
 
@@ -141,9 +157,14 @@ static void calc_penusage(gfx_element *gfx, int num)
 	{
 		for (y = 0; y < gfx->height; y++)
 		{
+			UINT32 row = 0;
+
 			for (x = 0; x < gfx->width/2; x++)
-				usage |= (1 << (dp[x] & 0x0f)) | (1 << (dp[x] >> 4));
+				row |= (1 << (dp[x] & 0x0f)) | (1 << (dp[x] >> 4));
 
+			if (rp)
+				rp[y] = row;
+			usage |= row;
 			dp += gfx->line_modulo;
 		}
 	}
@@ -153,15 +174,29 @@ static void calc_penusage(gfx_element *gfx, int num)
 	{
 		for (y = 0; y < gfx->height; y++)
 		{
+			UINT32 row = 0;
+
 			for (x = 0; x < gfx->width; x++)
-				usage |= 1 << dp[x];
+				row |= 1 << dp[x];
 
+			if (rp)
+				rp[y] = row;
+			usage |= row;
 			dp += gfx->line_modulo;
 		}
 	}
 
 	/* store the final result */
 	gfx->pen_usage[num] = usage;
+	gfx->row_gfxdata = gfx->gfxdata;
+	gfx->row_height = gfx->height;
+
+	/* the pen usage of the lines doesn't fit in 16 bits, drop it */
+	if (gfx->row_usage && (usage & ~0xffff))
+	{
+		free(gfx->row_usage);
+		gfx->row_usage = NULL;
+	}
 }
 
 
@@ -270,8 +305,14 @@ gfx_element *allocgfx(const gfx_layout *gl)
 	gfx->total_elements = gl->total;
 	gfx->color_granularity = 1 << gl->planes;
 	if (gfx->color_granularity <= 32)
+	{
 		gfx->pen_usage = malloc(gfx->total_elements * sizeof(*gfx->pen_usage));
 
+		/* the pen usage of the lines fits in 16 bits only up to 4 bitplanes */
+		if (gfx->pen_usage && gfx->color_granularity <= 16)
+			gfx->row_usage = malloc(gfx->total_elements * gfx->height * sizeof(*gfx->row_usage));
+	}
+
 	/* raw graphics case */
 	if (gl->planeoffset[0] == GFX_RAW)
 	{
@@ -335,6 +376,20 @@ void decodegfx(gfx_element *gfx, const UINT8 *src, UINT32 first, UINT32 count)
 }
 
 
+/*-------------------------------------------------
+    updategfxusage - recompute the pen usage after
+    the gfxdata of a gfx_element is modified in place
+-------------------------------------------------*/
+
+void updategfxusage(gfx_element *gfx)
+{
+	int c;
+
+	for (c = 0; c < gfx->total_elements; c++)
+		calc_penusage(gfx, c);
+}
+
+
 /*-------------------------------------------------
     freegfx - free a gfx_element
 -------------------------------------------------*/
@@ -352,6 +407,8 @@ void freegfx(gfx_element *gfx)
 		free((void *)gfx->layout.extxoffs);
 	if (gfx->pen_usage)
 		free(gfx->pen_usage);
+	if (gfx->row_usage)
+		free(gfx->row_usage);
 	if (!(gfx->flags & GFX_DONT_FREE_GFXDATA))
 		free(gfx->gfxdata);
 	free(gfx);
@@ -613,6 +670,403 @@ INLINE void blockmove_NtoN_transpen_noremap_flipx32(
 static int afterdrawmask = 31;
 int pdrawgfx_shadow_lowpri = 0;
 
+//* AAT032503: added limited 32-bit shadow and highlight support
+INLINE UINT32 SHADOW32(UINT32 c) {
+	c = (c>>9&0x7c00) | (c>>6&0x03e0) | (c>>3&0x001f);
+	return(((UINT32*)palette_shadow_table)[c]); }
+
+#ifdef USE_BLIT_SSE2
+
+/*
+    SSE2 versions of the blockmove of the unpacked characters, opaque and
+    with a transparent pen, for the 16 and 32 bit bitmaps with and without
+    the priority bitmap. The pixels are processed 8 at time. The lookups in
+    the palette are still done one pixel at time, as SSE2 has no gather
+    instruction, and the groups of pixels using the shadow table are drawn
+    with the C code.
+*/
+
+#include <emmintrin.h>
+
+/* reverse the order of the 8 words of a vector */
+INLINE __m128i reverse16_sse2(__m128i v)
+{
+	v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0,1,2,3));
+	v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0,1,2,3));
+	return _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,3,2));
+}
+
+/* select the words of a vector with the specified bit set */
+INLINE __m128i bitsel16_sse2(__m128i v, int bit)
+{
+	__m128i b = _mm_set1_epi16(bit);
+	return _mm_cmpeq_epi16(_mm_and_si128(v, b), b);
+}
+
+/* mask of the 8 pixels with ((1 << (pri & 0x1f)) & pmask) == 0 */
+INLINE __m128i pri_pass_sse2(__m128i p, __m128i pmask_lo, __m128i pmask_hi)
+{
+	__m128i one = _mm_set1_epi16(1);
+	__m128i sel = bitsel16_sse2(p, 0x10);
+	__m128i half = _mm_or_si128(_mm_and_si128(sel, pmask_hi), _mm_andnot_si128(sel, pmask_lo));
+	__m128i bit;
+
+	/* 1 << (pri & 0xf) as product of the powers of the single bits */
+	bit = _mm_add_epi16(one, _mm_and_si128(bitsel16_sse2(p, 1), one));
+	bit = _mm_mullo_epi16(bit, _mm_add_epi16(one, _mm_and_si128(bitsel16_sse2(p, 2), _mm_set1_epi16(3))));
+	bit = _mm_mullo_epi16(bit, _mm_add_epi16(one, _mm_and_si128(bitsel16_sse2(p, 4), _mm_set1_epi16(15))));
+	bit = _mm_mullo_epi16(bit, _mm_add_epi16(one, _mm_and_si128(bitsel16_sse2(p, 8), _mm_set1_epi16(255))));
+
+	return _mm_cmpeq_epi16(_mm_and_si128(half, bit), _mm_setzero_si128());
+}
+
+/* the same of SETPIXELCOLOR() of the 16 bit versions */
+INLINE void pixel16_sse2(UINT16 *dst, UINT8 *pri, UINT32 pmask, unsigned int n)
+{
+	if (pri)
+	{
+		if (((1 << (*pri & 0x1f)) & pmask) == 0)
+		{
+			if (*pri & 0x80)
+				*dst = palette_shadow_table[n];
+			else
+				*dst = n;
+		}
+		*pri = (*pri & 0x7f) | afterdrawmask;
+	}
+	else
+		*dst = n;
+}
+
+/* the same of SETPIXELCOLOR() of the 32 bit versions */
+INLINE void pixel32_sse2(UINT32 *dst, UINT8 *pri, UINT32 pmask, UINT32 n)
+{
+	if (pri)
+	{
+		UINT8 r8 = *pri;
+		if (!(1<<(r8&0x1f)&pmask))
+		{
+			if (afterdrawmask)
+			{
+				*dst = n;
+				*pri = (r8 & 0x7f) | 0x1f;
+			}
+			else if (!(r8&0x80))
+			{
+				*dst = SHADOW32(n);
+				*pri |= 0x80;
+			}
+		}
+	}
+	else
+		*dst = n;
+}
+
+#define COLOR_SSE2(col) (paldata ? paldata[col] : colorbase + (col))
+
+/*
+  Draw a line. The source pixel i goes in the destination pixel i, or
+  width-1-i if flipped. The paldata and pri arguments are constant at
+  each call, so the unused paths are removed by the compiler.
+*/
+INLINE void row16_sse2(const UINT8 *src, UINT16 *dst, UINT8 *pri, int width, int flipx,
+		const pen_t *paldata, unsigned int colorbase, int transpen, UINT32 pmask)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i vtrans = _mm_set1_epi16(transpen);
+	__m128i vbase = _mm_set1_epi16(colorbase);
+	__m128i plo = _mm_set1_epi16(pmask & 0xffff);
+	__m128i phi = _mm_set1_epi16(pmask >> 16);
+	__m128i v7f = _mm_set1_epi16(0x7f);
+	__m128i vafter = _mm_set1_epi16(afterdrawmask);
+	int i, j;
+
+	for (i = 0; i + 8 <= width; i += 8)
+	{
+		int x = flipx ? width - 8 - i : i;
+		__m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + i)), zero);
+		__m128i t, c, d;
+
+		if (flipx)
+			s = reverse16_sse2(s);
+		t = _mm_cmpeq_epi16(s, vtrans);
+		if (_mm_movemask_epi8(t) == 0xffff)
+			continue;
+
+		if (paldata)
+		{
+			if (flipx)
+				c = _mm_setr_epi16(paldata[src[i+7]], paldata[src[i+6]], paldata[src[i+5]], paldata[src[i+4]],
+					paldata[src[i+3]], paldata[src[i+2]], paldata[src[i+1]], paldata[src[i]]);
+			else
+				c = _mm_setr_epi16(paldata[src[i]], paldata[src[i+1]], paldata[src[i+2]], paldata[src[i+3]],
+					paldata[src[i+4]], paldata[src[i+5]], paldata[src[i+6]], paldata[src[i+7]]);
+		}
+		else
+			c = _mm_add_epi16(s, vbase);
+
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		if (pri)
+		{
+			__m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(pri + x)), zero);
+			__m128i w = _mm_andnot_si128(t, pri_pass_sse2(p, plo, phi));
+
+			if (_mm_movemask_epi8(_mm_and_si128(w, bitsel16_sse2(p, 0x80))) != 0)
+			{
+				/* shadow, use the C version */
+				for (j = 0; j < 8; ++j)
+				{
+					int col = src[flipx ? i + 7 - j : i + j];
+					if (col != transpen)
+						pixel16_sse2(dst + x + j, pri + x + j, pmask, COLOR_SSE2(col));
+				}
+				continue;
+			}
+
+			d = _mm_or_si128(_mm_and_si128(w, c), _mm_andnot_si128(w, d));
+			p = _mm_or_si128(_mm_andnot_si128(t, _mm_or_si128(_mm_and_si128(p, v7f), vafter)), _mm_and_si128(t, p));
+			_mm_storel_epi64((__m128i *)(pri + x), _mm_packus_epi16(p, p));
+		}
+		else
+		{
+			d = _mm_or_si128(_mm_and_si128(t, d), _mm_andnot_si128(t, c));
+		}
+		_mm_storeu_si128((__m128i *)(dst + x), d);
+	}
+
+	for (; i < width; ++i)
+	{
+		int col = src[i];
+		if (col != transpen)
+		{
+			int x = flipx ? width - 1 - i : i;
+			pixel16_sse2(dst + x, pri ? pri + x : NULL, pmask, COLOR_SSE2(col));
+		}
+	}
+}
+
+INLINE void row32_sse2(const UINT8 *src, UINT32 *dst, UINT8 *pri, int width, int flipx,
+		const pen_t *paldata, unsigned int colorbase, int transpen, UINT32 pmask)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i vtrans = _mm_set1_epi16(transpen);
+	__m128i vbase = _mm_set1_epi32(colorbase);
+	__m128i plo = _mm_set1_epi16(pmask & 0xffff);
+	__m128i phi = _mm_set1_epi16(pmask >> 16);
+	__m128i v7f = _mm_set1_epi16(0x7f);
+	__m128i v1f = _mm_set1_epi16(0x1f);
+	int i;
+
+	/* the shadow drawing is left to the C version */
+	i = 0;
+	if (!pri || afterdrawmask) for (; i + 8 <= width; i += 8)
+	{
+		int x = flipx ? width - 8 - i : i;
+		__m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + i)), zero);
+		__m128i t, t0, t1, c0, c1, d0, d1;
+
+		if (flipx)
+			s = reverse16_sse2(s);
+		t = _mm_cmpeq_epi16(s, vtrans);
+		if (_mm_movemask_epi8(t) == 0xffff)
+			continue;
+
+		if (!paldata)
+		{
+			c0 = _mm_add_epi32(_mm_unpacklo_epi16(s, zero), vbase);
+			c1 = _mm_add_epi32(_mm_unpackhi_epi16(s, zero), vbase);
+		}
+		else if (flipx)
+		{
+			c0 = _mm_setr_epi32(paldata[src[i+7]], paldata[src[i+6]], paldata[src[i+5]], paldata[src[i+4]]);
+			c1 = _mm_setr_epi32(paldata[src[i+3]], paldata[src[i+2]], paldata[src[i+1]], paldata[src[i]]);
+		}
+		else
+		{
+			c0 = _mm_setr_epi32(paldata[src[i]], paldata[src[i+1]], paldata[src[i+2]], paldata[src[i+3]]);
+			c1 = _mm_setr_epi32(paldata[src[i+4]], paldata[src[i+5]], paldata[src[i+6]], paldata[src[i+7]]);
+		}
+
+		if (pri)
+		{
+			__m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(pri + x)), zero);
+			__m128i w = _mm_andnot_si128(t, pri_pass_sse2(p, plo, phi));
+
+			p = _mm_or_si128(_mm_and_si128(w, _mm_or_si128(_mm_and_si128(p, v7f), v1f)), _mm_andnot_si128(w, p));
+			_mm_storel_epi64((__m128i *)(pri + x), _mm_packus_epi16(p, p));
+
+			/* draw only the pixels selected by the priority */
+			t = _mm_cmpeq_epi16(w, zero);
+		}
+
+		t0 = _mm_unpacklo_epi16(t, t);
+		t1 = _mm_unpackhi_epi16(t, t);
+		d0 = _mm_loadu_si128((const __m128i *)(dst + x));
+		d1 = _mm_loadu_si128((const __m128i *)(dst + x + 4));
+		d0 = _mm_or_si128(_mm_and_si128(t0, d0), _mm_andnot_si128(t0, c0));
+		d1 = _mm_or_si128(_mm_and_si128(t1, d1), _mm_andnot_si128(t1, c1));
+		_mm_storeu_si128((__m128i *)(dst + x), d0);
+		_mm_storeu_si128((__m128i *)(dst + x + 4), d1);
+	}
+
+	for (; i < width; ++i)
+	{
+		int col = src[i];
+		if (col != transpen)
+		{
+			int x = flipx ? width - 1 - i : i;
+			pixel32_sse2(dst + x, pri ? pri + x : NULL, pmask, COLOR_SSE2(col));
+		}
+	}
+}
+
+#undef COLOR_SSE2
+
+/* the same of ADJUST_8 of the C versions, and the loop on the lines */
+#define BLOCKMOVE_SSE2(row)														\
+	int ydir;																	\
+	if (flipy)																	\
+	{																			\
+		dstdata += dstmodulo * (dstheight-1);									\
+		if (pridata)															\
+			pridata += dstmodulo * (dstheight-1);								\
+		srcdata += (srcheight - dstheight - topskip) * srcmodulo;				\
+		ydir = -1;																\
+	}																			\
+	else																		\
+	{																			\
+		srcdata += topskip * srcmodulo;											\
+		ydir = 1;																\
+	}																			\
+	if (flipx)																	\
+		srcdata += srcwidth - dstwidth - leftskip;								\
+	else																		\
+		srcdata += leftskip;													\
+	while (dstheight)															\
+	{																			\
+		row(srcdata, dstdata, pridata, dstwidth, flipx, paldata, colorbase, transpen, pmask); \
+		srcdata += srcmodulo;													\
+		dstdata += ydir * dstmodulo;											\
+		if (pridata)															\
+			pridata += ydir * dstmodulo;										\
+		dstheight--;															\
+	}
+
+INLINE void blockmove16_sse2(const UINT8 *srcdata,int srcwidth,int srcheight,int srcmodulo,
+		int leftskip,int topskip,int flipx,int flipy,
+		UINT16 *dstdata,int dstwidth,int dstheight,int dstmodulo,
+		const pen_t *paldata,unsigned int colorbase,UINT8 *pridata,UINT32 pmask,int transpen)
+{
+	BLOCKMOVE_SSE2(row16_sse2)
+}
+
+INLINE void blockmove32_sse2(const UINT8 *srcdata,int srcwidth,int srcheight,int srcmodulo,
+		int leftskip,int topskip,int flipx,int flipy,
+		UINT32 *dstdata,int dstwidth,int dstheight,int dstmodulo,
+		const pen_t *paldata,unsigned int colorbase,UINT8 *pridata,UINT32 pmask,int transpen)
+{
+	BLOCKMOVE_SSE2(row32_sse2)
+}
+
+#undef BLOCKMOVE_SSE2
+
+#define COMMON_ARGS_SSE2(type)											\
+		const UINT8 *sd,int sw,int sh,int sm,int ls,int ts,int fx,int fy,	\
+		type *dd,int dw,int dh,int dm
+
+#define COMMON_SSE2 sd,sw,sh,sm,ls,ts,fx,fy,dd,dw,dh,dm
+
+/* the C versions, used for the transparent pens out of range */
+void blockmove_8toN_transpen_pri16(COMMON_ARGS_SSE2(UINT16),const pen_t *paldata,UINT8 *pridata,UINT32 pmask,int transpen);
+void blockmove_8toN_transpen_raw16(COMMON_ARGS_SSE2(UINT16),unsigned int colorbase,int transpen);
+void blockmove_8toN_transpen_raw_pri16(COMMON_ARGS_SSE2(UINT16),unsigned int colorbase,UINT8 *pridata,UINT32 pmask,int transpen);
+void blockmove_8toN_transpen_pri32(COMMON_ARGS_SSE2(UINT32),const pen_t *paldata,UINT8 *pridata,UINT32 pmask,int transpen);
+void blockmove_8toN_transpen_raw32(COMMON_ARGS_SSE2(UINT32),unsigned int colorbase,int transpen);
+void blockmove_8toN_transpen_raw_pri32(COMMON_ARGS_SSE2(UINT32),unsigned int colorbase,UINT8 *pridata,UINT32 pmask,int transpen);
+
+static void blockmove_8toN_opaque_pri16_sse2(COMMON_ARGS_SSE2(UINT16),const pen_t *paldata,UINT8 *pridata,UINT32 pmask)
+{
+	blockmove16_sse2(COMMON_SSE2,paldata,0,pridata,pmask,0x100);
+}
+
+static void blockmove_8toN_opaque_raw16_sse2(COMMON_ARGS_SSE2(UINT16),unsigned int colorbase)
+{
+	blockmove16_sse2(COMMON_SSE2,NULL,colorbase,NULL,0,0x100);
+}
+
+static void blockmove_8toN_opaque_raw_pri16_sse2(COMMON_ARGS_SSE2(UINT16),unsigned int colorbase,UINT8 *pridata,UINT32 pmask)
+{
+	blockmove16_sse2(COMMON_SSE2,NULL,colorbase,pridata,pmask,0x100);
+}
+
+static void blockmove_8toN_transpen_pri16_sse2(COMMON_ARGS_SSE2(UINT16),const pen_t *paldata,UINT8 *pridata,UINT32 pmask,int transpen)
+{
+	if ((unsigned)transpen > 0xff)
+		blockmove_8toN_transpen_pri16(COMMON_SSE2,paldata,pridata,pmask,transpen);
+	else
+		blockmove16_sse2(COMMON_SSE2,paldata,0,pridata,pmask,transpen);
+}
+
+static void blockmove_8toN_transpen_raw16_sse2(COMMON_ARGS_SSE2(UINT16),unsigned int colorbase,int transpen)
+{
+	if ((unsigned)transpen > 0xff)
+		blockmove_8toN_transpen_raw16(COMMON_SSE2,colorbase,transpen);
+	else
+		blockmove16_sse2(COMMON_SSE2,NULL,colorbase,NULL,0,transpen);
+}
+
+static void blockmove_8toN_transpen_raw_pri16_sse2(COMMON_ARGS_SSE2(UINT16),unsigned int colorbase,UINT8 *pridata,UINT32 pmask,int transpen)
+{
+	if ((unsigned)transpen > 0xff)
+		blockmove_8toN_transpen_raw_pri16(COMMON_SSE2,colorbase,pridata,pmask,transpen);
+	else
+		blockmove16_sse2(COMMON_SSE2,NULL,colorbase,pridata,pmask,transpen);
+}
+
+static void blockmove_8toN_opaque_pri32_sse2(COMMON_ARGS_SSE2(UINT32),const pen_t *paldata,UINT8 *pridata,UINT32 pmask)
+{
+	blockmove32_sse2(COMMON_SSE2,paldata,0,pridata,pmask,0x100);
+}
+
+static void blockmove_8toN_opaque_raw32_sse2(COMMON_ARGS_SSE2(UINT32),unsigned int colorbase)
+{
+	blockmove32_sse2(COMMON_SSE2,NULL,colorbase,NULL,0,0x100);
+}
+
+static void blockmove_8toN_opaque_raw_pri32_sse2(COMMON_ARGS_SSE2(UINT32),unsigned int colorbase,UINT8 *pridata,UINT32 pmask)
+{
+	blockmove32_sse2(COMMON_SSE2,NULL,colorbase,pridata,pmask,0x100);
+}
+
+static void blockmove_8toN_transpen_pri32_sse2(COMMON_ARGS_SSE2(UINT32),const pen_t *paldata,UINT8 *pridata,UINT32 pmask,int transpen)
+{
+	if ((unsigned)transpen > 0xff)
+		blockmove_8toN_transpen_pri32(COMMON_SSE2,paldata,pridata,pmask,transpen);
+	else
+		blockmove32_sse2(COMMON_SSE2,paldata,0,pridata,pmask,transpen);
+}
+
+static void blockmove_8toN_transpen_raw32_sse2(COMMON_ARGS_SSE2(UINT32),unsigned int colorbase,int transpen)
+{
+	if ((unsigned)transpen > 0xff)
+		blockmove_8toN_transpen_raw32(COMMON_SSE2,colorbase,transpen);
+	else
+		blockmove32_sse2(COMMON_SSE2,NULL,colorbase,NULL,0,transpen);
+}
+
+static void blockmove_8toN_transpen_raw_pri32_sse2(COMMON_ARGS_SSE2(UINT32),unsigned int colorbase,UINT8 *pridata,UINT32 pmask,int transpen)
+{
+	if ((unsigned)transpen > 0xff)
+		blockmove_8toN_transpen_raw_pri32(COMMON_SSE2,colorbase,pridata,pmask,transpen);
+	else
+		blockmove32_sse2(COMMON_SSE2,NULL,colorbase,pridata,pmask,transpen);
+}
+
+#undef COMMON_ARGS_SSE2
+#undef COMMON_SSE2
+
+#endif
+
 
 /* 8-bit version */
 #define DATA_TYPE UINT8
@@ -785,7 +1239,23 @@ int pdrawgfx_shadow_lowpri = 0;
 	blockmove_##function##_pri##16 args
 #define BLOCKMOVERAWPRI(function,args) \
 	blockmove_##function##_raw_pri##16 args
+#ifdef USE_BLIT_SSE2
+#define blockmove_8toN_opaque_pri16 blockmove_8toN_opaque_pri16_sse2
+#define blockmove_8toN_opaque_raw16 blockmove_8toN_opaque_raw16_sse2
+#define blockmove_8toN_opaque_raw_pri16 blockmove_8toN_opaque_raw_pri16_sse2
+#define blockmove_8toN_transpen_pri16 blockmove_8toN_transpen_pri16_sse2
+#define blockmove_8toN_transpen_raw16 blockmove_8toN_transpen_raw16_sse2
+#define blockmove_8toN_transpen_raw_pri16 blockmove_8toN_transpen_raw_pri16_sse2
+#endif
 #include "drawgfx.c"
+#ifdef USE_BLIT_SSE2
+#undef blockmove_8toN_opaque_pri16
+#undef blockmove_8toN_opaque_raw16
+#undef blockmove_8toN_opaque_raw_pri16
+#undef blockmove_8toN_transpen_pri16
+#undef blockmove_8toN_transpen_raw16
+#undef blockmove_8toN_transpen_raw_pri16
+#endif
 #undef DECLARE
 #undef DECLARE_SWAP_RAW_PRI
 #undef DECLAREG
@@ -801,11 +1271,6 @@ int pdrawgfx_shadow_lowpri = 0;
 #undef alpha_blend
 
 /* 32-bit version */
-//* AAT032503: added limited 32-bit shadow and highlight support
-INLINE UINT32 SHADOW32(UINT32 c) {
-	c = (c>>9&0x7c00) | (c>>6&0x03e0) | (c>>3&0x001f);
-	return(((UINT32*)palette_shadow_table)[c]); }
-
 #define DATA_TYPE UINT32
 #define DEPTH 32
 #define alpha_blend_r alpha_blend_r32
@@ -885,7 +1350,23 @@ INLINE UINT32 SHADOW32(UINT32 c) {
 	blockmove_##function##_pri##32 args
 #define BLOCKMOVERAWPRI(function,args) \
 	blockmove_##function##_raw_pri##32 args
+#ifdef USE_BLIT_SSE2
+#define blockmove_8toN_opaque_pri32 blockmove_8toN_opaque_pri32_sse2
+#define blockmove_8toN_opaque_raw32 blockmove_8toN_opaque_raw32_sse2
+#define blockmove_8toN_opaque_raw_pri32 blockmove_8toN_opaque_raw_pri32_sse2
+#define blockmove_8toN_transpen_pri32 blockmove_8toN_transpen_pri32_sse2
+#define blockmove_8toN_transpen_raw32 blockmove_8toN_transpen_raw32_sse2
+#define blockmove_8toN_transpen_raw_pri32 blockmove_8toN_transpen_raw_pri32_sse2
+#endif
 #include "drawgfx.c"
+#ifdef USE_BLIT_SSE2
+#undef blockmove_8toN_opaque_pri32
+#undef blockmove_8toN_opaque_raw32
+#undef blockmove_8toN_opaque_raw_pri32
+#undef blockmove_8toN_transpen_pri32
+#undef blockmove_8toN_transpen_raw32
+#undef blockmove_8toN_transpen_raw_pri32
+#endif
 #undef DECLARE
 #undef DECLARE_SWAP_RAW_PRI
 #undef DECLAREG
@@ -922,6 +1403,71 @@ INLINE UINT32 SHADOW32(UINT32 c) {
 
 ***************************************************************************/
 
+INLINE void drawgfx_depth(mame_bitmap *dest,const gfx_element *gfx,
+		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
+		const rectangle *clip,int transparency,int transparent_color,
+		mame_bitmap *pri_buffer,UINT32 pri_mask)
+{
+	if (dest->depth == 8)
+		drawgfx_core8(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
+	else if(dest->depth == 15 || dest->depth == 16)
+		drawgfx_core16(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
+	else
+		drawgfx_core32(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
+}
+
+/*
+  Draw a character using the pen usage of its lines. The totally
+  transparent lines at the top and at the bottom are skipped, and if all
+  the remaining lines are totally opaque, they are drawn without
+  transparency. Only the visible lines are examined.
+*/
+static void drawgfx_rows(mame_bitmap *dest,const gfx_element *gfx,
+		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
+		const rectangle *clip,int transparency,int transparent_color,
+		mame_bitmap *pri_buffer,UINT32 pri_mask,UINT32 transmask)
+{
+	const UINT16 *row_usage = gfx_row_usage(gfx, code);
+	int base = flipy ? sy + gfx->height-1 : sy;	/* destination line of the first line of the character */
+	int dir = flipy ? -1 : 1;
+	rectangle myclip;
+	int y, ey, opaque;
+
+	if (clip)
+		myclip = *clip;
+	else
+	{
+		myclip.min_x = 0;
+		myclip.max_x = dest->width-1;
+		myclip.min_y = 0;
+		myclip.max_y = dest->height-1;
+	}
+
+	y = sy;
+	if (y < 0) y = 0;
+	if (y < myclip.min_y) y = myclip.min_y;
+	ey = sy + gfx->height-1;
+	if (ey >= dest->height) ey = dest->height-1;
+	if (ey > myclip.max_y) ey = myclip.max_y;
+
+	while (y <= ey && (row_usage[dir * (y - base)] & ~transmask) == 0)
+		++y;
+	while (y <= ey && (row_usage[dir * (ey - base)] & ~transmask) == 0)
+		--ey;
+	if (y > ey)
+		return;
+
+	myclip.min_y = y;
+	myclip.max_y = ey;
+
+	opaque = 1;
+	for (; y <= ey && opaque; ++y)
+		if (row_usage[dir * (y - base)] & transmask)
+			opaque = 0;
+
+	drawgfx_depth(dest,gfx,code,color,flipx,flipy,sx,sy,&myclip,opaque ? TRANSPARENCY_NONE : transparency,transparent_color,pri_buffer,pri_mask);
+}
+
 INLINE void common_drawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
 		const rectangle *clip,int transparency,int transparent_color,
@@ -968,14 +1514,16 @@ INLINE void common_drawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		else if ((gfx->pen_usage[code] & transmask) == 0)
 			/* character is totally opaque, can disable transparency */
 			transparency = TRANSPARENCY_NONE;
+		else if (gfx_row_usage(gfx, code)
+			&& (transparency == TRANSPARENCY_PENS ? !(gfx->flags & GFX_PACKED) : (unsigned)transparent_color < 32))
+		{
+			/* character is partially transparent, check the single lines */
+			drawgfx_rows(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask,transmask);
+			return;
+		}
 	}
 
-	if (dest->depth == 8)
-		drawgfx_core8(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
-	else if(dest->depth == 15 || dest->depth == 16)
-		drawgfx_core16(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
-	else
-		drawgfx_core32(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
+	drawgfx_depth(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
 }
 
 void drawgfx(mame_bitmap *dest,const gfx_element *gfx,
@@ -1425,6 +1973,8 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 {
 	rectangle myclip;
 	int alphapen = 0;
+	const UINT16 *row_usage = NULL;
+	UINT32 transmask = 0;
 
 	UINT8 ah, al;
 
@@ -1465,6 +2015,17 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 	if (transparency == TRANSPARENCY_COLOR)
 		transparent_color = Machine->pens[transparent_color];
 
+	/* the pen usage of the lines is used to skip the transparent ones */
+	if (transparency == TRANSPARENCY_PEN && gfx && !(gfx->flags & GFX_PACKED) && (unsigned)transparent_color < 32)
+	{
+		row_usage = gfx_row_usage(gfx, code % gfx->total_elements);
+		transmask = 1 << transparent_color;
+
+		/* character is totally transparent, no need to draw */
+		if (row_usage && (gfx->pen_usage[code % gfx->total_elements] & ~transmask) == 0)
+			return;
+	}
+
 
 	/*
     scalex and scaley are 16.16 fixed point numbers
@@ -1663,6 +2224,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT8 *pri = pri_buffer->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = (source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f;
@@ -1687,6 +2253,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT8 *pri = pri_buffer->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = source[x_index>>16];
@@ -1713,6 +2284,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT8 *dest = dest_bmp->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = (source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f;
@@ -1731,6 +2307,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT8 *dest = dest_bmp->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = source[x_index>>16];
@@ -2256,6 +2837,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT8 *pri = pri_buffer->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = (source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f;
@@ -2280,6 +2866,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT8 *pri = pri_buffer->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = source[x_index>>16];
@@ -2306,6 +2897,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT16 *dest = (UINT16 *)dest_bmp->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = (source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f;
@@ -2324,6 +2920,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 									UINT16 *dest = (UINT16 *)dest_bmp->line[y];
 
 									int x, x_index = x_index_base;
+									if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+									{
+										y_index += dy;
+										continue;
+									}
 									for( x=sx; x<ex; x++ )
 									{
 										int c = source[x_index>>16];
@@ -2968,6 +3569,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 								UINT8 *pri = pri_buffer->line[y];
 
 								int x, x_index = x_index_base;
+								if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+								{
+									y_index += dy;
+									continue;
+								}
 								for( x=sx; x<ex; x++ )
 								{
 									int c = source[x_index>>16];
@@ -2991,6 +3597,11 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 								UINT32 *dest = (UINT32 *)dest_bmp->line[y];
 
 								int x, x_index = x_index_base;
+								if (row_usage && (row_usage[y_index>>16] & ~transmask) == 0)
+								{
+									y_index += dy;
+									continue;
+								}
 								for( x=sx; x<ex; x++ )
 								{
 									int c = source[x_index>>16];
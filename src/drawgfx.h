@@ -76,6 +76,13 @@ struct _gfx_element
 						/* (bit 0 = pen 0, and so on). This is used by */
 						/* drawgfgx() to do optimizations like skipping */
 						/* drawing of a totally transparent character */
+	UINT16 *row_usage;	/* an array of total_elements * height entries, only */
+						/* for the elements with up to 16 colors. */
+						/* It is the pen usage of each line of each character, */
+						/* used by drawgfx() to skip the transparent lines and */
+						/* to draw the opaque lines without transparency */
+	const UINT8 *row_gfxdata;	/* gfxdata and height used to compute row_usage, */
+	UINT16 row_height;			/* to detect the modified copies of the element */
 	UINT8 *gfxdata;		/* pixel data */
 	UINT32 line_modulo;	/* amount to add to get to the next line (usually = width) */
 	UINT32 char_modulo;	/* = line_modulo * height */
@@ -158,6 +165,7 @@ void drawgfx_init(void);
 void decodechar(gfx_element *gfx,int num,const unsigned char *src,const gfx_layout *gl);
 gfx_element *allocgfx(const gfx_layout *gl);
 void decodegfx(gfx_element *gfx, const UINT8 *src, UINT32 first, UINT32 count);
+void updategfxusage(gfx_element *gfx);
 void freegfx(gfx_element *gfx);
 void drawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
@@ -49,6 +49,7 @@
 
 #define FILEFLAG_OPENREAD		0x0001
 #define FILEFLAG_OPENWRITE		0x0002
+#define FILEFLAG_DEFER			0x0010
 #define FILEFLAG_HASH			0x0100
 #define FILEFLAG_REVERSE_SEARCH	0x0200
 #define FILEFLAG_VERIFY_ONLY	0x0400
@@ -86,6 +87,17 @@ struct _mame_file
 	UINT8		type;
 	char		hash[HASH_BUF_SIZE];
 	int			back_char; /* Buffered char for unget. EOF for empty. */
+	UINT8		deferred;			/* data still to hash */
+	UINT8 *		compressed;			/* deflated data read from the zip, still to decompress */
+	UINT32		compressed_length;
+	zip_map *	data_map;			/* mapping of the zip, if data points into it */
+	zip_map *	compressed_map;		/* mapping of the zip, if compressed points into it */
+	unsigned	hash_functions;		/* hash functions to compute */
+	UINT8		hash_cache_update;	/* store the hash in the checksum cache when closing */
+	int			hash_cache_type;	/* key of the file in the checksum cache */
+	int			hash_cache_index;
+	char		hash_cache_name[256];
+	char		hash_cache_entry[256];
 };
 
 
@@ -107,11 +119,21 @@ int mess_ghost_images;
 static mame_file *generic_fopen(int pathtype, const char *gamename, const char *filename, const char *hash, UINT32 flags, osd_file_error *error);
 static const char *get_extension_for_filetype(int filetype);
 static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **p, UINT64 *size, char* hash);
+static int hash_cache_lookup(int pathtype, int pathindex, const char *name, const char *entry, unsigned functions, char *hash);
+static void hash_cache_key(mame_file *file, int pathtype, int pathindex, const char *name, const char *entry);
 static chd_interface_file *chd_open_cb(const char *filename, const char *mode);
 static void chd_close_cb(chd_interface_file *file);
 static UINT32 chd_read_cb(chd_interface_file *file, UINT64 offset, UINT32 count, void *buffer);
 static UINT32 chd_write_cb(chd_interface_file *file, UINT64 offset, UINT32 count, const void *buffer);
 static UINT64 chd_length_cb(chd_interface_file *file);
+static void *chd_group_alloc_cb(void);
+static void chd_group_free_cb(void *group);
+static void chd_group_run_cb(void *group, void (*task)(void *param), void *param);
+static void chd_group_wait_cb(void *group);
+static void *chd_lock_alloc_cb(void);
+static void chd_lock_free_cb(void *lock);
+static void chd_lock_acquire_cb(void *lock);
+static void chd_lock_release_cb(void *lock);
 
 
 
@@ -125,7 +147,15 @@ static chd_interface mame_chd_interface =
 	chd_close_cb,
 	chd_read_cb,
 	chd_write_cb,
-	chd_length_cb
+	chd_length_cb,
+	chd_group_alloc_cb,
+	chd_group_free_cb,
+	chd_group_run_cb,
+	chd_group_wait_cb,
+	chd_lock_alloc_cb,
+	chd_lock_free_cb,
+	chd_lock_acquire_cb,
+	chd_lock_release_cb
 };
 
 
@@ -326,6 +356,58 @@ mame_file *mame_fopen_rom(const char *gamename, const char *filename, const char
 }
 
 
+/*-------------------------------------------------
+    mame_fopen_rom_deferred - similar to
+    mame_fopen_rom, but only reads the file; the
+    decompression and the checksums are left to
+    mame_fprepare
+-------------------------------------------------*/
+
+mame_file *mame_fopen_rom_deferred(const char *gamename, const char *filename, const char *exphash)
+{
+	return generic_fopen(FILETYPE_ROM, gamename, filename, exphash, FILEFLAG_OPENREAD | FILEFLAG_HASH | FILEFLAG_DEFER, NULL);
+}
+
+
+/*-------------------------------------------------
+    mame_fprepare - decompress and hash a file
+    opened with mame_fopen_rom_deferred; it
+    doesn't touch any shared state, so different
+    files can be prepared in parallel
+-------------------------------------------------*/
+
+int mame_fprepare(mame_file *file)
+{
+#ifdef DEBUG_COOKIE
+	assert(file->debug_cookie == DEBUG_COOKIE);
+#endif
+
+	/* inflate the data read from the zip */
+	if (file->compressed)
+	{
+		file->data = malloc(file->length);
+		if (!file->data)
+			return -1;
+
+		if (inflate_zipped_data(file->compressed, file->compressed_length, file->data, file->length) != 0)
+			return -1;
+
+		/* the mapping is released when closing */
+		if (!file->compressed_map)
+			free(file->compressed);
+		file->compressed = NULL;
+	}
+
+	/* the hash may be already known from the checksum cache */
+	if (file->deferred)
+	{
+		hash_compute(file->hash, file->data, file->length, file->hash_functions);
+		file->deferred = 0;
+	}
+	return 0;
+}
+
+
 /*-------------------------------------------------
     mame_fclose - closes a file
 -------------------------------------------------*/
@@ -337,6 +419,11 @@ void mame_fclose(mame_file *file)
 	file->debug_cookie = 0;
 #endif
 
+	/* remember the hash computed, if the file was prepared */
+	if (file->hash_cache_update && file->hash_cache_name[0] && !file->deferred && !file->compressed)
+		osd_hash_cache_set(file->hash_cache_type, file->hash_cache_index, file->hash_cache_name,
+			file->hash_cache_entry[0] ? file->hash_cache_entry : NULL, file->hash);
+
 	/* switch off the file type */
 	switch (file->type)
 	{
@@ -346,8 +433,14 @@ void mame_fclose(mame_file *file)
 
 		case ZIPPED_FILE:
 		case RAM_FILE:
-			if (file->data)
+			if (file->data && !file->data_map)
 				free(file->data);
+			if (file->compressed && !file->compressed_map)
+				free(file->compressed);
+			if (file->data_map)
+				unzip_map_release(file->data_map);
+			if (file->compressed_map)
+				unzip_map_release(file->compressed_map);
 			break;
 	}
 
@@ -1067,9 +1160,17 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 			/* if we need checksums, load it into RAM and compute it along the way */
 			if (flags & FILEFLAG_HASH)
 			{
-				if (checksum_file(pathtype, pathindex, name, &file.data, &file.length, file.hash) == 0)
+				/* the checksums of an unchanged file come from the cache, all the
+                   functions are computed as the hash of the file starts empty */
+				int cached = hash_cache_lookup(pathtype, pathindex, name, NULL, 0, file.hash);
+
+				/* the verify-only case doesn't need the data */
+				if (checksum_file(pathtype, pathindex, name, (flags & FILEFLAG_VERIFY_ONLY) ? NULL : &file.data, &file.length, (cached || (flags & FILEFLAG_DEFER)) ? NULL : file.hash) == 0)
 				{
 					file.type = RAM_FILE;
+					file.deferred = (flags & FILEFLAG_DEFER) && !cached;
+					hash_cache_key(&file, pathtype, pathindex, name, NULL);
+					file.hash_cache_update = !cached;
 					break;
 				}
 			}
@@ -1192,6 +1293,8 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 
 					if (checksum_zipped_file(pathtype, pathindex, name, tempname, &ziplength, &crc) == 0)
 					{
+						char cached[HASH_BUF_SIZE];
+
 						file.length = ziplength;
 						file.type = UNLOADED_ZIPPED_FILE;
 
@@ -1200,6 +1303,60 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 						crcs[2] = (UINT8)(crc >> 8);
 						crcs[3] = (UINT8)(crc >> 0);
 						hash_data_insert_binary_checksum(file.hash, HASH_CRC, crcs);
+
+						/* if the entry was loaded before, the cache also has the other
+                           checksums; the CRC ensures that it's the same entry */
+						if (hash_cache_lookup(pathtype, pathindex, name, tempname, hash_data_used_functions(hash) | HASH_CRC, cached)
+							&& hash_data_is_equal(cached, file.hash, HASH_CRC) == 1)
+							hash_data_copy(file.hash, cached);
+						break;
+					}
+				}
+
+				/* deferred load case, the data is only read */
+				else if (flags & FILEFLAG_DEFER)
+				{
+					const char *entryname = tempname;
+					UINT32 compressed_length;
+					int deflated;
+					int cached;
+					int err;
+					char crcn[9];
+
+					err = load_zipped_file_compressed(pathtype, pathindex, name, tempname, &file.compressed, &compressed_length, &ziplength, &deflated, &file.compressed_map);
+
+					/* load by CRC, as below */
+					if (err && hash)
+					{
+						if (hash_data_extract_printable_checksum(hash, HASH_CRC, crcn) != 0)
+						{
+							err = load_zipped_file_compressed(pathtype, pathindex, name, crcn, &file.compressed, &compressed_length, &ziplength, &deflated, &file.compressed_map);
+							entryname = crcn;
+						}
+					}
+
+					if (err == 0)
+					{
+						VPRINTF(("Using (mame_fopen) zip file for %s\n", filename));
+						file.length = ziplength;
+						file.type = ZIPPED_FILE;
+						file.hash_functions = hash_data_used_functions(hash);
+						cached = hash_cache_lookup(pathtype, pathindex, name, entryname, file.hash_functions, file.hash);
+						file.deferred = !cached;
+						hash_cache_key(&file, pathtype, pathindex, name, entryname);
+						file.hash_cache_update = !cached;
+
+						/* stored data is already the uncompressed image, */
+						/* if mapped it's used directly without any copy */
+						if (deflated)
+							file.compressed_length = compressed_length;
+						else
+						{
+							file.data = file.compressed;
+							file.data_map = file.compressed_map;
+							file.compressed = NULL;
+							file.compressed_map = NULL;
+						}
 						break;
 					}
 				}
@@ -1207,7 +1364,9 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 				/* full load case */
 				else
 				{
+					const char *entryname = tempname;
 					int err;
+					char crcn[9];
 
 					/* Try loading the file */
 					err = load_zipped_file(pathtype, pathindex, name, tempname, &file.data, &ziplength);
@@ -1217,10 +1376,11 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
                        of specifying the CRC as filename. */
 					if (err && hash)
 					{
-						char crcn[9];
-
 						if (hash_data_extract_printable_checksum(hash, HASH_CRC, crcn) != 0)
+						{
 							err = load_zipped_file(pathtype, pathindex, name, crcn, &file.data, &ziplength);
+							entryname = crcn;
+						}
 					}
 
 					if (err == 0)
@@ -1236,7 +1396,14 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
                            functions for which we have an expected checksum to compare with. */
 						functions = hash_data_used_functions(hash);
 
-						hash_compute(file.hash, file.data, file.length, functions);
+						hash_cache_key(&file, pathtype, pathindex, name, entryname);
+						if (hash_cache_lookup(pathtype, pathindex, name, entryname, functions, file.hash))
+							file.hash_cache_update = 0;
+						else
+						{
+							hash_compute(file.hash, file.data, file.length, functions);
+							file.hash_cache_update = 1;
+						}
 						break;
 					}
 				}
@@ -1297,6 +1464,15 @@ static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **
 		return -1;
 	}
 
+	*size = length;
+
+	/* if neither the data nor the checksums are needed, we are done */
+	if (!p && !hash)
+	{
+		osd_fclose(f);
+		return 0;
+	}
+
 	/* allocate space for entire file */
 	data = malloc(length);
 	if (!data)
@@ -1320,13 +1496,14 @@ static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **
 		return -1;
 	}
 
-	*size = length;
-
 	/* compute the checksums (only the functions for which we have an expected
        checksum). Take also care of crconly: if the user asked, we will calculate
        only the CRC, but only if there is an expected CRC for this file. */
-	functions = hash_data_used_functions(hash);
-	hash_compute(hash, data, length, functions);
+	if (hash)
+	{
+		functions = hash_data_used_functions(hash);
+		hash_compute(hash, data, length, functions);
+	}
 
 	/* if the caller wants the data, give it away, otherwise free it */
 	if (p)
@@ -1340,6 +1517,69 @@ static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **
 }
 
 
+/*-------------------------------------------------
+    hash_cache_lookup - get the checksums of a
+    file from the checksum cache; it succeeds
+    only if all the requested functions are
+    present, and it returns only them like
+    hash_compute does
+-------------------------------------------------*/
+
+static int hash_cache_lookup(int pathtype, int pathindex, const char *name, const char *entry, unsigned functions, char *hash)
+{
+	char cached[HASH_BUF_SIZE];
+	int i;
+
+	if (osd_hash_cache_get(pathtype, pathindex, name, entry, cached) != 0)
+		return 0;
+
+	/* zero means all the functions */
+	if (functions == 0)
+		functions = (1 << HASH_NUM_FUNCTIONS) - 1;
+
+	if ((hash_data_used_functions(cached) & functions) != functions)
+		return 0;
+
+	hash_data_clear(hash);
+	for (i = 0; i < HASH_NUM_FUNCTIONS; i++)
+	{
+		unsigned func = 1 << i;
+		UINT8 chksum[256];
+
+		if ((functions & func) && hash_data_extract_binary_checksum(cached, func, chksum))
+			hash_data_insert_binary_checksum(hash, func, chksum);
+	}
+
+	return 1;
+}
+
+
+/*-------------------------------------------------
+    hash_cache_key - remember where to store the
+    checksums of a file in the checksum cache
+-------------------------------------------------*/
+
+static void hash_cache_key(mame_file *file, int pathtype, int pathindex, const char *name, const char *entry)
+{
+	if (!entry)
+		entry = "";
+
+	file->hash_cache_type = pathtype;
+	file->hash_cache_index = pathindex;
+	file->hash_cache_update = 0;
+
+	/* names too long are not cached */
+	if (strlen(name) >= sizeof(file->hash_cache_name) || strlen(entry) >= sizeof(file->hash_cache_entry))
+	{
+		file->hash_cache_name[0] = 0;
+		return;
+	}
+
+	strcpy(file->hash_cache_name, name);
+	strcpy(file->hash_cache_entry, entry);
+}
+
+
 /*-------------------------------------------------
     chd_open_cb - interface for opening
     a hard disk image
@@ -1411,3 +1651,55 @@ UINT64 chd_length_cb(chd_interface_file *file)
 {
 	return mame_fsize((mame_file *)file);
 }
+
+
+/*-------------------------------------------------
+    chd_group_*_cb - interface for running the
+    hard disk read-ahead on the OSD task groups
+-------------------------------------------------*/
+
+void *chd_group_alloc_cb(void)
+{
+	return osd_task_group_alloc();
+}
+
+void chd_group_free_cb(void *group)
+{
+	osd_task_group_free((osd_task_group *)group);
+}
+
+void chd_group_run_cb(void *group, void (*task)(void *param), void *param)
+{
+	osd_task_group_run((osd_task_group *)group, task, param);
+}
+
+void chd_group_wait_cb(void *group)
+{
+	osd_task_group_wait((osd_task_group *)group);
+}
+
+
+/*-------------------------------------------------
+    chd_lock_*_cb - interface for the locks of
+    the hard disk read-ahead
+-------------------------------------------------*/
+
+void *chd_lock_alloc_cb(void)
+{
+	return osd_lock_alloc();
+}
+
+void chd_lock_free_cb(void *lock)
+{
+	osd_lock_free((osd_lock *)lock);
+}
+
+void chd_lock_acquire_cb(void *lock)
+{
+	osd_lock_acquire((osd_lock *)lock);
+}
+
+void chd_lock_release_cb(void *lock)
+{
+	osd_lock_release((osd_lock *)lock);
+}
@@ -56,6 +56,8 @@ int mame_faccess(const char *filename, int filetype);
 mame_file *mame_fopen(const char *gamename, const char *filename, int filetype, int openforwrite);
 mame_file *mame_fopen_error(const char *gamename, const char *filename, int filetype, int openforwrite, osd_file_error *error);
 mame_file *mame_fopen_rom(const char *gamename, const char *filename, const char *exphash);
+mame_file *mame_fopen_rom_deferred(const char *gamename, const char *filename, const char *exphash);
+int mame_fprepare(mame_file *file);
 UINT32 mame_fread(mame_file *file, void *buffer, UINT32 length);
 UINT32 mame_fwrite(mame_file *file, const void *buffer, UINT32 length);
 UINT32 mame_fread_swap(mame_file *file, void *buffer, UINT32 length);
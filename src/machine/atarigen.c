@@ -1472,7 +1472,6 @@ void atarigen_blend_gfx(int gfx0, int gfx1, int mask0, int mask1)
 	{
 		UINT8 *c0base = gx0->gfxdata + gx0->char_modulo * c;
 		UINT8 *c1base = gx1->gfxdata + gx1->char_modulo * c;
-		UINT32 usage = 0;
 
 		/* loop over height */
 		for (y = 0; y < gx0->height; y++)
@@ -1480,17 +1479,15 @@ void atarigen_blend_gfx(int gfx0, int gfx1, int mask0, int mask1)
 			UINT8 *c0 = c0base, *c1 = c1base;
 
 			for (x = 0; x < gx0->width; x++, c0++, c1++)
-			{
 				*c0 = (*c0 & mask0) | (*c1 & mask1);
-				usage |= 1 << *c0;
-			}
 			c0base += gx0->line_modulo;
 			c1base += gx1->line_modulo;
-			if (gx0->pen_usage)
-				gx0->pen_usage[c] = usage;
 		}
 	}
 
+	/* the blended pens may use more bitplanes than the first element */
+	updategfxusage(gx0);
+
 	/* free the second graphics element */
 	freegfx(gx1);
 	Machine->gfx[gfx1] = NULL;
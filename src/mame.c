@@ -150,6 +150,8 @@ static mame_timer *soft_reset_timer;
 /* load/save statics */
 static void (*saveload_schedule_callback)(void);
 static mame_time saveload_schedule_time;
+static void (*state_schedule_callback)(void);
+static int runahead_active;
 
 /* error recovery and exiting */
 static callback_item *reset_callback_list;
@@ -245,6 +247,10 @@ static void free_callback_list(callback_item **cb);
 static void saveload_init(void);
 static void handle_save(void);
 static void handle_load(void);
+static void save_state_tags(void);
+static void load_state_tags(void);
+static void runahead_init(void);
+static void runahead_timeslice(void);
 
 
 static void logfile_callback(const char *buffer);
@@ -324,13 +330,20 @@ int run_game(int game)
 
 			/* run the CPUs until a reset or exit */
 			hard_reset_pending = FALSE;
+			state_schedule_callback = NULL;
+			runahead_init();
 			while ((!hard_reset_pending && !exit_pending) || saveload_pending_file != NULL)
 			{
 				profiler_mark(PROFILER_EXTRA);
 
-				/* execute CPUs if not paused */
+				/* execute CPUs if not paused, a full frame at time with the run-ahead */
 				if (!mame_paused)
-					cpuexec_timeslice();
+				{
+					if (runahead_active && saveload_pending_file == NULL)
+						runahead_timeslice();
+					else
+						cpuexec_timeslice();
+				}
 
 				/* otherwise, just pump video updates through */
 				else
@@ -343,9 +356,21 @@ int run_game(int game)
 				if (saveload_schedule_callback)
 					(*saveload_schedule_callback)();
 
+				/* handle the in-memory states */
+				if (state_schedule_callback)
+				{
+					void (*callback)(void) = state_schedule_callback;
+					state_schedule_callback = NULL;
+					(*callback)();
+				}
+
 				profiler_mark(PROFILER_END);
 			}
 
+			/* report the average cost of the run-ahead */
+			if (runahead_active)
+				logerror("Run-ahead frame time %.2f ms, state save and load %.2f ms\n", mame_get_performance_info()->runahead_frame_time * 1000.0, mame_get_performance_info()->runahead_state_time * 1000.0);
+
 			/* and out via the exit phase */
 			current_phase = MAME_PHASE_EXIT;
 
@@ -541,6 +566,56 @@ void mame_schedule_load(const char *filename)
 }
 
 
+/*-------------------------------------------------
+    mame_schedule_state_callback - schedule a
+    call at the end of the current timeslice,
+    where mame_save_state_memory() and
+    mame_load_state_memory() can be used
+-------------------------------------------------*/
+
+void mame_schedule_state_callback(void (*callback)(void))
+{
+	state_schedule_callback = callback;
+}
+
+
+/*-------------------------------------------------
+    mame_save_state_memory - save the state in
+    memory, valid up to the next save
+-------------------------------------------------*/
+
+int mame_save_state_memory(void)
+{
+	/* the anonymous timers can't be saved, the caller tries again later */
+	if (timer_count_anonymous() > 0)
+		return 1;
+
+	if (state_save_save_begin(NULL) != 0)
+		return 1;
+	save_state_tags();
+	state_save_save_finish();
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    mame_load_state_memory - load a state saved
+    in memory
+-------------------------------------------------*/
+
+int mame_load_state_memory(const UINT8 *data, UINT32 size)
+{
+	if (timer_count_anonymous() > 0)
+		return 1;
+
+	if (state_save_load_begin_memory(data, size) != 0)
+		return 1;
+	load_state_tags();
+	state_save_load_finish();
+	return 0;
+}
+
+
 /*-------------------------------------------------
     mame_is_scheduled_event_pending - is a
     scheduled event pending?
@@ -1246,6 +1321,175 @@ static void saveload_init(void)
 }
 
 
+/*-------------------------------------------------
+    save_state_tags - save the default tag and
+    the tags of all the CPUs
+-------------------------------------------------*/
+
+static void save_state_tags(void)
+{
+	int cpunum;
+
+	/* write the default tag */
+	state_save_push_tag(0);
+	state_save_save_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* save the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_save_continue();
+		state_save_pop_tag();
+
+		cpuintrf_pop_context();
+	}
+}
+
+
+/*-------------------------------------------------
+    load_state_tags - load the default tag and
+    the tags of all the CPUs
+-------------------------------------------------*/
+
+static void load_state_tags(void)
+{
+	int cpunum;
+
+	/* read tag 0 */
+	state_save_push_tag(0);
+	state_save_load_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* load the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_load_continue();
+		state_save_pop_tag();
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		cpuintrf_pop_context();
+	}
+}
+
+
+/*-------------------------------------------------
+    runahead_init - enable the run-ahead if the
+    game can save its state
+-------------------------------------------------*/
+
+static void runahead_init(void)
+{
+	runahead_active = FALSE;
+
+	if (options.runahead <= 0)
+		return;
+
+	/* the input recording and the debugger must see every frame once */
+	if (options.record || options.playback || options.mame_debug)
+		logerror("Run-ahead disabled with the input recording and the debugger\n");
+	else if (!(Machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
+		logerror("Run-ahead disabled, the game doesn't support the save states\n");
+	else
+	{
+		logerror("Run-ahead of %d frames\n", options.runahead);
+		runahead_active = TRUE;
+	}
+}
+
+
+/*-------------------------------------------------
+    runahead_frame - run the CPUs up to the end
+    of the current frame
+-------------------------------------------------*/
+
+static void runahead_frame(int show_video, int play_sound)
+{
+	int frame = cpu_getcurrentframe();
+
+	video_set_frame_output(show_video, play_sound);
+	while (cpu_getcurrentframe() == frame && !mame_paused)
+		cpuexec_timeslice();
+	video_set_frame_output(TRUE, TRUE);
+}
+
+
+/*-------------------------------------------------
+    runahead_timeslice - run a frame with the
+    run-ahead, displaying the frame emulated some
+    frames later with the same input, and then
+    going back to the real one
+-------------------------------------------------*/
+
+static void runahead_timeslice(void)
+{
+	cycles_t start, state_start, state_cycles;
+	double scale;
+	int i;
+
+	start = osd_cycles();
+
+	/* a skipped frame doesn't need the run-ahead */
+	if (osd_skip_this_frame())
+	{
+		runahead_frame(TRUE, TRUE);
+		return;
+	}
+
+	/* the real frame, played but not displayed */
+	runahead_frame(FALSE, TRUE);
+
+	/* the anonymous timers can't be saved, in this case display the real frame */
+	state_start = osd_cycles();
+	if (mame_paused || timer_count_anonymous() > 0 || state_save_snapshot_begin() != 0)
+	{
+		video_frame_output();
+		return;
+	}
+	save_state_tags();
+	state_save_snapshot_finish();
+	state_cycles = osd_cycles() - state_start;
+
+	/* the frames ahead, only the last one is displayed */
+	for (i = 1; i <= options.runahead && !mame_paused; i++)
+		runahead_frame(i == options.runahead, FALSE);
+
+	/* the pause stops the run-ahead before the displayed frame */
+	if (i <= options.runahead)
+		video_frame_output();
+
+	/* go back to the real frame */
+	state_start = osd_cycles();
+	if (state_save_restore_begin() != 0)
+	{
+		logerror("Run-ahead failed to restore the state, disabled\n");
+		runahead_active = FALSE;
+		return;
+	}
+	load_state_tags();
+	state_save_load_finish();
+	state_cycles += osd_cycles() - state_start;
+
+	scale = 1.0 / (double)osd_cycles_per_second();
+	video_set_runahead_time(options.runahead, (osd_cycles() - start) * scale, state_cycles * scale);
+}
+
+
 /*-------------------------------------------------
     handle_save - attempt to perform a save
 -------------------------------------------------*/
@@ -1277,8 +1521,6 @@ static void handle_save(void)
 	file = mame_fopen(Machine->gamedrv->name, saveload_pending_file, FILETYPE_STATE, 1);
 	if (file)
 	{
-		int cpunum;
-
 		/* write the save state */
 		if (state_save_save_begin(file) != 0)
 		{
@@ -1287,26 +1529,8 @@ static void handle_save(void)
 			goto cancel;
 		}
 
-		/* write the default tag */
-		state_save_push_tag(0);
-		state_save_save_continue();
-		state_save_pop_tag();
-
-		/* loop over CPUs */
-		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-		{
-			cpuintrf_push_context(cpunum);
-
-			/* make sure banking is set */
-			activecpu_reset_banking();
-
-			/* save the CPU data */
-			state_save_push_tag(cpunum + 1);
-			state_save_save_continue();
-			state_save_pop_tag();
-
-			cpuintrf_pop_context();
-		}
+		/* write all the tags */
+		save_state_tags();
 
 		/* finish and close */
 		state_save_save_finish();
@@ -1364,31 +1588,8 @@ static void handle_load(void)
 		/* start loading */
 		if (state_save_load_begin(file) == 0)
 		{
-			int cpunum;
-
-			/* read tag 0 */
-			state_save_push_tag(0);
-			state_save_load_continue();
-			state_save_pop_tag();
-
-			/* loop over CPUs */
-			for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-			{
-				cpuintrf_push_context(cpunum);
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				/* load the CPU data */
-				state_save_push_tag(cpunum + 1);
-				state_save_load_continue();
-				state_save_pop_tag();
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				cpuintrf_pop_context();
-			}
+			/* read all the tags */
+			load_state_tags();
 
 			/* finish and close */
 			state_save_load_finish();
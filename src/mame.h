@@ -222,6 +222,7 @@ struct _global_options
 
 	const char * savegame;	/* string representing a savegame to load; if one length then interpreted as a character */
 	int		auto_save;		/* 1 to automatically save/restore at startup/quitting time */
+	int		runahead;		/* number of frames to emulate ahead to reduce the input latency, 0 to disable */
 	char *	bios;			/* specify system bios (if used), 0 is default */
 
 	int		debug_width;	/* requested width of debugger bitmap */
@@ -298,6 +299,15 @@ void mame_schedule_save(const char *filename);
 /* schedule a load */
 void mame_schedule_load(const char *filename);
 
+/* schedule a call between two timeslices, where the state can be saved or loaded in memory */
+void mame_schedule_state_callback(void (*callback)(void));
+
+/* save the state in memory, get it with state_save_get_memory() */
+int mame_save_state_memory(void);
+
+/* load a state saved in memory */
+int mame_load_state_memory(const UINT8 *data, UINT32 size);
+
 /* is a scheduled event pending? */
 int mame_is_scheduled_event_pending(void);
 
@@ -38,6 +38,15 @@ typedef UINT32 FPTR;
 typedef void genf(void);
 
 
+/* ----- for the state owned by each OSD thread ----- */
+/* MAME_THREADS is defined when the OSD layer runs more threads */
+#ifdef MAME_THREADS
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
+
 
 /* These are forward struct declarations that are used to break
    circular dependencies in the code */
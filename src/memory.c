@@ -228,6 +228,10 @@ struct _table_data
 	UINT8 					subtable_alloc;			/* number of subtables allocated */
 	subtable_data			subtable[SUBTABLE_COUNT]; /* info about each subtable */
 	handler_data			handlers[ENTRY_COUNT];	/* array of user-installed handlers */
+	UINT8 **				tlb;					/* direct pointer for each page, or NULL */
+	UINT8 *					tlbentry;				/* bank entry mapping each page, or STATIC_INVALID */
+	UINT32					tlbfirst[STATIC_COUNT];	/* first page mapped by each bank */
+	UINT32					tlblast[STATIC_COUNT];	/* last page mapped by each bank */
 };
 typedef struct _table_data table_data;
 
@@ -241,6 +245,10 @@ struct _addrspace_data
 	offs_t					rawmask;				/* raw address mask, before adjusting to bytes */
 	offs_t					mask;					/* address mask */
 	UINT64					unmap;					/* unmapped value */
+	UINT8					tlbshift;				/* shift to get the page from an address */
+	UINT8					bytexor;				/* address xor to access a byte in a direct page */
+	UINT8					wordxor;				/* address xor to access a word in a direct page */
+	UINT8					dwordxor;				/* address xor to access a dword in a direct page */
 	table_data				read;					/* memory read lookup table */
 	table_data				write;					/* memory write lookup table */
 	data_accessors *		accessors;				/* pointer to the memory accessors */
@@ -280,6 +288,7 @@ UINT8		 				opcode_entry;					/* opcode readmem entry */
 address_space				active_address_space[ADDRESS_SPACES];/* address space data */
 
 static UINT8 *				bank_ptr[STATIC_COUNT];			/* array of bank pointers */
+static UINT8				tlb_valid;						/* are the direct page tables built */
 static UINT8 *				bankd_ptr[STATIC_COUNT];		/* array of decrypted bank pointers */
 static void *				shared_ptr[MAX_SHARED_POINTERS];/* array of shared pointers */
 
@@ -376,6 +385,9 @@ static int init_addrspace(UINT8 cpunum, UINT8 spacenum);
 static int preflight_memory(void);
 static int populate_memory(void);
 static void install_mem_handler(addrspace_data *space, int iswrite, int databits, int ismatchmask, offs_t start, offs_t end, offs_t mask, offs_t mirror, genf *handler, int isfixed, const char *handler_name);
+static void tlb_build(addrspace_data *space, int iswrite);
+static void tlb_update_bank(int banknum);
+static void tlb_build_all(void);
 static genf *assign_dynamic_bank(int cpunum, int spacenum, offs_t start, offs_t end, offs_t mirror, int isfixed, int ismasked);
 static UINT8 get_handler_index(handler_data *table, genf *handler, const char *handler_name, offs_t start, offs_t end, offs_t mask);
 static void populate_table_range(addrspace_data *space, int iswrite, offs_t start, offs_t stop, UINT8 handler);
@@ -425,6 +437,9 @@ int memory_init(void)
 	/* no current context to start */
 	cur_context = -1;
 
+	/* the direct page tables are built once everything is mapped */
+	tlb_valid = FALSE;
+
 	/* reset the shared pointers and bank pointers */
 	memset(shared_ptr, 0, sizeof(shared_ptr));
 	memset(bank_ptr, 0, sizeof(bank_ptr));
@@ -455,6 +470,9 @@ int memory_init(void)
 	if (!find_memory())
 		return 1;
 
+	/* build the direct page tables */
+	tlb_build_all();
+
 	/* dump the final memory configuration */
 	mem_dump();
 	return 0;
@@ -477,7 +495,16 @@ void memory_exit(void)
 				free(cpudata[cpunum].space[spacenum].read.table);
 			if (cpudata[cpunum].space[spacenum].write.table)
 				free(cpudata[cpunum].space[spacenum].write.table);
+			if (cpudata[cpunum].space[spacenum].read.tlb)
+				free(cpudata[cpunum].space[spacenum].read.tlb);
+			if (cpudata[cpunum].space[spacenum].read.tlbentry)
+				free(cpudata[cpunum].space[spacenum].read.tlbentry);
+			if (cpudata[cpunum].space[spacenum].write.tlb)
+				free(cpudata[cpunum].space[spacenum].write.tlb);
+			if (cpudata[cpunum].space[spacenum].write.tlbentry)
+				free(cpudata[cpunum].space[spacenum].write.tlbentry);
 		}
+	tlb_valid = FALSE;
 }
 
 
@@ -513,6 +540,12 @@ void memory_set_context(int activecpu)
 	active_address_space[ADDRESS_SPACE_PROGRAM].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].read.handlers;
 	active_address_space[ADDRESS_SPACE_PROGRAM].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].write.handlers;
 	active_address_space[ADDRESS_SPACE_PROGRAM].accessors = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].accessors;
+	active_address_space[ADDRESS_SPACE_PROGRAM].readtlb = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].read.tlb;
+	active_address_space[ADDRESS_SPACE_PROGRAM].writetlb = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].write.tlb;
+	active_address_space[ADDRESS_SPACE_PROGRAM].tlbshift = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].tlbshift;
+	active_address_space[ADDRESS_SPACE_PROGRAM].bytexor = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].bytexor;
+	active_address_space[ADDRESS_SPACE_PROGRAM].wordxor = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].wordxor;
+	active_address_space[ADDRESS_SPACE_PROGRAM].dwordxor = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].dwordxor;
 
 	/* data address space */
 	if (cpudata[activecpu].spacemask & (1 << ADDRESS_SPACE_DATA))
@@ -523,6 +556,12 @@ void memory_set_context(int activecpu)
 		active_address_space[ADDRESS_SPACE_DATA].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_DATA].read.handlers;
 		active_address_space[ADDRESS_SPACE_DATA].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_DATA].write.handlers;
 		active_address_space[ADDRESS_SPACE_DATA].accessors = cpudata[activecpu].space[ADDRESS_SPACE_DATA].accessors;
+		active_address_space[ADDRESS_SPACE_DATA].readtlb = cpudata[activecpu].space[ADDRESS_SPACE_DATA].read.tlb;
+		active_address_space[ADDRESS_SPACE_DATA].writetlb = cpudata[activecpu].space[ADDRESS_SPACE_DATA].write.tlb;
+		active_address_space[ADDRESS_SPACE_DATA].tlbshift = cpudata[activecpu].space[ADDRESS_SPACE_DATA].tlbshift;
+		active_address_space[ADDRESS_SPACE_DATA].bytexor = cpudata[activecpu].space[ADDRESS_SPACE_DATA].bytexor;
+		active_address_space[ADDRESS_SPACE_DATA].wordxor = cpudata[activecpu].space[ADDRESS_SPACE_DATA].wordxor;
+		active_address_space[ADDRESS_SPACE_DATA].dwordxor = cpudata[activecpu].space[ADDRESS_SPACE_DATA].dwordxor;
 	}
 
 	/* I/O address space */
@@ -534,6 +573,12 @@ void memory_set_context(int activecpu)
 		active_address_space[ADDRESS_SPACE_IO].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_IO].read.handlers;
 		active_address_space[ADDRESS_SPACE_IO].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_IO].write.handlers;
 		active_address_space[ADDRESS_SPACE_IO].accessors = cpudata[activecpu].space[ADDRESS_SPACE_IO].accessors;
+		active_address_space[ADDRESS_SPACE_IO].readtlb = cpudata[activecpu].space[ADDRESS_SPACE_IO].read.tlb;
+		active_address_space[ADDRESS_SPACE_IO].writetlb = cpudata[activecpu].space[ADDRESS_SPACE_IO].write.tlb;
+		active_address_space[ADDRESS_SPACE_IO].tlbshift = cpudata[activecpu].space[ADDRESS_SPACE_IO].tlbshift;
+		active_address_space[ADDRESS_SPACE_IO].bytexor = cpudata[activecpu].space[ADDRESS_SPACE_IO].bytexor;
+		active_address_space[ADDRESS_SPACE_IO].wordxor = cpudata[activecpu].space[ADDRESS_SPACE_IO].wordxor;
+		active_address_space[ADDRESS_SPACE_IO].dwordxor = cpudata[activecpu].space[ADDRESS_SPACE_IO].dwordxor;
 	}
 
 	opbasefunc = cpudata[activecpu].opbase;
@@ -859,6 +904,7 @@ void memory_set_bank(int banknum, int entrynum)
 	bankdata[banknum].curentry = entrynum;
 	bank_ptr[banknum] = bankdata[banknum].entry[entrynum];
 	bankd_ptr[banknum] = bankdata[banknum].entryd[entrynum];
+	tlb_update_bank(banknum);
 
 	/* if we're executing out of this bank, adjust the opbase pointer */
 	if (opcode_entry == banknum && cpu_getactivecpu() >= 0)
@@ -886,6 +932,7 @@ void memory_set_bankptr(int banknum, void *base)
 
 	/* set the base */
 	bank_ptr[banknum] = base;
+	tlb_update_bank(banknum);
 
 	/* if we're executing out of this bank, adjust the opbase pointer */
 	if (opcode_entry == banknum && cpu_getactivecpu() >= 0)
@@ -1201,8 +1248,10 @@ static int init_addrspace(UINT8 cpunum, UINT8 spacenum)
 	int abits = cputype_addrbus_width(cputype, spacenum);
 	int dbits = cputype_databus_width(cputype, spacenum);
 	int accessorindex = (dbits == 8) ? 0 : (dbits == 16) ? 1 : (dbits == 32) ? 2 : 3;
+	int islittle = (cputype_endianness(cputype) == CPU_IS_LE);
 	construct_map_t internal_map = (construct_map_t)cputype_get_info_fct(cputype, CPUINFO_PTR_INTERNAL_MEMORY_MAP + spacenum);
-	int entrynum;
+	UINT32 pages;
+	int entrynum, i;
 
 	/* determine the address and data bits */
 	space->cpunum = cpunum;
@@ -1212,7 +1261,7 @@ static int init_addrspace(UINT8 cpunum, UINT8 spacenum)
 	space->dbits = dbits;
 	space->rawmask = 0xffffffffUL >> (32 - abits);
 	space->mask = SPACE_SHIFT_END(space, space->rawmask);
-	space->accessors = &memory_accessors[spacenum][accessorindex][cputype_endianness(cputype) == CPU_IS_LE ? 0 : 1];
+	space->accessors = &memory_accessors[spacenum][accessorindex][islittle ? 0 : 1];
 	space->map = NULL;
 	space->adjmap = NULL;
 
@@ -1301,6 +1350,37 @@ static int init_addrspace(UINT8 cpunum, UINT8 spacenum)
 	/* initialize everything to unmapped */
 	memset(space->read.table, STATIC_UNMAP, 1 << LEVEL1_BITS);
 	memset(space->write.table, STATIC_UNMAP, 1 << LEVEL1_BITS);
+
+	/* pick a page size that keeps the direct page tables small */
+	for (i = 0; i < 32 && (space->mask >> i) != 0; i++) ;
+	space->tlbshift = (i > TLB_MIN_SHIFT + TLB_MAX_BITS) ? i - TLB_MAX_BITS : TLB_MIN_SHIFT;
+
+	/* the direct pages use the same byte ordering as the banks */
+	space->bytexor = space->wordxor = space->dwordxor = 0;
+	if (dbits == 16)
+		space->bytexor = islittle ? BYTE_XOR_LE(0) : BYTE_XOR_BE(0);
+	else if (dbits == 32)
+	{
+		space->bytexor = islittle ? BYTE4_XOR_LE(0) : BYTE4_XOR_BE(0);
+		space->wordxor = islittle ? WORD_XOR_LE(0) : WORD_XOR_BE(0);
+	}
+	else if (dbits == 64)
+	{
+		space->bytexor = islittle ? BYTE8_XOR_LE(0) : BYTE8_XOR_BE(0);
+		space->wordxor = islittle ? WORD2_XOR_LE(0) : WORD2_XOR_BE(0);
+		space->dwordxor = islittle ? DWORD_XOR_LE(0) : DWORD_XOR_BE(0);
+	}
+
+	/* everything goes through the lookup until the direct pages are built */
+	pages = (space->mask >> space->tlbshift) + 1;
+	space->read.tlb = malloc_or_die(pages * sizeof(space->read.tlb[0]));
+	space->read.tlbentry = malloc_or_die(pages);
+	space->write.tlb = malloc_or_die(pages * sizeof(space->write.tlb[0]));
+	space->write.tlbentry = malloc_or_die(pages);
+	memset(space->read.tlb, 0, pages * sizeof(space->read.tlb[0]));
+	memset(space->read.tlbentry, STATIC_INVALID, pages);
+	memset(space->write.tlb, 0, pages * sizeof(space->write.tlb[0]));
+	memset(space->write.tlbentry, STATIC_INVALID, pages);
 	return 1;
 }
 
@@ -1596,6 +1676,10 @@ static void install_mem_handler(addrspace_data *space, int iswrite, int databits
 		}
 	}
 
+	/* the handler may have replaced some direct pages */
+	if (tlb_valid)
+		tlb_build(space, iswrite);
+
 	/* if this is being installed to a live CPU, update the context */
 	if (space->cpunum == cur_context)
 		memory_set_context(cur_context);
@@ -2248,8 +2332,177 @@ static void reattach_banks(void)
 		{
 			/* if this entry has a changed entry, set the appropriate pointer */
 			if (bankdata[banknum].curentry != MAX_BANK_ENTRIES)
+			{
 				bank_ptr[banknum] = bankdata[banknum].entry[bankdata[banknum].curentry];
+				tlb_update_bank(banknum);
+			}
+		}
+}
+
+
+/*-------------------------------------------------
+    tlb_page_entry - return the bank entry that
+    maps every address of a page, or STATIC_INVALID
+-------------------------------------------------*/
+
+static UINT8 tlb_page_entry(table_data *tabledata, offs_t start, offs_t end)
+{
+	UINT8 result = tabledata->table[LEVEL1_INDEX(start)];
+	offs_t address = start;
+
+	if (result >= SUBTABLE_BASE)
+		result = tabledata->table[LEVEL2_INDEX(result, start)];
+
+	for (;;)
+	{
+		UINT8 entry = tabledata->table[LEVEL1_INDEX(address)];
+		offs_t last = address | ((1 << LEVEL2_BITS) - 1);
+
+		if (last > end)
+			last = end;
+
+		/* a subtable has to be checked address by address */
+		if (entry >= SUBTABLE_BASE)
+		{
+			offs_t subaddress;
+			for (subaddress = address; ; subaddress++)
+			{
+				if (tabledata->table[LEVEL2_INDEX(entry, subaddress)] != result)
+					return STATIC_INVALID;
+				if (subaddress == last)
+					break;
+			}
+		}
+		else if (entry != result)
+			return STATIC_INVALID;
+
+		if (last == end)
+			break;
+		address = last + 1;
+	}
+
+	/* only banks are plain memory */
+	if (result < STATIC_BANK1 || result >= STATIC_RAM)
+		return STATIC_INVALID;
+	return result;
+}
+
+
+/*-------------------------------------------------
+    tlb_page_base - compute the direct pointer of
+    a page mapped by a bank
+-------------------------------------------------*/
+
+static UINT8 *tlb_page_base(table_data *tabledata, UINT8 entry, offs_t start)
+{
+	handler_data *handler = &tabledata->handlers[entry];
+
+	if (!bank_ptr[entry])
+		return NULL;
+
+	/* biased so that the page is indexed with the full address */
+	return bank_ptr[entry] + ((start - handler->offset) & handler->mask) - start;
+}
+
+
+/*-------------------------------------------------
+    tlb_build - rebuild the direct pages of an
+    address space from its lookup table
+-------------------------------------------------*/
+
+static void tlb_build(addrspace_data *space, int iswrite)
+{
+	table_data *tabledata = iswrite ? &space->write : &space->read;
+	offs_t pagemask = ((offs_t)1 << space->tlbshift) - 1;
+	UINT32 page, pages = (space->mask >> space->tlbshift) + 1;
+	int entry;
+
+	if (!tabledata->tlb)
+		return;
+
+	for (entry = 0; entry < STATIC_COUNT; entry++)
+	{
+		tabledata->tlbfirst[entry] = ~0;
+		tabledata->tlblast[entry] = 0;
+	}
+
+	for (page = 0; page < pages; page++)
+	{
+		offs_t start = page << space->tlbshift;
+		offs_t span = pagemask & space->mask;
+		UINT8 pageentry = STATIC_INVALID;
+
+#if !defined(MAME_DEBUG) || !defined(NEW_DEBUGGER)
+		/* the page must map linearly into the bank */
+		pageentry = tlb_page_entry(tabledata, start, start + span);
+		if (pageentry != STATIC_INVALID)
+		{
+			handler_data *handler = &tabledata->handlers[pageentry];
+			if ((handler->mask & span) != span || ((start - handler->offset) & span) != 0)
+				pageentry = STATIC_INVALID;
+		}
+#endif
+
+		tabledata->tlbentry[page] = pageentry;
+		if (pageentry == STATIC_INVALID)
+		{
+			tabledata->tlb[page] = NULL;
+			continue;
 		}
+
+		tabledata->tlb[page] = tlb_page_base(tabledata, pageentry, start);
+		if (tabledata->tlbfirst[pageentry] > page)
+			tabledata->tlbfirst[pageentry] = page;
+		tabledata->tlblast[pageentry] = page;
+	}
+}
+
+
+/*-------------------------------------------------
+    tlb_build_all - build the direct pages of all
+    the address spaces
+-------------------------------------------------*/
+
+static void tlb_build_all(void)
+{
+	int cpunum, spacenum;
+
+	for (cpunum = 0; cpunum < MAX_CPU && Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
+		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+			if (cpudata[cpunum].spacemask & (1 << spacenum))
+			{
+				tlb_build(&cpudata[cpunum].space[spacenum], 0);
+				tlb_build(&cpudata[cpunum].space[spacenum], 1);
+			}
+	tlb_valid = TRUE;
+}
+
+
+/*-------------------------------------------------
+    tlb_update_bank - refresh the direct pages
+    mapped by a bank after its base changed
+-------------------------------------------------*/
+
+static void tlb_update_bank(int banknum)
+{
+	int cpunum, spacenum, iswrite;
+
+	if (!tlb_valid)
+		return;
+
+	for (cpunum = 0; cpunum < MAX_CPU && Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
+		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+			if (cpudata[cpunum].spacemask & (1 << spacenum))
+				for (iswrite = 0; iswrite < 2; iswrite++)
+				{
+					addrspace_data *space = &cpudata[cpunum].space[spacenum];
+					table_data *tabledata = iswrite ? &space->write : &space->read;
+					UINT32 page;
+
+					for (page = tabledata->tlbfirst[banknum]; page <= tabledata->tlblast[banknum]; page++)
+						if (tabledata->tlbentry[page] == banknum)
+							tabledata->tlb[page] = tlb_page_base(tabledata, banknum, page << space->tlbshift);
+				}
 }
 
 
@@ -2376,6 +2629,26 @@ static void *memory_find_base(int cpunum, int spacenum, int readwrite, offs_t of
 		entry = space.lookup[LEVEL2_INDEX(entry,address)];								\
 
 
+/*-------------------------------------------------
+    PERFORM_TLB_READ/WRITE - access a direct page
+    without going through the lookup
+-------------------------------------------------*/
+
+#define TLB_NOXOR(a)	(a)
+
+#define PERFORM_TLB_READ(spacenum,extraand,type,xormacro)								\
+	address &= active_address_space[spacenum].addrmask & extraand;						\
+	base = active_address_space[spacenum].readtlb[address >> active_address_space[spacenum].tlbshift];\
+	if (base != NULL)																	\
+		MEMREADEND(*(type *)&base[xormacro(address)]);									\
+
+#define PERFORM_TLB_WRITE(spacenum,extraand,type,xormacro)								\
+	address &= active_address_space[spacenum].addrmask & extraand;						\
+	base = active_address_space[spacenum].writetlb[address >> active_address_space[spacenum].tlbshift];\
+	if (base != NULL)																	\
+		MEMWRITEEND(*(type *)&base[xormacro(address)] = data);							\
+
+
 /*-------------------------------------------------
     READBYTE - generic byte-sized read handler
 -------------------------------------------------*/
@@ -2384,7 +2657,9 @@ static void *memory_find_base(int cpunum, int spacenum, int readwrite, offs_t of
 UINT8 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMREADSTART();																		\
+	PERFORM_TLB_READ(spacenum,~0,UINT8,TLB_NOXOR);										\
 	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_READ(spacenum, 1, address);												\
 																						\
@@ -2403,7 +2678,9 @@ UINT8 name(offs_t address)																\
 UINT8 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMREADSTART();																		\
+	PERFORM_TLB_READ(spacenum,~0,UINT8,xormacro);										\
 	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_READ(spacenum, 1, address);												\
 																						\
@@ -2438,7 +2715,9 @@ UINT8 name(offs_t address)																\
 UINT16 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMREADSTART();																		\
+	PERFORM_TLB_READ(spacenum,~1,UINT16,TLB_NOXOR);										\
 	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_READ(spacenum, 2, address);												\
 																						\
@@ -2457,7 +2736,9 @@ UINT16 name(offs_t address)																\
 UINT16 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMREADSTART();																		\
+	PERFORM_TLB_READ(spacenum,~1,UINT16,xormacro);										\
 	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_READ(spacenum, 2, address);												\
 																						\
@@ -2490,7 +2771,9 @@ UINT16 name(offs_t address)																\
 UINT32 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMREADSTART();																		\
+	PERFORM_TLB_READ(spacenum,~3,UINT32,TLB_NOXOR);										\
 	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_READ(spacenum, 4, address);												\
 																						\
@@ -2509,7 +2792,9 @@ UINT32 name(offs_t address)																\
 UINT32 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMREADSTART();																		\
+	PERFORM_TLB_READ(spacenum,~3,UINT32,xormacro);										\
 	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_READ(spacenum, 4, address);												\
 																						\
@@ -2540,7 +2825,9 @@ UINT32 name(offs_t address)																\
 UINT64 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMREADSTART();																		\
+	PERFORM_TLB_READ(spacenum,~7,UINT64,TLB_NOXOR);										\
 	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~7);						\
 	DEBUG_HOOK_READ(spacenum, 8, address);												\
 																						\
@@ -2564,7 +2851,9 @@ UINT64 name(offs_t address)																\
 void name(offs_t address, UINT8 data)													\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMWRITESTART();																	\
+	PERFORM_TLB_WRITE(spacenum,~0,UINT8,TLB_NOXOR);										\
 	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_WRITE(spacenum, 1, address, data);										\
 																						\
@@ -2582,7 +2871,9 @@ void name(offs_t address, UINT8 data)													\
 void name(offs_t address, UINT8 data)													\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMWRITESTART();																	\
+	PERFORM_TLB_WRITE(spacenum,~0,UINT8,xormacro);										\
 	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_WRITE(spacenum, 1, address, data);										\
 																						\
@@ -2616,7 +2907,9 @@ void name(offs_t address, UINT8 data)													\
 void name(offs_t address, UINT16 data)													\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMWRITESTART();																	\
+	PERFORM_TLB_WRITE(spacenum,~1,UINT16,TLB_NOXOR);									\
 	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_WRITE(spacenum, 2, address, data);										\
 																						\
@@ -2634,7 +2927,9 @@ void name(offs_t address, UINT16 data)													\
 void name(offs_t address, UINT16 data)													\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMWRITESTART();																	\
+	PERFORM_TLB_WRITE(spacenum,~1,UINT16,xormacro);										\
 	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_WRITE(spacenum, 2, address, data);										\
 																						\
@@ -2666,7 +2961,9 @@ void name(offs_t address, UINT16 data)													\
 void name(offs_t address, UINT32 data)													\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMWRITESTART();																	\
+	PERFORM_TLB_WRITE(spacenum,~3,UINT32,TLB_NOXOR);									\
 	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_WRITE(spacenum, 4, address, data);										\
 																						\
@@ -2684,7 +2981,9 @@ void name(offs_t address, UINT32 data)													\
 void name(offs_t address, UINT32 data)													\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMWRITESTART();																	\
+	PERFORM_TLB_WRITE(spacenum,~3,UINT32,xormacro);										\
 	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_WRITE(spacenum, 4, address, data);										\
 																						\
@@ -2714,7 +3013,9 @@ void name(offs_t address, UINT32 data)													\
 void name(offs_t address, UINT64 data)													\
 {																						\
 	UINT32 entry;																		\
+	UINT8 *base;																		\
 	MEMWRITESTART();																	\
+	PERFORM_TLB_WRITE(spacenum,~7,UINT64,TLB_NOXOR);									\
 	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~7);						\
 	DEBUG_HOOK_WRITE(spacenum, 8, address, data);										\
 																						\
@@ -600,6 +600,12 @@ struct _address_space
 	handler_data *		readhandlers;		/* read handlers */
 	handler_data *		writehandlers;		/* write handlers */
 	data_accessors *	accessors;			/* pointers to the data access handlers */
+	UINT8 **			readtlb;			/* direct read pointer for each page, or NULL */
+	UINT8 **			writetlb;			/* direct write pointer for each page, or NULL */
+	UINT8				tlbshift;			/* shift to get the page from an address */
+	UINT8				bytexor;			/* address xor to access a byte in a direct page */
+	UINT8				wordxor;			/* address xor to access a word in a direct page */
+	UINT8				dwordxor;			/* address xor to access a dword in a direct page */
 };
 typedef struct _address_space address_space;
 
@@ -737,6 +743,8 @@ extern const char *address_space_names[ADDRESS_SPACES];
 /* ----- bit counts ----- */
 #define LEVEL1_BITS				18						/* number of address bits in the level 1 table */
 #define LEVEL2_BITS				(32 - LEVEL1_BITS)		/* number of address bits in the level 2 table */
+#define TLB_MIN_SHIFT			8						/* smallest direct page is 256 bytes */
+#define TLB_MAX_BITS			14						/* no more than 16384 direct pages per address space */
 
 /* ----- other address map constants ----- */
 #define MAX_ADDRESS_MAP_SIZE	256						/* maximum entries in an address map */
@@ -1066,25 +1074,89 @@ extern address_map *	construct_map_0(address_map *map);
 #define memory_install_write64_matchmask_handler(cpu, space, start, end, mask, mirror, handler)			\
 	_memory_install_write64_matchmask_handler(cpu, space, start, end, mask, mirror, handler, #handler)
 
+/* ----- direct access to the RAM, ROM and bank pages, with fallback to the accessors ----- */
+INLINE UINT8 memory_tlb_read_byte(int spacenum, offs_t offset)
+{
+	address_space *space = &active_address_space[spacenum];
+	offs_t address = offset & space->addrmask;
+	UINT8 *base = space->readtlb[address >> space->tlbshift];
+	if (base != NULL)
+		return base[address ^ space->bytexor];
+	return (*space->accessors->read_byte)(offset);
+}
+
+INLINE UINT16 memory_tlb_read_word(int spacenum, offs_t offset)
+{
+	address_space *space = &active_address_space[spacenum];
+	offs_t address = offset & space->addrmask & ~1;
+	UINT8 *base = space->readtlb[address >> space->tlbshift];
+	if (base != NULL)
+		return *(UINT16 *)&base[address ^ space->wordxor];
+	return (*space->accessors->read_word)(offset);
+}
+
+INLINE UINT32 memory_tlb_read_dword(int spacenum, offs_t offset)
+{
+	address_space *space = &active_address_space[spacenum];
+	offs_t address = offset & space->addrmask & ~3;
+	UINT8 *base = space->readtlb[address >> space->tlbshift];
+	if (base != NULL)
+		return *(UINT32 *)&base[address ^ space->dwordxor];
+	return (*space->accessors->read_dword)(offset);
+}
+
+INLINE void memory_tlb_write_byte(int spacenum, offs_t offset, UINT8 data)
+{
+	address_space *space = &active_address_space[spacenum];
+	offs_t address = offset & space->addrmask;
+	UINT8 *base = space->writetlb[address >> space->tlbshift];
+	if (base != NULL)
+		base[address ^ space->bytexor] = data;
+	else
+		(*space->accessors->write_byte)(offset, data);
+}
+
+INLINE void memory_tlb_write_word(int spacenum, offs_t offset, UINT16 data)
+{
+	address_space *space = &active_address_space[spacenum];
+	offs_t address = offset & space->addrmask & ~1;
+	UINT8 *base = space->writetlb[address >> space->tlbshift];
+	if (base != NULL)
+		*(UINT16 *)&base[address ^ space->wordxor] = data;
+	else
+		(*space->accessors->write_word)(offset, data);
+}
+
+INLINE void memory_tlb_write_dword(int spacenum, offs_t offset, UINT32 data)
+{
+	address_space *space = &active_address_space[spacenum];
+	offs_t address = offset & space->addrmask & ~3;
+	UINT8 *base = space->writetlb[address >> space->tlbshift];
+	if (base != NULL)
+		*(UINT32 *)&base[address ^ space->dwordxor] = data;
+	else
+		(*space->accessors->write_dword)(offset, data);
+}
+
 /* ----- generic memory access ----- */
-INLINE UINT8  program_read_byte (offs_t offset) { return (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->read_byte)(offset); }
-INLINE UINT16 program_read_word (offs_t offset) { return (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->read_word)(offset); }
-INLINE UINT32 program_read_dword(offs_t offset) { return (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->read_dword)(offset); }
+INLINE UINT8  program_read_byte (offs_t offset) { return memory_tlb_read_byte(ADDRESS_SPACE_PROGRAM, offset); }
+INLINE UINT16 program_read_word (offs_t offset) { return memory_tlb_read_word(ADDRESS_SPACE_PROGRAM, offset); }
+INLINE UINT32 program_read_dword(offs_t offset) { return memory_tlb_read_dword(ADDRESS_SPACE_PROGRAM, offset); }
 INLINE UINT64 program_read_qword(offs_t offset) { return (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->read_qword)(offset); }
 
-INLINE void	program_write_byte (offs_t offset, UINT8  data) { (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->write_byte)(offset, data); }
-INLINE void	program_write_word (offs_t offset, UINT16 data) { (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->write_word)(offset, data); }
-INLINE void	program_write_dword(offs_t offset, UINT32 data) { (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->write_dword)(offset, data); }
+INLINE void	program_write_byte (offs_t offset, UINT8  data) { memory_tlb_write_byte(ADDRESS_SPACE_PROGRAM, offset, data); }
+INLINE void	program_write_word (offs_t offset, UINT16 data) { memory_tlb_write_word(ADDRESS_SPACE_PROGRAM, offset, data); }
+INLINE void	program_write_dword(offs_t offset, UINT32 data) { memory_tlb_write_dword(ADDRESS_SPACE_PROGRAM, offset, data); }
 INLINE void	program_write_qword(offs_t offset, UINT64 data) { (*active_address_space[ADDRESS_SPACE_PROGRAM].accessors->write_qword)(offset, data); }
 
-INLINE UINT8  data_read_byte (offs_t offset) { return (*active_address_space[ADDRESS_SPACE_DATA].accessors->read_byte)(offset); }
-INLINE UINT16 data_read_word (offs_t offset) { return (*active_address_space[ADDRESS_SPACE_DATA].accessors->read_word)(offset); }
-INLINE UINT32 data_read_dword(offs_t offset) { return (*active_address_space[ADDRESS_SPACE_DATA].accessors->read_dword)(offset); }
+INLINE UINT8  data_read_byte (offs_t offset) { return memory_tlb_read_byte(ADDRESS_SPACE_DATA, offset); }
+INLINE UINT16 data_read_word (offs_t offset) { return memory_tlb_read_word(ADDRESS_SPACE_DATA, offset); }
+INLINE UINT32 data_read_dword(offs_t offset) { return memory_tlb_read_dword(ADDRESS_SPACE_DATA, offset); }
 INLINE UINT64 data_read_qword(offs_t offset) { return (*active_address_space[ADDRESS_SPACE_DATA].accessors->read_qword)(offset); }
 
-INLINE void	data_write_byte (offs_t offset, UINT8  data) { (*active_address_space[ADDRESS_SPACE_DATA].accessors->write_byte)(offset, data); }
-INLINE void	data_write_word (offs_t offset, UINT16 data) { (*active_address_space[ADDRESS_SPACE_DATA].accessors->write_word)(offset, data); }
-INLINE void	data_write_dword(offs_t offset, UINT32 data) { (*active_address_space[ADDRESS_SPACE_DATA].accessors->write_dword)(offset, data); }
+INLINE void	data_write_byte (offs_t offset, UINT8  data) { memory_tlb_write_byte(ADDRESS_SPACE_DATA, offset, data); }
+INLINE void	data_write_word (offs_t offset, UINT16 data) { memory_tlb_write_word(ADDRESS_SPACE_DATA, offset, data); }
+INLINE void	data_write_dword(offs_t offset, UINT32 data) { memory_tlb_write_dword(ADDRESS_SPACE_DATA, offset, data); }
 INLINE void	data_write_qword(offs_t offset, UINT64 data) { (*active_address_space[ADDRESS_SPACE_DATA].accessors->write_qword)(offset, data); }
 
 INLINE UINT8  io_read_byte (offs_t offset) { return (*active_address_space[ADDRESS_SPACE_IO].accessors->read_byte)(offset); }
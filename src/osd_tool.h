@@ -28,4 +28,18 @@ UINT32 osd_tool_fread(osd_tool_file *file, UINT64 offset, UINT32 count, void *bu
 UINT32 osd_tool_fwrite(osd_tool_file *file, UINT64 offset, UINT32 count, const void *buffer);
 UINT64 osd_tool_flength(osd_tool_file *file);
 
+/* optional parallel execution; osd_tool_group_alloc() returns NULL if unsupported */
+typedef struct _osd_tool_group osd_tool_group;
+osd_tool_group *osd_tool_group_alloc(void);
+void osd_tool_group_free(osd_tool_group *group);
+void osd_tool_group_run(osd_tool_group *group, void (*task)(void *param), void *param);
+void osd_tool_group_wait(osd_tool_group *group);
+
+/* optional locks; osd_tool_lock_alloc() returns NULL if unsupported */
+typedef struct _osd_tool_lock osd_tool_lock;
+osd_tool_lock *osd_tool_lock_alloc(void);
+void osd_tool_lock_free(osd_tool_lock *lock);
+void osd_tool_lock_acquire(osd_tool_lock *lock);
+void osd_tool_lock_release(osd_tool_lock *lock);
+
 #endif /* __OSD_TOOL_H__ */
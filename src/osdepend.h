@@ -83,6 +83,14 @@ void osd_close_display(void);
 int osd_skip_this_frame(void);
 
 
+/*
+  Wait until the core can draw in the screen bitmap. The OSD layer can pass
+  the screen bitmap to another thread, which fills the next one with the
+  current frame while the core emulates the next frame.
+*/
+void osd_wait_for_screen(void);
+
+
 /*
   Update video and audio. game_bitmap contains the game display, while
   debug_bitmap an image of the debugger window (if the debugger is active; NULL
@@ -140,6 +148,10 @@ const char *osd_get_fps_text(const performance_info *performance);
   to the reference value of Machine->sample_rate / Machine->drv->frames_per_second.
   Of course that value is not necessarily an integer so at least a +/- 1
   adjustment is necessary to avoid drifting over time.
+
+  The buffer passed to osd_update_audio_stream() remains valid and unchanged
+  until the next call, so the OSD can play it from another thread without
+  copying it.
 */
 int osd_start_audio_stream(int stereo);
 int osd_update_audio_stream(INT16 *buffer);
@@ -293,6 +305,26 @@ UINT32 osd_fwrite(osd_file *file, const void *buffer, UINT32 length);
 /* Close an open file */
 void osd_fclose(osd_file *file);
 
+/*
+  Map a whole file in memory for reading. The mapping remains valid until
+  osd_funmap() even if the file is closed. Returns NULL if the mapping isn't
+  supported or if it fails, and in this case the file must be read with
+  osd_fread().
+*/
+void *osd_fmap(int pathtype, int pathindex, const char *filename, UINT64 *length);
+void osd_funmap(void *data, UINT64 length);
+
+/*
+  Persistent cache of the checksums of the files. A checksum is identified
+  by the file and by the name of the entry for a file in an archive (NULL
+  for a plain file), and it's valid until the file is changed. The hash
+  data uses the format of hash.c, and the buffer must be HASH_BUF_SIZE long.
+  osd_hash_cache_get() returns 0 if the checksum was found. They are called
+  only from the main thread.
+*/
+int osd_hash_cache_get(int pathtype, int pathindex, const char *filename, const char *entry, char *hash);
+void osd_hash_cache_set(int pathtype, int pathindex, const char *filename, const char *entry, const char *hash);
+
 
 
 /******************************************************************************
@@ -314,6 +346,55 @@ cycles_t osd_cycles_per_second(void);
    it isn't necessary to know the number of ticks per seconds. */
 cycles_t osd_profiling_ticks(void);
 
+/* return the number of profiling ticks per second */
+cycles_t osd_profiling_ticks_per_second(void);
+
+
+
+/******************************************************************************
+
+    Parallel execution
+
+******************************************************************************/
+
+/*
+  All these functions return only when all the work is done, and they can be
+  called from inside a running task. When the OS dependent code doesn't
+  support threads, the work is executed serially in the calling thread.
+
+  osd_parallelize() calls task(param, task_num, task_count) task_count times,
+  with task_count<=max_tasks and task_num from zero to task_count-1.
+
+  osd_parallel_for() splits the range [0, count) in chunks of chunk items
+  (the last one may be smaller) and calls task(param, begin, end) once for
+  every chunk. The order of the calls is not specified.
+
+  A task group runs a set of independent tasks. osd_task_group_run() queues
+  a task, osd_task_group_wait() waits the end of all the queued tasks. A group
+  must be used by only one thread and it can be reused after a wait.
+*/
+typedef struct _osd_task_group osd_task_group;
+
+void osd_parallelize(void (*task)(void *param, int task_num, int task_count), void *param, int max_tasks);
+void osd_parallel_for(void (*task)(void *param, int begin, int end), void *param, int count, int chunk);
+
+osd_task_group *osd_task_group_alloc(void);
+void osd_task_group_free(osd_task_group *group);
+void osd_task_group_run(osd_task_group *group, void (*task)(void *param), void *param);
+void osd_task_group_wait(osd_task_group *group);
+
+/*
+  A lock serializes the accesses of several threads to a shared state. It
+  isn't recursive. When the OS dependent code doesn't support threads, the
+  lock does nothing.
+*/
+typedef struct _osd_lock osd_lock;
+
+osd_lock *osd_lock_alloc(void);
+void osd_lock_free(osd_lock *lock);
+void osd_lock_acquire(osd_lock *lock);
+void osd_lock_release(osd_lock *lock);
+
 
 
 /******************************************************************************
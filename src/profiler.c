@@ -32,25 +32,264 @@ static int use_profiler;
 
 #define MEMORY 6
 
-struct _profile_data
+/* limits of each thread */
+#define MAX_DEPTH	32
+#define MAX_NODES	1024
+
+struct _profiler_frame
 {
+	int node;							/* node of the scope */
+	cycles_t start;						/* ticks at the begin of the scope */
+	cycles_t children;					/* ticks spent in the nested scopes */
+};
+typedef struct _profiler_frame profiler_frame;
+
+struct _profiler_thread
+{
+	struct _profiler_thread *next;		/* next thread in the list */
+	int generation;						/* generation of the data, reset if old */
+
+	/* stack of the open scopes */
+	int depth;
+	int overflow;						/* scopes not entered because the stack is full */
+	profiler_frame stack[MAX_DEPTH];
+
+	/* call tree, the node 0 is the root */
+	int node_count;
+	profiler_node node[MAX_NODES];
+
+	/* trace, only allocated if requested */
+	int event_count;
+	int event_max;
+	profiler_event *event;
+
+	/* exclusive time of each type for the text report */
 	UINT64 count[MEMORY][PROFILER_TOTAL];
 	unsigned int cpu_context_switches[MEMORY];
 };
-typedef struct _profile_data profile_data;
+typedef struct _profiler_thread profiler_thread;
+
+struct _profiler_scope
+{
+	char name[32];						/* name of the scope */
+	int type;							/* PROFILER_* type where the time is accounted */
+};
+typedef struct _profiler_scope profiler_scope;
 
-static profile_data profile;
 static int memory;
 
+/* all the threads, only the owner thread writes its data */
+static THREAD_LOCAL profiler_thread *current_thread;
+static profiler_thread *thread_list;
+static int thread_count;
+static osd_lock *thread_lock;
+
+/* incremented to reset the data of all the threads */
+static volatile int generation;
+static cycles_t start_ticks;
+static int trace_events;
+
+static profiler_scope scopes[PROFILER_MAX_SCOPES];
+static int scope_count;
+
+/* names without spaces, for the machine-readable reports */
+static const char *tags[PROFILER_TOTAL] =
+{
+	"cpu1",
+	"cpu2",
+	"cpu3",
+	"cpu4",
+	"cpu5",
+	"cpu6",
+	"cpu7",
+	"cpu8",
+	"memread",
+	"memwrite",
+	"video",
+	"drawgfx",
+	"copybitmap",
+	"tilemap_draw",
+	"tilemap_draw_roz",
+	"tilemap_update",
+	"artwork",
+	"blit",
+	"sound",
+	"mixer",
+	"timer_callback",
+	"hiscore",
+	"input",
+	"movie_rec",
+	"logerror",
+	"extra",
+	"user1",
+	"user2",
+	"user3",
+	"user4",
+	"profiler",
+	"idle",
+};
+
+/* get the data of the current thread, resetting it if old */
+static profiler_thread *profiler_thread_get(void)
+{
+	profiler_thread *thread = current_thread;
+
+	if (thread != NULL && thread->generation == generation)
+		return thread;
+
+	/* the first time register the thread */
+	if (thread == NULL)
+	{
+		thread = malloc(sizeof(*thread));
+		if (thread == NULL)
+			return NULL;
+		memset(thread, 0, sizeof(*thread));
+
+		osd_lock_acquire(thread_lock);
+		thread->next = thread_list;
+		thread_list = thread;
+		thread_count++;
+		osd_lock_release(thread_lock);
+
+		current_thread = thread;
+	}
+
+	thread->generation = generation;
+	thread->depth = 0;
+	thread->overflow = 0;
+	memset(thread->count, 0, sizeof(thread->count));
+	memset(thread->cpu_context_switches, 0, sizeof(thread->cpu_context_switches));
+
+	/* the root of the call tree */
+	thread->node_count = 1;
+	thread->node[0].scope = PROFILER_END;
+	thread->node[0].parent = -1;
+	thread->node[0].child = -1;
+	thread->node[0].sibling = -1;
+	thread->node[0].calls = 0;
+	thread->node[0].total = 0;
+	thread->node[0].self = 0;
+
+	/* the trace buffer is kept between the runs */
+	thread->event_count = 0;
+	if (thread->event_max != trace_events)
+	{
+		free(thread->event);
+		thread->event = trace_events ? malloc(trace_events * sizeof(profiler_event)) : NULL;
+		thread->event_max = thread->event ? trace_events : 0;
+	}
+
+	return thread;
+}
+
+/* get the child node of a scope, creating it if missing */
+static int profiler_thread_node(profiler_thread *thread, int parent, int scope)
+{
+	profiler_node *node;
+	int i;
+
+	for (i = thread->node[parent].child; i >= 0; i = thread->node[i].sibling)
+		if (thread->node[i].scope == scope)
+			return i;
+
+	/* if the tree is full, account the time to the parent */
+	if (thread->node_count >= MAX_NODES)
+		return parent;
+
+	i = thread->node_count++;
+	node = &thread->node[i];
+	node->scope = scope;
+	node->parent = parent;
+	node->child = -1;
+	node->sibling = thread->node[parent].child;
+	node->calls = 0;
+	node->total = 0;
+	node->self = 0;
+	thread->node[parent].child = i;
+
+	return i;
+}
+
+/* the PROFILER_* types are the first scopes */
+static void profiler_scope_init(void)
+{
+	int i;
+
+	if (scope_count != 0)
+		return;
+
+	for (i = 0; i < PROFILER_TOTAL; i++)
+	{
+		strcpy(scopes[i].name, tags[i]);
+		scopes[i].type = i;
+	}
+	scope_count = PROFILER_TOTAL;
+}
+
+/* lock the list of the threads, the new threads are added at any time */
+static void profiler_thread_lock(void)
+{
+	if (thread_lock != NULL)
+		osd_lock_acquire(thread_lock);
+}
+
+static void profiler_thread_unlock(void)
+{
+	if (thread_lock != NULL)
+		osd_lock_release(thread_lock);
+}
+
+/* sum the counters of a frame of all the threads */
+static UINT64 profiler_thread_count(int frame, int type)
+{
+	profiler_thread *thread;
+	UINT64 computed = 0;
+
+	profiler_thread_lock();
+	for (thread = thread_list; thread != NULL; thread = thread->next)
+		if (thread->generation == generation)
+			computed += thread->count[frame][type];
+	profiler_thread_unlock();
+	return computed;
+}
+
+int profiler_scope_register(const char *name, int type)
+{
+	int i;
+
+	profiler_scope_init();
+
+	/* the scopes are kept between the games, reuse the ones with the same name */
+	for (i = PROFILER_TOTAL; i < scope_count; i++)
+		if (strcmp(scopes[i].name, name) == 0)
+			return i;
 
-static int FILO_type[10];
-static cycles_t FILO_start[10];
-static int FILO_length;
+	if (scope_count >= PROFILER_MAX_SCOPES)
+	{
+logerror("Profiler error: too many scopes\n");
+		return type;
+	}
+
+	i = scope_count++;
+	strncpy(scopes[i].name, name, sizeof(scopes[i].name) - 1);
+	scopes[i].name[sizeof(scopes[i].name) - 1] = 0;
+	scopes[i].type = type;
+
+	return i;
+}
 
 void profiler_start(void)
 {
+	profiler_scope_init();
+
+	if (thread_lock == NULL)
+		thread_lock = osd_lock_alloc();
+
+	/* the threads reset their data at the next mark */
+	generation++;
+	start_ticks = osd_profiling_ticks();
+	memory = 0;
 	use_profiler = 1;
-	FILO_length = 0;
 }
 
 void profiler_stop(void)
@@ -58,59 +297,171 @@ void profiler_stop(void)
 	use_profiler = 0;
 }
 
-void profiler_mark(int type)
+void profiler_set_trace(int events)
 {
-	cycles_t curr_cycles;
+	trace_events = events;
+}
 
+void profiler_scope_begin(int scope)
+{
+	profiler_thread *thread;
+	profiler_frame *frame;
+	int type;
 
 	if (!use_profiler)
+		return;
+
+	thread = profiler_thread_get();
+	if (thread == NULL)
+		return;
+
+	if (thread->depth >= MAX_DEPTH)
 	{
-		FILO_length = 0;
+		if (thread->overflow++ == 0)
+logerror("Profiler error: FILO buffer overflow\n");
 		return;
 	}
 
+	type = scopes[scope].type;
 	if (type >= PROFILER_CPU1 && type <= PROFILER_CPU8)
-		profile.cpu_context_switches[memory]++;
+		thread->cpu_context_switches[memory]++;
+
+	frame = &thread->stack[thread->depth];
+	frame->node = profiler_thread_node(thread, thread->depth > 0 ? frame[-1].node : 0, scope);
+	frame->children = 0;
+	thread->depth++;
+
+	frame->start = osd_profiling_ticks();
+
+	if (thread->event_count < thread->event_max)
+	{
+		profiler_event *event = &thread->event[thread->event_count++];
+		event->ticks = frame->start - start_ticks;
+		event->scope = scope;
+	}
+}
+
+void profiler_scope_end(void)
+{
+	profiler_thread *thread;
+	profiler_frame *frame;
+	profiler_node *node;
+	cycles_t curr_cycles;
+	cycles_t elapsed;
+
+	if (!use_profiler)
+		return;
 
 	curr_cycles = osd_profiling_ticks();
 
-	if (type != PROFILER_END)
+	/* the scopes opened before a reset are ignored */
+	thread = current_thread;
+	if (thread == NULL || thread->generation != generation || thread->depth == 0)
+		return;
+
+	if (thread->overflow > 0)
 	{
-		if (FILO_length > 0)
-		{
-			if (FILO_length >= 10)
-			{
-logerror("Profiler error: FILO buffer overflow\n");
-				return;
-			}
+		thread->overflow--;
+		return;
+	}
 
-			/* handle nested calls */
-			profile.count[memory][FILO_type[FILO_length-1]] += curr_cycles - FILO_start[FILO_length-1];
-		}
-		FILO_type[FILO_length] = type;
-		FILO_start[FILO_length] = curr_cycles;
-		FILO_length++;
+	frame = &thread->stack[--thread->depth];
+	node = &thread->node[frame->node];
+	elapsed = curr_cycles - frame->start;
+
+	node->calls++;
+	node->total += elapsed;
+	node->self += elapsed - frame->children;
+	thread->count[memory][scopes[node->scope].type] += elapsed - frame->children;
+
+	/* handle nested calls */
+	if (thread->depth > 0)
+		frame[-1].children += elapsed;
+
+	if (thread->event_count < thread->event_max)
+	{
+		profiler_event *event = &thread->event[thread->event_count++];
+		event->ticks = curr_cycles - start_ticks;
+		event->scope = PROFILER_END;
 	}
+}
+
+void profiler_mark(int type)
+{
+	if (type != PROFILER_END)
+		profiler_scope_begin(type);
 	else
-	{
-		if (FILO_length <= 0)
-		{
-logerror("Profiler error: FILO buffer underflow\n");
-			return;
-		}
+		profiler_scope_end();
+}
 
-		FILO_length--;
-		profile.count[memory][FILO_type[FILO_length]] += curr_cycles - FILO_start[FILO_length];
-		if (FILO_length > 0)
-		{
-			/* handle nested calls */
-			FILO_start[FILO_length-1] = curr_cycles;
-		}
-	}
+const char *profiler_get_tag(int type)
+{
+	if (type < 0 || type >= PROFILER_TOTAL)
+		return NULL;
+	return tags[type];
+}
+
+UINT64 profiler_get_ticks(int type)
+{
+	UINT64 computed = 0;
+	int j;
+
+	/* the counters of all the frames still in memory */
+	for (j = 0;j < MEMORY;j++)
+		computed += profiler_thread_count(j, type);
+	return computed;
+}
+
+const char *profiler_get_scope_name(int scope)
+{
+	if (scope < 0 || scope >= scope_count)
+		return NULL;
+	return scopes[scope].name;
+}
+
+int profiler_get_thread_count(void)
+{
+	return thread_count;
+}
+
+/* get a thread by index, only if it has data of the last run */
+static profiler_thread *profiler_thread_find(int index)
+{
+	profiler_thread *thread;
+
+	profiler_thread_lock();
+	thread = thread_list;
+
+	/* the list has the most recent thread first */
+	index = thread_count - 1 - index;
+	while (thread != NULL && index-- > 0)
+		thread = thread->next;
+	profiler_thread_unlock();
+
+	if (thread == NULL || thread->generation != generation)
+		return NULL;
+	return thread;
+}
+
+const profiler_node *profiler_get_nodes(int thread, int *count)
+{
+	profiler_thread *data = profiler_thread_find(thread);
+
+	*count = data ? data->node_count : 0;
+	return data ? data->node : NULL;
+}
+
+const profiler_event *profiler_get_events(int thread, int *count)
+{
+	profiler_thread *data = profiler_thread_find(thread);
+
+	*count = data ? data->event_count : 0;
+	return data ? data->event : NULL;
 }
 
 const char *profiler_get_text(void)
 {
+	profiler_thread *thread;
 	int i,j;
 	UINT64 total,normalize;
 	UINT64 computed;
@@ -163,14 +514,14 @@ const char *profiler_get_text(void)
 	while (i < PROFILER_PROFILER)
 	{
 		for (j = 0;j < MEMORY;j++)
-			computed += profile.count[j][i];
+			computed += profiler_thread_count(j, i);
 		i++;
 	}
 	normalize = computed;
 	while (i < PROFILER_TOTAL)
 	{
 		for (j = 0;j < MEMORY;j++)
-			computed += profile.count[j][i];
+			computed += profiler_thread_count(j, i);
 		i++;
 	}
 	total = computed;
@@ -182,7 +533,7 @@ const char *profiler_get_text(void)
 		computed = 0;
 		{
 			for (j = 0;j < MEMORY;j++)
-				computed += profile.count[j][i];
+				computed += profiler_thread_count(j, i);
 		}
 		if (computed || showdelay[i])
 		{
@@ -199,16 +550,25 @@ const char *profiler_get_text(void)
 		}
 	}
 
+	profiler_thread_lock();
+
 	i = 0;
-	for (j = 0;j < MEMORY;j++)
-		i += profile.cpu_context_switches[j];
+	for (thread = thread_list; thread != NULL; thread = thread->next)
+		if (thread->generation == generation)
+			for (j = 0;j < MEMORY;j++)
+				i += thread->cpu_context_switches[j];
 	bufptr += sprintf(bufptr,"CPU switches%4d\n",i / MEMORY);
 
 	/* reset the counters */
 	memory = (memory + 1) % MEMORY;
-	profile.cpu_context_switches[memory] = 0;
-	for (i = 0;i < PROFILER_TOTAL;i++)
-		profile.count[memory][i] = 0;
+	for (thread = thread_list; thread != NULL; thread = thread->next)
+	{
+		thread->cpu_context_switches[memory] = 0;
+		for (i = 0;i < PROFILER_TOTAL;i++)
+			thread->count[memory][i] = 0;
+	}
+
+	profiler_thread_unlock();
 
 	profiler_mark(PROFILER_END);
 
@@ -64,18 +64,77 @@ to end profiling the current section:
 profiler_mark(PROFILER_END);
 
 the profiler handles a FILO list so calls may be nested.
+
+The PROFILER_* types are also the first scopes of the hierarchical
+profiler. More scopes can be registered at init time, for example one
+for each CPU or sound chip, and they are accounted to the type given
+at the registration in the text report:
+
+scope = profiler_scope_register("cpu1:z80", PROFILER_CPU1);
+...
+profiler_scope_begin(scope);
+...
+profiler_scope_end();
+
+Every thread keeps its own call tree of the nested scopes, and if
+requested, a trace of all the begin and end events. The threads
+never share what they write, so no lock is needed to profile.
 */
 
-#ifdef MAME_DEBUG
+/* maximum number of scopes, the PROFILER_* types included */
+#define PROFILER_MAX_SCOPES		256
+
+/* a node of the call tree of a thread */
+typedef struct _profiler_node profiler_node;
+struct _profiler_node
+{
+	int		scope;				/* scope of the node, PROFILER_END for the root */
+	int		parent;				/* parent node, -1 for the root */
+	int		child;				/* first child node, -1 if none */
+	int		sibling;			/* next node with the same parent, -1 if none */
+	UINT32	calls;				/* number of times the scope was entered */
+	UINT64	total;				/* ticks spent in the scope, children included */
+	UINT64	self;				/* ticks spent in the scope, children excluded */
+};
+
+/* a begin or end event of the trace of a thread */
+typedef struct _profiler_event profiler_event;
+struct _profiler_event
+{
+	UINT64	ticks;				/* ticks from the start of the profiler */
+	int		scope;				/* scope entered, PROFILER_END if exited */
+};
+
+#if defined(MAME_DEBUG) || defined(MAME_PROFILER)
 void profiler_mark(int type);
 
+/* scopes of the hierarchical profiler */
+int profiler_scope_register(const char *name, int type);
+void profiler_scope_begin(int scope);
+void profiler_scope_end(void);
+
 /* functions called by usrintf.c */
 void profiler_start(void);
 void profiler_stop(void);
 const char *profiler_get_text(void);
+
+/* functions called by the OSD benchmark */
+const char *profiler_get_tag(int type);
+UINT64 profiler_get_ticks(int type);
+
+/* functions called by the OSD to export the call trees and the traces */
+void profiler_set_trace(int events);
+const char *profiler_get_scope_name(int scope);
+int profiler_get_thread_count(void);
+const profiler_node *profiler_get_nodes(int thread, int *count);
+const profiler_event *profiler_get_events(int thread, int *count);
 #else
 #define profiler_mark(type)
 
+#define profiler_scope_register(name,type) (type)
+#define profiler_scope_begin(scope)
+#define profiler_scope_end()
+
 #define profiler_start()
 #define profiler_stop()
 #define profiler_get_text() ""
@@ -24,6 +24,11 @@
 //#define LOG_LOAD
 
 
+/* bytes of the files read in advance and not yet used; a single larger */
+/* file is still read */
+#define PREFETCH_BYTES		(32 << 20)
+
+
 
 /***************************************************************************
 
@@ -411,7 +416,7 @@ static int display_rom_load_results(rom_load_data *romdata)
     byte swapping and inverting data as necessary
 -------------------------------------------------*/
 
-static void region_post_process(rom_load_data *romdata, const rom_entry *regiondata)
+static void region_post_process(UINT8 *regionbase, UINT32 regionlength, const rom_entry *regiondata)
 {
 	int type = ROMREGION_GETTYPE(regiondata);
 	int datawidth = ROMREGION_GETWIDTH(regiondata) / 8;
@@ -437,7 +442,7 @@ static void region_post_process(rom_load_data *romdata, const rom_entry *regiond
 	if (ROMREGION_ISINVERTED(regiondata))
 	{
 		debugload("+ Inverting region\n");
-		for (i = 0, base = romdata->regionbase; i < romdata->regionlength; i++)
+		for (i = 0, base = regionbase; i < regionlength; i++)
 			*base++ ^= 0xff;
 	}
 
@@ -449,7 +454,7 @@ static void region_post_process(rom_load_data *romdata, const rom_entry *regiond
 #endif
 	{
 		debugload("+ Byte swapping region\n");
-		for (i = 0, base = romdata->regionbase; i < romdata->regionlength; i += datawidth)
+		for (i = 0, base = regionbase; i < regionlength; i += datawidth)
 		{
 			UINT8 temp[8];
 			memcpy(temp, base, datawidth);
@@ -460,6 +465,223 @@ static void region_post_process(rom_load_data *romdata, const rom_entry *regiond
 }
 
 
+/*-------------------------------------------------
+    region_post_process_task - post-process a
+    region from a worker thread
+-------------------------------------------------*/
+
+struct region_post_process_param
+{
+	const rom_entry *	regiondata;
+	UINT8 *				regionbase;
+	UINT32				regionlength;
+};
+
+static void region_post_process_task(void *param)
+{
+	struct region_post_process_param *region = param;
+
+	region_post_process(region->regionbase, region->regionlength, region->regiondata);
+}
+
+
+/*-------------------------------------------------
+    prefetch_prepare_task - decompress and hash
+    a prefetched file from a worker thread
+-------------------------------------------------*/
+
+struct _rom_prefetch
+{
+	mame_file *			file;
+	UINT32				length;
+	osd_task_group *	group;
+	int					result;
+};
+
+static void prefetch_prepare_task(void *param)
+{
+	struct _rom_prefetch *prefetch = param;
+
+	prefetch->result = mame_fprepare(prefetch->file);
+}
+
+
+/*-------------------------------------------------
+    prefetch_is_loaded - return if a ROM entry is
+    a file loaded with the current BIOS
+-------------------------------------------------*/
+
+INLINE int prefetch_is_loaded(const rom_entry *romp)
+{
+	return ROMENTRY_ISFILE(romp) && (!ROM_GETBIOSFLAGS(romp) || (ROM_GETBIOSFLAGS(romp) == (system_bios+1)));
+}
+
+
+/*-------------------------------------------------
+    prefetch_init - prepare to open the ROM files
+    of all the regions in the same order used by
+    process_rom_entries
+-------------------------------------------------*/
+
+static void prefetch_init(rom_load_data *romdata, const rom_entry *romp)
+{
+	const rom_entry *region, *entry;
+	int count;
+
+	/* count the files to load */
+	count = 0;
+	for (region = romp; region; region = rom_next_region(region))
+		if (ROMREGION_ISROMDATA(region))
+			for (entry = region + 1; !ROMENTRY_ISREGIONEND(entry); entry++)
+				if (prefetch_is_loaded(entry))
+					count++;
+	if (count == 0)
+		return;
+
+	/* without memory, open_rom_file opens the files itself */
+	romdata->prefetch = malloc(count * sizeof(romdata->prefetch[0]));
+	if (!romdata->prefetch)
+		return;
+
+	romdata->prefetchcount = count;
+	romdata->prefetchregion = romp;
+	romdata->prefetchentry = romp + 1;
+}
+
+
+/*-------------------------------------------------
+    prefetch_next_entry - return the entry of the
+    next file to open, moving through the regions
+-------------------------------------------------*/
+
+static const rom_entry *prefetch_next_entry(rom_load_data *romdata)
+{
+	while (romdata->prefetchregion)
+	{
+		if (ROMREGION_ISROMDATA(romdata->prefetchregion))
+			for (; !ROMENTRY_ISREGIONEND(romdata->prefetchentry); romdata->prefetchentry++)
+				if (prefetch_is_loaded(romdata->prefetchentry))
+					return romdata->prefetchentry++;
+
+		romdata->prefetchregion = rom_next_region(romdata->prefetchregion);
+		if (romdata->prefetchregion)
+			romdata->prefetchentry = romdata->prefetchregion + 1;
+	}
+
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    prefetch_fill - open the next ROM files, also
+    of the next regions, until PREFETCH_BYTES are
+    waiting to be used; the reads are serial, the
+    decompression and the checksum of every file
+    run as a task, while the previous files are
+    copied in their regions
+-------------------------------------------------*/
+
+static void prefetch_fill(rom_load_data *romdata)
+{
+	while (romdata->prefetchopen < romdata->prefetchcount
+		&& (romdata->prefetchopen == romdata->prefetchindex || romdata->prefetchbytes < PREFETCH_BYTES))
+	{
+		struct _rom_prefetch *prefetch = &romdata->prefetch[romdata->prefetchopen++];
+		const rom_entry *entry = prefetch_next_entry(romdata);
+		const game_driver *drv;
+		mame_file *file;
+
+		++romdata->romsloaded;
+
+		/* update status display */
+		file = NULL;
+		if (!osd_display_loading_rom_message(ROM_GETNAME(entry), romdata))
+		{
+			/* Attempt reading up the chain through the parents. It automatically also
+               attempts any kind of load by checksum supported by the archives. */
+			for (drv = Machine->gamedrv; !file && drv; drv = driver_get_clone(drv))
+				if (drv->name && *drv->name)
+					file = mame_fopen_rom_deferred(drv->name, ROM_GETNAME(entry), ROM_GETHASHDATA(entry));
+		}
+
+		prefetch->file = file;
+		prefetch->length = file ? mame_fsize(file) : 0;
+		prefetch->group = NULL;
+		prefetch->result = 0;
+		romdata->prefetchbytes += prefetch->length;
+
+		if (file)
+		{
+			prefetch->group = osd_task_group_alloc();
+			if (prefetch->group)
+				osd_task_group_run(prefetch->group, prefetch_prepare_task, prefetch);
+			else
+				prefetch_prepare_task(prefetch);
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+    prefetch_get - return the next prefetched
+    file, when it's ready
+-------------------------------------------------*/
+
+static mame_file *prefetch_get(rom_load_data *romdata)
+{
+	struct _rom_prefetch *prefetch;
+
+	/* keep the reads ahead of the copies */
+	prefetch_fill(romdata);
+
+	prefetch = &romdata->prefetch[romdata->prefetchindex++];
+	if (prefetch->group)
+	{
+		osd_task_group_wait(prefetch->group);
+		osd_task_group_free(prefetch->group);
+		prefetch->group = NULL;
+	}
+	romdata->prefetchbytes -= prefetch->length;
+
+	/* a file that cannot be decompressed is handled as missing */
+	if (prefetch->file && prefetch->result != 0)
+	{
+		mame_fclose(prefetch->file);
+		prefetch->file = NULL;
+	}
+
+	return prefetch->file;
+}
+
+
+/*-------------------------------------------------
+    prefetch_free - close the prefetched files
+    not used
+-------------------------------------------------*/
+
+static void prefetch_free(rom_load_data *romdata)
+{
+	for (; romdata->prefetchindex < romdata->prefetchopen; romdata->prefetchindex++)
+	{
+		struct _rom_prefetch *prefetch = &romdata->prefetch[romdata->prefetchindex];
+		if (prefetch->group)
+		{
+			osd_task_group_wait(prefetch->group);
+			osd_task_group_free(prefetch->group);
+		}
+		if (prefetch->file)
+			mame_fclose(prefetch->file);
+	}
+
+	free(romdata->prefetch);
+	romdata->prefetch = NULL;
+	romdata->prefetchcount = 0;
+	romdata->prefetchopen = 0;
+	romdata->prefetchindex = 0;
+	romdata->prefetchbytes = 0;
+}
+
+
 /*-------------------------------------------------
     open_rom_file - open a ROM file, searching
     up the parent and loading by checksum
@@ -469,6 +691,13 @@ static int open_rom_file(rom_load_data *romdata, const rom_entry *romp)
 {
 	const game_driver *drv;
 
+	/* use the file already opened by prefetch_fill */
+	if (romdata->prefetch)
+	{
+		romdata->file = prefetch_get(romdata);
+		return (romdata->file != NULL);
+	}
+
 	++romdata->romsloaded;
 
 	/* update status display */
@@ -932,9 +1161,12 @@ static int process_disk_entries(rom_load_data *romdata, const rom_entry *romp)
 int rom_init(const rom_entry *romp)
 {
 	const rom_entry *regionlist[REGION_MAX];
-	const rom_entry *region;
+	struct region_post_process_param postlist[REGION_MAX];
+	UINT8 copysource[REGION_MAX];
+	const rom_entry *region, *entry;
 	static rom_load_data romdata;
-	int regnum;
+	osd_task_group *group;
+	int regnum, result;
 
 	/* if no roms, bail */
 	if (romp == NULL)
@@ -953,6 +1185,19 @@ int rom_init(const rom_entry *romp)
 	/* determine the correct biosset to load based on options.bios string */
 	system_bios = determine_bios_rom(Machine->gamedrv->bios);
 
+	/* the regions read by a copy are post-processed only at the end, */
+	/* the others as soon as they are loaded */
+	memset(copysource, 0, sizeof(copysource));
+	for (region = romp; region; region = rom_next_region(region))
+		for (entry = region + 1; !ROMENTRY_ISREGIONEND(entry); entry++)
+			if (ROMENTRY_ISCOPY(entry) && (ROM_GETFLAGS(entry) >> 24) < REGION_MAX)
+				copysource[ROM_GETFLAGS(entry) >> 24] = 1;
+
+	/* the files are read ahead through all the regions */
+	prefetch_init(&romdata, romp);
+	group = osd_task_group_alloc();
+	result = 1;
+
 	/* loop until we hit the end */
 	for (region = romp, regnum = 0; region; region = rom_next_region(region), regnum++)
 	{
@@ -964,14 +1209,14 @@ int rom_init(const rom_entry *romp)
 		if (!ROMENTRY_ISREGION(region))
 		{
 			printf("Error: missing ROM_REGION header\n");
-			return 1;
+			goto cleanup;
 		}
 
 		/* allocate memory for the region */
 		if (new_memory_region(regiontype, ROMREGION_GETLENGTH(region), ROMREGION_GETFLAGS(region)) != 0)
 		{
 			printf("Error: unable to allocate memory for region %d\n", regiontype);
-			return 1;
+			goto cleanup;
 		}
 
 		/* remember the base and length */
@@ -997,29 +1242,55 @@ int rom_init(const rom_entry *romp)
 		if (ROMREGION_ISROMDATA(region))
 		{
 			if (!process_rom_entries(&romdata, region + 1))
-				return 1;
+				goto cleanup;
 		}
 		else if (ROMREGION_ISDISKDATA(region))
 		{
 			if (!process_disk_entries(&romdata, region + 1))
-				return 1;
+				goto cleanup;
 		}
 
 		/* add this region to the list */
 		if (regiontype < REGION_MAX)
+		{
 			regionlist[regiontype] = region;
+
+			/* post-process it while the next regions are loaded */
+			if (!copysource[regiontype])
+			{
+				debugload("Post-processing region %02X\n", regiontype);
+				postlist[regiontype].regiondata = region;
+				postlist[regiontype].regionlength = romdata.regionlength;
+				postlist[regiontype].regionbase = romdata.regionbase;
+				if (group)
+					osd_task_group_run(group, region_post_process_task, &postlist[regiontype]);
+				else
+					region_post_process_task(&postlist[regiontype]);
+			}
+		}
 	}
 
-	/* post-process the regions */
+	/* post-process the regions read by the copies */
 	for (regnum = 0; regnum < REGION_MAX; regnum++)
-		if (regionlist[regnum])
+		if (regionlist[regnum] && copysource[regnum])
 		{
 			debugload("Post-processing region %02X\n", regnum);
-			romdata.regionlength = memory_region_length(regnum);
-			romdata.regionbase = memory_region(regnum);
-			region_post_process(&romdata, regionlist[regnum]);
+			region_post_process(memory_region(regnum), memory_region_length(regnum), regionlist[regnum]);
 		}
 
+	result = 0;
+
+cleanup:
+	/* wait the tasks before the regions are used or freed */
+	prefetch_free(&romdata);
+	if (group)
+	{
+		osd_task_group_wait(group);
+		osd_task_group_free(group);
+	}
+	if (result != 0)
+		return result;
+
 	/* display the results and exit */
 	total_rom_load_warnings = romdata.warnings;
 
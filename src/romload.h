@@ -147,6 +147,14 @@ struct _rom_load_data
 
 	void *			file;				/* current file */
 
+	struct _rom_prefetch *prefetch;		/* files of all the regions, opened in advance */
+	int				prefetchcount;		/* number of files to load */
+	int				prefetchopen;		/* next file to open */
+	int				prefetchindex;		/* next prefetched file to use */
+	UINT32			prefetchbytes;		/* bytes of the opened files not yet used */
+	const rom_entry *prefetchregion;	/* region of the next file to open */
+	const rom_entry *prefetchentry;		/* entry of the next file to open */
+
 	UINT8 *			regionbase;			/* base of current region */
 	UINT32			regionlength;		/* length of current region */
 
@@ -100,6 +100,7 @@ static int totalspeakers;
 static speaker_info speaker[MAX_SPEAKER];
 
 static INT16 *finalmix;
+static INT16 *finalmix_buffer[2];
 static INT32 *leftmix, *rightmix;
 static int samples_this_frame;
 static int global_sound_enabled;
@@ -192,7 +193,9 @@ int sound_init(void)
 	/* allocate memory for mix buffers */
 	leftmix = auto_malloc(Machine->sample_rate * sizeof(*leftmix));
 	rightmix = auto_malloc(Machine->sample_rate * sizeof(*rightmix));
-	finalmix = auto_malloc(Machine->sample_rate * sizeof(*finalmix));
+	finalmix_buffer[0] = auto_malloc(Machine->sample_rate * sizeof(*finalmix));
+	finalmix_buffer[1] = auto_malloc(Machine->sample_rate * sizeof(*finalmix));
+	finalmix = finalmix_buffer[0];
 
 	/* allocate a global timer for sound timing */
 	sound_update_timer = mame_timer_alloc(NULL);
@@ -301,6 +304,7 @@ static int start_sound_chips(void)
 	{
 		const sound_config *msound = &Machine->drv->sound[sndnum];
 		sound_info *info;
+		char scope[32];
 		int num_regs;
 		int index;
 
@@ -320,6 +324,8 @@ static int start_sound_chips(void)
 		VPRINTF(("sndnum = %d -- sound_type = %d\n", sndnum, msound->sound_type));
 		num_regs = state_save_get_reg_count();
 		streams_set_tag(info);
+		sprintf(scope, "sound%d:%s", sndnum + 1, sndtype_name(msound->sound_type));
+		streams_set_profiler_scope(profiler_scope_register(scope, PROFILER_SOUND));
 		if (sndintrf_init_sound(sndnum, msound->sound_type, msound->clock, msound->config) != 0)
 			return 1;
 
@@ -453,12 +459,14 @@ static int route_sound(void)
 
 	/* now allocate the mixers and input data */
 	streams_set_tag(NULL);
+	streams_set_profiler_scope(PROFILER_MIXER);
 	for (spknum = 0; spknum < totalspeakers; spknum++)
 	{
 		speaker_info *info = &speaker[spknum];
 		if (info->inputs)
 		{
 			info->mixer_stream = stream_create(info->inputs, 1, Machine->sample_rate, info, mixer_update);
+			stream_set_callback_gain(info->mixer_stream, TRUE);
 			info->input = auto_malloc(info->inputs * sizeof(*info->input));
 			info->inputs = 0;
 		}
@@ -740,6 +748,39 @@ void sound_frame_update(void)
 	/* play the result */
 	samples_this_frame = osd_update_audio_stream(finalmix);
 
+	/* the OSD may still use the buffer until the next frame, mix the next one in the other buffer */
+	finalmix = finalmix_buffer[finalmix == finalmix_buffer[0]];
+
+	/* update the streamer */
+	streams_frame_update();
+
+	/* reset the timer to resync for this frame */
+	mame_timer_adjust(sound_update_timer, time_never, 0, time_never);
+
+	profiler_mark(PROFILER_END);
+}
+
+
+/*-------------------------------------------------
+    sound_frame_skip - advance the sound of one
+    frame without mixing it, used for the frames
+    that are emulated but never played
+-------------------------------------------------*/
+
+void sound_frame_skip(void)
+{
+	int spknum;
+
+	VPRINTF(("sound_frame_skip\n"));
+
+	profiler_mark(PROFILER_SOUND);
+
+	/* the streams must still generate their samples to stay in sync */
+	if (!mame_is_paused())
+		for (spknum = 0; spknum < totalspeakers; spknum++)
+			if (speaker[spknum].mixer_stream)
+				stream_consume_output(speaker[spknum].mixer_stream, 0, samples_this_frame);
+
 	/* update the streamer */
 	streams_frame_update();
 
@@ -758,20 +799,35 @@ static void mixer_update(void *param, stream_sample_t **inputs, stream_sample_t
 {
 	speaker_info *speaker = param;
 	int numinputs = speaker->inputs;
-	int pos;
+	stream_sample_t *dest = buffer[0];
+	int inp, pos;
 
 	VPRINTF(("Mixer_update(%d)\n", length));
 
-	/* loop over samples */
-	for (pos = 0; pos < length; pos++)
+	/* the resampler leaves the gain to us, apply it while mixing */
+	/* one input at a time, to keep the loops simple enough to vectorize */
+	for (inp = 0; inp < numinputs; inp++)
 	{
-		INT32 sample = inputs[0][pos];
-		int inp;
+		const stream_sample_t *source = inputs[inp];
+		INT32 gain = stream_get_input_gain(speaker->mixer_stream, inp);
 
-		/* add up all the inputs */
-		for (inp = 1; inp < numinputs; inp++)
-			sample += inputs[inp][pos];
-		buffer[0][pos] = sample;
+		if (inp == 0)
+		{
+			if (gain == 0x100)
+				memcpy(dest, source, length * sizeof(*dest));
+			else
+				for (pos = 0; pos < length; pos++)
+					dest[pos] = (source[pos] * gain) >> 8;
+		}
+		else
+		{
+			if (gain == 0x100)
+				for (pos = 0; pos < length; pos++)
+					dest[pos] += source[pos];
+			else
+				for (pos = 0; pos < length; pos++)
+					dest[pos] += (source[pos] * gain) >> 8;
+		}
 	}
 }
 
@@ -66,6 +66,7 @@ struct _speaker_config
 /* core interfaces */
 int sound_init(void);
 void sound_frame_update(void);
+void sound_frame_skip(void);
 int sound_scalebufferpos(int value);
 
 /* global sound enable/disable */
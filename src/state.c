@@ -12,15 +12,35 @@
     Save state file format:
 
      0.. 7  'MAMESAVE"
-     8      Format version (this is format 1)
+     8      Format version (this is format 2)
      9      Flags
      a..13  Game name padded with \0
     14..17  Signature
-    18..end Save game data
+    18..1b  CRC of the reference state, if SS_DELTA is set
+    1c..1f  Number of chunks
+    20..end Chunks
+
+    Every chunk holds the entries of a tag/module/instance, in the same
+    order as the registry:
+
+     0.. 1  Length N of the chunk name
+     2..    Chunk name "tag/module/instance" (not terminated)
+     2+N    Encoding method, CHUNK_*
+     3+N..  Size of the data once decoded
+     7+N..  Size of the encoded data
+     b+N..  Encoded data
+
+    All the values are little endian. The data of a chunk is stored, or
+    raw deflate compressed, or omitted because it's equal to the reference
+    state. A compressed chunk may be the XOR with the reference state.
+
+    Format 1 files (the raw data after the header) can still be loaded.
+    The same format is used for the states saved in memory.
 
 ***************************************************************************/
 
 #include "driver.h"
+#include "osdepend.h"
 #include <zlib.h>
 
 
@@ -43,14 +63,30 @@
     CONSTANTS
 ***************************************************************************/
 
-#define SAVE_VERSION		1
+#define SAVE_VERSION		2
 
 #define TAG_STACK_SIZE		4
 
+#define HEADER_SIZE			0x18				/* header of the format 1 and of the dump */
+#define HEADER_SIZE_V2		0x20				/* header of the format 2 */
+#define CHUNK_HEADER_SIZE(namelen) (11 + (namelen))
+#define CHUNK_MIN_DEFLATE	64					/* smaller chunks are always stored */
+#define CHUNK_DELTA_BLOCK	4096				/* bytes XORed at once with the reference */
+
 /* Available flags */
 enum
 {
-	SS_MSB_FIRST = 0x02
+	SS_MSB_FIRST = 0x02,
+	SS_DELTA = 0x04
+};
+
+/* Chunk encoding methods */
+enum
+{
+	CHUNK_STORED = 0,
+	CHUNK_DEFLATE = 1,
+	CHUNK_REFERENCE = 2,
+	CHUNK_DELTA = 0x80					/* the data is XORed with the reference */
 };
 
 enum
@@ -80,6 +116,21 @@ struct _ss_entry
 };
 
 
+typedef struct _ss_chunk ss_chunk;
+struct _ss_chunk
+{
+	const char *	name;				/* the first entry name, the key is its tag/module/instance prefix */
+	UINT32			namelen;			/* length of the key */
+	UINT32			offset;				/* offset of the data within the dump */
+	UINT32			size;				/* size of the data */
+	UINT32			packoffset;			/* offset of the encoded chunk, or of its data when loading */
+	UINT32			packsize;			/* size of the encoded chunk, or of its data when loading */
+	UINT8			method;				/* encoding method, when loading */
+	UINT8			found;				/* the chunk is present, when loading */
+	UINT8			error;				/* the chunk can't be decoded, when loading */
+};
+
+
 typedef struct _ss_func ss_func;
 struct _ss_func
 {
@@ -116,9 +167,36 @@ static int ss_tag_stack_index;
 static int ss_current_tag;
 static UINT8 ss_registration_allowed;
 
+/* the dump is kept allocated between the saves */
 static UINT8 *ss_dump_array;
 static mame_file *ss_dump_file;
 static UINT32 ss_dump_size;
+static UINT32 ss_dump_alloc;
+static UINT32 ss_dump_saved;	/* size of the last saved state, still in the dump */
+
+/* the encoded state, saved or loaded */
+static UINT8 *ss_pack_array;
+static const UINT8 *ss_pack_data;
+static UINT32 ss_pack_size;
+static UINT32 ss_pack_alloc;
+
+/* the reference state of the delta encoding, as a dump */
+static UINT8 *ss_ref_array;
+static UINT32 ss_ref_size;
+static UINT32 ss_ref_alloc;
+static UINT32 ss_ref_crc;
+
+/* the snapshot, a dump kept apart and never encoded */
+static UINT8 *ss_snap_array;
+static UINT32 ss_snap_size;
+static UINT32 ss_snap_alloc;
+static int ss_snap_active;	/* if the snapshot is swapped in the dump */
+
+static ss_chunk *ss_chunk_array;
+static UINT32 ss_chunk_count;
+static UINT32 ss_chunk_alloc;
+
+static int ss_compression = Z_BEST_SPEED;
 
 #ifdef MESS
 static const char ss_magic_num[8] = { 'M', 'E', 'S', 'S', 'S', 'A', 'V', 'E' };
@@ -534,9 +612,32 @@ void state_save_free(void)
 	func_free(&ss_prefunc_reg);
 	func_free(&ss_postfunc_reg);
 
-	/* if we're clear of all registrations, reset the invalid counter */
+	/* if we're clear of all registrations, reset the invalid counter and free the buffers */
 	if (ss_registry == NULL && ss_prefunc_reg == NULL && ss_postfunc_reg == NULL)
+	{
 		ss_illegal_regs = 0;
+
+		free(ss_dump_array);
+		ss_dump_array = NULL;
+		ss_dump_alloc = 0;
+		ss_dump_saved = 0;
+		free(ss_pack_array);
+		ss_pack_array = NULL;
+		ss_pack_alloc = 0;
+		ss_pack_size = 0;
+		free(ss_ref_array);
+		ss_ref_array = NULL;
+		ss_ref_alloc = 0;
+		ss_ref_size = 0;
+		free(ss_snap_array);
+		ss_snap_array = NULL;
+		ss_snap_alloc = 0;
+		ss_snap_size = 0;
+		free(ss_chunk_array);
+		ss_chunk_array = NULL;
+		ss_chunk_alloc = 0;
+		ss_chunk_count = 0;
+	}
 }
 
 
@@ -596,25 +697,117 @@ static void ss_c8(UINT8 *data, UINT32 size)
 
 ***************************************************************************/
 
+/*-------------------------------------------------
+    reserve_array - make sure a buffer kept
+    between the saves is large enough
+-------------------------------------------------*/
+
+static int reserve_array(UINT8 **array, UINT32 *alloc, UINT32 size)
+{
+	UINT8 *newarray;
+
+	if (size <= *alloc)
+		return 0;
+
+	/* leave some room to the states growing a bit */
+	size += size / 8;
+	newarray = realloc(*array, size);
+	if (!newarray)
+		return 1;
+	*array = newarray;
+	*alloc = size;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    chunk_key_length - return the length of the
+    tag/module/instance prefix of an entry name
+-------------------------------------------------*/
+
+static UINT32 chunk_key_length(const char *name)
+{
+	const char *end;
+	int i;
+
+	/* stop at the third '/'; if the module name contains a '/', the key */
+	/* includes less than the instance, but it's still a prefix of the */
+	/* name, so the entries of the chunk are still consecutive */
+	end = name;
+	for (i = 0; i < 3 && end; i++)
+		end = strchr(i ? end + 1 : end, '/');
+	return end ? end - name : strlen(name);
+}
+
+
+/*-------------------------------------------------
+    get_le32/put_le32 - access an unaligned
+    little endian value of the encoded state
+-------------------------------------------------*/
+
+INLINE UINT32 get_le32(const UINT8 *data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((UINT32)data[3] << 24);
+}
+
+INLINE void put_le32(UINT8 *data, UINT32 value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+}
+
+
 /*-------------------------------------------------
     compute_size_and_offsets - compute the total
-    size and offsets of each individual item
+    size and offsets of each individual item, and
+    group them in chunks
 -------------------------------------------------*/
 
 static int compute_size_and_offsets(void)
 {
 	ss_entry *entry;
+	ss_chunk *chunk = NULL;
 	int total_size;
 
 	/* start with the header size */
-	total_size = 0x18;
+	total_size = HEADER_SIZE;
+	ss_chunk_count = 0;
 
 	/* iterate over entries */
 	for (entry = ss_registry; entry; entry = entry->next)
 	{
+		UINT32 size = entry->typesize * entry->typecount;
+		UINT32 keylen = chunk_key_length(entry->name);
+
 		/* note the offset and accumulate a total size */
 		entry->offset = total_size;
-		total_size += entry->typesize * entry->typecount;
+		total_size += size;
+
+		/* the registry is sorted, so the entries of a chunk are consecutive */
+		if (chunk && chunk->namelen == keylen && !memcmp(chunk->name, entry->name, keylen))
+		{
+			chunk->size += size;
+			continue;
+		}
+
+		/* start a new chunk */
+		if (ss_chunk_count == ss_chunk_alloc)
+		{
+			UINT32 newalloc = ss_chunk_alloc ? ss_chunk_alloc * 2 : 64;
+			ss_chunk *newarray = realloc(ss_chunk_array, newalloc * sizeof(*newarray));
+			if (!newarray)
+				fatalerror("Out of memory allocating the save state chunks");
+			ss_chunk_array = newarray;
+			ss_chunk_alloc = newalloc;
+		}
+		chunk = &ss_chunk_array[ss_chunk_count++];
+		memset(chunk, 0, sizeof(*chunk));
+		chunk->name = entry->name;
+		chunk->namelen = keylen;
+		chunk->offset = entry->offset;
+		chunk->size = size;
 	}
 
 	/* return the total size */
@@ -622,6 +815,322 @@ static int compute_size_and_offsets(void)
 }
 
 
+/*-------------------------------------------------
+    deflate_chunk - compress the data of a chunk,
+    optionally XORed with the reference; return
+    0 if it doesn't fit in the destination
+-------------------------------------------------*/
+
+static UINT32 deflate_chunk(z_stream *stream, const UINT8 *src, const UINT8 *ref, UINT32 size, UINT8 *dst, UINT32 dstsize)
+{
+	UINT8 block[CHUNK_DELTA_BLOCK];
+	UINT32 pos = 0;
+
+	if (deflateReset(stream) != Z_OK)
+		return 0;
+	stream->next_out = dst;
+	stream->avail_out = dstsize;
+
+	while (pos < size)
+	{
+		UINT32 len = size - pos;
+		int last, result;
+
+		/* the delta is computed a block at time, to stay in the cache */
+		if (ref)
+		{
+			UINT32 i;
+			if (len > sizeof(block))
+				len = sizeof(block);
+			for (i = 0; i < len; i++)
+				block[i] = src[pos + i] ^ ref[pos + i];
+			stream->next_in = block;
+		}
+		else
+			stream->next_in = (Bytef *)src + pos;
+		stream->avail_in = len;
+		pos += len;
+		last = (pos == size);
+
+		/* without more output space, the chunk is better stored */
+		result = deflate(stream, last ? Z_FINISH : Z_NO_FLUSH);
+		if (last ? result != Z_STREAM_END : (result != Z_OK || stream->avail_in != 0))
+			return 0;
+	}
+
+	return dstsize - stream->avail_out;
+}
+
+
+/*-------------------------------------------------
+    encode_chunks - encode a range of chunks of
+    the dump, every one in its own place of the
+    encoded state
+-------------------------------------------------*/
+
+static void encode_chunks(void *param, int begin, int end)
+{
+	const UINT8 *refbase = param;
+	z_stream stream;
+	int stream_ready = FALSE;
+	int i;
+
+	memset(&stream, 0, sizeof(stream));
+
+	for (i = begin; i < end; i++)
+	{
+		ss_chunk *chunk = &ss_chunk_array[i];
+		const UINT8 *src = ss_dump_array + chunk->offset;
+		const UINT8 *ref = refbase ? refbase + chunk->offset : NULL;
+		UINT8 *dst = ss_pack_array + chunk->packoffset;
+		UINT8 *data = dst + CHUNK_HEADER_SIZE(chunk->namelen);
+		UINT32 datasize = 0;
+		UINT8 method = CHUNK_STORED;
+
+		/* a chunk unchanged from the reference isn't saved at all */
+		if (ref && !memcmp(src, ref, chunk->size))
+			method = CHUNK_REFERENCE;
+
+		/* compress it only if it gets smaller */
+		else if (ss_compression != 0 && chunk->size >= CHUNK_MIN_DEFLATE)
+		{
+			if (!stream_ready)
+				stream_ready = (deflateInit2(&stream, ss_compression, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+			if (stream_ready)
+				datasize = deflate_chunk(&stream, src, ref, chunk->size, data, chunk->size - 1);
+			if (datasize != 0)
+				method = CHUNK_DEFLATE | (ref ? CHUNK_DELTA : 0);
+		}
+
+		if (method == CHUNK_STORED)
+		{
+			memcpy(data, src, chunk->size);
+			datasize = chunk->size;
+		}
+
+		/* build the chunk header */
+		dst[0] = chunk->namelen & 0xff;
+		dst[1] = chunk->namelen >> 8;
+		memcpy(dst + 2, chunk->name, chunk->namelen);
+		dst += 2 + chunk->namelen;
+		*dst++ = method;
+		put_le32(dst, chunk->size);
+		put_le32(dst + 4, datasize);
+
+		chunk->packsize = CHUNK_HEADER_SIZE(chunk->namelen) + datasize;
+	}
+
+	if (stream_ready)
+		deflateEnd(&stream);
+}
+
+
+/*-------------------------------------------------
+    decode_chunks - decode a range of chunks of
+    the loaded state into the dump
+-------------------------------------------------*/
+
+static void decode_chunks(void *param, int begin, int end)
+{
+	z_stream stream;
+	int stream_ready = FALSE;
+	int i;
+
+	memset(&stream, 0, sizeof(stream));
+
+	for (i = begin; i < end; i++)
+	{
+		ss_chunk *chunk = &ss_chunk_array[i];
+		const UINT8 *src = ss_pack_data + chunk->packoffset;
+		const UINT8 *ref = ss_ref_array ? ss_ref_array + chunk->offset : NULL;
+		UINT8 *dst = ss_dump_array + chunk->offset;
+
+		switch (chunk->method)
+		{
+			case CHUNK_STORED:
+				if (chunk->packsize != chunk->size)
+					chunk->error = TRUE;
+				else
+					memcpy(dst, src, chunk->size);
+				break;
+
+			case CHUNK_REFERENCE:
+				memcpy(dst, ref, chunk->size);
+				break;
+
+			case CHUNK_DEFLATE:
+			case CHUNK_DEFLATE | CHUNK_DELTA:
+				if (!stream_ready)
+					stream_ready = (inflateInit2(&stream, -MAX_WBITS) == Z_OK);
+				if (!stream_ready || inflateReset(&stream) != Z_OK)
+				{
+					chunk->error = TRUE;
+					break;
+				}
+				stream.next_in = (Bytef *)src;
+				stream.avail_in = chunk->packsize;
+				stream.next_out = dst;
+				stream.avail_out = chunk->size;
+				if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.avail_out != 0)
+				{
+					chunk->error = TRUE;
+					break;
+				}
+				if (chunk->method & CHUNK_DELTA)
+				{
+					UINT32 j;
+					for (j = 0; j < chunk->size; j++)
+						dst[j] ^= ref[j];
+				}
+				break;
+
+			default:
+				chunk->error = TRUE;
+				break;
+		}
+	}
+
+	if (stream_ready)
+		inflateEnd(&stream);
+}
+
+
+/*-------------------------------------------------
+    encode_state - encode the dump in the pack
+    buffer
+-------------------------------------------------*/
+
+static int encode_state(void)
+{
+	UINT32 size, pos, i;
+
+	/* the files must be loadable alone, only the memory saves are deltas */
+	int delta = (ss_ref_array != NULL && ss_dump_file == NULL);
+
+	/* every chunk gets the space to be stored */
+	size = HEADER_SIZE_V2;
+	for (i = 0; i < ss_chunk_count; i++)
+	{
+		ss_chunk_array[i].packoffset = size;
+		size += CHUNK_HEADER_SIZE(ss_chunk_array[i].namelen) + ss_chunk_array[i].size;
+	}
+	if (reserve_array(&ss_pack_array, &ss_pack_alloc, size))
+	{
+		logerror("malloc failed in state_save_save_finish\n");
+		return 1;
+	}
+
+	/* the chunks are independent, encode them in parallel */
+	osd_parallel_for(encode_chunks, delta ? ss_ref_array : NULL, ss_chunk_count, 4);
+
+	/* pack them together */
+	pos = HEADER_SIZE_V2;
+	for (i = 0; i < ss_chunk_count; i++)
+	{
+		if (pos != ss_chunk_array[i].packoffset)
+			memmove(ss_pack_array + pos, ss_pack_array + ss_chunk_array[i].packoffset, ss_chunk_array[i].packsize);
+		pos += ss_chunk_array[i].packsize;
+	}
+	ss_pack_size = pos;
+
+	/* the header is the same of the dump, with the delta information */
+	memcpy(ss_pack_array, ss_dump_array, HEADER_SIZE);
+	if (delta)
+		ss_pack_array[9] |= SS_DELTA;
+	put_le32(&ss_pack_array[0x18], delta ? ss_ref_crc : 0);
+	put_le32(&ss_pack_array[0x1c], ss_chunk_count);
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    decode_state - decode a state in the dump
+-------------------------------------------------*/
+
+static int decode_state(const UINT8 *data, UINT32 size)
+{
+	UINT32 count, pos, i, next = 0;
+
+	/* the format 1 is already a dump */
+	if (data[8] == 1)
+	{
+		if (size != ss_dump_size)
+			return 1;
+		memcpy(ss_dump_array, data, size);
+		return 0;
+	}
+
+	if (size < HEADER_SIZE_V2)
+		return 1;
+
+	/* a delta state must have its reference */
+	if ((data[9] & SS_DELTA) && (!ss_ref_array || ss_ref_size != ss_dump_size || ss_ref_crc != get_le32(&data[0x18])))
+		return 1;
+
+	for (i = 0; i < ss_chunk_count; i++)
+		ss_chunk_array[i].found = ss_chunk_array[i].error = FALSE;
+
+	/* locate every chunk by its name, usually in the same order of the registry */
+	count = get_le32(&data[0x1c]);
+	pos = HEADER_SIZE_V2;
+	while (count-- > 0)
+	{
+		UINT32 namelen, rawsize, packsize, j;
+		const char *name;
+		ss_chunk *chunk = NULL;
+		UINT8 method;
+
+		if (pos + 2 > size)
+			return 1;
+		namelen = data[pos] | (data[pos + 1] << 8);
+		if (pos + CHUNK_HEADER_SIZE(namelen) > size)
+			return 1;
+		name = (const char *)data + pos + 2;
+		method = data[pos + 2 + namelen];
+		rawsize = get_le32(&data[pos + 3 + namelen]);
+		packsize = get_le32(&data[pos + 7 + namelen]);
+		pos += CHUNK_HEADER_SIZE(namelen);
+		if (packsize > size - pos)
+			return 1;
+
+		for (j = 0; j < ss_chunk_count && !chunk; j++)
+		{
+			ss_chunk *candidate = &ss_chunk_array[(next + j) % ss_chunk_count];
+			if (candidate->namelen == namelen && !memcmp(candidate->name, name, namelen))
+				chunk = candidate;
+		}
+		if (!chunk || chunk->found || chunk->size != rawsize)
+			return 1;
+		if ((method == CHUNK_REFERENCE || (method & CHUNK_DELTA)) && !(data[9] & SS_DELTA))
+			return 1;
+
+		chunk->found = TRUE;
+		chunk->method = method;
+		chunk->packoffset = pos;
+		chunk->packsize = packsize;
+		next = chunk - ss_chunk_array + 1;
+		pos += packsize;
+	}
+
+	for (i = 0; i < ss_chunk_count; i++)
+		if (!ss_chunk_array[i].found)
+			return 1;
+
+	/* the chunks are independent, decode them in parallel */
+	ss_pack_data = data;
+	osd_parallel_for(decode_chunks, NULL, ss_chunk_count, 4);
+	ss_pack_data = NULL;
+
+	for (i = 0; i < ss_chunk_count; i++)
+		if (ss_chunk_array[i].error)
+			return 1;
+
+	/* the dump header gets the flags of the state */
+	memcpy(ss_dump_array, data, HEADER_SIZE);
+	return 0;
+}
+
+
 /*-------------------------------------------------
     call_hook_functions - loop through all the
     hook functions and call them
@@ -702,11 +1211,11 @@ static int validate_header(const UINT8 *header, const char *gamename, UINT32 sig
 		return -1;
 	}
 
-	/* check save state version */
-	if (header[8] != SAVE_VERSION)
+	/* check save state version, the format 1 can still be loaded */
+	if (header[8] != 1 && header[8] != SAVE_VERSION)
 	{
 		if (errormsg)
-			errormsg("%sWrong version in save file (%d, 1 expected)", error_prefix, header[8]);
+			errormsg("%sWrong version in save file (%d, %d expected)", error_prefix, header[8], SAVE_VERSION);
 		return -1;
 	}
 
@@ -742,7 +1251,7 @@ static int validate_header(const UINT8 *header, const char *gamename, UINT32 sig
 int state_save_check_file(mame_file *file, const char *gamename, int validate_signature, void (CLIB_DECL *errormsg)(const char *fmt, ...))
 {
 	UINT32 signature = 0;
-	UINT8 header[0x18];
+	UINT8 header[HEADER_SIZE];
 
 	/* if we want to validate the signature, compute it */
 	if (validate_signature)
@@ -771,7 +1280,8 @@ int state_save_check_file(mame_file *file, const char *gamename, int validate_si
 
 /*-------------------------------------------------
     state_save_save_begin - begin the process of
-    saving
+    saving; with a NULL file the state is saved
+    in memory
 -------------------------------------------------*/
 
 int state_save_save_begin(mame_file *file)
@@ -782,15 +1292,23 @@ int state_save_save_begin(mame_file *file)
 
 	TRACE(logerror("Beginning save\n"));
 	ss_dump_file = file;
+	ss_dump_saved = 0;
 
 	/* compute the total dump size and the offsets of each element */
 	ss_dump_size = compute_size_and_offsets();
 	TRACE(logerror("   total size %u\n", ss_dump_size));
 
-	/* allocate memory for the array */
-	ss_dump_array = malloc(ss_dump_size);
-	if (!ss_dump_array)
+	/* the dump memory is reused by the next saves */
+	if (reserve_array(&ss_dump_array, &ss_dump_alloc, ss_dump_size))
+	{
 		logerror("malloc failed in state_save_save_begin\n");
+		ss_dump_file = NULL;
+		return 1;
+	}
+
+	/* a reference of another layout can't be used */
+	if (ss_ref_array && ss_ref_size != ss_dump_size)
+		state_save_clear_reference();
 	return 0;
 }
 
@@ -826,17 +1344,14 @@ void state_save_save_continue(void)
 
 
 /*-------------------------------------------------
-    state_save_save_finish - finish saving the
-    file by writing the header and closing
+    fill_header - build the header of the dump
 -------------------------------------------------*/
 
-void state_save_save_finish(void)
+static void fill_header(void)
 {
 	UINT32 signature;
 	UINT8 flags = 0;
 
-	TRACE(logerror("Finishing save\n"));
-
 	/* compute the flags */
 #ifndef LSB_FIRST
 	flags |= SS_MSB_FIRST;
@@ -852,18 +1367,232 @@ void state_save_save_finish(void)
 	/* copy in the signature */
 	signature = get_signature();
 	*(UINT32 *)&ss_dump_array[0x14] = LITTLE_ENDIANIZE_INT32(signature);
+}
 
-	/* write the file */
-	mame_fwrite(ss_dump_file, ss_dump_array, ss_dump_size);
 
-	/* free memory and reset the global states */
-	free(ss_dump_array);
-	ss_dump_array = NULL;
+/*-------------------------------------------------
+    state_save_save_finish - finish saving the
+    file by encoding the dump and writing it
+-------------------------------------------------*/
+
+void state_save_save_finish(void)
+{
+	TRACE(logerror("Finishing save\n"));
+
+	fill_header();
+
+	/* encode and write the file */
+	ss_pack_size = 0;
+	if (encode_state() == 0)
+	{
+		if (ss_dump_file)
+			mame_fwrite(ss_dump_file, ss_pack_array, ss_pack_size);
+		ss_dump_saved = ss_dump_size;
+	}
+
+	/* reset the global states, the memory is kept for the next time */
 	ss_dump_size = 0;
 	ss_dump_file = NULL;
 }
 
 
+/*-------------------------------------------------
+    state_save_get_memory - return the state
+    saved in memory, valid up to the next save
+-------------------------------------------------*/
+
+const UINT8 *state_save_get_memory(UINT32 *size)
+{
+	*size = ss_pack_size;
+	return ss_pack_size ? ss_pack_array : NULL;
+}
+
+
+
+/***************************************************************************
+
+    Snapshot processing
+
+***************************************************************************/
+
+/*-------------------------------------------------
+    swap_snapshot - exchange the dump and the
+    snapshot buffers
+-------------------------------------------------*/
+
+static void swap_snapshot(void)
+{
+	UINT8 *array = ss_dump_array;
+	UINT32 alloc = ss_dump_alloc;
+
+	ss_dump_array = ss_snap_array;
+	ss_dump_alloc = ss_snap_alloc;
+	ss_snap_array = array;
+	ss_snap_alloc = alloc;
+	ss_snap_active = !ss_snap_active;
+}
+
+
+/*-------------------------------------------------
+    state_save_snapshot_begin - begin the process
+    of saving a snapshot, a state kept in memory
+    without any encoding, to be restored soon
+-------------------------------------------------*/
+
+int state_save_snapshot_begin(void)
+{
+	/* if we have illegal registrations, return an error */
+	if (ss_illegal_regs > 0)
+		return 1;
+
+	TRACE(logerror("Beginning snapshot\n"));
+	ss_dump_file = NULL;
+	ss_dump_saved = 0;
+	ss_snap_size = 0;
+
+	/* the snapshot is saved with the dump functions, in its own buffer */
+	swap_snapshot();
+	ss_dump_size = compute_size_and_offsets();
+	if (reserve_array(&ss_dump_array, &ss_dump_alloc, ss_dump_size))
+	{
+		logerror("malloc failed in state_save_snapshot_begin\n");
+		swap_snapshot();
+		ss_dump_size = 0;
+		return 1;
+	}
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_save_snapshot_finish - complete the
+    process of saving the snapshot
+-------------------------------------------------*/
+
+void state_save_snapshot_finish(void)
+{
+	TRACE(logerror("Finishing snapshot\n"));
+
+	fill_header();
+	ss_snap_size = ss_dump_size;
+
+	swap_snapshot();
+	ss_dump_size = 0;
+}
+
+
+/*-------------------------------------------------
+    state_save_restore_begin - begin the process
+    of loading the last snapshot, completed by
+    state_save_load_continue/finish
+-------------------------------------------------*/
+
+int state_save_restore_begin(void)
+{
+	UINT32 size;
+
+	TRACE(logerror("Beginning restore\n"));
+
+	/* the registrations must be the same of the snapshot */
+	size = compute_size_and_offsets();
+	if (ss_snap_size == 0 || ss_snap_size != size)
+		return 1;
+
+	ss_dump_saved = 0;
+	swap_snapshot();
+	ss_dump_size = size;
+	return 0;
+}
+
+
+
+/***************************************************************************
+
+    Encoding options
+
+***************************************************************************/
+
+/*-------------------------------------------------
+    state_save_set_compression - set the zlib
+    compression level of the saves, 0 stores the
+    data
+-------------------------------------------------*/
+
+void state_save_set_compression(int level)
+{
+	ss_compression = level;
+}
+
+
+/*-------------------------------------------------
+    state_save_set_reference - decode a state and
+    use it as reference of the next saves, which
+    store only the differences with it
+-------------------------------------------------*/
+
+int state_save_set_reference(const UINT8 *data, UINT32 size)
+{
+	UINT8 *array;
+	UINT32 alloc;
+
+	if (size < HEADER_SIZE || validate_header(data, NULL, get_signature(), NULL, "") != 0)
+		return 1;
+
+	/* the state just saved is still in the dump, otherwise decode it */
+	/* there, as a load without the copy to the entries */
+	if (ss_dump_saved != 0 && data == ss_pack_array && size == ss_pack_size)
+		ss_dump_size = ss_dump_saved;
+	else
+	{
+		ss_dump_size = compute_size_and_offsets();
+		if (reserve_array(&ss_dump_array, &ss_dump_alloc, ss_dump_size) || decode_state(data, size) != 0)
+		{
+			ss_dump_size = 0;
+			ss_dump_saved = 0;
+			return 1;
+		}
+	}
+	ss_dump_saved = 0;
+
+	/* the dump becomes the reference */
+	array = ss_ref_array;
+	alloc = ss_ref_alloc;
+	ss_ref_array = ss_dump_array;
+	ss_ref_alloc = ss_dump_alloc;
+	ss_ref_size = ss_dump_size;
+	ss_ref_crc = crc32(0, ss_ref_array + HEADER_SIZE, ss_ref_size - HEADER_SIZE);
+	ss_dump_array = array;
+	ss_dump_alloc = alloc;
+	ss_dump_size = 0;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_save_clear_reference - save the full
+    states again
+-------------------------------------------------*/
+
+void state_save_clear_reference(void)
+{
+	/* the memory is kept for the next reference */
+	if (ss_ref_array && ss_dump_alloc < ss_ref_alloc)
+	{
+		UINT8 *array = ss_dump_array;
+		UINT32 alloc = ss_dump_alloc;
+		ss_dump_saved = 0;
+		ss_dump_array = ss_ref_array;
+		ss_dump_alloc = ss_ref_alloc;
+		ss_ref_array = array;
+		ss_ref_alloc = alloc;
+	}
+	free(ss_ref_array);
+	ss_ref_array = NULL;
+	ss_ref_alloc = 0;
+	ss_ref_size = 0;
+}
+
+
 
 /***************************************************************************
 
@@ -871,6 +1600,40 @@ void state_save_save_finish(void)
 
 ***************************************************************************/
 
+/*-------------------------------------------------
+    state_save_load_begin_memory - begin the
+    process of loading a state saved in memory
+-------------------------------------------------*/
+
+int state_save_load_begin_memory(const UINT8 *data, UINT32 size)
+{
+	TRACE(logerror("Beginning load\n"));
+
+	/* verify the header and report an error if it doesn't match */
+	if (size < HEADER_SIZE || validate_header(data, NULL, get_signature(), ui_popup, "Error: "))
+		return 1;
+
+	/* compute the total size and offset of all the entries */
+	ss_dump_saved = 0;
+	ss_dump_size = compute_size_and_offsets();
+	if (reserve_array(&ss_dump_array, &ss_dump_alloc, ss_dump_size))
+	{
+		logerror("malloc failed in state_save_load_begin\n");
+		ss_dump_size = 0;
+		return 1;
+	}
+
+	/* decode all the data at once */
+	if (decode_state(data, size) != 0)
+	{
+		ui_popup("Error: Corrupted save file or missing reference state");
+		ss_dump_size = 0;
+		return 1;
+	}
+	return 0;
+}
+
+
 /*-------------------------------------------------
     state_save_load_begin - begin the process
     of loading the state
@@ -878,23 +1641,27 @@ void state_save_save_finish(void)
 
 int state_save_load_begin(mame_file *file)
 {
-	TRACE(logerror("Beginning load\n"));
+	UINT32 size = mame_fsize(file);
 
 	/* read the file into memory */
-	ss_dump_size = mame_fsize(file);
-	ss_dump_array = malloc(ss_dump_size);
+	if (reserve_array(&ss_pack_array, &ss_pack_alloc, size))
+	{
+		logerror("malloc failed in state_save_load_begin\n");
+		return 1;
+	}
+	ss_pack_size = 0;
 	ss_dump_file = file;
-	mame_fread(ss_dump_file, ss_dump_array, ss_dump_size);
-
-	/* verify the header and report an error if it doesn't match */
-	if (validate_header(ss_dump_array, NULL, get_signature(), ui_popup, "Error: "))
+	if (mame_fread(ss_dump_file, ss_pack_array, size) != size)
 	{
-		free(ss_dump_array);
+		ss_dump_file = NULL;
 		return 1;
 	}
 
-	/* compute the total size and offset of all the entries */
-	compute_size_and_offsets();
+	if (state_save_load_begin_memory(ss_pack_array, size) != 0)
+	{
+		ss_dump_file = NULL;
+		return 1;
+	}
 	return 0;
 }
 
@@ -946,9 +1713,11 @@ void state_save_load_finish(void)
 {
 	TRACE(logerror("Finishing load\n"));
 
-	/* free memory and reset the global states */
-	free(ss_dump_array);
-	ss_dump_array = NULL;
+	/* a restored snapshot is kept for the next restore */
+	if (ss_snap_active)
+		swap_snapshot();
+
+	/* reset the global states, the memory is kept for the next time */
 	ss_dump_size = 0;
 	ss_dump_file = NULL;
 }
@@ -106,6 +106,21 @@ void state_save_load_continue(void);
 void state_save_save_finish(void);
 void state_save_load_finish(void);
 
+/* Saving in memory, with a NULL file, and loading from memory */
+const UINT8 *state_save_get_memory(UINT32 *size);
+int  state_save_load_begin_memory(const UINT8 *data, UINT32 size);
+
+/* Snapshot in memory, never encoded, saved with state_save_save_continue() */
+/* and restored with state_save_load_continue/finish() */
+int  state_save_snapshot_begin(void);
+void state_save_snapshot_finish(void);
+int  state_save_restore_begin(void);
+
+/* Encoding options: zlib level (0 = store) and reference of the delta encoding */
+void state_save_set_compression(int level);
+int  state_save_set_reference(const UINT8 *data, UINT32 size);
+void state_save_clear_reference(void);
+
 /* Display function */
 void state_save_dump_registry(void);
 
@@ -11,6 +11,7 @@
 
 #include "driver.h"
 #include "streams.h"
+#include "profiler.h"
 #include <math.h>
 
 #define VERBOSE			(0)
@@ -90,6 +91,8 @@ struct _sound_stream
 	/* callback information */
 	void *			param;
 	stream_callback callback;					/* callback function */
+	int				callback_gain;				/* the callback applies the input gains */
+	int				profiler_scope;				/* profiler scope of the callback */
 };
 
 
@@ -102,6 +105,7 @@ struct _sound_stream
 
 static sound_stream *stream_head;
 static void *stream_current_tag;
+static int stream_current_scope;
 static int stream_index;
 
 
@@ -113,7 +117,7 @@ static int stream_index;
  *************************************/
 
 static void stream_generate_samples(sound_stream *stream, int samples);
-static void resample_input_stream(struct stream_input *input, int samples);
+static void resample_input_stream(struct stream_input *input, int samples, int apply_gain);
 
 
 
@@ -128,6 +132,7 @@ int streams_init(void)
 	/* reset globals */
 	stream_head = NULL;
 	stream_current_tag = NULL;
+	stream_current_scope = PROFILER_SOUND;
 	stream_index = 0;
 
 	return 0;
@@ -148,6 +153,20 @@ void streams_set_tag(void *streamtag)
 
 
 
+/*************************************
+ *
+ *  Set the profiler scope of the
+ *  next streams
+ *
+ *************************************/
+
+void streams_set_profiler_scope(int scope)
+{
+	stream_current_scope = scope;
+}
+
+
+
 /*************************************
  *
  *  Update all
@@ -306,6 +325,7 @@ sound_stream *stream_create(int inputs, int outputs, int sample_rate, void *para
 	stream->outputs     = outputs;
 	stream->param       = param;
 	stream->callback    = callback;
+	stream->profiler_scope = stream_current_scope;
 
 	/* create a unique tag for saving */
 	sprintf(statetag, "stream.%d", stream->index);
@@ -470,6 +490,39 @@ void stream_set_input_gain(sound_stream *stream, int input, float gain)
 
 
 
+/*************************************
+ *
+ *  Return the total gain of an input
+ *  of a given stream
+ *
+ *************************************/
+
+int stream_get_input_gain(sound_stream *stream, int input)
+{
+	struct stream_input *inp = &stream->input[input];
+
+	/* combine the input and the source output gains as the resampler does */
+	if (!inp->source)
+		return 0;
+	return (INT16)((inp->gain * inp->source->gain) >> 8);
+}
+
+
+
+/*************************************
+ *
+ *  Let the callback of a given stream
+ *  apply the input gains itself
+ *
+ *************************************/
+
+void stream_set_callback_gain(sound_stream *stream, int enable)
+{
+	stream->callback_gain = enable;
+}
+
+
+
 /*************************************
  *
  *  Set the output gain on a given
@@ -579,9 +632,18 @@ static void stream_generate_samples(sound_stream *stream, int samples)
 			if (source_samples_needed > 0)
 				stream_generate_samples(input->stream, source_samples_needed);
 
+			/* if nothing has to be changed, point directly to the source samples */
+			if (input->step_frac == FRAC_ONE && stream->callback_gain && resample_samples_needed == samples)
+			{
+				VPRINTF(("    passing through %d samples\n", samples));
+				stream->input_array[inputnum] = input->source->buffer + (input->source_frac >> FRAC_BITS);
+				input->source_frac += samples << FRAC_BITS;
+				continue;
+			}
+
 			/* now resample */
 			VPRINTF(("    resample_input_stream(%d)\n", resample_samples_needed));
-			resample_input_stream(input, resample_samples_needed);
+			resample_input_stream(input, resample_samples_needed, !stream->callback_gain);
 			VPRINTF(("    resample_input_stream done\n"));
 		}
 
@@ -600,7 +662,9 @@ static void stream_generate_samples(sound_stream *stream, int samples)
 
 	/* okay, all the inputs are up-to-date ... call the callback */
 	VPRINTF(("  callback(%p, %d)\n", stream, samples));
+	profiler_scope_begin(stream->profiler_scope);
 	(*stream->callback)(stream->param, stream->input_array, stream->output_array, samples);
+	profiler_scope_end();
 	VPRINTF(("  callback done\n"));
 }
 
@@ -614,41 +678,46 @@ static void stream_generate_samples(sound_stream *stream, int samples)
  *
  *************************************/
 
-static void resample_input_stream(struct stream_input *input, int samples)
+static void resample_input_stream(struct stream_input *input, int samples, int apply_gain)
 {
 	stream_sample_t *dest = input->resample + input->resample_in_pos;
-	stream_sample_t *source = input->source->buffer;
-	INT16 gain = (input->gain * input->source->gain) >> 8;
+	const stream_sample_t *source = input->source->buffer;
+	INT16 gain = apply_gain ? (input->gain * input->source->gain) >> 8 : 0x100;
 	UINT32 pos = input->source_frac;
 	UINT32 step = input->step_frac;
-	INT32 sample;
+	int i;
 
 	VPRINTF(("    resample_input_stream -- step = %d\n", step));
 
-	/* perfectly matching */
+	/* perfectly matching: a straight copy, done in a single pass */
 	if (step == FRAC_ONE)
 	{
-		while (samples--)
-		{
-			/* compute the sample */
-			sample = source[pos >> FRAC_BITS];
-			*dest++ = (sample * gain) >> 8;
-			pos += FRAC_ONE;
-		}
+		source += pos >> FRAC_BITS;
+		if (gain == 0x100)
+			memcpy(dest, source, samples * sizeof(*dest));
+		else
+			for (i = 0; i < samples; i++)
+				dest[i] = (source[i] * gain) >> 8;
+		pos += samples << FRAC_BITS;
 	}
 
 	/* input is undersampled: use linear interpolation */
 	else if (step < FRAC_ONE)
 	{
-		while (samples--)
+		for (i = 0; i < samples; i++)
 		{
+			const stream_sample_t *s = source + (pos >> FRAC_BITS);
+			INT32 frac = pos & FRAC_MASK;
+
 			/* compute the sample */
-			sample  = source[(pos >> FRAC_BITS) + 0] * (FRAC_ONE - (pos & FRAC_MASK));
-			sample += source[(pos >> FRAC_BITS) + 1] * (pos & FRAC_MASK);
-			sample >>= FRAC_BITS;
-			*dest++ = (sample * gain) >> 8;
+			dest[i] = (s[0] * (FRAC_ONE - frac) + s[1] * frac) >> FRAC_BITS;
 			pos += step;
 		}
+
+		/* apply the gain in a separate pass */
+		if (gain != 0x100)
+			for (i = 0; i < samples; i++)
+				dest[i] = (dest[i] * gain) >> 8;
 	}
 
 	/* input is oversampled: sum the energy */
@@ -657,30 +726,36 @@ static void resample_input_stream(struct stream_input *input, int samples)
 		/* use 8 bits to allow some extra headroom */
 		int smallstep = step >> (FRAC_BITS - 8);
 
-		while (samples--)
+		for (i = 0; i < samples; i++)
 		{
-			int tpos = pos >> FRAC_BITS;
-			int remainder = smallstep;
-			int scale;
-
-			/* compute the sample */
-			scale = (FRAC_ONE - (pos & FRAC_MASK)) >> (FRAC_BITS - 8);
-			sample = source[tpos++] * scale;
-			remainder -= scale;
+			const stream_sample_t *s = source + (pos >> FRAC_BITS);
+			int scale = (FRAC_ONE - (pos & FRAC_MASK)) >> (FRAC_BITS - 8);
+			int remainder = smallstep - scale;
+			INT32 sample;
+			INT32 sum;
+
+			/* the whole samples in the middle have all the same weight */
+			sample = *s++ * scale;
+			sum = 0;
 			while (remainder > 0x100)
 			{
-				sample += source[tpos++] * 0x100;
+				sum += *s++;
 				remainder -= 0x100;
 			}
-			sample += source[tpos] * remainder;
-			sample /= smallstep;
+			sample += sum * 0x100;
+			sample += *s * remainder;
 
-			*dest++ = (sample * gain) >> 8;
+			dest[i] = sample / smallstep;
 			pos += step;
 		}
+
+		/* apply the gain in a separate pass */
+		if (gain != 0x100)
+			for (i = 0; i < samples; i++)
+				dest[i] = (dest[i] * gain) >> 8;
 	}
 
 	/* update the input parameters */
-	input->resample_in_pos = dest - input->resample;
+	input->resample_in_pos += samples;
 	input->source_frac = pos;
 }
@@ -20,6 +20,7 @@ typedef void (*stream_callback)(void *param, stream_sample_t **inputs, stream_sa
 
 int streams_init(void);
 void streams_set_tag(void *streamtag);
+void streams_set_profiler_scope(int scope);
 void streams_frame_update(void);
 
 /* core stream configuration and operation */
@@ -33,6 +34,8 @@ sound_stream *stream_find_by_tag(void *streamtag, int streamindex);
 int stream_get_inputs(sound_stream *stream);
 int stream_get_outputs(sound_stream *stream);
 void stream_set_input_gain(sound_stream *stream, int input, float gain);
+int stream_get_input_gain(sound_stream *stream, int input);	/* 8.8 fixed point */
+void stream_set_callback_gain(sound_stream *stream, int enable);	/* the callback must use stream_get_input_gain() */
 void stream_set_output_gain(sound_stream *stream, int output, float gain);
 void stream_set_sample_rate(sound_stream *stream, int sample_rate);
 
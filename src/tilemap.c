@@ -35,6 +35,10 @@
 #define MAX_TILESIZE 64
 
 #define TILE_FLAG_DIRTY	(0x80)
+#define TILE_FLAG_QUEUED	(0x81) /* dirty tile to refresh before drawing */
+
+/* minimum number of dirty tiles to refresh them in parallel */
+#define TILE_REFRESH_PARALLEL_MIN 32
 
 typedef enum { eWHOLLY_TRANSPARENT, eWHOLLY_OPAQUE, eMASKED } trans_t;
 
@@ -76,7 +80,7 @@ struct _tilemap
 
 	UINT32 *pPenToPixel[4];
 
-	UINT8 (*draw_tile)( tilemap *tmap, UINT32 col, UINT32 row, UINT32 flags );
+	UINT8 (*draw_tile)( tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags );
 
 	INT32 cached_scroll_rows, cached_scroll_cols;
 	INT32 *cached_rowscroll, *cached_colscroll;
@@ -115,6 +119,25 @@ tile_data				tile_info;
 typedef void (*blitmask_t)( void *dest, const void *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode );
 typedef void (*blitopaque_t)( void *dest, const void *source, int count, UINT8 *pri, UINT32 pcode );
 
+/* tile info returned by the driver, to draw the tile in a worker thread */
+struct tile_refresh_entry
+{
+	tile_data info;
+	UINT32 cached_indx;
+	UINT32 x0, y0;
+	UINT32 flags;
+};
+
+/* buffers for the parallel refresh of the dirty tiles */
+static struct
+{
+	tilemap *tmap;
+	struct tile_refresh_entry *entry; /* tiles to draw, in row order */
+	UINT32 entry_max;
+	UINT32 *row_first; /* first entry of every row of tiles, and the end */
+	UINT32 row_max;
+} refresh;
+
 /* the following parameters are constant across tilemap_draw calls */
 static struct
 {
@@ -331,6 +354,288 @@ static void mappings_update( tilemap *tmap )
 
 /***********************************************************************************/
 
+#ifdef USE_BLIT_SSE2
+
+/*
+    SSE2 versions of the scanline helpers. The priority bitmap is updated 16
+    pixels at time, the 16 bit pixels 8 at time and the alpha blending 4
+    pixels at time. The lookups in the color table are still done one pixel
+    at time, as SSE2 has no gather instruction.
+*/
+
+#include <emmintrin.h>
+
+/* priority update of all the pixels */
+INLINE void pri_opaque_sse2( UINT8 *pri, int count, UINT32 pcode )
+{
+	__m128i pand = _mm_set1_epi8( (char)(pcode >> 8) );
+	__m128i por = _mm_set1_epi8( (char)pcode );
+	int i;
+
+	for( i=0; i+16<=count; i+=16 )
+	{
+		__m128i p = _mm_loadu_si128( (const __m128i *)(pri+i) );
+		_mm_storeu_si128( (__m128i *)(pri+i), _mm_or_si128( _mm_and_si128( p, pand ), por ) );
+	}
+	for( ; i<count; i++ )
+	{
+		pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+	}
+}
+
+/* priority update of the pixels selected by the transparency mask */
+INLINE void pri_masked_sse2( UINT8 *pri, const UINT8 *pMask, int mask, int value, int count, UINT32 pcode )
+{
+	__m128i pand = _mm_set1_epi8( (char)(pcode >> 8) );
+	__m128i por = _mm_set1_epi8( (char)pcode );
+	__m128i vmask = _mm_set1_epi8( (char)mask );
+	__m128i vvalue = _mm_set1_epi8( (char)value );
+	int i;
+
+	for( i=0; i+16<=count; i+=16 )
+	{
+		__m128i m = _mm_loadu_si128( (const __m128i *)(pMask+i) );
+		__m128i p = _mm_loadu_si128( (const __m128i *)(pri+i) );
+		__m128i sel = _mm_cmpeq_epi8( _mm_and_si128( m, vmask ), vvalue );
+		__m128i n = _mm_or_si128( _mm_and_si128( p, pand ), por );
+		_mm_storeu_si128( (__m128i *)(pri+i), _mm_or_si128( _mm_and_si128( sel, n ), _mm_andnot_si128( sel, p ) ) );
+	}
+	for( ; i<count; i++ )
+	{
+		if( (pMask[i]&mask)==value )
+		{
+			pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+		}
+	}
+}
+
+/* 16 bit mask of 8 pixels selected by the transparency mask */
+INLINE __m128i mask16_sse2( const UINT8 *pMask, __m128i vmask, __m128i vvalue )
+{
+	__m128i m = _mm_loadl_epi64( (const __m128i *)pMask );
+	m = _mm_cmpeq_epi8( _mm_and_si128( m, vmask ), vvalue );
+	return _mm_unpacklo_epi8( m, m );
+}
+
+/* 32 bit mask of 4 pixels selected by the transparency mask */
+INLINE __m128i mask32_sse2( const UINT8 *pMask, __m128i vmask, __m128i vvalue )
+{
+	UINT32 data;
+	__m128i m;
+	memcpy( &data, pMask, 4 );
+	m = _mm_cvtsi32_si128( data );
+	m = _mm_cmpeq_epi8( _mm_and_si128( m, vmask ), vvalue );
+	m = _mm_unpacklo_epi8( m, m );
+	return _mm_unpacklo_epi16( m, m );
+}
+
+/* the same of alpha_blend32() for 4 pixels, with the levels of the alpha cache */
+INLINE __m128i alpha_blend32_sse2( __m128i d, __m128i s, __m128i levels, __m128i leveld )
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_add_epi16(
+		_mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), levels ), 8 ),
+		_mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), leveld ), 8 ) );
+	__m128i hi = _mm_add_epi16(
+		_mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), levels ), 8 ),
+		_mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), leveld ), 8 ) );
+	return _mm_and_si128( _mm_packus_epi16( lo, hi ), _mm_set1_epi32( 0x00ffffff ) );
+}
+
+/* 4 pixels from the color table */
+INLINE __m128i clut32_sse2( const pen_t *clut, const UINT16 *source )
+{
+	return _mm_set_epi32( clut[source[3]], clut[source[2]], clut[source[1]], clut[source[0]] );
+}
+
+static void pio_sse2( void *dest, const void *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	if (pcode)
+		pri_opaque_sse2( pri, count, pcode );
+}
+#define pio pio_sse2
+
+static void pit_sse2( void *dest, const void *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	if (pcode)
+		pri_masked_sse2( pri, pMask, mask, value, count, pcode );
+}
+#define pit pit_sse2
+
+static void pdo16_sse2( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	memcpy( dest,source,count*sizeof(UINT16) );
+	pri_opaque_sse2( pri, count, pcode );
+}
+#define pdo16 pdo16_sse2
+
+static void pdo16pal_sse2( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int pal = pcode >> 16;
+	__m128i vpal = _mm_set1_epi16( (short)pal );
+	int i;
+	for( i=0; i+8<=count; i+=8 )
+	{
+		__m128i s = _mm_loadu_si128( (const __m128i *)(source+i) );
+		_mm_storeu_si128( (__m128i *)(dest+i), _mm_add_epi16( s, vpal ) );
+	}
+	for( ; i<count; i++ )
+	{
+		dest[i] = source[i] + pal;
+	}
+	pri_opaque_sse2( pri, count, pcode );
+}
+#define pdo16pal pdo16pal_sse2
+
+static void pdo15_sse2( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	for( i=0; i<count; i++ )
+	{
+		dest[i] = clut[source[i]];
+	}
+	pri_opaque_sse2( pri, count, pcode );
+}
+#define pdo15 pdo15_sse2
+
+static void pdo32_sse2( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	for( i=0; i<count; i++ )
+	{
+		dest[i] = clut[source[i]];
+	}
+	pri_opaque_sse2( pri, count, pcode );
+}
+#define pdo32 pdo32_sse2
+
+/* 16 bit pixels selected by the transparency mask, with a palette offset */
+INLINE void pdt16_sse2_dest( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, int pal )
+{
+	__m128i vmask = _mm_set1_epi8( (char)mask );
+	__m128i vvalue = _mm_set1_epi8( (char)value );
+	__m128i vpal = _mm_set1_epi16( (short)pal );
+	int i;
+	for( i=0; i+8<=count; i+=8 )
+	{
+		__m128i sel = mask16_sse2( pMask+i, vmask, vvalue );
+		__m128i s = _mm_add_epi16( _mm_loadu_si128( (const __m128i *)(source+i) ), vpal );
+		__m128i d = _mm_loadu_si128( (const __m128i *)(dest+i) );
+		_mm_storeu_si128( (__m128i *)(dest+i), _mm_or_si128( _mm_and_si128( sel, s ), _mm_andnot_si128( sel, d ) ) );
+	}
+	for( ; i<count; i++ )
+	{
+		if( (pMask[i]&mask)==value )
+			dest[i] = source[i] + pal;
+	}
+}
+
+static void pdt16_sse2( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	pdt16_sse2_dest( dest, source, pMask, mask, value, count, 0 );
+	pri_masked_sse2( pri, pMask, mask, value, count, pcode );
+}
+#define pdt16 pdt16_sse2
+
+static void pdt16pal_sse2( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	pdt16_sse2_dest( dest, source, pMask, mask, value, count, pcode >> 16 );
+	pri_masked_sse2( pri, pMask, mask, value, count, pcode );
+}
+#define pdt16pal pdt16pal_sse2
+
+static void pdt16np_sse2( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	pdt16_sse2_dest( dest, source, pMask, mask, value, count, 0 );
+}
+#define pdt16np pdt16np_sse2
+
+static void pdt15_sse2( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	for( i=0; i<count; i++ )
+	{
+		if( (pMask[i]&mask)==value )
+			dest[i] = clut[source[i]];
+	}
+	pri_masked_sse2( pri, pMask, mask, value, count, pcode );
+}
+#define pdt15 pdt15_sse2
+
+static void pdt32_sse2( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	for( i=0; i<count; i++ )
+	{
+		if( (pMask[i]&mask)==value )
+			dest[i] = clut[source[i]];
+	}
+	pri_masked_sse2( pri, pMask, mask, value, count, pcode );
+}
+#define pdt32 pdt32_sse2
+
+/* alpha blending of the pixels, selected by the transparency mask if pMask isn't NULL */
+INLINE void pb32_sse2_dest( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT32 pcode )
+{
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	__m128i levels = _mm_set1_epi16( (short)((drawgfx_alpha_cache.alphas - drawgfx_alpha_cache.alpha[0]) / 0x100) );
+	__m128i leveld = _mm_set1_epi16( (short)((drawgfx_alpha_cache.alphad - drawgfx_alpha_cache.alpha[0]) / 0x100) );
+	__m128i vmask = _mm_set1_epi8( (char)mask );
+	__m128i vvalue = _mm_set1_epi8( (char)value );
+	int i;
+	for( i=0; i+4<=count; i+=4 )
+	{
+		__m128i d = _mm_loadu_si128( (const __m128i *)(dest+i) );
+		__m128i b = alpha_blend32_sse2( d, clut32_sse2( clut, source+i ), levels, leveld );
+		if( pMask )
+		{
+			__m128i sel = mask32_sse2( pMask+i, vmask, vvalue );
+			b = _mm_or_si128( _mm_and_si128( sel, b ), _mm_andnot_si128( sel, d ) );
+		}
+		_mm_storeu_si128( (__m128i *)(dest+i), b );
+	}
+	for( ; i<count; i++ )
+	{
+		if( !pMask || (pMask[i]&mask)==value )
+			dest[i] = alpha_blend32(dest[i], clut[source[i]]);
+	}
+}
+
+static void pbo32_sse2( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	pb32_sse2_dest( dest, source, NULL, 0, 0, count, pcode );
+	pri_opaque_sse2( pri, count, pcode );
+}
+#define pbo32 pbo32_sse2
+
+static void npbo32_sse2( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	pb32_sse2_dest( dest, source, NULL, 0, 0, count, pcode );
+}
+#define npbo32 npbo32_sse2
+
+static void pbt32_sse2( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	pb32_sse2_dest( dest, source, pMask, mask, value, count, pcode );
+	pri_masked_sse2( pri, pMask, mask, value, count, pcode );
+}
+#define pbt32 pbt32_sse2
+
+static void npbt32_sse2( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	pb32_sse2_dest( dest, source, pMask, mask, value, count, pcode );
+}
+#define npbt32 npbt32_sse2
+
+#endif
+
+/***********************************************************************************/
+
+#ifndef pio
 static void pio( void *dest, const void *source, int count, UINT8 *pri, UINT32 pcode )
 {
 	int i;
@@ -341,7 +646,9 @@ static void pio( void *dest, const void *source, int count, UINT8 *pri, UINT32 p
 			pri[i] = (pri[i] & (pcode >> 8)) | pcode;
 		}
 }
+#endif
 
+#ifndef pit
 static void pit( void *dest, const void *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
 {
 	int i;
@@ -355,6 +662,7 @@ static void pit( void *dest, const void *source, const UINT8 *pMask, int mask, i
 			}
 		}
 }
+#endif
 
 /***********************************************************************************/
 
@@ -390,6 +698,7 @@ static void pdo16np( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri,
 }
 #endif
 
+#ifndef pdo15
 static void pdo15( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
 {
 	int i;
@@ -400,6 +709,7 @@ static void pdo15( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UI
 		pri[i] = (pri[i] & (pcode >> 8)) | pcode;
 	}
 }
+#endif
 
 #ifndef pdo32
 static void pdo32( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
@@ -493,6 +803,7 @@ static void pdt16np( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int
 }
 #endif
 
+#ifndef pdt15
 static void pdt15( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
 {
 	int i;
@@ -506,6 +817,7 @@ static void pdt15( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int m
 		}
 	}
 }
+#endif
 
 #ifndef pdt32
 static void pdt32( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
@@ -661,12 +973,12 @@ static void npbt32( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int
 #define DECLARE(function,args,body) static void function##32BPP args body
 #include "tilemap.c"
 
-#define PAL_INIT const pen_t *pPalData = tile_info.pal_data
+#define PAL_INIT const pen_t *pPalData = info->pal_data
 #define PAL_GET(pen) pPalData[pen]
 #define TRANSP(f) f ## _ind
 #include "tilemap.c"
 
-#define PAL_INIT int palBase = tile_info.pal_data - Machine->remapped_colortable
+#define PAL_INIT int palBase = info->pal_data - Machine->remapped_colortable
 #define PAL_GET(pen) (palBase + (pen))
 #define TRANSP(f) f ## _raw
 #include "tilemap.c"
@@ -752,6 +1064,13 @@ void tilemap_exit( void )
 		first_tilemap = next;
 	}
 	bitmap_free( priority_bitmap );
+
+	free( refresh.entry );
+	free( refresh.row_first );
+	refresh.entry = NULL;
+	refresh.row_first = NULL;
+	refresh.entry_max = 0;
+	refresh.row_max = 0;
 }
 
 /***********************************************************************************/
@@ -1014,16 +1333,131 @@ profiler_mark(PROFILER_TILEMAP_UPDATE);
 	x0 = tmap->cached_tile_width*col;
 	y0 = tmap->cached_tile_height*row;
 
-	tmap->transparency_data[cached_indx] = tmap->draw_tile(tmap,x0,y0,flags );
+	tmap->transparency_data[cached_indx] = tmap->draw_tile(tmap,&tile_info,x0,y0,flags );
 
 profiler_mark(PROFILER_END);
 }
 
-mame_bitmap *tilemap_get_pixmap( tilemap * tmap )
+/* grow the buffers of the parallel refresh */
+static int tilemap_refresh_alloc( UINT32 count, UINT32 rows )
+{
+	if( count > refresh.entry_max )
+	{
+		struct tile_refresh_entry *entry = malloc( count * sizeof(struct tile_refresh_entry) );
+		if( !entry )
+			return 0;
+		free( refresh.entry );
+		refresh.entry = entry;
+		refresh.entry_max = count;
+	}
+
+	if( rows + 1 > refresh.row_max )
+	{
+		UINT32 *row_first = malloc( (rows + 1) * sizeof(UINT32) );
+		if( !row_first )
+			return 0;
+		free( refresh.row_first );
+		refresh.row_first = row_first;
+		refresh.row_max = rows + 1;
+	}
+
+	return 1;
+}
+
+/* draw the tiles of the rows [begin, end) of the refresh buffer */
+static void tilemap_refresh_task( void *param, int begin, int end )
 {
-	UINT32 cached_indx = 0;
+	tilemap *tmap = refresh.tmap;
+	UINT32 i;
+
+	for( i=refresh.row_first[begin]; i<refresh.row_first[end]; i++ )
+	{
+		struct tile_refresh_entry *entry = &refresh.entry[i];
+		tmap->transparency_data[entry->cached_indx] = tmap->draw_tile( tmap, &entry->info, entry->x0, entry->y0, entry->flags );
+	}
+}
+
+/*
+    Refresh all the tiles with the specified transparency code.
+    The driver callback isn't thread safe and it's called for every tile
+    in order, saving a copy of the tile info. The tiles are then drawn in
+    parallel, splitting them by rows.
+*/
+static void tilemap_refresh_tiles( tilemap *tmap, UINT8 code )
+{
+	UINT32 cached_indx;
 	UINT32 row,col;
+	UINT32 count;
+	UINT32 rows;
+
+	count = 0;
+	for( cached_indx=0; cached_indx<tmap->num_tiles; cached_indx++ )
+	{
+		if( tmap->transparency_data[cached_indx] == code )
+			count++;
+	}
+
+	if( count == 0 )
+		return;
+
+	/* few tiles are not worth the threads */
+	if( count < TILE_REFRESH_PARALLEL_MIN || !tilemap_refresh_alloc( count, tmap->num_cached_rows ) )
+	{
+		cached_indx = 0;
+		for( row=0; row<tmap->num_cached_rows; row++ )
+		{
+			for( col=0; col<tmap->num_cached_cols; col++ )
+			{
+				if( tmap->transparency_data[cached_indx] == code )
+				{
+					update_tile_info( tmap, cached_indx, col, row );
+				}
+				cached_indx++;
+			} /* next col */
+		} /* next row */
+		return;
+	}
 
+profiler_mark(PROFILER_TILEMAP_UPDATE);
+
+	count = 0;
+	rows = 0;
+	cached_indx = 0;
+	for( row=0; row<tmap->num_cached_rows; row++ )
+	{
+		UINT32 first = count;
+
+		for( col=0; col<tmap->num_cached_cols; col++ )
+		{
+			if( tmap->transparency_data[cached_indx] == code )
+			{
+				struct tile_refresh_entry *entry = &refresh.entry[count++];
+				UINT32 flags;
+
+				tmap->tile_get_info( tmap->cached_indx_to_memory_offset[cached_indx] );
+				flags = tile_info.flags;
+				entry->info = tile_info;
+				entry->flags = (flags&0xfc)|tmap->logical_flip_to_cached_flip[flags&0x3];
+				entry->x0 = tmap->cached_tile_width*col;
+				entry->y0 = tmap->cached_tile_height*row;
+				entry->cached_indx = cached_indx;
+			}
+			cached_indx++;
+		} /* next col */
+
+		if( count != first )
+			refresh.row_first[rows++] = first;
+	} /* next row */
+	refresh.row_first[rows] = count;
+
+	refresh.tmap = tmap;
+	osd_parallel_for( tilemap_refresh_task, NULL, rows, 1 );
+
+profiler_mark(PROFILER_END);
+}
+
+mame_bitmap *tilemap_get_pixmap( tilemap * tmap )
+{
 	if (!tmap)
 		return 0;
 
@@ -1041,18 +1475,7 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 		memset( &tile_info, 0x00, sizeof(tile_info) ); /* initialize defaults */
 		tile_info.user_data = tmap->user_data;
 
-		/* walk over cached rows/cols (better to walk screen coords) */
-		for( row=0; row<tmap->num_cached_rows; row++ )
-		{
-			for( col=0; col<tmap->num_cached_cols; col++ )
-			{
-				if( tmap->transparency_data[cached_indx] == TILE_FLAG_DIRTY )
-				{
-					update_tile_info( tmap, cached_indx, col, row );
-				}
-				cached_indx++;
-			} /* next col */
-		} /* next row */
+		tilemap_refresh_tiles( tmap, TILE_FLAG_DIRTY );
 
 		tmap->all_tiles_clean = 1;
 
@@ -1172,6 +1595,220 @@ void tilemap_set_user_data( tilemap *tmap, void *user_data )
 
 /***********************************************************************************/
 
+/* mark as queued the dirty tiles that the draw function is going to refresh */
+static void tilemap_queue_tiles( tilemap *tmap, int xpos, int ypos, int mask, int value )
+{
+	int x1 = xpos;
+	int y1 = ypos;
+	int x2 = xpos+tmap->cached_width;
+	int y2 = ypos+tmap->cached_height;
+	int c1,c2,r1,r2;
+	int row,column;
+
+	/* clip source coordinates, like the draw functions */
+	if( x1<blit.clip_left ) x1 = blit.clip_left;
+	if( x2>blit.clip_right ) x2 = blit.clip_right;
+	if( y1<blit.clip_top ) y1 = blit.clip_top;
+	if( y2>blit.clip_bottom ) y2 = blit.clip_bottom;
+
+	if( x1>=x2 || y1>=y2 )
+		return;
+
+	/* convert screen coordinates to source tilemap coordinates */
+	x1 -= xpos;
+	y1 -= ypos;
+	x2 -= xpos;
+	y2 -= ypos;
+
+	c1 = x1/tmap->cached_tile_width; /* round down */
+	c2 = (x2+tmap->cached_tile_width-1)/tmap->cached_tile_width; /* round up */
+	r1 = y1/tmap->cached_tile_height; /* round down */
+	r2 = (y2+tmap->cached_tile_height-1)/tmap->cached_tile_height; /* round up */
+
+	for( row=r1; row<r2; row++ )
+	{
+		UINT8 *data = tmap->transparency_data + row*tmap->num_cached_cols;
+		for( column=c1; column<c2; column++ )
+		{
+			if( data[column] == TILE_FLAG_DIRTY )
+				data[column] = TILE_FLAG_QUEUED;
+		}
+	}
+}
+
+/* call the draw function for every part of the tilemap visible with the scroll */
+static void tilemap_draw_scroll( tilemap *tmap, tilemap_draw_func drawfunc, int rows, int cols, const int *rowscroll, const int *colscroll,
+	int left, int top, int right, int bottom, int mask, int value )
+{
+	int xpos,ypos;
+
+	if( rows == 1 && cols == 1 )
+	{ /* XY scrolling playfield */
+		int scrollx = rowscroll[0];
+		int scrolly = colscroll[0];
+
+		if( scrollx < 0 )
+		{
+			scrollx = tmap->cached_width - (-scrollx) % tmap->cached_width;
+		}
+		else
+		{
+			scrollx = scrollx % tmap->cached_width;
+		}
+
+		if( scrolly < 0 )
+		{
+			scrolly = tmap->cached_height - (-scrolly) % tmap->cached_height;
+		}
+		else
+		{
+			scrolly = scrolly % tmap->cached_height;
+		}
+
+ 		blit.clip_left		= left;
+ 		blit.clip_top		= top;
+ 		blit.clip_right		= right;
+ 		blit.clip_bottom	= bottom;
+
+		for(
+			ypos = scrolly - tmap->cached_height;
+			ypos < blit.clip_bottom;
+			ypos += tmap->cached_height )
+		{
+			for(
+				xpos = scrollx - tmap->cached_width;
+				xpos < blit.clip_right;
+				xpos += tmap->cached_width )
+			{
+				drawfunc( tmap, xpos, ypos, mask, value );
+			}
+		}
+	}
+	else if( rows == 1 )
+	{ /* scrolling columns + horizontal scroll */
+		int col = 0;
+		int colwidth = tmap->cached_width / cols;
+		int scrollx = rowscroll[0];
+
+		if( scrollx < 0 )
+		{
+			scrollx = tmap->cached_width - (-scrollx) % tmap->cached_width;
+		}
+		else
+		{
+			scrollx = scrollx % tmap->cached_width;
+		}
+
+		blit.clip_top		= top;
+		blit.clip_bottom	= bottom;
+
+		while( col < cols )
+		{
+			int cons	= 1;
+			int scrolly	= colscroll[col];
+
+ 			/* count consecutive columns scrolled by the same amount */
+			if( scrolly != TILE_LINE_DISABLED )
+			{
+				while( col + cons < cols &&	colscroll[col + cons] == scrolly ) cons++;
+
+				if( scrolly < 0 )
+				{
+					scrolly = tmap->cached_height - (-scrolly) % tmap->cached_height;
+				}
+				else
+				{
+					scrolly %= tmap->cached_height;
+				}
+
+				blit.clip_left = col * colwidth + scrollx;
+				if (blit.clip_left < left) blit.clip_left = left;
+				blit.clip_right = (col + cons) * colwidth + scrollx;
+				if (blit.clip_right > right) blit.clip_right = right;
+
+				for(
+					ypos = scrolly - tmap->cached_height;
+					ypos < blit.clip_bottom;
+					ypos += tmap->cached_height )
+				{
+					drawfunc( tmap, scrollx, ypos, mask, value );
+				}
+
+				blit.clip_left = col * colwidth + scrollx - tmap->cached_width;
+				if (blit.clip_left < left) blit.clip_left = left;
+				blit.clip_right = (col + cons) * colwidth + scrollx - tmap->cached_width;
+				if (blit.clip_right > right) blit.clip_right = right;
+
+				for(
+					ypos = scrolly - tmap->cached_height;
+					ypos < blit.clip_bottom;
+					ypos += tmap->cached_height )
+				{
+					drawfunc( tmap, scrollx - tmap->cached_width, ypos, mask, value );
+				}
+			}
+			col += cons;
+		}
+	}
+	else if( cols == 1 )
+	{ /* scrolling rows + vertical scroll */
+		int row = 0;
+		int rowheight = tmap->cached_height / rows;
+		int scrolly = colscroll[0];
+		if( scrolly < 0 )
+		{
+			scrolly = tmap->cached_height - (-scrolly) % tmap->cached_height;
+		}
+		else
+		{
+			scrolly = scrolly % tmap->cached_height;
+		}
+		blit.clip_left = left;
+		blit.clip_right = right;
+		while( row < rows )
+		{
+			int cons = 1;
+			int scrollx = rowscroll[row];
+			/* count consecutive rows scrolled by the same amount */
+			if( scrollx != TILE_LINE_DISABLED )
+			{
+				while( row + cons < rows &&	rowscroll[row + cons] == scrollx ) cons++;
+				if( scrollx < 0)
+				{
+					scrollx = tmap->cached_width - (-scrollx) % tmap->cached_width;
+				}
+				else
+				{
+					scrollx %= tmap->cached_width;
+				}
+				blit.clip_top = row * rowheight + scrolly;
+				if (blit.clip_top < top) blit.clip_top = top;
+				blit.clip_bottom = (row + cons) * rowheight + scrolly;
+				if (blit.clip_bottom > bottom) blit.clip_bottom = bottom;
+				for(
+					xpos = scrollx - tmap->cached_width;
+					xpos < blit.clip_right;
+					xpos += tmap->cached_width )
+				{
+					drawfunc( tmap, xpos, scrolly, mask, value );
+				}
+				blit.clip_top = row * rowheight + scrolly - tmap->cached_height;
+				if (blit.clip_top < top) blit.clip_top = top;
+				blit.clip_bottom = (row + cons) * rowheight + scrolly - tmap->cached_height;
+				if (blit.clip_bottom > bottom) blit.clip_bottom = bottom;
+				for(
+					xpos = scrollx - tmap->cached_width;
+					xpos < blit.clip_right;
+					xpos += tmap->cached_width )
+				{
+					drawfunc( tmap, xpos, scrolly - tmap->cached_height, mask, value );
+				}
+			}
+			row += cons;
+		}
+	}
+}
+
 void tilemap_draw( mame_bitmap *dest, const rectangle *cliprect, tilemap *tmap, UINT32 flags, UINT32 priority )
 {
 	tilemap_draw_primask( dest, cliprect, tmap, flags, priority, 0xff );
@@ -1180,7 +1817,7 @@ void tilemap_draw( mame_bitmap *dest, const rectangle *cliprect, tilemap *tmap,
 void tilemap_draw_primask( mame_bitmap *dest, const rectangle *cliprect, tilemap *tmap, UINT32 flags, UINT32 priority, UINT32 priority_mask )
 {
 	tilemap_draw_func drawfunc = pick_draw_func(dest);
-	int xpos,ypos,mask,value;
+	int mask,value;
 	int rows, cols;
 	const int *rowscroll, *colscroll;
 	int left, right, top, bottom;
@@ -1325,171 +1962,14 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 
 		blit.tilemap_priority_code = (priority & 0xff) | ((priority_mask & 0xff) << 8) | (tmap->palette_offset << 16);
 
-		if( rows == 1 && cols == 1 )
-		{ /* XY scrolling playfield */
-			int scrollx = rowscroll[0];
-			int scrolly = colscroll[0];
-
-			if( scrollx < 0 )
-			{
-				scrollx = tmap->cached_width - (-scrollx) % tmap->cached_width;
-			}
-			else
-			{
-				scrollx = scrollx % tmap->cached_width;
-			}
-
-			if( scrolly < 0 )
-			{
-				scrolly = tmap->cached_height - (-scrolly) % tmap->cached_height;
-			}
-			else
-			{
-				scrolly = scrolly % tmap->cached_height;
-			}
-
-	 		blit.clip_left		= left;
-	 		blit.clip_top		= top;
-	 		blit.clip_right		= right;
-	 		blit.clip_bottom	= bottom;
-
-			for(
-				ypos = scrolly - tmap->cached_height;
-				ypos < blit.clip_bottom;
-				ypos += tmap->cached_height )
-			{
-				for(
-					xpos = scrollx - tmap->cached_width;
-					xpos < blit.clip_right;
-					xpos += tmap->cached_width )
-				{
-					drawfunc( tmap, xpos, ypos, mask, value );
-				}
-			}
+		/* refresh at once all the dirty tiles that are going to be drawn */
+		if( !tmap->all_tiles_clean )
+		{
+			tilemap_draw_scroll( tmap, tilemap_queue_tiles, rows, cols, rowscroll, colscroll, left, top, right, bottom, mask, value );
+			tilemap_refresh_tiles( tmap, TILE_FLAG_QUEUED );
 		}
-		else if( rows == 1 )
-		{ /* scrolling columns + horizontal scroll */
-			int col = 0;
-			int colwidth = tmap->cached_width / cols;
-			int scrollx = rowscroll[0];
-
-			if( scrollx < 0 )
-			{
-				scrollx = tmap->cached_width - (-scrollx) % tmap->cached_width;
-			}
-			else
-			{
-				scrollx = scrollx % tmap->cached_width;
-			}
-
-			blit.clip_top		= top;
-			blit.clip_bottom	= bottom;
-
-			while( col < cols )
-			{
-				int cons	= 1;
-				int scrolly	= colscroll[col];
-
-	 			/* count consecutive columns scrolled by the same amount */
-				if( scrolly != TILE_LINE_DISABLED )
-				{
-					while( col + cons < cols &&	colscroll[col + cons] == scrolly ) cons++;
-
-					if( scrolly < 0 )
-					{
-						scrolly = tmap->cached_height - (-scrolly) % tmap->cached_height;
-					}
-					else
-					{
-						scrolly %= tmap->cached_height;
-					}
-
-					blit.clip_left = col * colwidth + scrollx;
-					if (blit.clip_left < left) blit.clip_left = left;
-					blit.clip_right = (col + cons) * colwidth + scrollx;
-					if (blit.clip_right > right) blit.clip_right = right;
-
-					for(
-						ypos = scrolly - tmap->cached_height;
-						ypos < blit.clip_bottom;
-						ypos += tmap->cached_height )
-					{
-						drawfunc( tmap, scrollx, ypos, mask, value );
-					}
-
-					blit.clip_left = col * colwidth + scrollx - tmap->cached_width;
-					if (blit.clip_left < left) blit.clip_left = left;
-					blit.clip_right = (col + cons) * colwidth + scrollx - tmap->cached_width;
-					if (blit.clip_right > right) blit.clip_right = right;
 
-					for(
-						ypos = scrolly - tmap->cached_height;
-						ypos < blit.clip_bottom;
-						ypos += tmap->cached_height )
-					{
-						drawfunc( tmap, scrollx - tmap->cached_width, ypos, mask, value );
-					}
-				}
-				col += cons;
-			}
-		}
-		else if( cols == 1 )
-		{ /* scrolling rows + vertical scroll */
-			int row = 0;
-			int rowheight = tmap->cached_height / rows;
-			int scrolly = colscroll[0];
-			if( scrolly < 0 )
-			{
-				scrolly = tmap->cached_height - (-scrolly) % tmap->cached_height;
-			}
-			else
-			{
-				scrolly = scrolly % tmap->cached_height;
-			}
-			blit.clip_left = left;
-			blit.clip_right = right;
-			while( row < rows )
-			{
-				int cons = 1;
-				int scrollx = rowscroll[row];
-				/* count consecutive rows scrolled by the same amount */
-				if( scrollx != TILE_LINE_DISABLED )
-				{
-					while( row + cons < rows &&	rowscroll[row + cons] == scrollx ) cons++;
-					if( scrollx < 0)
-					{
-						scrollx = tmap->cached_width - (-scrollx) % tmap->cached_width;
-					}
-					else
-					{
-						scrollx %= tmap->cached_width;
-					}
-					blit.clip_top = row * rowheight + scrolly;
-					if (blit.clip_top < top) blit.clip_top = top;
-					blit.clip_bottom = (row + cons) * rowheight + scrolly;
-					if (blit.clip_bottom > bottom) blit.clip_bottom = bottom;
-					for(
-						xpos = scrollx - tmap->cached_width;
-						xpos < blit.clip_right;
-						xpos += tmap->cached_width )
-					{
-						drawfunc( tmap, xpos, scrolly, mask, value );
-					}
-					blit.clip_top = row * rowheight + scrolly - tmap->cached_height;
-					if (blit.clip_top < top) blit.clip_top = top;
-					blit.clip_bottom = (row + cons) * rowheight + scrolly - tmap->cached_height;
-					if (blit.clip_bottom > bottom) blit.clip_bottom = bottom;
-					for(
-						xpos = scrollx - tmap->cached_width;
-						xpos < blit.clip_right;
-						xpos += tmap->cached_width )
-					{
-						drawfunc( tmap, xpos, scrolly - tmap->cached_height, mask, value );
-					}
-				}
-				row += cons;
-			}
-		}
+		tilemap_draw_scroll( tmap, drawfunc, rows, cols, rowscroll, colscroll, left, top, right, bottom, mask, value );
 	}
 profiler_mark(PROFILER_END);
 }
@@ -2150,18 +2630,18 @@ DECLARE( draw, (tilemap *tmap, int xpos, int ypos, int mask, int value ),
  * in that tile have the same masked transparency value.
  */
 
-static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel;
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 code_opaque = code_transparent | TILE_FLAG_FG_OPAQUE;
 	UINT32 tx;
 	UINT32 ty;
@@ -2170,7 +2650,7 @@ static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, UINT32 x0, UINT32
 	UINT32 x;
 	UINT32 y;
 	UINT32 pen;
-	UINT8 *pBitmask = tile_info.mask_data;
+	UINT8 *pBitmask = info->mask_data;
 	UINT32 bitoffs;
 	int bWhollyOpaque;
 	int bWhollyTransparent;
@@ -2248,18 +2728,18 @@ static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, UINT32 x0, UINT32
 	return (bWhollyOpaque || bWhollyTransparent)?0:TILE_FLAG_FG_OPAQUE;
 }
 
-static UINT8 TRANSP(HandleTransparencyColor)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyColor)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 code_opaque = code_transparent | TILE_FLAG_FG_OPAQUE;
 	UINT32 tx;
 	UINT32 ty;
@@ -2348,18 +2828,18 @@ static UINT8 TRANSP(HandleTransparencyColor)(tilemap *tmap, UINT32 x0, UINT32 y0
 	return (bWhollyOpaque || bWhollyTransparent)?0:TILE_FLAG_FG_OPAQUE;
 }
 
-static UINT8 TRANSP(HandleTransparencyPen)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyPen)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 code_opaque = code_transparent | TILE_FLAG_FG_OPAQUE;
 	UINT32 tx;
 	UINT32 ty;
@@ -2446,16 +2926,16 @@ static UINT8 TRANSP(HandleTransparencyPen)(tilemap *tmap, UINT32 x0, UINT32 y0,
 	return (bWhollyOpaque || bWhollyTransparent)?0:TILE_FLAG_FG_OPAQUE;
 }
 
-static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
 	UINT32 tx;
 	UINT32 ty;
@@ -2465,8 +2945,8 @@ static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, UINT32 x0, UINT32 y
 	UINT32 y;
 	UINT32 pen;
 	UINT32 penbit = tmap->transparent_pen;
-	UINT32 code_front = tile_info.priority | TILE_FLAG_FG_OPAQUE;
-	UINT32 code_back = tile_info.priority | TILE_FLAG_BG_OPAQUE;
+	UINT32 code_front = info->priority | TILE_FLAG_FG_OPAQUE;
+	UINT32 code_back = info->priority | TILE_FLAG_BG_OPAQUE;
 	int code;
 	int and_flags = ~0;
 	int or_flags = 0;
@@ -2526,18 +3006,18 @@ static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, UINT32 x0, UINT32 y
 	return or_flags ^ and_flags;
 }
 
-static UINT8 TRANSP(HandleTransparencyPens)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyPens)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 tx;
 	UINT32 ty;
 	UINT32 data;
@@ -2612,18 +3092,18 @@ static UINT8 TRANSP(HandleTransparencyPens)(tilemap *tmap, UINT32 x0, UINT32 y0,
 	return and_flags ^ or_flags;
 }
 
-static UINT8 TRANSP(HandleTransparencyNone)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyNone)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_opaque = tile_info.priority;
+	UINT32 code_opaque = info->priority;
 	UINT32 tx;
 	UINT32 ty;
 	UINT32 data;
@@ -45,7 +45,12 @@
 struct _mame_timer
 {
 	mame_timer *	next;
-	mame_timer *	prev;
+	mame_timer *	parent;			/* position in the queue */
+	mame_timer *	left;
+	mame_timer *	right;
+	UINT32			priority;		/* random priority that balances the queue */
+	mame_time		maxexpire;		/* highest expire time of the subtree */
+	UINT8			queued;
 	void 			(*callback)(int);
 	void			(*callback_ptr)(void *);
 	int 			callback_param;
@@ -74,9 +79,11 @@ UINT32 cycles_per_second[MAX_CPU];
 double cycles_to_sec[MAX_CPU];
 double sec_to_cycles[MAX_CPU];
 
-/* list of active timers */
+/* queue of active timers, a tree kept in the order of the old sorted list */
 static mame_timer timers[MAX_TIMERS];
+static mame_timer *timer_root;
 static mame_timer *timer_head;
+static UINT32 timer_priority;
 static mame_timer *timer_free_head;
 static mame_timer *timer_free_tail;
 
@@ -155,86 +162,218 @@ INLINE mame_timer *timer_new(void)
 
 
 /*-------------------------------------------------
-    timer_list_insert - insert a new timer into
-    the list at the appropriate location
+    timer_queue_fix - recompute the highest
+    expire time of a subtree
 -------------------------------------------------*/
 
-INLINE void timer_list_insert(mame_timer *timer)
+INLINE void timer_queue_fix(mame_timer *timer)
+{
+	timer->maxexpire = timer->expire;
+	if (timer->left && compare_mame_times(timer->left->maxexpire, timer->maxexpire) > 0)
+		timer->maxexpire = timer->left->maxexpire;
+	if (timer->right && compare_mame_times(timer->right->maxexpire, timer->maxexpire) > 0)
+		timer->maxexpire = timer->right->maxexpire;
+}
+
+
+/*-------------------------------------------------
+    timer_queue_rotate - move a timer over its
+    parent, keeping the queue order, and so the
+    head
+-------------------------------------------------*/
+
+INLINE void timer_queue_rotate(mame_timer *timer)
+{
+	mame_timer *parent = timer->parent;
+	mame_timer *grand = parent->parent;
+
+	if (timer == parent->left)
+	{
+		parent->left = timer->right;
+		if (timer->right)
+			timer->right->parent = parent;
+		timer->right = parent;
+	}
+	else
+	{
+		parent->right = timer->left;
+		if (timer->left)
+			timer->left->parent = parent;
+		timer->left = parent;
+	}
+	parent->parent = timer;
+
+	timer->parent = grand;
+	if (!grand)
+		timer_root = timer;
+	else if (grand->left == parent)
+		grand->left = timer;
+	else
+		grand->right = timer;
+
+	timer_queue_fix(parent);
+	timer_queue_fix(timer);
+}
+
+
+/*-------------------------------------------------
+    timer_queue_head - return the first timer of
+    the queue
+-------------------------------------------------*/
+
+INLINE mame_timer *timer_queue_head(void)
+{
+	return timer_head;
+}
+
+
+/*-------------------------------------------------
+    timer_queue_next - return the timer following
+    another in the queue
+-------------------------------------------------*/
+
+INLINE mame_timer *timer_queue_next(mame_timer *timer)
+{
+	if (timer->right)
+	{
+		timer = timer->right;
+		while (timer->left)
+			timer = timer->left;
+		return timer;
+	}
+
+	while (timer->parent && timer == timer->parent->right)
+		timer = timer->parent;
+	return timer->parent;
+}
+
+
+/*-------------------------------------------------
+    timer_queue_insert - insert a new timer into
+    the queue at the appropriate location
+-------------------------------------------------*/
+
+INLINE void timer_queue_insert(mame_timer *timer)
 {
 	mame_time expire = timer->enabled ? timer->expire : time_never;
-	mame_timer *t, *lt = NULL;
+	mame_timer *t, *before = NULL;
 
 	/* sanity checks for the debug build */
 	#ifdef MAME_DEBUG
 	{
-		int tnum = 0;
+		if (timer->queued)
+			fatalerror("This timer is already inserted in the list!");
+	}
+	#endif
 
-		/* loop over the timer list */
-		for (t = timer_head; t; t = t->next, tnum++)
+	/* find the first timer that expires after us, like the scan of a list; */
+	/* it compares the expire time of the queued timers also if disabled */
+	for (t = timer_root; t; )
+	{
+		if (t->left && compare_mame_times(t->left->maxexpire, expire) > 0)
+			t = t->left;
+		else if (compare_mame_times(t->expire, expire) > 0)
 		{
-			if (t == timer)
-				fatalerror("This timer is already inserted in the list!");
-			if (tnum == MAX_TIMERS-1)
-				fatalerror("Timer list is full!");
+			before = t;
+			break;
 		}
+		else if (t->right && compare_mame_times(t->right->maxexpire, expire) > 0)
+			t = t->right;
+		else
+			break;
 	}
-	#endif
 
-	/* loop over the timer list */
-	for (t = timer_head; t; lt = t, t = t->next)
+	/* link it just before that timer, or after the last one */
+	if (before == timer_head)
+		timer_head = timer;
+	timer->left = NULL;
+	timer->right = NULL;
+	timer->maxexpire = timer->expire;
+	timer->queued = TRUE;
+	if (before && !before->left)
 	{
-		/* if the current list entry expires after us, we should be inserted before it */
-		if (compare_mame_times(t->expire, expire) > 0)
+		before->left = timer;
+		timer->parent = before;
+	}
+	else
+	{
+		t = before ? before->left : timer_root;
+		if (t)
 		{
-			/* link the new guy in before the current list entry */
-			timer->prev = t->prev;
-			timer->next = t;
-
-			if (t->prev)
-				t->prev->next = timer;
-			else
-				timer_head = timer;
-			t->prev = timer;
-			return;
+			while (t->right)
+				t = t->right;
+			t->right = timer;
 		}
+		else
+			timer_root = timer;
+		timer->parent = t;
 	}
 
-	/* need to insert after the last one */
-	if (lt)
-		lt->next = timer;
-	else
-		timer_head = timer;
-	timer->prev = lt;
-	timer->next = NULL;
+	/* update the subtrees, and restore the priorities */
+	for (t = timer->parent; t; t = t->parent)
+		timer_queue_fix(t);
+	timer_priority = timer_priority * 1664525 + 1013904223;
+	timer->priority = timer_priority;
+	while (timer->parent && timer->parent->priority < timer->priority)
+		timer_queue_rotate(timer);
 }
 
 
 /*-------------------------------------------------
-    timer_list_remove - remove a timer from the
-    linked list
+    timer_queue_remove - remove a timer from the
+    queue
 -------------------------------------------------*/
 
-INLINE void timer_list_remove(mame_timer *timer)
+INLINE void timer_queue_remove(mame_timer *timer)
 {
+	mame_timer *t;
+
 	/* sanity checks for the debug build */
 	#ifdef MAME_DEBUG
 	{
-		mame_timer *t;
-
-		/* loop over the timer list */
-		for (t = timer_head; t && t != timer; t = t->next) ;
-		if (t == NULL)
+		if (!timer->queued)
 			fatalerror("timer (%s from %s:%d) not found in list", timer->func, timer->file, timer->line);
 	}
 	#endif
 
-	/* remove it from the list */
-	if (timer->prev)
-		timer->prev->next = timer->next;
+	/* the next timer becomes the head */
+	if (timer == timer_head)
+		timer_head = timer_queue_next(timer);
+
+	/* move it down to a leaf */
+	while (timer->left || timer->right)
+	{
+		if (!timer->right || (timer->left && timer->left->priority > timer->right->priority))
+			timer_queue_rotate(timer->left);
+		else
+			timer_queue_rotate(timer->right);
+	}
+
+	/* unlink it; the expire time may be already changed, so update the subtrees */
+	t = timer->parent;
+	if (!t)
+		timer_root = NULL;
+	else if (t->left == timer)
+		t->left = NULL;
 	else
-		timer_head = timer->next;
-	if (timer->next)
-		timer->next->prev = timer->prev;
+		t->right = NULL;
+	for (; t; t = t->parent)
+		timer_queue_fix(t);
+
+	timer->parent = NULL;
+	timer->queued = FALSE;
+}
+
+
+/*-------------------------------------------------
+    timer_queue_update - move a queued timer to
+    the position of its new expire time
+-------------------------------------------------*/
+
+INLINE void timer_queue_update(mame_timer *timer)
+{
+	timer_queue_remove(timer);
+	timer_queue_insert(timer);
 }
 
 
@@ -274,14 +413,15 @@ void timer_init(void)
 	memset(timers, 0, sizeof(timers));
 
 	/* initialize the lists */
+	timer_root = NULL;
 	timer_head = NULL;
+	timer_priority = 0;
 	timer_free_head = &timers[0];
-	for (i = 0; i < MAX_TIMERS-1; i++)
+	for (i = 0; i < MAX_TIMERS; i++)
 	{
 		timers[i].tag = -1;
-		timers[i].next = &timers[i+1];
+		timers[i].next = (i < MAX_TIMERS-1) ? &timers[i+1] : NULL;
 	}
-	timers[MAX_TIMERS-1].next = NULL;
 	timer_free_tail = &timers[MAX_TIMERS-1];
 }
 
@@ -296,11 +436,11 @@ void timer_free(void)
 	int tag = get_resource_tag();
 	mame_timer *timer, *next;
 
-	/* scan the list */
-	for (timer = timer_head; timer != NULL; timer = next)
+	/* scan the queue */
+	for (timer = timer_queue_head(); timer != NULL; timer = next)
 	{
 		/* prefetch the next timer in case we remove this one */
-		next = timer->next;
+		next = timer_queue_next(timer);
 
 		/* if this tag matches, remove it */
 		if (timer->tag == tag)
@@ -323,7 +463,7 @@ void timer_free(void)
 
 mame_time mame_timer_next_fire_time(void)
 {
-	return timer_head->expire;
+	return timer_queue_head()->expire;
 }
 
 
@@ -339,15 +479,14 @@ void mame_timer_set_global_time(mame_time newbase)
 	/* set the new global offset */
 	global_basetime = newbase;
 
-	LOG(("mame_timer_set_global_time: new=%.9f head->expire=%.9f\n", mame_time_to_double(newbase), mame_time_to_double(timer_head->expire)));
+	LOG(("mame_timer_set_global_time: new=%.9f head->expire=%.9f\n", mame_time_to_double(newbase), mame_time_to_double(timer_queue_head()->expire)));
 
 	/* now process any timers that are overdue */
-	while (compare_mame_times(timer_head->expire, global_basetime) <= 0)
+	while (compare_mame_times((timer = timer_queue_head())->expire, global_basetime) <= 0)
 	{
-		int was_enabled = timer_head->enabled;
+		int was_enabled = timer->enabled;
 
 		/* if this is a one-shot timer, disable it now */
-		timer = timer_head;
 		if (compare_mame_times(timer->period, time_zero) == 0 || compare_mame_times(timer->period, time_never) == 0)
 			timer->enabled = FALSE;
 
@@ -391,8 +530,7 @@ void mame_timer_set_global_time(mame_time newbase)
 				timer->start = timer->expire;
 				timer->expire = add_mame_times(timer->expire, timer->period);
 
-				timer_list_remove(timer);
-				timer_list_insert(timer);
+				timer_queue_update(timer);
 			}
 		}
 	}
@@ -418,7 +556,7 @@ static void timer_register_save(mame_timer *timer)
 	mame_timer *t;
 
 	/* find other timers that match our func name */
-	for (t = timer_head; t; t = t->next)
+	for (t = timer_queue_head(); t; t = timer_queue_next(t))
 		if (!strcmp(t->func, timer->func))
 			count++;
 
@@ -449,9 +587,9 @@ static void timer_postload(void)
 	mame_timer *t;
 
 	/* remove all timers and make a private list */
-	while (timer_head)
+	while (timer_root)
 	{
-		t = timer_head;
+		t = timer_queue_head();
 
 		/* temporary timers go away entirely */
 		if (t->temporary)
@@ -460,7 +598,7 @@ static void timer_postload(void)
 		/* permanent ones get added to our private list */
 		else
 		{
-			timer_list_remove(t);
+			timer_queue_remove(t);
 			t->next = privlist;
 			privlist = t;
 		}
@@ -471,7 +609,7 @@ static void timer_postload(void)
 	{
 		t = privlist;
 		privlist = t->next;
-		timer_list_insert(t);
+		timer_queue_insert(t);
 	}
 }
 
@@ -486,14 +624,19 @@ int timer_count_anonymous(void)
 	mame_timer *t;
 	int count = 0;
 
-	logerror("timer_count_anonymous:\n");
-	for (t = timer_head; t; t = t->next)
+	/* this is checked at every frame by the run-ahead, log only the timers found */
+	for (t = timer_queue_head(); t; t = timer_queue_next(t))
+	{
 		if (t->temporary && t != callback_timer)
 		{
+			if (count == 0)
+				logerror("timer_count_anonymous:\n");
 			count++;
 			logerror("  Temp. timer %p, file %s:%d[%s]\n", (void *) t, t->file, t->line, t->func);
 		}
-	logerror("%d temporary timers found\n", count);
+	}
+	if (count != 0)
+		logerror("%d temporary timers found\n", count);
 
 	return count;
 }
@@ -537,7 +680,7 @@ INLINE mame_timer *_mame_timer_alloc_common(void (*callback)(int), void (*callba
 	/* compute the time of the next firing and insert into the list */
 	timer->start = time;
 	timer->expire = time_never;
-	timer_list_insert(timer);
+	timer_queue_insert(timer);
 
 	/* if we're not temporary, register ourselve with the save state system */
 	if (!temp)
@@ -577,8 +720,8 @@ static void mame_timer_remove(mame_timer *which)
 	if (which == callback_timer)
 		callback_timer_modified = TRUE;
 
-	/* remove it from the list */
-	timer_list_remove(which);
+	/* remove it from the queue */
+	timer_queue_remove(which);
 
 	/* mark it as dead */
 	which->tag = -1;
@@ -635,13 +778,12 @@ INLINE void mame_timer_adjust_common(mame_timer *which, mame_time duration, INT3
 	which->expire = add_mame_times(time, duration);
 	which->period = period;
 
-	/* remove and re-insert the timer in its new order */
-	timer_list_remove(which);
-	timer_list_insert(which);
+	/* move the timer in its new order */
+	timer_queue_update(which);
 
 	/* if this was inserted as the head, abort the current timeslice and resync */
 	LOG(("timer_adjust %s.%s:%d to expire @ %.9f\n", which->file, which->func, which->line, mame_time_to_double(which->expire)));
-	if (which == timer_head && cpu_getexecutingcpu() >= 0)
+	if (which == timer_queue_head() && cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
 }
 
@@ -769,9 +911,8 @@ int mame_timer_enable(mame_timer *which, int enable)
 	old = which->enabled;
 	which->enabled = enable;
 
-	/* remove the timer and insert back into the list */
-	timer_list_remove(which);
-	timer_list_insert(which);
+	/* move the timer in its new order */
+	timer_queue_update(which);
 
 	return old;
 }
@@ -858,7 +999,7 @@ static void timer_logtimers(void)
 	logerror("===============\n");
 
 	logerror("Enqueued timers:\n");
-	for (t = timer_head; t; t = t->next)
+	for (t = timer_queue_head(); t; t = timer_queue_next(t))
 		logerror("  Start=%15.6f Exp=%15.6f Per=%15.6f Ena=%d Tmp=%d (%s:%d[%s])\n",
 			mame_time_to_double(t->start), mame_time_to_double(t->expire), mame_time_to_double(t->period), t->enabled, t->temporary, t->file, t->line, t->func);
 
@@ -0,0 +1,665 @@
+/***************************************************************************
+
+    timertst.c
+
+    Checks that the timer queue fires the timers in the same order as the
+    sorted linked list it replaced. The old list is kept here as a model,
+    and both run the same traces of timer operations.
+
+***************************************************************************/
+
+/* the queue is static in timer.c, so it's tested in place */
+#include "timer.c"
+
+#include <stdarg.h>
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define TEST_TIMERS		12				/* permanent timers of a trace */
+#define TEST_STEPS		2000			/* operations of a trace */
+#define TEST_TRACES		200				/* random traces */
+#define TEST_EVENTS		65536			/* fired callbacks recorded */
+
+#define TICK			(MAX_SUBSECONDS / 1000)
+
+
+
+/***************************************************************************
+    STUBS
+***************************************************************************/
+
+int activecpu = -1;
+int executingcpu = -1;
+int resource_tracking_tag = 0;
+
+mame_time cpunum_get_localtime(int cpunum)
+{
+	return time_zero;
+}
+
+void activecpu_abort_timeslice(void)
+{
+}
+
+void CLIB_DECL logerror(const char *text, ...)
+{
+}
+
+void CLIB_DECL fatalerror(const char *text, ...)
+{
+	va_list arg;
+
+	va_start(arg, text);
+	vfprintf(stderr, text, arg);
+	va_end(arg);
+	fprintf(stderr, "\n");
+	exit(EXIT_FAILURE);
+}
+
+#if defined(MAME_DEBUG) || defined(MAME_PROFILER)
+void profiler_mark(int type)
+{
+}
+#endif
+
+void state_save_push_tag(int tag)
+{
+}
+
+void state_save_pop_tag(void)
+{
+}
+
+void state_save_register_func_postload(void (*func)(void))
+{
+}
+
+void state_save_register_memory(const char *module, UINT32 instance, const char *name, void *val, UINT32 valsize, UINT32 valcount)
+{
+}
+
+
+
+/***************************************************************************
+    MODEL OF THE SORTED LIST
+***************************************************************************/
+
+typedef struct _list_timer list_timer;
+struct _list_timer
+{
+	list_timer *	next;
+	list_timer *	prev;
+	int				param;
+	int				tag;
+	UINT8			enabled;
+	UINT8			temporary;
+	mame_time		period;
+	mame_time		start;
+	mame_time		expire;
+};
+
+static list_timer list_timers[MAX_TIMERS];
+static list_timer *list_head;
+static list_timer *list_free_head;
+static mame_time list_basetime;
+static list_timer *list_callback_timer;
+static int list_callback_timer_modified;
+static mame_time list_callback_timer_expire_time;
+
+static mame_time list_current_time(void)
+{
+	if (list_callback_timer)
+		return list_callback_timer_expire_time;
+	return list_basetime;
+}
+
+static void list_insert(list_timer *timer)
+{
+	mame_time expire = timer->enabled ? timer->expire : time_never;
+	list_timer *t, *lt = NULL;
+
+	for (t = list_head; t; lt = t, t = t->next)
+	{
+		if (compare_mame_times(t->expire, expire) > 0)
+		{
+			timer->prev = t->prev;
+			timer->next = t;
+
+			if (t->prev)
+				t->prev->next = timer;
+			else
+				list_head = timer;
+			t->prev = timer;
+			return;
+		}
+	}
+
+	if (lt)
+		lt->next = timer;
+	else
+		list_head = timer;
+	timer->prev = lt;
+	timer->next = NULL;
+}
+
+static void list_remove(list_timer *timer)
+{
+	if (timer->prev)
+		timer->prev->next = timer->next;
+	else
+		list_head = timer->next;
+	if (timer->next)
+		timer->next->prev = timer->prev;
+}
+
+static void list_init(void)
+{
+	int i;
+
+	memset(list_timers, 0, sizeof(list_timers));
+	list_head = NULL;
+	list_basetime = time_zero;
+	list_callback_timer = NULL;
+	list_callback_timer_modified = FALSE;
+	list_free_head = &list_timers[0];
+	for (i = 0; i < MAX_TIMERS; i++)
+	{
+		list_timers[i].tag = -1;
+		list_timers[i].next = (i < MAX_TIMERS-1) ? &list_timers[i+1] : NULL;
+	}
+}
+
+static list_timer *list_alloc(int temp)
+{
+	list_timer *timer = list_free_head;
+
+	if (!timer)
+		fatalerror("Out of list timers!");
+	list_free_head = timer->next;
+
+	timer->param = 0;
+	timer->enabled = FALSE;
+	timer->temporary = temp;
+	timer->tag = 0;
+	timer->period = time_zero;
+	timer->start = list_current_time();
+	timer->expire = time_never;
+	list_insert(timer);
+	return timer;
+}
+
+static void list_timer_remove(list_timer *which)
+{
+	if (which == list_callback_timer)
+		list_callback_timer_modified = TRUE;
+	list_remove(which);
+	which->tag = -1;
+	which->next = list_free_head;
+	list_free_head = which;
+}
+
+static void list_adjust(list_timer *which, mame_time duration, INT32 param, mame_time period)
+{
+	mame_time time = list_current_time();
+
+	if (which == list_callback_timer)
+		list_callback_timer_modified = TRUE;
+
+	which->param = param;
+	which->enabled = TRUE;
+	if (duration.seconds < 0)
+		duration = time_zero;
+	which->start = time;
+	which->expire = add_mame_times(time, duration);
+	which->period = period;
+
+	list_remove(which);
+	list_insert(which);
+}
+
+static int list_enable(list_timer *which, int enable)
+{
+	int old = which->enabled;
+
+	which->enabled = enable;
+	list_remove(which);
+	list_insert(which);
+	return old;
+}
+
+static void list_postload(void)
+{
+	list_timer *privlist = NULL;
+	list_timer *t;
+
+	while (list_head)
+	{
+		t = list_head;
+		if (t->temporary)
+			list_timer_remove(t);
+		else
+		{
+			list_remove(t);
+			t->next = privlist;
+			privlist = t;
+		}
+	}
+
+	while (privlist)
+	{
+		t = privlist;
+		privlist = t->next;
+		list_insert(t);
+	}
+}
+
+
+
+/***************************************************************************
+    TRACES
+***************************************************************************/
+
+/* a fired callback */
+typedef struct _test_event test_event;
+struct _test_event
+{
+	int				param;
+	mame_time		time;
+};
+
+/* the operations of a world, the new queue or the model */
+typedef struct _test_world test_world;
+struct _test_world
+{
+	void			(*adjust)(int id, mame_time duration, mame_time period);
+	void			(*enable)(int id, int enable);
+	void			(*set)(int param, mame_time duration);
+	void			(*set_global_time)(mame_time newbase);
+	void			(*postload)(void);
+	mame_time		(*next_fire_time)(void);
+	mame_time		(*get_time)(void);
+	int				(*state)(int id, mame_time *start, mame_time *expire);
+};
+
+static const test_world *world;
+static test_event events[TEST_EVENTS];
+static int event_count;
+static int fire_count[TEST_TIMERS + 256];
+static int actions;
+static mame_timer *queue_timer[TEST_TIMERS];
+static list_timer *list_timer_id[TEST_TIMERS];
+static UINT32 seed;
+
+static UINT32 test_rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7fff;
+}
+
+static mame_time ticks(int count)
+{
+	return make_mame_time(0, count * TICK);
+}
+
+static void test_callback(int param)
+{
+	UINT32 action = (param * 7 + fire_count[param] * 13) % 11;
+	int other = (param + fire_count[param]) % TEST_TIMERS;
+
+	if (event_count < TEST_EVENTS)
+	{
+		events[event_count].param = param;
+		events[event_count].time = (*world->get_time)();
+		event_count++;
+	}
+	fire_count[param]++;
+	if (!actions)
+		return;
+
+	/* the timer 0 is the frame timer, always running */
+	if (other == 0)
+		other = 1;
+
+	/* the callbacks change the queue like the drivers do */
+	switch (action)
+	{
+		case 0:
+			if (param < TEST_TIMERS && param != 0)
+				(*world->adjust)(param, ticks(action % 3), ticks(fire_count[param] % 3));
+			break;
+		case 1:
+			(*world->adjust)(other, ticks(1), time_zero);
+			break;
+		case 2:
+			(*world->enable)(other, FALSE);
+			break;
+		case 3:
+			(*world->enable)(other, TRUE);
+			break;
+		case 4:
+			(*world->set)(TEST_TIMERS + fire_count[param] % 8, time_zero);
+			break;
+	}
+}
+
+/* the new queue */
+
+static void queue_adjust(int id, mame_time duration, mame_time period)
+{
+	mame_timer_adjust(queue_timer[id], duration, id, period);
+}
+
+static void queue_enable(int id, int enable)
+{
+	mame_timer_enable(queue_timer[id], enable);
+}
+
+static void queue_set(int param, mame_time duration)
+{
+	_mame_timer_set(duration, param, test_callback, __FILE__, __LINE__, "test_callback");
+}
+
+static int queue_state(int id, mame_time *start, mame_time *expire)
+{
+	*start = queue_timer[id]->start;
+	*expire = queue_timer[id]->expire;
+	return queue_timer[id]->enabled;
+}
+
+/* the cached head is the leftmost timer of the tree */
+static int queue_head_is_first(void)
+{
+	mame_timer *t = timer_root;
+
+	if (t)
+		while (t->left)
+			t = t->left;
+	return t == timer_queue_head();
+}
+
+static const test_world queue_world =
+{
+	queue_adjust,
+	queue_enable,
+	queue_set,
+	mame_timer_set_global_time,
+	timer_postload,
+	mame_timer_next_fire_time,
+	mame_timer_get_time,
+	queue_state
+};
+
+/* the model */
+
+static void list_world_adjust(int id, mame_time duration, mame_time period)
+{
+	list_adjust(list_timer_id[id], duration, id, period);
+}
+
+static void list_world_enable(int id, int enable)
+{
+	list_enable(list_timer_id[id], enable);
+}
+
+static void list_world_set(int param, mame_time duration)
+{
+	list_adjust(list_alloc(TRUE), duration, param, time_zero);
+}
+
+static void list_world_set_global_time(mame_time newbase)
+{
+	list_timer *timer;
+
+	list_basetime = newbase;
+
+	while (compare_mame_times(list_head->expire, list_basetime) <= 0)
+	{
+		int was_enabled = list_head->enabled;
+
+		timer = list_head;
+		if (compare_mame_times(timer->period, time_zero) == 0 || compare_mame_times(timer->period, time_never) == 0)
+			timer->enabled = FALSE;
+
+		list_callback_timer_modified = FALSE;
+		list_callback_timer = timer;
+		list_callback_timer_expire_time = timer->expire;
+
+		if (was_enabled)
+			test_callback(timer->param);
+
+		list_callback_timer = NULL;
+
+		if (!list_callback_timer_modified)
+		{
+			if (timer->temporary)
+				list_timer_remove(timer);
+			else
+			{
+				timer->start = timer->expire;
+				timer->expire = add_mame_times(timer->expire, timer->period);
+
+				list_remove(timer);
+				list_insert(timer);
+			}
+		}
+	}
+}
+
+static mame_time list_world_next_fire_time(void)
+{
+	return list_head->expire;
+}
+
+static int list_world_state(int id, mame_time *start, mame_time *expire)
+{
+	*start = list_timer_id[id]->start;
+	*expire = list_timer_id[id]->expire;
+	return list_timer_id[id]->enabled;
+}
+
+static const test_world list_world =
+{
+	list_world_adjust,
+	list_world_enable,
+	list_world_set,
+	list_world_set_global_time,
+	list_postload,
+	list_world_next_fire_time,
+	list_current_time,
+	list_world_state
+};
+
+
+
+/***************************************************************************
+    RUN
+***************************************************************************/
+
+/* a step of a trace, also recording the head and the state of the timers */
+typedef struct _test_step test_step;
+struct _test_step
+{
+	int				head;
+	mame_time		next;
+	mame_time		start[TEST_TIMERS];
+	mame_time		expire[TEST_TIMERS];
+	int				enabled[TEST_TIMERS];
+};
+
+static test_step steps[2][TEST_STEPS];
+static test_event recorded[2][TEST_EVENTS];
+static int recorded_count[2];
+
+static void run_trace(int index, UINT32 trace_seed)
+{
+	mame_time base = time_zero;
+	int i, step;
+
+	/* start from the same state */
+	world = index == 0 ? &queue_world : &list_world;
+	seed = trace_seed;
+	actions = TRUE;
+	event_count = 0;
+	memset(fire_count, 0, sizeof(fire_count));
+	if (index == 0)
+	{
+		timer_init();
+		for (i = 0; i < TEST_TIMERS; i++)
+			queue_timer[i] = _mame_timer_alloc(test_callback, __FILE__, __LINE__, "test_callback");
+	}
+	else
+	{
+		list_init();
+		for (i = 0; i < TEST_TIMERS; i++)
+			list_timer_id[i] = list_alloc(FALSE);
+	}
+
+	/* the frame timer keeps a timer in the future */
+	(*world->adjust)(0, ticks(4), ticks(4));
+
+	for (step = 0; step < TEST_STEPS; step++)
+	{
+		int op = test_rand() % 16;
+		int id = 1 + test_rand() % (TEST_TIMERS - 1);
+		int a = test_rand() % 4;
+		int b = test_rand() % 4;
+
+		switch (op)
+		{
+			case 0: case 1: case 2: case 3:
+				(*world->adjust)(id, ticks(a), ticks(b));
+				break;
+			case 4: case 5:
+				(*world->adjust)(id, ticks(a), time_zero);
+				break;
+			case 6: case 7:
+				(*world->enable)(id, FALSE);
+				break;
+			case 8: case 9:
+				(*world->enable)(id, TRUE);
+				break;
+			case 10:
+				(*world->set)(TEST_TIMERS + a, ticks(b));
+				break;
+			case 11:
+				(*world->postload)();
+				break;
+			default:
+				base = add_mame_times(base, ticks(a % 3));
+				(*world->set_global_time)(base);
+				break;
+		}
+
+		steps[index][step].head = index == 0 ? queue_head_is_first() : TRUE;
+		steps[index][step].next = (*world->next_fire_time)();
+		for (i = 0; i < TEST_TIMERS; i++)
+			steps[index][step].enabled[i] = (*world->state)(i, &steps[index][step].start[i], &steps[index][step].expire[i]);
+	}
+
+	memcpy(recorded[index], events, event_count * sizeof(events[0]));
+	recorded_count[index] = event_count;
+}
+
+static int compare_traces(UINT32 trace_seed)
+{
+	int i, step;
+
+	run_trace(0, trace_seed);
+	run_trace(1, trace_seed);
+
+	if (recorded_count[0] != recorded_count[1])
+	{
+		printf("trace %u: %d callbacks fired, expected %d\n", trace_seed, recorded_count[0], recorded_count[1]);
+		return 1;
+	}
+	for (i = 0; i < recorded_count[0]; i++)
+		if (recorded[0][i].param != recorded[1][i].param || compare_mame_times(recorded[0][i].time, recorded[1][i].time) != 0)
+		{
+			printf("trace %u: callback %d fired timer %d, expected %d\n", trace_seed, i, recorded[0][i].param, recorded[1][i].param);
+			return 1;
+		}
+	for (step = 0; step < TEST_STEPS; step++)
+	{
+		if (!steps[0][step].head)
+		{
+			printf("trace %u: step %d the head isn't the first timer of the queue\n", trace_seed, step);
+			return 1;
+		}
+		if (compare_mame_times(steps[0][step].next, steps[1][step].next) != 0)
+		{
+			printf("trace %u: step %d next fire time %.9f, expected %.9f\n", trace_seed, step, mame_time_to_double(steps[0][step].next), mame_time_to_double(steps[1][step].next));
+			return 1;
+		}
+		for (i = 0; i < TEST_TIMERS; i++)
+			if (steps[0][step].enabled[i] != steps[1][step].enabled[i]
+				|| compare_mame_times(steps[0][step].start[i], steps[1][step].start[i]) != 0
+				|| compare_mame_times(steps[0][step].expire[i], steps[1][step].expire[i]) != 0)
+			{
+				printf("trace %u: step %d timer %d has a different state\n", trace_seed, step, i);
+				return 1;
+			}
+	}
+
+	return 0;
+}
+
+/* timers adjusted to the same time fire in the order they were queued, also after a re-enable */
+static int check_same_expire(void)
+{
+	static const int expected[] = { 1, 3, 2, 4 };
+	int i;
+
+	world = &queue_world;
+	actions = FALSE;
+	event_count = 0;
+	memset(fire_count, 0, sizeof(fire_count));
+	timer_init();
+	for (i = 0; i < 5; i++)
+		queue_timer[i] = _mame_timer_alloc(test_callback, __FILE__, __LINE__, "test_callback");
+
+	mame_timer_adjust(queue_timer[1], ticks(2), 1, time_zero);
+	mame_timer_adjust(queue_timer[2], ticks(2), 2, time_zero);
+	mame_timer_adjust(queue_timer[3], ticks(2), 3, time_zero);
+	mame_timer_enable(queue_timer[2], FALSE);
+	mame_timer_enable(queue_timer[2], TRUE);
+	mame_timer_adjust(queue_timer[4], ticks(2), 4, time_zero);
+	mame_timer_adjust(queue_timer[0], ticks(4), 0, ticks(4));
+	mame_timer_set_global_time(ticks(2));
+
+	if (event_count != 4)
+	{
+		printf("same expire: %d callbacks fired, expected 4\n", event_count);
+		return 1;
+	}
+	for (i = 0; i < 4; i++)
+		if (events[i].param != expected[i])
+		{
+			printf("same expire: callback %d fired timer %d, expected %d\n", i, events[i].param, expected[i]);
+			return 1;
+		}
+
+	return 0;
+}
+
+int main(void)
+{
+	int failed = 0;
+	UINT32 i;
+
+	failed |= check_same_expire();
+	for (i = 1; i <= TEST_TRACES && !failed; i++)
+		failed |= compare_traces(i);
+
+	if (failed)
+	{
+		printf("timer queue test FAILED\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("timer queue test passed, %d traces\n", TEST_TRACES);
+	return EXIT_SUCCESS;
+}
@@ -179,6 +179,203 @@ static int ecd_read(zip_file* zip) {
 #define ZIPXTRALN	0x1c
 #define ZIPNAME		0x1e
 
+/* -------------------------------------------------------------------------
+   Memory mapping support
+ ------------------------------------------------------------------------- */
+
+struct _zip_map
+{
+	UINT8* data; /* mapped file */
+	UINT64 length; /* length of the mapping */
+	int refcount; /* the zip and any data handed out from it */
+};
+
+/* Map a whole zip file in memory
+   return:
+     !=0 success
+     ==0 mapping not supported or error, the file must be read
+*/
+static zip_map* openmap(int pathtype, int pathindex, const char* zipfile) {
+	zip_map* map = (zip_map*)malloc(sizeof(zip_map));
+	if (!map)
+		return 0;
+
+	map->data = (UINT8*)osd_fmap(pathtype, pathindex, zipfile, &map->length);
+	if (!map->data) {
+		free(map);
+		return 0;
+	}
+
+	map->refcount = 1;
+
+	return map;
+}
+
+/* Release a reference to a mapping, unmapping it with the last one */
+void unzip_map_release(zip_map* map) {
+	if (--map->refcount == 0) {
+		osd_funmap(map->data, map->length);
+		free(map);
+	}
+}
+
+/* Parse the entry at the specified position in the central directory
+   out:
+     ent entry, the name isn't set
+     *next position of the next entry
+   return:
+     ==0 success
+     <0 error
+*/
+static int parseentry(zip_file* zip, unsigned pos, zip_entry* ent, unsigned* next) {
+	char* buf = zip->cd+pos;
+
+	if (pos + ZIPCFN > zip->size_of_cent_dir) {
+		errormsg("Invalid entry in directory", ERROR_CORRUPT,zip->zip);
+		return -1;
+	}
+
+	/* compile zipent info */
+	ent->cent_file_header_sig = read_dword (buf+ZIPCENSIG);
+	ent->version_made_by = *(buf+ZIPCVER);
+	ent->host_os = *(buf+ZIPCOS);
+	ent->version_needed_to_extract = *(buf+ZIPCVXT);
+	ent->os_needed_to_extract = *(buf+ZIPCEXOS);
+	ent->general_purpose_bit_flag = read_word (buf+ZIPCFLG);
+	ent->compression_method = read_word (buf+ZIPCMTHD);
+	ent->last_mod_file_time = read_word (buf+ZIPCTIM);
+	ent->last_mod_file_date = read_word (buf+ZIPCDAT);
+	ent->crc32 = read_dword (buf+ZIPCCRC);
+	ent->compressed_size = read_dword (buf+ZIPCSIZ);
+	ent->uncompressed_size = read_dword (buf+ZIPCUNC);
+	ent->filename_length = read_word (buf+ZIPCFNL);
+	ent->extra_field_length = read_word (buf+ZIPCXTL);
+	ent->file_comment_length = read_word (buf+ZIPCCML);
+	ent->disk_number_start = read_word (buf+ZIPDSK);
+	ent->internal_file_attrib = read_word (buf+ZIPINT);
+	ent->external_file_attrib = read_dword (buf+ZIPEXT);
+	ent->offset_lcl_hdr_frm_frst_disk = read_dword (buf+ZIPOFST);
+
+	/* check to see if filename length is illegally long (past the size of this directory
+	   entry) */
+	if (pos + ZIPCFN + ent->filename_length > zip->size_of_cent_dir)
+	{
+		errormsg("Invalid filename length in directory", ERROR_CORRUPT,zip->zip);
+		return -1;
+	}
+
+	/* skip to next entry in central dir */
+	*next = pos + ZIPCFN + ent->filename_length + ent->extra_field_length + ent->file_comment_length;
+
+	return 0;
+}
+
+/* -------------------------------------------------------------------------
+   Central directory index
+ ------------------------------------------------------------------------- */
+
+/* Hash of a name, ignoring the case */
+static unsigned hashname(const char* name) {
+	unsigned h = 2166136261U;
+
+	while (*name) {
+		h = (h ^ (unsigned char)toupper(*name)) * 16777619U;
+		++name;
+	}
+
+	return h;
+}
+
+/* Hash of a crc */
+static unsigned hashcrc(UINT32 crc) {
+	return crc ^ (crc >> 16);
+}
+
+/* Name of an entry without the directory */
+static const char* basename_entry(const char* name) {
+	const char* s = strrchr(name,'/');
+	if (s)
+		return s + 1;
+	else
+		return name;
+}
+
+/* Parse the whole central directory and build the hash tables
+   of the entries by name and by crc. The chains are in directory order,
+   so a lookup returns the same entry of a linear scan.
+   return:
+     ==0 success
+     <0 error
+*/
+static int indexzip(zip_file* zip) {
+	unsigned max = zip->size_of_cent_dir / ZIPCFN + 1;
+	unsigned pos, next, i;
+	char* names;
+
+	zip->entries = (zip_entry*)malloc(max * sizeof(zip_entry));
+	zip->names = (char*)malloc(zip->size_of_cent_dir + 1);
+	if (!zip->entries || !zip->names)
+		return -1;
+
+	/* every entry uses in the directory more space than its name */
+	names = zip->names;
+	zip->entries_count = 0;
+	pos = 0;
+	while (pos < zip->size_of_cent_dir) {
+		zip_entry* ent = &zip->entries[zip->entries_count];
+
+		if (parseentry(zip, pos, ent, &next) != 0)
+			break;
+
+		memcpy(names, zip->cd+pos+ZIPCFN, ent->filename_length);
+		names[ent->filename_length] = 0;
+		ent->name = names;
+		names += ent->filename_length + 1;
+
+		++zip->entries_count;
+		pos = next;
+	}
+
+	zip->index_size = 16;
+	while (zip->index_size < 2 * zip->entries_count)
+		zip->index_size *= 2;
+
+	zip->index = (int*)malloc((2 * zip->index_size + 2 * zip->entries_count + 1) * sizeof(int));
+	if (!zip->index)
+		return -1;
+
+	zip->name_head = zip->index;
+	zip->crc_head = zip->name_head + zip->index_size;
+	zip->name_next = zip->crc_head + zip->index_size;
+	zip->crc_next = zip->name_next + zip->entries_count;
+
+	for(i=0;i<2*zip->index_size;++i)
+		zip->index[i] = -1;
+
+	/* insert in reverse order to have the chains in directory order */
+	for(i=zip->entries_count;i>0;--i) {
+		zip_entry* ent = &zip->entries[i-1];
+		unsigned h;
+
+		h = hashname(basename_entry(ent->name)) & (zip->index_size - 1);
+		zip->name_next[i-1] = zip->name_head[h];
+		zip->name_head[h] = i-1;
+
+		h = hashcrc(ent->crc32) & (zip->index_size - 1);
+		zip->crc_next[i-1] = zip->crc_head[h];
+		zip->crc_head[h] = i-1;
+	}
+
+	return 0;
+}
+
+/* Release the index of the central directory */
+static void freeindex(zip_file* zip) {
+	free(zip->entries);
+	free(zip->names);
+	free(zip->index);
+}
+
 /* Opens a zip stream for reading
    return:
      !=0 success, zip stream
@@ -299,6 +496,23 @@ zip_file* openzip(int pathtype, int pathindex, const char* zipfile) {
 	zip->pathtype = pathtype;
 	zip->pathindex = pathindex;
 
+	/* index the central directory */
+	zip->entries = 0;
+	zip->names = 0;
+	zip->index = 0;
+	if (indexzip(zip)!=0) {
+		freeindex(zip);
+		free(zip->zip);
+		free(zip->cd);
+		free(zip->ecd);
+		osd_fclose(zip->fp);
+		free(zip);
+		return 0;
+	}
+
+	/* map the file, if supported */
+	zip->map = openmap(pathtype, pathindex, zipfile);
+
 	return zip;
 }
 
@@ -310,39 +524,14 @@ zip_file* openzip(int pathtype, int pathindex, const char* zipfile) {
      ==0 error
 */
 zip_entry* readzip(zip_file* zip) {
+	unsigned next;
 
 	/* end of directory */
 	if (zip->cd_pos >= zip->size_of_cent_dir)
 		return 0;
 
-	/* compile zipent info */
-	zip->ent.cent_file_header_sig = read_dword (zip->cd+zip->cd_pos+ZIPCENSIG);
-	zip->ent.version_made_by = *(zip->cd+zip->cd_pos+ZIPCVER);
-	zip->ent.host_os = *(zip->cd+zip->cd_pos+ZIPCOS);
-	zip->ent.version_needed_to_extract = *(zip->cd+zip->cd_pos+ZIPCVXT);
-	zip->ent.os_needed_to_extract = *(zip->cd+zip->cd_pos+ZIPCEXOS);
-	zip->ent.general_purpose_bit_flag = read_word (zip->cd+zip->cd_pos+ZIPCFLG);
-	zip->ent.compression_method = read_word (zip->cd+zip->cd_pos+ZIPCMTHD);
-	zip->ent.last_mod_file_time = read_word (zip->cd+zip->cd_pos+ZIPCTIM);
-	zip->ent.last_mod_file_date = read_word (zip->cd+zip->cd_pos+ZIPCDAT);
-	zip->ent.crc32 = read_dword (zip->cd+zip->cd_pos+ZIPCCRC);
-	zip->ent.compressed_size = read_dword (zip->cd+zip->cd_pos+ZIPCSIZ);
-	zip->ent.uncompressed_size = read_dword (zip->cd+zip->cd_pos+ZIPCUNC);
-	zip->ent.filename_length = read_word (zip->cd+zip->cd_pos+ZIPCFNL);
-	zip->ent.extra_field_length = read_word (zip->cd+zip->cd_pos+ZIPCXTL);
-	zip->ent.file_comment_length = read_word (zip->cd+zip->cd_pos+ZIPCCML);
-	zip->ent.disk_number_start = read_word (zip->cd+zip->cd_pos+ZIPDSK);
-	zip->ent.internal_file_attrib = read_word (zip->cd+zip->cd_pos+ZIPINT);
-	zip->ent.external_file_attrib = read_dword (zip->cd+zip->cd_pos+ZIPEXT);
-	zip->ent.offset_lcl_hdr_frm_frst_disk = read_dword (zip->cd+zip->cd_pos+ZIPOFST);
-
-    /* check to see if filename length is illegally long (past the size of this directory
-       entry) */
-    if (zip->cd_pos + ZIPCFN + zip->ent.filename_length > zip->size_of_cent_dir)
-    {
-        errormsg("Invalid filename length in directory", ERROR_CORRUPT,zip->zip);
-        return 0;
-    }
+	if (parseentry(zip, zip->cd_pos, &zip->ent, &next)!=0)
+		return 0;
 
 	/* copy filename */
 	free(zip->ent.name);
@@ -351,7 +540,7 @@ zip_entry* readzip(zip_file* zip) {
 	zip->ent.name[zip->ent.filename_length] = 0;
 
 	/* skip to next entry in central dir */
-	zip->cd_pos += ZIPCFN + zip->ent.filename_length + zip->ent.extra_field_length + zip->ent.file_comment_length;
+	zip->cd_pos = next;
 
 	return &zip->ent;
 }
@@ -359,6 +548,9 @@ zip_entry* readzip(zip_file* zip) {
 /* Closes a zip stream */
 void closezip(zip_file* zip) {
 	/* release all */
+	if (zip->map)
+		unzip_map_release(zip->map);
+	freeindex(zip);
 	free(zip->ent.name);
 	free(zip->cd);
 	free(zip->ecd);
@@ -454,6 +646,34 @@ int seekcompresszip(zip_file* zip, zip_entry* ent) {
 	return 0;
 }
 
+/* Get the compressed data of an entry from the memory mapping
+   return:
+    !=0 compressed data, followed by at least one more readable byte
+    ==0 error
+*/
+static const UINT8* mapcompresszip(zip_file* zip, zip_entry* ent) {
+	char* buf;
+	UINT64 offset;
+
+	if ((UINT64)ent->offset_lcl_hdr_frm_frst_disk + ZIPNAME > zip->map->length) {
+		errormsg ("Reading header", ERROR_CORRUPT, zip->zip);
+		return 0;
+	}
+
+	buf = (char*)zip->map->data + ent->offset_lcl_hdr_frm_frst_disk;
+
+	/* calculate offset to data */
+	offset = (UINT64)ent->offset_lcl_hdr_frm_frst_disk + ZIPNAME + read_word (buf+ZIPFNLN) + read_word (buf+ZIPXTRALN);
+
+	/* the data is always followed by the central directory */
+	if (offset + ent->compressed_size + 1 > zip->map->length) {
+		errormsg ("Seeking to compressed data", ERROR_CORRUPT, zip->zip);
+		return 0;
+	}
+
+	return zip->map->data + offset;
+}
+
 /* Inflate a file
    in:
    in_file stream to inflate
@@ -549,7 +769,17 @@ static int inflate_file(osd_file* in_file, unsigned in_size, unsigned char* out_
     <0 error
 */
 int readcompresszip(zip_file* zip, zip_entry* ent, char* data) {
-	int err = seekcompresszip(zip,ent);
+	int err;
+
+	if (zip->map) {
+		const UINT8* src = mapcompresszip(zip, ent);
+		if (!src)
+			return -1;
+		memcpy(data, src, ent->compressed_size);
+		return 0;
+	}
+
+	err = seekcompresszip(zip,ent);
 	if (err!=0)
 		return err;
 
@@ -561,14 +791,69 @@ int readcompresszip(zip_file* zip, zip_entry* ent, char* data) {
 	return 0;
 }
 
-/* Read UNcompressed data
+/* Inflate a memory buffer
+   in:
+   in_data compressed data, followed by one more readable byte
+   in_size size of the compressed data
+   out_size size of decompressed data
    out:
-    data UNcompressed data
+   out_data buffer for decompressed data
+   return:
+   ==0 ok
+   note:
+   it doesn't use any global state, so it can be called from any thread
+*/
+int inflate_zipped_data(const unsigned char* in_data, unsigned in_size, unsigned char* out_data, unsigned out_size)
+{
+	int err;
+	z_stream d_stream; /* decompression stream */
+
+	d_stream.zalloc = 0;
+	d_stream.zfree = 0;
+	d_stream.opaque = 0;
+
+	d_stream.next_in = (unsigned char*)in_data;
+	d_stream.avail_in = in_size + 1; /* add dummy byte at end of compressed data */
+	d_stream.next_out = out_data;
+	d_stream.avail_out = out_size;
+
+	err = inflateInit2(&d_stream, -MAX_WBITS);
+	if (err != Z_OK)
+	{
+		logerror("inflateInit error: %d\n", err);
+		return -1;
+	}
+
+	err = inflate(&d_stream, Z_FINISH);
+	if (err != Z_STREAM_END)
+	{
+		logerror("inflate error: %d\n", err);
+		inflateEnd(&d_stream);
+		return -1;
+	}
+
+	err = inflateEnd(&d_stream);
+	if (err != Z_OK)
+	{
+		logerror("inflateEnd error: %d\n", err);
+		return -1;
+	}
+
+	if (d_stream.avail_out > 0)
+	{
+		logerror("zip size mismatch. %i\n", d_stream.avail_out);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Check if an entry can be decompressed
    return:
     ==0 success
     <0 error
 */
-int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
+static int checkuncompresszip(zip_file* zip, zip_entry* ent) {
 	if (ent->compression_method == 0x0000) {
 		/* file is not compressed, simply stored */
 
@@ -578,7 +863,7 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 			return -3;
 		}
 
-		return readcompresszip(zip,ent,data);
+		return 0;
 	} else if (ent->compression_method == 0x0008) {
 		/* file is compressed using "Deflate" method */
 		if (ent->version_needed_to_extract > 0x14) {
@@ -596,6 +881,41 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 			return -2;
 		}
 
+		return 0;
+	} else {
+		errormsg("Compression method unsupported", ERROR_UNSUPPORTED, zip->zip);
+		return -2;
+	}
+}
+
+/* Read UNcompressed data
+   out:
+    data UNcompressed data
+   return:
+    ==0 success
+    <0 error
+*/
+int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
+	int err = checkuncompresszip(zip, ent);
+	if (err!=0)
+		return err;
+
+	if (ent->compression_method == 0x0000) {
+		return readcompresszip(zip,ent,data);
+	} else if (zip->map) {
+		/* inflate directly from the mapping */
+		const UINT8* src = mapcompresszip(zip, ent);
+		if (!src)
+			return -1;
+
+		if (inflate_zipped_data(src, ent->compressed_size, (unsigned char*)data, ent->uncompressed_size))
+		{
+			errormsg("Inflating compressed data", ERROR_CORRUPT, zip->zip);
+			return -3;
+		}
+
+		return 0;
+	} else {
 		/* read compressed data */
 		if (seekcompresszip(zip,ent)!=0) {
 			return -1;
@@ -609,9 +929,6 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 		}
 
 		return 0;
-	} else {
-		errormsg("Compression method unsupported", ERROR_UNSUPPORTED, zip->zip);
-		return -2;
 	}
 }
 
@@ -625,20 +942,27 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 #ifdef ZIP_CACHE
 
 /* ZIP cache entries */
-#define ZIP_CACHE_MAX 5
+static unsigned zip_cache_max = ZIP_CACHE_DEFAULT;
 
 /* ZIP cache buffer LRU ( Last Recently Used )
      zip_cache_map[0] is the newer
-     zip_cache_map[ZIP_CACHE_MAX-1] is the older
+     zip_cache_map[zip_cache_max-1] is the older
+   It's allocated at the first use.
 */
-static zip_file* zip_cache_map[ZIP_CACHE_MAX];
+static zip_file** zip_cache_map;
 
 static zip_file* cache_openzip(int pathtype, int pathindex, const char* zipfile) {
 	zip_file* zip;
 	unsigned i;
 
+	if (!zip_cache_map) {
+		zip_cache_map = (zip_file**)calloc(zip_cache_max, sizeof(zip_file*));
+		if (!zip_cache_map)
+			return 0;
+	}
+
 	/* search in the cache buffer */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
+	for(i=0;i<zip_cache_max;++i) {
 		if (zip_cache_map[i] && zip_cache_map[i]->pathtype == pathtype && zip_cache_map[i]->pathindex == pathindex && strcmp(zip_cache_map[i]->zip,zipfile)==0) {
 			/* found */
 			unsigned j;
@@ -675,15 +999,15 @@ static zip_file* cache_openzip(int pathtype, int pathindex, const char* zipfile)
 		return 0;
 
 	/* close the oldest entry */
-	if (zip_cache_map[ZIP_CACHE_MAX-1]) {
+	if (zip_cache_map[zip_cache_max-1]) {
 		/* close last zip */
-		closezip(zip_cache_map[ZIP_CACHE_MAX-1]);
+		closezip(zip_cache_map[zip_cache_max-1]);
 		/* reset the entry */
-		zip_cache_map[ZIP_CACHE_MAX-1] = 0;
+		zip_cache_map[zip_cache_max-1] = 0;
 	}
 
 	/* shift */
-	for(i=ZIP_CACHE_MAX-1;i>0;--i)
+	for(i=zip_cache_max-1;i>0;--i)
 		zip_cache_map[i] = zip_cache_map[i-1];
 
 	/* set the first entry */
@@ -696,7 +1020,7 @@ static void cache_closezip(zip_file* zip) {
 	unsigned i;
 
 	/* search in the cache buffer */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
+	for(i=0;zip_cache_map && i<zip_cache_max;++i) {
 		if (zip_cache_map[i]==zip) {
 			/* close zip */
 			closezip(zip);
@@ -719,8 +1043,11 @@ void unzip_cache_clear()
 {
 	unsigned i;
 
+	if (!zip_cache_map)
+		return;
+
 	/* search in the cache buffer for any zip info and clear it */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
+	for(i=0;i<zip_cache_max;++i) {
 		if (zip_cache_map[i] != NULL) {
 			/* close zip */
 			closezip(zip_cache_map[i]);
@@ -733,6 +1060,17 @@ void unzip_cache_clear()
 	}
 }
 
+/* Set the number of zip files kept open, closing all the cached ones */
+void unzip_cache_set_size(unsigned size)
+{
+	unzip_cache_clear();
+
+	free(zip_cache_map);
+	zip_cache_map = 0;
+
+	zip_cache_max = size ? size : 1;
+}
+
 #define cache_suspendzip(a) suspendzip(a)
 
 #else
@@ -742,6 +1080,7 @@ void unzip_cache_clear()
 #define cache_suspendzip(a) closezip(a)
 
 #define unzip_cache_clear()
+#define unzip_cache_set_size(a)
 
 #endif
 
@@ -768,6 +1107,65 @@ static int equal_filename(const char* zipfile, const char* file) {
 	return !*s1 && !*s2;
 }
 
+/* Search an entry by name in the index
+   return:
+     >=0 index of the first entry in the directory with the name
+     <0 not found
+*/
+static int findname(zip_file* zip, const char* filename) {
+	int i = zip->name_head[hashname(filename) & (zip->index_size - 1)];
+
+	while (i >= 0) {
+		if (equal_filename(zip->entries[i].name, filename))
+			return i;
+		i = zip->name_next[i];
+	}
+
+	return -1;
+}
+
+/* Search an entry by crc in the index
+   return:
+     >=0 index of the first entry in the directory with the crc
+     <0 not found
+*/
+static int findcrc(zip_file* zip, UINT32 crc) {
+	int i = zip->crc_head[hashcrc(crc) & (zip->index_size - 1)];
+
+	while (i >= 0) {
+		if (zip->entries[i].crc32 == crc)
+			return i;
+		i = zip->crc_next[i];
+	}
+
+	return -1;
+}
+
+/* Search the first entry in the directory matching the name, or the crc
+   if the name is a crc written with 8 lowercase hex digits
+   return:
+     !=0 entry
+     ==0 not found
+*/
+static zip_entry* findentry(zip_file* zip, const char* filename) {
+	int i = findname(zip, filename);
+
+	/* NS981003: support for "load by CRC" */
+	if (strlen(filename) == 8 && strspn(filename, "0123456789abcdef") == 8) {
+		UINT32 crc = strtoul(filename, 0, 16);
+		if (crc) {
+			int j = findcrc(zip, crc);
+			if (j >= 0 && (i < 0 || j < i))
+				i = j;
+		}
+	}
+
+	if (i < 0)
+		return 0;
+
+	return &zip->entries[i];
+}
+
 /* Pass the path to the zipfile and the name of the file within the zipfile.
    buf will be set to point to the uncompressed image of that zipped file.
    length will be set to the length of the uncompressed data. */
@@ -779,44 +1177,40 @@ int /* error */ load_zipped_file (int pathtype, int pathindex, const char* zipfi
 	if (!zip)
 		return -1;
 
-	while (readzip(zip)) {
-		/* NS981003: support for "load by CRC" */
-		char crc[9];
-
-		ent = &(zip->ent);
-
-		sprintf(crc,"%08x",ent->crc32);
-		if (equal_filename(ent->name, filename) ||
-				(ent->crc32 && !strcmp(crc, filename)))
-		{
-			*length = ent->uncompressed_size;
-			*buf = (unsigned char*)malloc( *length );
-			if (!*buf) {
-				if (!gUnzipQuiet)
-					printf("load_zipped_file(): Unable to allocate %d bytes of RAM\n",*length);
-				cache_closezip(zip);
-				return -1;
-			}
+	ent = findentry(zip, filename);
+	if (!ent) {
+		cache_suspendzip(zip);
+		return -1;
+	}
 
-			if (readuncompresszip(zip, ent, (char*)*buf)!=0) {
-				free(*buf);
-				cache_closezip(zip);
-				return -1;
-			}
+	*length = ent->uncompressed_size;
+	*buf = (unsigned char*)malloc( *length );
+	if (!*buf) {
+		if (!gUnzipQuiet)
+			printf("load_zipped_file(): Unable to allocate %d bytes of RAM\n",*length);
+		cache_closezip(zip);
+		return -1;
+	}
 
-			cache_suspendzip(zip);
-			return 0;
-		}
+	if (readuncompresszip(zip, ent, (char*)*buf)!=0) {
+		free(*buf);
+		cache_closezip(zip);
+		return -1;
 	}
 
 	cache_suspendzip(zip);
-	return -1;
+	return 0;
 }
 
-/*  Pass the path to the zipfile and the name of the file within the zipfile.
-    sum will be set to the CRC-32 of that zipped file. */
-/*  The caller can preset sum to the expected checksum to enable "load by CRC" */
-int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename, unsigned int *length, unsigned int *sum) {
+/* Like load_zipped_file() but the data is read without decompressing it.
+   buf will be set to point to the data as stored in the zip, followed by one
+   more readable byte, and compressed_length to its size. If deflated is set
+   the data must be decompressed with inflate_zipped_data(), otherwise it's
+   already the uncompressed image.
+   If the zip is mapped in memory, buf points directly into the mapping and
+   map is set to it. In this case buf is read only and it must be released
+   with unzip_map_release() instead of free(). */
+int /* error */ load_zipped_file_compressed (int pathtype, int pathindex, const char* zipfile, const char* filename, unsigned char** buf, unsigned int* compressed_length, unsigned int* length, int* deflated, zip_map** map) {
 	zip_file* zip;
 	zip_entry* ent;
 
@@ -824,37 +1218,80 @@ int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *z
 	if (!zip)
 		return -1;
 
-	while (readzip(zip)) {
-		ent = &(zip->ent);
+	ent = findentry(zip, filename);
+	if (!ent) {
+		cache_suspendzip(zip);
+		return -1;
+	}
 
-		if (equal_filename(ent->name, filename))
-		{
-			*length = ent->uncompressed_size;
-			*sum = ent->crc32;
-			cache_suspendzip(zip);
-			return 0;
+	if (checkuncompresszip(zip, ent)!=0) {
+		cache_closezip(zip);
+		return -1;
+	}
+
+	*length = ent->uncompressed_size;
+	*compressed_length = ent->compressed_size;
+	*deflated = ent->compression_method == 0x0008;
+
+	if (zip->map) {
+		const UINT8* src = mapcompresszip(zip, ent);
+		if (!src) {
+			cache_closezip(zip);
+			return -1;
 		}
+
+		*buf = (unsigned char*)src;
+		*map = zip->map;
+		++zip->map->refcount;
+
+		cache_suspendzip(zip);
+		return 0;
+	}
+
+	*map = 0;
+	*buf = (unsigned char*)malloc( *compressed_length + 1 );
+	if (!*buf) {
+		if (!gUnzipQuiet)
+			printf("load_zipped_file_compressed(): Unable to allocate %d bytes of RAM\n",*compressed_length + 1);
+		cache_closezip(zip);
+		return -1;
+	}
+	(*buf)[*compressed_length] = 0;
+
+	if (readcompresszip(zip, ent, (char*)*buf)!=0) {
+		free(*buf);
+		cache_closezip(zip);
+		return -1;
 	}
 
 	cache_suspendzip(zip);
+	return 0;
+}
+
+/*  Pass the path to the zipfile and the name of the file within the zipfile.
+    sum will be set to the CRC-32 of that zipped file. */
+/*  The caller can preset sum to the expected checksum to enable "load by CRC" */
+int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename, unsigned int *length, unsigned int *sum) {
+	zip_file* zip;
+	int i;
 
-	/* NS981003: support for "load by CRC" */
 	zip = cache_openzip(pathtype, pathindex, zipfile);
 	if (!zip)
 		return -1;
 
-	while (readzip(zip)) {
-		ent = &(zip->ent);
+	i = findname(zip, filename);
 
-		if (*sum && ent->crc32 == *sum)
-		{
-			*length = ent->uncompressed_size;
-			*sum = ent->crc32;
-			cache_suspendzip(zip);
-			return 0;
-		}
+	/* NS981003: support for "load by CRC" */
+	if (i < 0 && *sum)
+		i = findcrc(zip, *sum);
+
+	if (i < 0) {
+		cache_suspendzip(zip);
+		return -1;
 	}
 
+	*length = zip->entries[i].uncompressed_size;
+	*sum = zip->entries[i].crc32;
 	cache_suspendzip(zip);
-	return -1;
+	return 0;
 }
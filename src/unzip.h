@@ -43,6 +43,9 @@ struct _zip_entry
 };
 typedef struct _zip_entry zip_entry;
 
+/* Memory mapping of a zip file, shared with the data read from it */
+typedef struct _zip_map zip_map;
+
 struct _zip_file
 {
 	char* zip; /* zip name */
@@ -59,6 +62,19 @@ struct _zip_file
 
 	zip_entry ent; /* buffer for readzip */
 
+	/* index of the central directory */
+	zip_entry* entries; /* all the entries, the names point in the names buffer */
+	unsigned entries_count; /* number of entries */
+	char* names; /* 0 terminated names of all the entries */
+	unsigned index_size; /* size of the hash tables, a power of 2 */
+	int* index; /* hash tables of the entries, -1 terminated chains */
+	int* name_head; /* first entry with the hash of the name, in index */
+	int* name_next; /* next entry with the same hash of the name, in index */
+	int* crc_head; /* first entry with the hash of the crc, in index */
+	int* crc_next; /* next entry with the same hash of the crc, in index */
+
+	zip_map* map; /* memory mapping of the zip, 0 if not available */
+
 	/* end_of_cent_dir */
 	UINT32	end_of_cent_dir_sig;
 	UINT16	number_of_this_disk;
@@ -135,9 +151,17 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data);
 /* public functions */
 int /* error */ load_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename,
 	unsigned char **buf, unsigned int *length);
+int /* error */ load_zipped_file_compressed (int pathtype, int pathindex, const char *zipfile, const char *filename,
+	unsigned char **buf, unsigned int *compressed_length, unsigned int *length, int *deflated, zip_map **map);
+int inflate_zipped_data(const unsigned char *in_data, unsigned in_size, unsigned char *out_data, unsigned out_size);
 int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename, unsigned int *length, unsigned int *sum);
 
+/* default number of zip files kept open in the cache */
+#define ZIP_CACHE_DEFAULT 16
+
 void unzip_cache_clear(void);
+void unzip_cache_set_size(unsigned size);
+void unzip_map_release(zip_map *map);
 
 /* public globals */
 extern int	gUnzipQuiet;	/* flag controls error messages */
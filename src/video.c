@@ -54,6 +54,14 @@ static UINT8 refresh_rate_changed;
 static UINT8 full_refresh_pending;
 static int last_partial_scanline;
 
+/* frame output, disabled for the frames emulated by the run-ahead and then discarded */
+static UINT8 frame_video_hidden;
+static UINT8 frame_sound_muted;
+
+/* profiler scopes of the driver callbacks */
+static int video_update_scope;
+static int video_eof_scope;
+
 /* speed computation */
 static cycles_t last_fps_time;
 static int frames_since_last_fps;
@@ -115,6 +123,9 @@ int video_init(void)
 	movie_file = NULL;
 	movie_frame = 0;
 
+	video_update_scope = profiler_scope_register("video_update", PROFILER_VIDEO);
+	video_eof_scope = profiler_scope_register("video_eof", PROFILER_VIDEO);
+
 	add_pause_callback(video_pause);
 	add_exit_callback(video_exit);
 
@@ -225,8 +236,13 @@ int video_init(void)
 	performance.game_speed_percent = 100;
 	performance.frames_per_second = Machine->refresh_rate;
 	performance.vector_updates_last_second = 0;
+	performance.runahead_frames = 0;
+	performance.runahead_frame_time = 0;
+	performance.runahead_state_time = 0;
 
 	/* reset video statics and get out of here */
+	frame_video_hidden = 0;
+	frame_sound_muted = 0;
 	pdrawgfx_shadow_lowpri = 0;
 	leds_status = 0;
 	knocker_status = 0;
@@ -618,13 +634,16 @@ void force_partial_update(int scanline)
 	rectangle clip = Machine->visible_area;
 
 	/* if skipping this frame, bail */
-	if (osd_skip_this_frame())
+	if (osd_skip_this_frame() || frame_video_hidden)
 		return;
 
 	/* skip if less than the lowest so far */
 	if (scanline < last_partial_scanline)
 		return;
 
+	/* the OSD layer can still be filling the bitmap with the previous frame */
+	osd_wait_for_screen();
+
 	/* if there's a dirty bitmap and we didn't do any partial updates yet, handle it now */
 	if (full_refresh_pending && last_partial_scanline == 0)
 	{
@@ -641,10 +660,10 @@ void force_partial_update(int scanline)
 	/* render if necessary */
 	if (clip.min_y <= clip.max_y)
 	{
-		profiler_mark(PROFILER_VIDEO);
+		profiler_scope_begin(video_update_scope);
 		(*Machine->drv->video_update)(0, scrbitmap[0], &clip);
 		performance.partial_updates_this_frame++;
-		profiler_mark(PROFILER_END);
+		profiler_scope_end();
 	}
 
 	/* remember where we left off */
@@ -798,8 +817,32 @@ static void recompute_fps(int skipped_it)
 void updatescreen(void)
 {
 	/* update sound */
-	sound_frame_update();
+	if (frame_sound_muted)
+		sound_frame_skip();
+	else
+		sound_frame_update();
+
+	/* a hidden frame is never displayed, the run-ahead outputs it later or discards it */
+	if (!frame_video_hidden)
+		video_frame_output();
 
+	/* call the end-of-frame callback */
+	if (Machine->drv->video_eof && !mame_is_paused())
+	{
+		profiler_scope_begin(video_eof_scope);
+		(*Machine->drv->video_eof)();
+		profiler_scope_end();
+	}
+}
+
+
+/*-------------------------------------------------
+    video_frame_output - draw the screen and send
+    it to the OSD layer
+-------------------------------------------------*/
+
+void video_frame_output(void)
+{
 	/* if we're not skipping this frame, draw the screen */
 	if (!osd_skip_this_frame())
 	{
@@ -811,6 +854,7 @@ void updatescreen(void)
 	/* the user interface must be called between vh_update() and osd_update_video_and_audio(), */
 	/* to allow it to overlay things on the game display. We must call it even */
 	/* if the frame is skipped, to keep a consistent timing. */
+	osd_wait_for_screen();
 	ui_update_and_render(artwork_get_ui_bitmap());
 
 	/* update our movie recording state */
@@ -819,14 +863,18 @@ void updatescreen(void)
 
 	/* blit to the screen */
 	update_video_and_audio();
+}
 
-	/* call the end-of-frame callback */
-	if (Machine->drv->video_eof && !mame_is_paused())
-	{
-		profiler_mark(PROFILER_VIDEO);
-		(*Machine->drv->video_eof)();
-		profiler_mark(PROFILER_END);
-	}
+
+/*-------------------------------------------------
+    video_set_frame_output - select the output of
+    the next frames
+-------------------------------------------------*/
+
+void video_set_frame_output(int show_video, int play_sound)
+{
+	frame_video_hidden = !show_video;
+	frame_sound_muted = !play_sound;
 }
 
 
@@ -836,7 +884,31 @@ void updatescreen(void)
 
 int skip_this_frame(void)
 {
-	return osd_skip_this_frame();
+	return osd_skip_this_frame() || frame_video_hidden;
+}
+
+
+/*-------------------------------------------------
+    video_set_runahead_time - update the time
+    spent to emulate a displayed frame with the
+    run-ahead, and the part of it used to save
+    and load the state
+-------------------------------------------------*/
+
+void video_set_runahead_time(int frames, double frame_time, double state_time)
+{
+	/* smooth the times over some frames */
+	if (performance.runahead_frames != frames)
+	{
+		performance.runahead_frames = frames;
+		performance.runahead_frame_time = frame_time;
+		performance.runahead_state_time = state_time;
+	}
+	else
+	{
+		performance.runahead_frame_time = 0.95 * performance.runahead_frame_time + 0.05 * frame_time;
+		performance.runahead_state_time = 0.95 * performance.runahead_state_time + 0.05 * state_time;
+	}
 }
 
 
@@ -79,6 +79,9 @@ struct _performance_info
 	double			frames_per_second;			/* actual rendered fps */
 	int				vector_updates_last_second; /* # of vector updates last second */
 	int				partial_updates_this_frame; /* # of partial updates last frame */
+	int				runahead_frames;			/* # of frames emulated ahead, 0 if disabled */
+	double			runahead_frame_time;		/* seconds to emulate a displayed frame with the run-ahead */
+	double			runahead_state_time;		/* seconds of it spent to save and load the state */
 };
 /* In mamecore.h: typedef struct _performance_info performance_info; */
 
@@ -123,9 +126,18 @@ void update_video_and_audio(void);
 /* (this calls draw_screen and update_video_and_audio) */
 void updatescreen(void);
 
+/* draw the screen and send it to the OSD layer, called by updatescreen for the visible frames */
+void video_frame_output(void);
+
+/* hide the video or mute the sound of the next frames, used by the run-ahead */
+void video_set_frame_output(int show_video, int play_sound);
+
 /* can we skip this frame? */
 int skip_this_frame(void);
 
+/* update the run-ahead performance data, times in seconds */
+void video_set_runahead_time(int frames, double frame_time, double state_time);
+
 /* return current performance data */
 const performance_info *mame_get_performance_info(void);
 
@@ -83,6 +83,14 @@ void osd_close_display(void);
 int osd_skip_this_frame(void);
 
 
+/*
+  Wait until the core can draw in the screen bitmap. The OSD layer can pass
+  the screen bitmap to another thread, which fills the next one with the
+  current frame while the core emulates the next frame.
+*/
+void osd_wait_for_screen(void);
+
+
 /*
   Update video and audio. game_bitmap contains the game display, while
   debug_bitmap an image of the debugger window (if the debugger is active; NULL
@@ -646,6 +646,9 @@ void force_partial_update(int scanline)
 	if (scanline < last_partial_scanline)
 		return;
 
+	/* the OSD layer can still be filling the bitmap with the previous frame */
+	osd_wait_for_screen();
+
 	/* if there's a dirty bitmap and we didn't do any partial updates yet, handle it now */
 	if (full_refresh_pending && last_partial_scanline == 0)
 	{
@@ -864,6 +867,7 @@ void updatescreen(void)
 	/* the user interface must be called between vh_update() and osd_update_video_and_audio(), */
 	/* to allow it to overlay things on the game display. We must call it even */
 	/* if the frame is skipped, to keep a consistent timing. */
+	osd_wait_for_screen();
 	ui_update_and_render(artwork_get_ui_bitmap());
 
 	/* update our movie recording state */